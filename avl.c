@@ -4,7 +4,7 @@
  |                                                                            |
  |                         An AVL Trees Library in C                          |
  |                                                                            |
- |                                  v 3.0.1                                   |
+ |                                  v 3.1.0                                   |
  |                                                                            |
  *----------------------------------------------------------------------------*/
 /*
@@ -66,12 +66,35 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef AVL_NODE_INCREMENT_MAX
 #define AVL_NODE_INCREMENT_MAX (1024 * 1024 - 1)
 #endif
+#ifndef AVL_SMALL_MAX
+#define AVL_SMALL_MAX 16
+#endif
+#ifndef AVL_LOCATE_MANY_WAYS
+#define AVL_LOCATE_MANY_WAYS 16
+#endif
+#ifndef AVL_APPEND_MIN_NODES
+#define AVL_APPEND_MIN_NODES 64
+#endif
 
 /*---------------------------------------------------------------------------*/
 
 #define CASE    break; case
 #define DEFAULT break; default
 
+/* forces the inlining of the generic insert/remove functions into their specialized instances */
+#if defined(__GNUC__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+/* hints that a node is going to be visited soon, so that its cache miss overlaps with other work */
+#if defined(__GNUC__)
+#define PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+#define PREFETCH(ptr) ((void)0)
+#endif
+
 #ifndef MAX
 #define MAX(a, b) ((a) >= (b) ? (a) : (b))
 #endif
@@ -120,24 +143,31 @@ struct avl_l_node {
 #define PTR_OF(nodeptr) ((void   *)(VAL_OF(nodeptr) & ~DEEPER))
 #define IS_DEEPER(nodeptr)         (VAL_OF(nodeptr) &  DEEPER)
 
-#define LOG_2_MAX_NODES (sizeof(long) * CHAR_BIT - 1)
-#define MAX_PATHDEPTH ((4761964 * LOG_2_MAX_NODES - 1083441) / 3305955)
+#define LOG_2_MAX_NODES AVL_LOG_2_MAX_NODES
+#define MAX_PATHDEPTH   AVL_MAX_PATHDEPTH
 
-typedef struct avl_path {
-   union {
-      void   **  pathnode;
-      X_NODE **x_pathnode;
-      L_NODE **l_pathnode;
-   };
-   char *pathright;
-   union {
-      void   *  node[MAX_PATHDEPTH + 2];
-      X_NODE *x_node[MAX_PATHDEPTH + 2];
-      L_NODE *l_node[MAX_PATHDEPTH + 2];
-   };
-   char right[MAX_PATHDEPTH + 2];
-} PATH;
+/* the path used by avl_first() etc. is a cursor owned by the tree */
+typedef AVL_CURSOR PATH;
+
+/* The right spine of a tree, cached for appending (see append_x()): the links from the root down to
+ * the empty right link of the rightmost node, of which the first n are valid. Any modification of the tree
+ * other than an append invalidates all of them. After a vain attempt to append, the next skip insertions
+ * make no attempt, and backoff grows exponentially up to MAX_BACKOFF, so that random insertions don't pay
+ * for rebuilding the spine.
+ */
+typedef struct spine {
+   void **link [MAX_PATHDEPTH + 1];
+   char   right[MAX_PATHDEPTH + 1]; /* all true */
+   int    n;
+   int    skip;
+   int    backoff;
+} SPINE;
+
+#define MAX_BACKOFF 1023
 
+#define FORGET_SPINE(tree) do { if ((tree)->spine) (tree)->spine->n = 0; } while (0)
+
+/* the root must remain the first member (see avl_define.h) */
 struct avl_tree {
    union {
       void   *  root;
@@ -146,6 +176,7 @@ struct avl_tree {
    };
    CMPFUN usrcmp;
    PATH  *path;
+   SPINE *spine;
    union {
       void   *  unused;
       X_NODE *x_unused;
@@ -156,12 +187,30 @@ struct avl_tree {
       X_NODE *x_store;
       L_NODE *l_store;
    };
+   union {           /* the leftmost node, NULL only if the tree is empty */
+      void   *  first;
+      X_NODE *x_first;
+      L_NODE *l_first;
+   };
+   union {           /* the rightmost node, NULL only if the tree is empty */
+      void   *  last;
+      X_NODE *x_last;
+      L_NODE *l_last;
+   };
+   void **small;     /* the sorted data of a small tree (see IS_SMALL()), NULL if it has nodes or is empty */
+   TREE  *sharing;
+   const AVL_ALLOCATOR *allocator;
+   void  *context;
    long   nodes;
    long   alloc;
    int    avail;
+   int    incmax; /* maximum size of a new node block */
    USHORT keyoffs;
    char   bits;
    char   type;
+   char   shift;  /* (alloc >> shift) + 1 is the size of the next node block */
+   char   counted; /* false after avl_split(), until avl_nodes() counts the nodes (see split_tree()) */
+   char   nosmall; /* true if the tree always has nodes (see IS_SMALL()) */
 };
 
 #define NODUP 0
@@ -194,7 +243,21 @@ struct avl_tree {
 #define FLT_KEY (AVL_FLT >> 1)
 #define DBL_KEY (AVL_DBL >> 1)
 
-#define KEYTYPE(tree) ((tree)->type >> 1)
+#define KEYTYPE(tree) (((tree)->type & ~(AVL_RANK | AVL_SET)) >> 1)
+#define IS_RANK(tree) ((tree)->type & AVL_RANK)
+#define IS_SET(tree)  ((tree)->type & AVL_SET)
+#define IS_MAP(tree)  (IS_SET(tree) && (tree)->keyoffs)
+#define IS_FULL(tree) ((tree)->counted && (tree)->nodes < 0)
+
+/* A small tree keeps its data in a sorted array instead of nodes, like tests/avm.c does, from its first insertion
+ * until it would hold more than AVL_SMALL_MAX items, or until a modifying function which needs nodes is called
+ * (see TO_NODES()). The reading functions all work on the array, and an empty small tree keeps it.
+ */
+#define IS_SMALL(tree)    ((tree)->small != NULL)
+#define CAN_BE_SMALL(tree) (!(tree)->root && !(tree)->nosmall && !(tree)->alloc && !(tree)->unused \
+                            && (tree)->sharing == (tree) && (tree)->counted)
+#define TO_NODES(tree)    (!(tree)->small || small_to_nodes(tree))
+#define IS_EMPTY(tree)    ( !(tree)->root && !((tree)->small && (tree)->nodes))
 
 /* bits:          3 2 1 0
  *                X V I D
@@ -266,6 +329,22 @@ typedef enum avl_ins {
    INS_DEEPER
 } INS_T;
 
+/* Insertion and removal functions specialized for a kind of tree, i.e. for a combination of
+ * tree->bits and IS_RANK(tree), so that the flags these imply are constants inside the loops.
+ * Only the X or only the L functions are set, according to IS_X(tree).
+ */
+typedef struct avl_ops {
+   INS_T   (*insert_x)(X_NODE **p_root, X_NODE *node, X_NODE **p_found, void *x_key, UINT keyoffs, CMPFUN usrcmp);
+   INS_T   (*insert_l)(L_NODE **p_root, L_NODE *node, L_NODE **p_found, char *keytail, UINT keyoffs);
+   X_NODE *(*remove_x)(X_NODE **p_root, void *x_key, UINT keyoffs, CMPFUN usrcmp, DEPTH *depth);
+   L_NODE *(*remove_l)(L_NODE **p_root, long l_key, char *keytail, UINT keyoffs, DEPTH *depth);
+} OPS;
+
+/* defined after the functions it points to */
+static const OPS ops_v[2][X_BIT << 1];
+
+#define OPS_OF(tree) (&ops_v[IS_RANK(tree) != 0][(int)(tree)->bits])
+
 #define PTRADD(ptr, offs) ((void *)((char *)(ptr) + (offs)))
 #define PTRSUB(ptr, offs) ((void *)((char *)(ptr) - (offs)))
 
@@ -287,7 +366,18 @@ typedef enum avl_ins {
          : strcmp((keytail),  (char  *)PTRADD((data), (keyoffs)) + sizeof(long)) \
 )
 
-#define AVL_FREE_AND_NULL(ptr) (AVL_FREE(ptr), (ptr) = NULL)
+/* all memory of a tree goes through its allocator, if it has one (see avl_tree_with_allocator()) */
+#define TREE_MALLOC(tree, size) ( \
+   (tree)->allocator ? (tree)->allocator->allocate((tree)->context, (size)) : AVL_MALLOC(size) \
+)
+#define TREE_FREE(tree, ptr) ( \
+   !(tree)->allocator         ? (void)AVL_FREE(ptr) : \
+   (tree)->allocator->release ? (void)(tree)->allocator->release((tree)->context, (ptr)) : (void)0 \
+)
+#define TREE_FREE_AND_NULL(tree, ptr) (TREE_FREE((tree), (ptr)), (ptr) = NULL)
+
+/* the trees created in a pool (see avl_tree_in_pool()) have the pool as the context of pool_allocator */
+#define POOL_OF(tree) ((tree)->allocator == &pool_allocator ? (AVL_POOL *)(tree)->context : NULL)
 
 #define SIZEOF_P   (sizeof(void *))
 #define SIZEOF_L   (sizeof(long))
@@ -295,6 +385,18 @@ typedef enum avl_ins {
 #define SIZEOF_P_L (MAX(SIZEOF_P, SIZEOF_L))
 #define SIZEOF_P_I (MAX(SIZEOF_P, SIZEOF_I))
 
+/* in rank trees every node is preceded by the number of nodes of its subtree,
+ * in set trees L nodes end before their data pointer, where map trees hold the value
+ * (set trees don't use the key offset, which holds the value size, rounded up here) */
+#define CNT_SIZE(tree)   (IS_RANK(tree) ? SIZEOF_P_L : 0)
+#define VALSIZE(tree)    (((size_t)(tree)->keyoffs + SIZEOF_P_L - 1) / SIZEOF_P_L * SIZEOF_P_L)
+#define VALUE_OF(node)   ((void *)&(node)->data)
+#define X_NODESIZE(tree) (sizeof(X_NODE) + CNT_SIZE(tree))
+#define L_NODESIZE(tree) ((IS_SET(tree) ? offsetof(L_NODE, data) + VALSIZE(tree) : sizeof(L_NODE)) + CNT_SIZE(tree))
+#define COUNT(node)      (*(long *)PTRSUB((node), SIZEOF_P_L))
+#define COUNT_OF(link)   ((link) ? COUNT(PTR_OF(link)) : 0L)
+#define RECOUNT(node)    (COUNT(node) = COUNT_OF((node)->left) + COUNT_OF((node)->right) + 1)
+
 /*===========================================================================*/
 
 static int floatcmp(void *p1, void *p2)
@@ -314,14 +416,25 @@ static int doublecmp(void *p1, void *p2)
 /*===========================================================================*/
 
 TREE *avl_tree(int treetype, size_t keyoffs, CMPFUN usrcmp)
+{
+   return avl_tree_with_allocator(treetype, keyoffs, usrcmp, NULL, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+TREE *avl_tree_with_allocator(int treetype, size_t keyoffs, CMPFUN usrcmp, const AVL_ALLOCATOR *allocator, void *context)
 {
    TREE *tree;
    char bits;
+   int  rank = treetype & AVL_RANK;
+   int  set  = treetype & AVL_SET;
+   int  nosmall = treetype & AVL_NOSMALL;
 
    if (sizeof(void *) != sizeof(char *)) {
       return NULL;
    }
-   if (keyoffs > USHRT_MAX || (treetype >= AVL_CHARS) != !usrcmp) {
+   treetype &= ~(AVL_RANK | AVL_SET | AVL_NOSMALL);
+   if (keyoffs > USHRT_MAX || (treetype >= AVL_CHARS) != !usrcmp || (allocator && !allocator->allocate)) {
       return NULL;
    }
    switch (treetype >> 1) {
@@ -347,22 +460,184 @@ TREE *avl_tree(int treetype, size_t keyoffs, CMPFUN usrcmp)
    DEFAULT:
       return NULL;
    }
-   tree = AVL_MALLOC(sizeof(*tree));
+   if (set && (bits >= X_BIT || (treetype >> 1 != LNG_KEY && treetype >> 1 != ULN_KEY && treetype >> 1 != DBL_KEY)
+               || (keyoffs && (treetype & AVL_DUP)))) {
+      return NULL;
+   }
+   tree = allocator ? allocator->allocate(context, sizeof(*tree)) : AVL_MALLOC(sizeof(*tree));
    if ( !tree) return NULL;
    tree->root    = NULL;
    tree->usrcmp  = usrcmp;
    tree->path    = NULL;
+   tree->spine   = NULL;
+   tree->first   = NULL;
+   tree->last    = NULL;
    tree->unused  = NULL;
    tree->store   = NULL;
+   tree->small   = NULL;
+   tree->sharing = tree;
+   tree->allocator = allocator;
+   tree->context   = context;
    tree->nodes   = 0;
    tree->alloc   = 0;
    tree->avail   = 0;
+   tree->incmax  = AVL_NODE_INCREMENT_MAX;
    tree->keyoffs = (USHORT)keyoffs;
    tree->bits    = bits;
-   tree->type    = (char)treetype;
+   tree->type    = (char)(treetype | rank | set);
+   tree->shift   = AVL_NODE_INCREMENT_SHIFT;
+   tree->counted = true;
+   tree->nosmall = nosmall || set || AVL_SMALL_MAX <= 0;
+   return tree;
+}
+
+/*===========================================================================*/
+
+/* A pool holds the nodes of all the trees created in it, in blocks of one node size each.
+ * The trees take their nodes from the pool when they have no removed nodes of their own,
+ * and give all of their nodes back to it when they are emptied, trimmed or freed.
+ * All memory obtained through the pool (also the TREE structures and the paths) is in a list of chunks,
+ * so that freeing the pool frees everything.
+ */
+typedef struct pool_chunk {
+   struct pool_chunk *prev;
+   struct pool_chunk *next;
+} POOL_CHUNK;
+
+typedef struct pool_class {
+   size_t nodesize; /* 0 if the sclass is not in use */
+   void  *unused;   /* the nodes given back by the trees, linked through their first word */
+   void  *store;    /* the last node taken from the current block */
+   long   alloc;
+   int    avail;
+} POOL_CLASS;
+
+/* X and L nodes, with and without a count (in rank trees), have at most 4 sizes
+ * (the nodes of set trees have the size of X nodes, and map trees can't be in a pool) */
+#define POOL_CLASSES 4
+
+struct avl_pool {
+   POOL_CHUNK chunks; /* the head of a circular list */
+   POOL_CLASS class_v[POOL_CLASSES];
+};
+
+/*---------------------------------------------------------------------------*/
+
+static void *pool_allocate(void *context, size_t size)
+{
+   AVL_POOL   *pool = context;
+   POOL_CHUNK *chunk;
+
+   if (size > (size_t)-1 - sizeof(POOL_CHUNK)) return NULL;
+   chunk = AVL_MALLOC(sizeof(POOL_CHUNK) + size);
+   if ( !chunk) return NULL;
+   chunk->prev = &pool->chunks;
+   chunk->next = pool->chunks.next;
+   chunk->next->prev = chunk;
+   pool->chunks.next = chunk;
+   return chunk + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void pool_release(void *context, void *ptr)
+{
+   POOL_CHUNK *chunk = (POOL_CHUNK *)ptr - 1;
+
+   (void)context;
+   chunk->prev->next = chunk->next;
+   chunk->next->prev = chunk->prev;
+   AVL_FREE(chunk);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static const AVL_ALLOCATOR pool_allocator = { pool_allocate, pool_release };
+
+/*---------------------------------------------------------------------------*/
+
+AVL_POOL *avl_pool(void)
+{
+   AVL_POOL *pool;
+
+   pool = AVL_MALLOC(sizeof(*pool));
+   if ( !pool) return NULL;
+   pool->chunks.prev = pool->chunks.next = &pool->chunks;
+   memset(pool->class_v, 0, sizeof(pool->class_v));
+   return pool;
+}
+
+/*---------------------------------------------------------------------------*/
+
+TREE *avl_tree_in_pool(AVL_POOL *pool, int treetype, size_t keyoffs, CMPFUN usrcmp)
+{
+   TREE *tree;
+
+   if ((treetype & AVL_SET) && keyoffs) {
+      return NULL; /* the node size of map trees is not one of the POOL_CLASSES */
+   }
+   tree = avl_tree_with_allocator(treetype, keyoffs, usrcmp, &pool_allocator, pool);
+   if (tree) {
+      tree->nosmall = true; /* its nodes are taken from the pool from the start */
+   }
    return tree;
 }
 
+/*---------------------------------------------------------------------------*/
+
+void avl_pool_free(AVL_POOL *pool)
+{
+   POOL_CHUNK *chunk, *next;
+
+   for (chunk = pool->chunks.next; chunk != &pool->chunks; chunk = next) {
+      next = chunk->next;
+      AVL_FREE(chunk);
+   }
+   AVL_FREE(pool);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static POOL_CLASS *pool_class_of(AVL_POOL *pool, size_t nodesize)
+{
+   POOL_CLASS *sclass;
+
+   for (sclass = pool->class_v; sclass->nodesize != nodesize; sclass++) {
+      if (sclass->nodesize == 0) {
+         sclass->nodesize = nodesize;
+         break;
+      }
+   }
+   return sclass;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Return a node of the given size (including the count of rank trees), i.e., the address where its count,
+ * if any, goes, or NULL if out of memory.
+ */
+static void *pool_node(AVL_POOL *pool, size_t nodesize)
+{
+   POOL_CLASS *sclass = pool_class_of(pool, nodesize);
+   void       *node;
+   int         increment;
+
+   if (sclass->unused) {
+      PTRPOP(sclass->unused, node);
+   } else if (sclass->avail) {
+      node = sclass->store = PTRSUB(sclass->store, nodesize);
+      sclass->avail--;
+   } else {
+      increment = (int)MIN((sclass->alloc >> AVL_NODE_INCREMENT_SHIFT) + 1, AVL_NODE_INCREMENT_MAX);
+      node = pool_allocate(pool, increment * nodesize);
+      if ( !node) return NULL;
+      node = sclass->store = PTRADD(node, (increment - 1) * nodesize);
+      sclass->alloc += increment;
+      sclass->avail  = increment - 1;
+   }
+   return node;
+}
+
 /*===========================================================================*/
 
 static long l_key_of(char *str, char **p_keytail)
@@ -420,6 +695,25 @@ static long dbl2lng(double d)
 
 /*---------------------------------------------------------------------------*/
 
+/* The inverse of dbl2lng(), for the keys of set trees.
+ */
+static double lng2dbl(long l)
+{
+   union { double d; long l; int i; } u;
+
+   if (l > 0) {
+      if (sizeof(double) == sizeof(long)) u.l =  l; else u.i = (int) l;
+      return u.d;
+   } else if (l < 0) {
+      if (sizeof(double) == sizeof(long)) u.l = -l; else u.i = (int)-l;
+      return -u.d;
+   } else {
+      return 0.0;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
 bool avl_has_fast_floats(void)
 {
    return (sizeof(float) == sizeof(long) || sizeof(float) == sizeof(int)) &&
@@ -440,7 +734,7 @@ bool avl_has_fast_doubles(void)
 
 /*===========================================================================*/
 
-static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal)
+static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal, bool cnt)
 {
    X_NODE *root        = PTR_OF   (*p_root);
    UINTPTR root_deeper = IS_DEEPER(*p_root);
@@ -455,6 +749,10 @@ static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal)
          root->rightval &= ~DEEPER;
          newroot->right = root;
          newroot->leftval &= ~DEEPER;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return LESS;
       } else if (IS_DEEPER(root_left->right)) {
@@ -479,6 +777,11 @@ static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal)
          }
          newroot->left  = half;
          newroot->right = root;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+            RECOUNT(half);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return LESS;
       } else {
@@ -488,6 +791,10 @@ static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal)
          root->rightval &= ~DEEPER;
          newroot->rightval = VAL_OF(root) | DEEPER;
          newroot->leftval &= ~DEEPER;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return SAME;
       }
@@ -500,6 +807,10 @@ static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal)
          root->leftval &= ~DEEPER;
          newroot->left = root;
          newroot->rightval &= ~DEEPER;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return LESS;
       } else if (IS_DEEPER(root_right->left)) {
@@ -524,6 +835,11 @@ static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal)
          }
          newroot->right = half;
          newroot->left  = root;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+            RECOUNT(half);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return LESS;
       } else {
@@ -533,6 +849,10 @@ static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal)
          root->leftval &= ~DEEPER;
          newroot->leftval = VAL_OF(root) | DEEPER;
          newroot->rightval &= ~DEEPER;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return SAME;
       }
@@ -541,7 +861,7 @@ static DEPTH rebalance_x(X_NODE **p_root, UNBAL unbal)
 
 /*---------------------------------------------------------------------------*/
 
-static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal)
+static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal, bool cnt)
 {
    L_NODE *root        = PTR_OF   (*p_root);
    UINTPTR root_deeper = IS_DEEPER(*p_root);
@@ -556,6 +876,10 @@ static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal)
          root->rightval &= ~DEEPER;
          newroot->right = root;
          newroot->leftval &= ~DEEPER;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return LESS;
       } else if (IS_DEEPER(root_left->right)) {
@@ -580,6 +904,11 @@ static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal)
          }
          newroot->left  = half;
          newroot->right = root;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+            RECOUNT(half);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return LESS;
       } else {
@@ -589,6 +918,10 @@ static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal)
          root->rightval &= ~DEEPER;
          newroot->rightval = VAL_OF(root) | DEEPER;
          newroot->leftval &= ~DEEPER;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return SAME;
       }
@@ -601,6 +934,10 @@ static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal)
          root->leftval &= ~DEEPER;
          newroot->left = root;
          newroot->rightval &= ~DEEPER;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return LESS;
       } else if (IS_DEEPER(root_right->left)) {
@@ -625,6 +962,11 @@ static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal)
          }
          newroot->right = half;
          newroot->left  = root;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+            RECOUNT(half);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return LESS;
       } else {
@@ -634,6 +976,10 @@ static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal)
          root->leftval &= ~DEEPER;
          newroot->leftval = VAL_OF(root) | DEEPER;
          newroot->rightval &= ~DEEPER;
+         if (cnt) {
+            COUNT(newroot) = COUNT(root);
+            RECOUNT(root);
+         }
          *p_root = PTRADD(newroot, root_deeper);
          return SAME;
       }
@@ -642,135 +988,162 @@ static DEPTH rebalance_l(L_NODE **p_root, UNBAL unbal)
 
 /*===========================================================================*/
 
-static INS_T insert_x(X_NODE **p_root, X_NODE *node, void *x_key, UINT keyoffs, bool ind, CMPFUN usrcmp, bool dup)
+/* Link node at the end of the given path, i.e., into the empty link p_link_v[n], which is reached
+ * from the root through the links p_link_v[0 .. n-1], turning right from the nodes they point to if right_v[].
+ * The path is then unwound to update the balance (and the counts of rank trees).
+ * If p_valid is not NULL, it receives the length of the part of the path that is still valid afterwards, i.e.,
+ * n, or the index of the link to the subtree that has been rotated (see avl_insert_sorted_batch()).
+ */
+static ALWAYS_INLINE INS_T insert_at_x(X_NODE **p_link_v[], char right_v[], int n, X_NODE *node, bool cnt, int *p_valid)
 {
-   X_NODE *root = PTR_OF(*p_root);
-   int     cmp;
-   INS_T   ins;
-
-   cmp = CMP(usrcmp, x_key, root->data, keyoffs, ind);
-   if (cmp < 0) {
-      if (root->left) {
-         ins = insert_x(&root->left, node, x_key, keyoffs, ind, usrcmp, dup);
-      } else {
-         root->left = PTRADD(node, IS_DEEPER(root->left));
-         ins = INS_DEEPER;
+   X_NODE **p_link;
+   X_NODE  *root;
+   INS_T    ins = INS_DEEPER;
+
+   if (p_valid) *p_valid = n;
+   *p_link_v[n] = node;
+   while (n > 0) {
+      p_link = p_link_v[--n];
+      root = PTR_OF(*p_link);
+      if (cnt) {
+         COUNT(root)++;
       }
-      switch (ins) {
-      CASE INS_DEEPER:
+      if (ins == INS) {
+         if ( !cnt) break;
+      } else if ( !right_v[n]) {
          if (IS_DEEPER(root->left)) {
-            return rebalance_x(p_root, LEFTUNBAL) == LESS ? INS : INS_DEEPER;
+            ins = rebalance_x(p_link, LEFTUNBAL, cnt) == LESS ? INS : INS_DEEPER;
+            if (p_valid) *p_valid = n;
          } else if (IS_DEEPER(root->right)) {
             root->rightval &= ~DEEPER;
-            return INS;
+            ins = INS;
          } else {
             root->leftval |= DEEPER;
-            return INS_DEEPER;
          }
-      CASE INS:
-         return INS;
-      DEFAULT:
-         return NOT_INS;
-      }
-   } else if (cmp > 0 || dup) {
-      if (root->right) {
-         ins = insert_x(&root->right, node, x_key, keyoffs, ind, usrcmp, dup);
       } else {
-         root->right = PTRADD(node, IS_DEEPER(root->right));
-         ins = INS_DEEPER;
-      }
-      switch (ins) {
-      CASE INS_DEEPER:
          if (IS_DEEPER(root->right)) {
-            return rebalance_x(p_root, RIGHTUNBAL) == LESS ? INS : INS_DEEPER;
+            ins = rebalance_x(p_link, RIGHTUNBAL, cnt) == LESS ? INS : INS_DEEPER;
+            if (p_valid) *p_valid = n;
          } else if (IS_DEEPER(root->left)) {
             root->leftval &= ~DEEPER;
-            return INS;
+            ins = INS;
          } else {
             root->rightval |= DEEPER;
-            return INS_DEEPER;
          }
-      CASE INS:
-         return INS;
-      DEFAULT:
-         return NOT_INS;
       }
-   } else {
-      return NOT_INS;
    }
+   return ins;
 }
 
 /*---------------------------------------------------------------------------*/
 
-static INS_T insert_l(L_NODE **p_root, L_NODE *node, char *keytail, UINT keyoffs, bool ind, bool dup)
+/* Like insert_at_x().
+ */
+static ALWAYS_INLINE INS_T insert_at_l(L_NODE **p_link_v[], char right_v[], int n, L_NODE *node, bool cnt, int *p_valid)
 {
-   L_NODE *root = PTR_OF(*p_root);
-   INS_T   ins;
-
-   if (node->key < root->key) {
-      insert_lt:
-      if (root->left) {
-         ins = insert_l(&root->left, node, keytail, keyoffs, ind, dup);
-      } else {
-         root->left = PTRADD(node, IS_DEEPER(root->left));
-         ins = INS_DEEPER;
+   L_NODE **p_link;
+   L_NODE  *root;
+   INS_T    ins = INS_DEEPER;
+
+   if (p_valid) *p_valid = n;
+   *p_link_v[n] = node;
+   while (n > 0) {
+      p_link = p_link_v[--n];
+      root = PTR_OF(*p_link);
+      if (cnt) {
+         COUNT(root)++;
       }
-      switch (ins) {
-      CASE INS_DEEPER:
+      if (ins == INS) {
+         if ( !cnt) break;
+      } else if ( !right_v[n]) {
          if (IS_DEEPER(root->left)) {
-            return rebalance_l(p_root, LEFTUNBAL) == LESS ? INS : INS_DEEPER;
+            ins = rebalance_l(p_link, LEFTUNBAL, cnt) == LESS ? INS : INS_DEEPER;
+            if (p_valid) *p_valid = n;
          } else if (IS_DEEPER(root->right)) {
             root->rightval &= ~DEEPER;
-            return INS;
+            ins = INS;
          } else {
             root->leftval |= DEEPER;
-            return INS_DEEPER;
          }
-      CASE INS:
-         return INS;
-      DEFAULT:
-         return NOT_INS;
-      }
-   } else if (node->key > root->key) {
-      insert_gt_or_dup:
-      if (root->right) {
-         ins = insert_l(&root->right, node, keytail, keyoffs, ind, dup);
       } else {
-         root->right = PTRADD(node, IS_DEEPER(root->right));
-         ins = INS_DEEPER;
-      }
-      switch (ins) {
-      CASE INS_DEEPER:
          if (IS_DEEPER(root->right)) {
-            return rebalance_l(p_root, RIGHTUNBAL) == LESS ? INS : INS_DEEPER;
+            ins = rebalance_l(p_link, RIGHTUNBAL, cnt) == LESS ? INS : INS_DEEPER;
+            if (p_valid) *p_valid = n;
          } else if (IS_DEEPER(root->left)) {
             root->leftval &= ~DEEPER;
-            return INS;
+            ins = INS;
          } else {
             root->rightval |= DEEPER;
-            return INS_DEEPER;
          }
-      CASE INS:
-         return INS;
-      DEFAULT:
-         return NOT_INS;
       }
-   } else if ( !keytail) {
-      if (dup) {
-         goto insert_gt_or_dup;
+   }
+   return ins;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Insert node into the tree of the given root. If the tree does not allow duplicates and a node
+ * with the same key is found, NOT_INS is returned and the found node is stored into *p_found.
+ * The insertion is iterative: the links followed on the way down are kept on a stack,
+ * which is then unwound to update the balance (and the counts of rank trees).
+ */
+static ALWAYS_INLINE INS_T insert_x(X_NODE **p_root, X_NODE *node, X_NODE **p_found, void *x_key, UINT keyoffs, bool ind, CMPFUN usrcmp, bool dup, bool cnt)
+{
+   X_NODE **p_link_v[MAX_PATHDEPTH + 1];
+   char     right_v [MAX_PATHDEPTH + 1];
+   X_NODE **p_link = p_root;
+   X_NODE  *root;
+   int      n = 0;
+   int      cmp;
+
+   do {
+      root = PTR_OF(*p_link);
+      cmp = CMP(usrcmp, x_key, root->data, keyoffs, ind);
+      if (cmp < 0) {
+         right_v[n] = false;
+      } else if (cmp > 0 || dup) {
+         right_v[n] = true;
       } else {
+         *p_found = root;
          return NOT_INS;
       }
-   } else {
-      int cmp = TAILCMP(keytail, root->data, keyoffs, ind);
+      p_link_v[n] = p_link;
+      p_link = right_v[n++] ? &root->right : &root->left;
+   } while (*p_link);
+   p_link_v[n] = p_link;
+   return insert_at_x(p_link_v, right_v, n, node, cnt, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static ALWAYS_INLINE INS_T insert_l(L_NODE **p_root, L_NODE *node, L_NODE **p_found, char *keytail, UINT keyoffs, bool ind, bool dup, bool cnt)
+{
+   L_NODE **p_link_v[MAX_PATHDEPTH + 1];
+   char     right_v [MAX_PATHDEPTH + 1];
+   L_NODE **p_link = p_root;
+   L_NODE  *root;
+   int      n = 0;
+   int      cmp;
+
+   do {
+      root = PTR_OF(*p_link);
+      if      (node->key < root->key) cmp = -1;
+      else if (node->key > root->key) cmp =  1;
+      else if (keytail)               cmp = TAILCMP(keytail, root->data, keyoffs, ind);
+      else                            cmp =  0;
       if (cmp < 0) {
-         goto insert_lt;
+         right_v[n] = false;
       } else if (cmp > 0 || dup) {
-         goto insert_gt_or_dup;
+         right_v[n] = true;
       } else {
+         *p_found = root;
          return NOT_INS;
       }
-   }
+      p_link_v[n] = p_link;
+      p_link = right_v[n++] ? &root->right : &root->left;
+   } while (*p_link);
+   p_link_v[n] = p_link;
+   return insert_at_l(p_link_v, right_v, n, node, cnt, NULL);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -781,15 +1154,20 @@ static X_NODE *alloc_node_x(TREE *tree)
    void   *old_alloc_base, *new_alloc_base;
    int     increment;
 
-   increment = (tree->alloc >> AVL_NODE_INCREMENT_SHIFT) + 1;
-   if (increment > AVL_NODE_INCREMENT_MAX) increment = AVL_NODE_INCREMENT_MAX;
-   old_alloc_base = tree->x_store ? PTRSUB(tree->x_store, SIZEOF_P) : NULL;
-   new_alloc_base = AVL_MALLOC(SIZEOF_P + increment * sizeof(X_NODE));
+   if (POOL_OF(tree)) {
+      x_node = pool_node(POOL_OF(tree), X_NODESIZE(tree));
+      if ( !x_node) return NULL;
+      tree->alloc++;
+      return PTRADD(x_node, CNT_SIZE(tree));
+   }
+   increment = (int)MIN((tree->alloc >> tree->shift) + 1, tree->incmax);
+   old_alloc_base = tree->x_store ? PTRSUB(tree->x_store, SIZEOF_P + CNT_SIZE(tree)) : NULL;
+   new_alloc_base = TREE_MALLOC(tree, SIZEOF_P + increment * X_NODESIZE(tree));
    if ( !new_alloc_base) return NULL;
    tree->alloc += increment;
    tree->avail = increment - 1;
    *(void **)new_alloc_base = old_alloc_base;
-   x_node = ((X_NODE *)PTRADD(new_alloc_base, SIZEOF_P)) + (increment - 1);
+   x_node = PTRADD(new_alloc_base, SIZEOF_P + CNT_SIZE(tree) + (increment - 1) * X_NODESIZE(tree));
    tree->x_store = x_node;
    return x_node;
 }
@@ -802,39 +1180,267 @@ static L_NODE *alloc_node_l(TREE *tree)
    void   *old_alloc_base, *new_alloc_base;
    int     increment;
 
-   increment = (tree->alloc >> AVL_NODE_INCREMENT_SHIFT) + 1;
-   if (increment > AVL_NODE_INCREMENT_MAX) increment = AVL_NODE_INCREMENT_MAX;
-   old_alloc_base = tree->l_store ? PTRSUB(tree->l_store, SIZEOF_P_L) : NULL;
-   new_alloc_base = AVL_MALLOC(SIZEOF_P_L + increment * sizeof(L_NODE));
+   if (POOL_OF(tree)) {
+      l_node = pool_node(POOL_OF(tree), L_NODESIZE(tree));
+      if ( !l_node) return NULL;
+      tree->alloc++;
+      return PTRADD(l_node, CNT_SIZE(tree));
+   }
+   increment = (int)MIN((tree->alloc >> tree->shift) + 1, tree->incmax);
+   old_alloc_base = tree->l_store ? PTRSUB(tree->l_store, SIZEOF_P_L + CNT_SIZE(tree)) : NULL;
+   new_alloc_base = TREE_MALLOC(tree, SIZEOF_P_L + increment * L_NODESIZE(tree));
    if ( !new_alloc_base) return NULL;
    tree->alloc += increment;
    tree->avail = increment - 1;
    *(void **)new_alloc_base = old_alloc_base;
-   l_node = ((L_NODE *)PTRADD(new_alloc_base, SIZEOF_P_L)) + (increment - 1);
+   l_node = PTRADD(new_alloc_base, SIZEOF_P_L + CNT_SIZE(tree) + (increment - 1) * L_NODESIZE(tree));
    tree->l_store = l_node;
    return l_node;
 }
 
 /*---------------------------------------------------------------------------*/
 
-bool avl_insert(TREE *tree, void *data)
+static void *x_key_of(TREE *tree, void *data)
+{
+   switch (KEYTYPE(tree)) {
+   CASE USR_KEY: return data;
+   CASE MBR_KEY:
+   case FLT_KEY:
+   case DBL_KEY: return           PTRADD(data, tree->keyoffs);
+   CASE PTR_KEY: return *(void **)PTRADD(data, tree->keyoffs);
+   }
+   return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static long l_key_of_data(TREE *tree, void *data, char **p_keytail)
+{
+   *p_keytail = NULL;
+   switch (KEYTYPE(tree)) {
+   CASE CHA_KEY: return l_key_of( (char  *)PTRADD(data, tree->keyoffs), p_keytail);
+   CASE STR_KEY: return l_key_of(*(char **)PTRADD(data, tree->keyoffs), p_keytail);
+   CASE LNG_KEY: return          *(long  *)PTRADD(data, tree->keyoffs);
+   CASE INT_KEY: return          *(int   *)PTRADD(data, tree->keyoffs);
+   CASE SHT_KEY: return          *(short *)PTRADD(data, tree->keyoffs);
+   CASE SCH_KEY: return          *(SCHAR *)PTRADD(data, tree->keyoffs);
+   CASE ULN_KEY: return  CORRECT(*(ULONG *)PTRADD(data, tree->keyoffs));
+   CASE UIN_KEY: return  CORR_IF(*(UINT  *)PTRADD(data, tree->keyoffs), UIN_CORR);
+   CASE USH_KEY: return  CORR_IF(*(USHORT*)PTRADD(data, tree->keyoffs), USH_CORR);
+   CASE UCH_KEY: return  CORR_IF(*(UCHAR *)PTRADD(data, tree->keyoffs), UCH_CORR);
+   CASE FLT_KEY: return  flt2lng(*(float *)PTRADD(data, tree->keyoffs));
+   CASE DBL_KEY: return  dbl2lng(*(double*)PTRADD(data, tree->keyoffs));
+   }
+   return 0L;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Allocate the spine of the tree, to be built by the next append. Without memory, the tree simply has none.
+ */
+static void new_spine(TREE *tree)
+{
+   SPINE *spine = TREE_MALLOC(tree, sizeof(SPINE));
+
+   if (spine) {
+      memset(spine->right, true, sizeof(spine->right));
+      spine->n = spine->skip = spine->backoff = 0;
+   }
+   tree->spine = spine;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Append node to the tree if its key is not less than the greatest key (greater, in trees without duplicates),
+ * linking it at the end of the cached right spine (see SPINE), and return INS, or else NOT_INS.
+ * The spine is first extended from its last valid link, without comparisons. Since an append leaves it valid
+ * down to the link to the rotated subtree, if any, which is rarely high up, appending in order takes
+ * amortized constant time. If the key is equal to the greatest one in a tree without duplicates,
+ * the rightmost node is stored into *p_found. Unless forced, no attempt is made during a backoff.
+ * The tree must have a spine (see new_spine()).
+ */
+static INS_T append_x(TREE *tree, X_NODE *node, X_NODE **p_found, void *x_key, bool force)
+{
+   SPINE    *spine = tree->spine;
+   X_NODE ***p_link_v;
+   X_NODE   *last;
+   bool      rebuilt;
+   int       n, cmp;
+
+   *p_found = NULL;
+   if (spine->skip && !force) {
+      spine->skip--;
+      return NOT_INS;
+   }
+   p_link_v = (X_NODE ***)spine->link;
+   rebuilt = spine->n == 0;
+   if (rebuilt) {
+      p_link_v[0] = &tree->x_root;
+      spine->n = 1;
+   }
+   for (n = spine->n - 1; *p_link_v[n]; n++) {
+      last = PTR_OF(*p_link_v[n]);
+      p_link_v[n + 1] = &last->right;
+   }
+   spine->n = n + 1;
+   if (n > 0) {
+      last = PTR_OF(*p_link_v[n - 1]);
+      cmp = CMP(tree->usrcmp, x_key, last->data, tree->keyoffs, IS_IND(tree));
+      if (cmp < 0 || (cmp == 0 && !IS_DUP(tree))) {
+         if (cmp == 0) {
+            *p_found = last;
+         } else if (rebuilt && !force) {
+            spine->skip = spine->backoff = MIN(2 * spine->backoff + 1, MAX_BACKOFF);
+         }
+         return NOT_INS;
+      }
+   }
+   spine->backoff = 0;
+   insert_at_x(p_link_v, spine->right, n, node, IS_RANK(tree), &n);
+   spine->n = n + 1;
+   return INS;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static ALWAYS_INLINE int cmp_l(long key, char *keytail, L_NODE *l_node, UINT keyoffs, bool ind)
+{
+   if (key < l_node->key) return -1;
+   if (key > l_node->key) return  1;
+   return keytail ? TAILCMP(keytail, l_node->data, keyoffs, ind) : 0;
+}
+
+/* Like append_x().
+ */
+static INS_T append_l(TREE *tree, L_NODE *node, L_NODE **p_found, char *keytail, bool force)
+{
+   SPINE    *spine = tree->spine;
+   L_NODE ***p_link_v;
+   L_NODE   *last;
+   bool      rebuilt;
+   int       n, cmp;
+
+   *p_found = NULL;
+   if (spine->skip && !force) {
+      spine->skip--;
+      return NOT_INS;
+   }
+   p_link_v = (L_NODE ***)spine->link;
+   rebuilt = spine->n == 0;
+   if (rebuilt) {
+      p_link_v[0] = &tree->l_root;
+      spine->n = 1;
+   }
+   for (n = spine->n - 1; *p_link_v[n]; n++) {
+      last = PTR_OF(*p_link_v[n]);
+      p_link_v[n + 1] = &last->right;
+   }
+   spine->n = n + 1;
+   if (n > 0) {
+      last = PTR_OF(*p_link_v[n - 1]);
+      cmp = cmp_l(node->key, keytail, last, tree->keyoffs, IS_IND(tree));
+      if (cmp < 0 || (cmp == 0 && !IS_DUP(tree))) {
+         if (cmp == 0) {
+            *p_found = last;
+         } else if (rebuilt && !force) {
+            spine->skip = spine->backoff = MIN(2 * spine->backoff + 1, MAX_BACKOFF);
+         }
+         return NOT_INS;
+      }
+   }
+   spine->backoff = 0;
+   insert_at_l(p_link_v, spine->right, n, node, IS_RANK(tree), &n);
+   spine->n = n + 1;
+   return INS;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Recompute the cached first and last nodes of the tree by walking down its left and right spines.
+ */
+static void reset_ends(TREE *tree)
 {
    X_NODE *x_node;
    L_NODE *l_node;
+
+   if ( !tree->root) {
+      tree->first = tree->last = NULL;
+   } else if (IS_X(tree)) {
+      for (x_node = tree->x_root; x_node->left;  x_node = PTR_OF(x_node->left )) {}
+      tree->x_first = x_node;
+      for (x_node = tree->x_root; x_node->right; x_node = PTR_OF(x_node->right)) {}
+      tree->x_last  = x_node;
+   } else {
+      for (l_node = tree->l_root; l_node->left;  l_node = PTR_OF(l_node->left )) {}
+      tree->l_first = l_node;
+      for (l_node = tree->l_root; l_node->right; l_node = PTR_OF(l_node->right)) {}
+      tree->l_last  = l_node;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Update the cached first and last nodes of the tree after the given node has been inserted into it.
+ * No comparison is needed: rotations keep a new leftmost node a leaf, whose parent is its successor,
+ * i.e., the previous leftmost node, and likewise on the right.
+ */
+static void note_insert(TREE *tree, void *node)
+{
+   if ( !tree->first) {
+      tree->first = tree->last = node;
+   } else if (IS_X(tree)) {
+      if (PTR_OF(tree->x_first->left ) == node) tree->first = node;
+      if (PTR_OF(tree->x_last ->right) == node) tree->last  = node;
+   } else {
+      if (PTR_OF(tree->l_first->left ) == node) tree->first = node;
+      if (PTR_OF(tree->l_last ->right) == node) tree->last  = node;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Update the cached first and last nodes of the tree after the given node has been removed from it.
+ */
+static void note_remove(TREE *tree, void *node)
+{
+   if (node == tree->first || node == tree->last) {
+      reset_ends(tree);
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Insert data into the tree, returning true if successful. Otherwise, if a node with the same key was found
+ * (in a tree without duplicates), it is stored into *p_found, else NULL is.
+ * The new node is taken only once the insertion point is known: if the insertion fails,
+ * it is given back to the store of available nodes or to the list of removed nodes it came from.
+ * The data is first appended if the tree has a spine (see append_x()). The spine is allocated by avl_append(),
+ * or by the first insertion at the rightmost position once the tree is large enough and not in a pool,
+ * whose chunks would be spent on spines. If append is true, the data is only appended, as if forced:
+ * without a spine, its key is compared with the greatest one and it is inserted by a descent from the root.
+ */
+static bool insert_data(TREE *tree, void *data, void **p_found, bool append)
+{
+   X_NODE *x_node, *x_found;
+   L_NODE *l_node, *l_found;
    void   *x_key;
    char   *keytail;
+   INS_T   ins;
+   bool    descend = !append;
+   int     cmp;
 
+   *p_found = NULL;
    if (tree->path) {
-      AVL_FREE_AND_NULL(tree->path);
+      TREE_FREE_AND_NULL(tree, tree->path);
    }
-   if (tree->nodes < 0) {
+   if (IS_FULL(tree) || IS_SET(tree)) {
       return false;
    }
    if (IS_X(tree)) {
       if (tree->unused) {
          PTRPOP(tree->unused, x_node);
       } else if (tree->avail) {
-         x_node = --tree->x_store;
+         x_node = tree->x_store = PTRSUB(tree->x_store, X_NODESIZE(tree));
          tree->avail--;
       } else {
          x_node = alloc_node_x(tree);
@@ -843,27 +1449,52 @@ bool avl_insert(TREE *tree, void *data)
       x_node->data  = data;
       x_node->left  = NULL;
       x_node->right = NULL;
-      switch (KEYTYPE(tree)) {
-      CASE USR_KEY: x_key = data;
-      CASE MBR_KEY:
-      case FLT_KEY:
-      case DBL_KEY: x_key =           PTRADD(data, tree->keyoffs);
-      CASE PTR_KEY: x_key = *(void **)PTRADD(data, tree->keyoffs);
-      DEFAULT: return false;
-      }
-      if (tree->x_root) {
-         if (insert_x(&tree->x_root, x_node, x_key, tree->keyoffs, IS_IND(tree), tree->usrcmp, IS_DUP(tree)) == NOT_INS) {
+      if (IS_RANK(tree)) {
+         COUNT(x_node) = 1;
+      }
+      x_key = x_key_of(tree, data);
+      ins = NOT_INS;
+      x_found = NULL;
+      if (append && !tree->spine) {
+         new_spine(tree);
+      }
+      if (tree->spine) {
+         ins = append_x(tree, x_node, &x_found, x_key, append);
+      } else if (append) {
+         cmp = tree->x_last ? CMP(tree->usrcmp, x_key, tree->x_last->data, tree->keyoffs, IS_IND(tree)) : 1;
+         if (cmp == 0 && !IS_DUP(tree)) {
+            x_found = tree->x_last;
+         }
+         descend = cmp > 0 || (cmp == 0 && IS_DUP(tree));
+      }
+      if (ins == NOT_INS && !x_found && descend) {
+         FORGET_SPINE(tree);
+         if (tree->x_root) {
+            ins = OPS_OF(tree)->insert_x(&tree->x_root, x_node, &x_found, x_key, tree->keyoffs, tree->usrcmp);
+         } else {
+            tree->x_root = x_node;
+            ins = INS;
+         }
+      }
+      if (ins == NOT_INS) {
+         if (x_node == tree->x_store) {
+            tree->x_store = PTRADD(x_node, X_NODESIZE(tree));
+            tree->avail++;
+         } else {
             PTRPUSH(tree->unused, x_node);
-            return false;
          }
-      } else {
-         tree->x_root = x_node;
+         *p_found = x_found;
+         return false;
+      }
+      note_insert(tree, x_node);
+      if ( !tree->spine && tree->x_last == x_node && tree->nodes >= AVL_APPEND_MIN_NODES && !POOL_OF(tree)) {
+         new_spine(tree);
       }
    } else {
       if (tree->unused) {
          PTRPOP(tree->unused, l_node);
       } else if (tree->avail) {
-         l_node = --tree->l_store;
+         l_node = tree->l_store = PTRSUB(tree->l_store, L_NODESIZE(tree));
          tree->avail--;
       } else {
          l_node = alloc_node_l(tree);
@@ -872,29 +1503,46 @@ bool avl_insert(TREE *tree, void *data)
       l_node->data  = data;
       l_node->left  = NULL;
       l_node->right = NULL;
-      keytail = NULL;
-      switch (KEYTYPE(tree)) {
-      CASE CHA_KEY: l_node->key = l_key_of( (char  *)PTRADD(data, tree->keyoffs), &keytail);
-      CASE STR_KEY: l_node->key = l_key_of(*(char **)PTRADD(data, tree->keyoffs), &keytail);
-      CASE LNG_KEY: l_node->key =          *(long  *)PTRADD(data, tree->keyoffs);
-      CASE INT_KEY: l_node->key =          *(int   *)PTRADD(data, tree->keyoffs);
-      CASE SHT_KEY: l_node->key =          *(short *)PTRADD(data, tree->keyoffs);
-      CASE SCH_KEY: l_node->key =          *(SCHAR *)PTRADD(data, tree->keyoffs);
-      CASE ULN_KEY: l_node->key =  CORRECT(*(ULONG *)PTRADD(data, tree->keyoffs));
-      CASE UIN_KEY: l_node->key =  CORR_IF(*(UINT  *)PTRADD(data, tree->keyoffs), UIN_CORR);
-      CASE USH_KEY: l_node->key =  CORR_IF(*(USHORT*)PTRADD(data, tree->keyoffs), USH_CORR);
-      CASE UCH_KEY: l_node->key =  CORR_IF(*(UCHAR *)PTRADD(data, tree->keyoffs), UCH_CORR);
-      CASE FLT_KEY: l_node->key =  flt2lng(*(float *)PTRADD(data, tree->keyoffs));
-      CASE DBL_KEY: l_node->key =  dbl2lng(*(double*)PTRADD(data, tree->keyoffs));
-      DEFAULT: return false;
-      }
-      if (tree->l_root) {
-         if (insert_l(&tree->l_root, l_node, keytail, tree->keyoffs, IS_IND(tree), IS_DUP(tree)) == NOT_INS) {
+      if (IS_RANK(tree)) {
+         COUNT(l_node) = 1;
+      }
+      l_node->key   = l_key_of_data(tree, data, &keytail);
+      ins = NOT_INS;
+      l_found = NULL;
+      if (append && !tree->spine) {
+         new_spine(tree);
+      }
+      if (tree->spine) {
+         ins = append_l(tree, l_node, &l_found, keytail, append);
+      } else if (append) {
+         cmp = tree->l_last ? cmp_l(l_node->key, keytail, tree->l_last, tree->keyoffs, IS_IND(tree)) : 1;
+         if (cmp == 0 && !IS_DUP(tree)) {
+            l_found = tree->l_last;
+         }
+         descend = cmp > 0 || (cmp == 0 && IS_DUP(tree));
+      }
+      if (ins == NOT_INS && !l_found && descend) {
+         FORGET_SPINE(tree);
+         if (tree->l_root) {
+            ins = OPS_OF(tree)->insert_l(&tree->l_root, l_node, &l_found, keytail, tree->keyoffs);
+         } else {
+            tree->l_root = l_node;
+            ins = INS;
+         }
+      }
+      if (ins == NOT_INS) {
+         if (l_node == tree->l_store) {
+            tree->l_store = PTRADD(l_node, L_NODESIZE(tree));
+            tree->avail++;
+         } else {
             PTRPUSH(tree->unused, l_node);
-            return false;
          }
-      } else {
-         tree->l_root = l_node;
+         *p_found = l_found;
+         return false;
+      }
+      note_insert(tree, l_node);
+      if ( !tree->spine && tree->l_last == l_node && tree->nodes >= AVL_APPEND_MIN_NODES && !POOL_OF(tree)) {
+         new_spine(tree);
       }
    }
    tree->nodes++;
@@ -903,286 +1551,918 @@ bool avl_insert(TREE *tree, void *data)
 
 /*===========================================================================*/
 
-static X_NODE *fetch_leftmost_x(X_NODE **p_root, DEPTH *depth)
+/* Compare a key with the key of the given data of a small tree, like the insertion and removal functions do:
+ * x_key for the X trees, l_key and keytail for the L trees.
+ */
+static int small_cmp(TREE *tree, void *x_key, long l_key, char *keytail, void *data)
 {
-   X_NODE *root        = PTR_OF   (*p_root);
-   UINTPTR root_deeper = IS_DEEPER(*p_root);
-   X_NODE *node;
-
-   if (root) {
-      if (root->left) {
-         node = fetch_leftmost_x(&root->left, depth);
-         if (*depth == LESS) {
-            /* left subtree depth decreased */
-            if (IS_DEEPER(root->rightval)) {
-               *depth = rebalance_x(p_root, RIGHTUNBAL);
-            } else if (IS_DEEPER(root->leftval)) {
-               root->leftval  &= ~DEEPER;
-            } else {
-               root->rightval |=  DEEPER;
-               *depth = SAME;
-            }
-         }
-         return node;
-      } else {
-         *p_root = PTRADD(PTR_OF(root->right), root_deeper);
-         *depth = LESS;
-         return root;
-      }
-   } else {
-      *depth = SAME;
-      return NULL;
+   long  key;
+   char *datatail;
+
+   if (IS_X(tree)) {
+      return CMP(tree->usrcmp, x_key, data, CMPTYPE(tree) == X_USR_CMP ? 0 : tree->keyoffs, IS_IND(tree));
    }
+   key = l_key_of_data(tree, data, &datatail);
+   if (l_key != key) {
+      return l_key < key ? -1 : 1;
+   }
+   return keytail ? TAILCMP(keytail, data, tree->keyoffs, IS_IND(tree)) : 0;
 }
 
 /*---------------------------------------------------------------------------*/
 
-static L_NODE *fetch_leftmost_l(L_NODE **p_root, DEPTH *depth)
+/* Return the index of the first item of a small tree whose key is not less than the given one,
+ * or, if upper, greater than it (see small_cmp()). Unless p_equal is NULL, *p_equal tells whether
+ * the found item (or, if upper, the one before it) has the given key: the bisection always compares it.
+ */
+static long small_bound(TREE *tree, void *x_key, long l_key, char *keytail, bool upper, bool *p_equal)
 {
-   L_NODE *root        = PTR_OF   (*p_root);
-   UINTPTR root_deeper = IS_DEEPER(*p_root);
-   L_NODE *node;
-
-   if (root) {
-      if (root->left) {
-         node = fetch_leftmost_l(&root->left, depth);
-         if (*depth == LESS) {
-            /* left subtree depth decreased */
-            if (IS_DEEPER(root->rightval)) {
-               *depth = rebalance_l(p_root, RIGHTUNBAL);
-            } else if (IS_DEEPER(root->leftval)) {
-               root->leftval  &= ~DEEPER;
-            } else {
-               root->rightval |=  DEEPER;
-               *depth = SAME;
-            }
-         }
-         return node;
+   long lo = 0, hi = tree->nodes, mid;
+   int  cmp;
+   bool equal = false;
+
+   while (lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      cmp = small_cmp(tree, x_key, l_key, keytail, tree->small[mid]);
+      if (cmp == 0) {
+         equal = true;
+      }
+      if (cmp > 0 || (cmp == 0 && upper)) {
+         lo = mid + 1;
       } else {
-         *p_root = PTRADD(PTR_OF(root->right), root_deeper);
-         *depth = LESS;
-         return root;
+         hi = mid;
       }
+   }
+   if (p_equal) *p_equal = equal;
+   return lo;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Like small_bound(), but for a key passed by address as to avl_locate(),
+ * returning -1 if the tree has integer keys.
+ */
+static long small_index(TREE *tree, void *key, bool upper, bool *p_equal)
+{
+   long  l_key;
+   char *keytail;
+
+   if (p_equal) *p_equal = false;
+   switch (CMPTYPE(tree)) {
+   CASE X_USR_CMP:
+   case X_MBR_CMP:
+   case X_PTR_CMP:
+      return small_bound(tree, key, 0L, NULL, upper, p_equal);
+   CASE L_CHA_CMP:
+   case L_STR_CMP:
+      l_key = l_key_of(key, &keytail);
+      return small_bound(tree, NULL, l_key, keytail, upper, p_equal);
+   }
+   return -1;
+}
+
+/* Like small_bound(), but for an integer key passed as to avl_locate_long(),
+ * returning -1 if the tree does not have integer keys.
+ */
+static long small_index_long(TREE *tree, long key, bool upper, bool *p_equal)
+{
+   if (p_equal) *p_equal = false;
+   switch (CMPTYPE(tree)) {
+   CASE L_COR_CMP:
+      return small_bound(tree, NULL, CORRECT(key), NULL, upper, p_equal);
+   CASE L_VAL_CMP:
+      return small_bound(tree, NULL, key, NULL, upper, p_equal);
+   }
+   return -1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Return the item at index i of a small tree, or NULL if there is none.
+ */
+static void *small_item(TREE *tree, long i)
+{
+   return i >= 0 && i < tree->nodes ? tree->small[i] : NULL;
+}
+
+/* Return the first item of a small tree with the given key (see small_cmp()), or NULL if there is none.
+ */
+static void *small_locate(TREE *tree, void *x_key, long l_key, char *keytail)
+{
+   bool equal;
+   long i = small_bound(tree, x_key, l_key, keytail, false, &equal);
+
+   return equal ? tree->small[i] : NULL;
+}
+
+/* Remove the item at index i of a small tree, returning it, or NULL if there is none.
+ * The array is kept even when the tree becomes empty.
+ */
+static void *small_take(TREE *tree, long i)
+{
+   void *data = small_item(tree, i);
+
+   if (data) {
+      memmove(tree->small + i, tree->small + i + 1, (tree->nodes - i - 1) * SIZEOF_P);
+      tree->nodes--;
+   }
+   return data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Give the nodes to a small tree, returning false if out of memory, in which case it remains small.
+ */
+static bool small_to_nodes(TREE *tree)
+{
+   void **small = tree->small;
+   long   n     = tree->nodes;
+
+   tree->small = NULL;
+   tree->nodes = 0;
+   if ( !avl_build_sorted(tree, small, n)) {
+      tree->small = small;
+      tree->nodes = n;
+      return false;
+   }
+   TREE_FREE(tree, small);
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Insert data into a small tree, or into a tree which can become small (see CAN_BE_SMALL()),
+ * giving it the nodes first if it would hold more than AVL_SMALL_MAX items.
+ * The array is allocated once, for AVL_SMALL_MAX items, by the first insertion.
+ * If an item with the same key is found (in a tree without duplicates), its slot is stored into *p_slot,
+ * else NULL is.
+ */
+static bool small_insert(TREE *tree, void *data, bool append, void ***p_slot)
+{
+   void  *x_key = NULL, *found;
+   long   l_key = 0, i;
+   char  *keytail = NULL;
+   bool   equal;
+
+   *p_slot = NULL;
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   if (IS_X(tree)) {
+      x_key = x_key_of(tree, data);
    } else {
-      *depth = SAME;
-      return NULL;
+      l_key = l_key_of_data(tree, data, &keytail);
+   }
+   i = small_bound(tree, x_key, l_key, keytail, IS_DUP(tree), &equal);
+   if (equal && !IS_DUP(tree)) {
+      *p_slot = &tree->small[i];
+      return false;
+   }
+   if (append && i < tree->nodes) {
+      return false;
+   }
+   if (tree->nodes == AVL_SMALL_MAX) {
+      return small_to_nodes(tree) && insert_data(tree, data, &found, append);
    }
+   if ( !tree->small) {
+      tree->small = TREE_MALLOC(tree, AVL_SMALL_MAX * SIZEOF_P);
+      if ( !tree->small) return false;
+   }
+   memmove(tree->small + i + 1, tree->small + i, (tree->nodes - i) * SIZEOF_P);
+   tree->small[i] = data;
+   tree->nodes++;
+   return true;
+}
+
+/*===========================================================================*/
+
+bool avl_insert(TREE *tree, void *data)
+{
+   void **slot, *found;
+
+   if (IS_SMALL(tree) || CAN_BE_SMALL(tree)) {
+      return small_insert(tree, data, false, &slot);
+   }
+   return insert_data(tree, data, &found, false);
 }
 
 /*---------------------------------------------------------------------------*/
 
-static X_NODE *remove_x(X_NODE **p_root, void *x_key, UINT keyoffs, bool ind, CMPFUN usrcmp, bool dup, DEPTH *depth)
+bool avl_append(TREE *tree, void *data)
 {
-   X_NODE *root        = PTR_OF   (*p_root);
-   UINTPTR root_deeper = IS_DEEPER(*p_root);
-   X_NODE *node;
-   int     cmp;
+   void **slot, *found;
 
-   cmp = CMP(usrcmp, x_key, root->data, keyoffs, ind);
-   if (cmp < 0) {
-      if ( !root->left) {
-         return NULL;
+   if (IS_SMALL(tree) || CAN_BE_SMALL(tree)) {
+      return small_insert(tree, data, true, &slot);
+   }
+   return insert_data(tree, data, &found, true);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avl_insert_or_locate(TREE *tree, void *data, void **p_existing)
+{
+   void **slot, *found;
+
+   if (IS_SMALL(tree) || CAN_BE_SMALL(tree)) {
+      if (small_insert(tree, data, false, &slot)) {
+         if (p_existing) *p_existing = NULL;
+         return true;
       }
-      node = remove_x(&root->left, x_key, keyoffs, ind, usrcmp, dup, depth);
-      if (node && *depth == LESS) {
-         /* left subtree depth decreased */
-         if (IS_DEEPER(root->right)) {
-            *depth = rebalance_x(p_root, RIGHTUNBAL);
-         } else if (IS_DEEPER(root->left)) {
-            root->leftval  &= ~DEEPER;
-         } else {
-            root->rightval |=  DEEPER;
-            *depth = SAME;
-         }
+      if (p_existing) *p_existing = slot ? *slot : NULL;
+      return false;
+   }
+   if (insert_data(tree, data, &found, false)) {
+      if (p_existing) *p_existing = NULL;
+      return true;
+   }
+   if (p_existing) {
+      *p_existing = !found ? NULL : IS_X(tree) ? ((X_NODE *)found)->data : ((L_NODE *)found)->data;
+   }
+   return false;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avl_insert_or_replace(TREE *tree, void *data, void **p_replaced)
+{
+   void **slot, *found, *replaced;
+
+   if (IS_SMALL(tree) || CAN_BE_SMALL(tree)) {
+      if (small_insert(tree, data, false, &slot)) {
+         if (p_replaced) *p_replaced = NULL;
+         return true;
       }
-      return node;
-   } else if (cmp > 0) {
-      if ( !root->right) {
-         return NULL;
+      if ( !slot) {
+         return false;
       }
-      node = remove_x(&root->right, x_key, keyoffs, ind, usrcmp, dup, depth);
-      if (node && *depth == LESS) {
-         /* right subtree depth decreased */
-         if (IS_DEEPER(root->left)) {
-            *depth = rebalance_x(p_root, LEFTUNBAL);
-         } else if (IS_DEEPER(root->right)) {
-            root->rightval &= ~DEEPER;
-         } else {
-            root->leftval  |=  DEEPER;
-            *depth = SAME;
+      replaced = *slot;
+      *slot = data;
+      if (p_replaced) *p_replaced = replaced;
+      return true;
+   }
+   if (insert_data(tree, data, &found, false)) {
+      if (p_replaced) *p_replaced = NULL;
+      return true;
+   }
+   if ( !found) {
+      return false;
+   }
+   if (IS_X(tree)) {
+      replaced = ((X_NODE *)found)->data;
+      ((X_NODE *)found)->data = data;
+   } else {
+      replaced = ((L_NODE *)found)->data;
+      ((L_NODE *)found)->data = data;
+   }
+   if (p_replaced) *p_replaced = replaced;
+   return true;
+}
+
+/*===========================================================================*/
+
+static int height_of(long nodes)
+{
+   int height;
+
+   for (height = 0; nodes; nodes >>= 1) {
+      height++;
+   }
+   return height;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Link the n (> 0) sorted nodes starting at x_node_v into a perfectly balanced tree, returning its root.
+ * The right subtree gets the extra node if n - 1 is odd, so that only the right side can be deeper.
+ */
+static X_NODE *build_x(TREE *tree, X_NODE *x_node_v, long n)
+{
+   X_NODE *root;
+   long    n_left  = (n - 1) / 2;
+   long    n_right = n - 1 - n_left;
+
+   root = PTRADD(x_node_v, n_left * X_NODESIZE(tree));
+   root->left  = n_left  ? build_x(tree, x_node_v, n_left ) : NULL;
+   root->right = n_right ? build_x(tree, PTRADD(root, X_NODESIZE(tree)), n_right) : NULL;
+   if (height_of(n_right) > height_of(n_left)) {
+      root->rightval |= DEEPER;
+   }
+   if (IS_RANK(tree)) {
+      COUNT(root) = n;
+   }
+   return root;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static L_NODE *build_l(TREE *tree, L_NODE *l_node_v, long n)
+{
+   L_NODE *root;
+   long    n_left  = (n - 1) / 2;
+   long    n_right = n - 1 - n_left;
+
+   root = PTRADD(l_node_v, n_left * L_NODESIZE(tree));
+   root->left  = n_left  ? build_l(tree, l_node_v, n_left ) : NULL;
+   root->right = n_right ? build_l(tree, PTRADD(root, L_NODESIZE(tree)), n_right) : NULL;
+   if (height_of(n_right) > height_of(n_left)) {
+      root->rightval |= DEEPER;
+   }
+   if (IS_RANK(tree)) {
+      COUNT(root) = n;
+   }
+   return root;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avl_build_sorted(TREE *tree, void *data_v[], long n)
+{
+   X_NODE *x_node_v, *x_node;
+   L_NODE *l_node_v, *l_node, *l_prev;
+   void   *alloc_base;
+   char   *keytail, *prev_keytail;
+   long    i;
+   int     cmp;
+
+   if (tree->root || (IS_SMALL(tree) && tree->nodes) || n < 0 || IS_SET(tree)) {
+      return false;
+   }
+   avl_empty(tree);
+   if (n == 0) {
+      return true;
+   }
+   if (IS_X(tree)) {
+      if ((size_t)n > ((size_t)-1 - SIZEOF_P - CNT_SIZE(tree)) / X_NODESIZE(tree)) return false;
+      alloc_base = TREE_MALLOC(tree, SIZEOF_P + CNT_SIZE(tree) + n * X_NODESIZE(tree));
+      if ( !alloc_base) return false;
+      x_node_v = PTRADD(alloc_base, SIZEOF_P + CNT_SIZE(tree));
+      for (i = 0, x_node = x_node_v; i < n; i++, x_node = PTRADD(x_node, X_NODESIZE(tree))) {
+         x_node->data = data_v[i];
+         if (i > 0) {
+            cmp = CMP(tree->usrcmp, x_key_of(tree, data_v[i - 1]), data_v[i], tree->keyoffs, IS_IND(tree));
+            if (cmp > 0 || (cmp == 0 && !IS_DUP(tree))) {
+               TREE_FREE(tree, alloc_base);
+               return false;
+            }
          }
       }
-      return node;
+      tree->x_root  = build_x(tree, x_node_v, n);
+      tree->x_store = x_node_v;
+      tree->x_first = x_node_v;
+      tree->x_last  = PTRADD(x_node_v, (n - 1) * X_NODESIZE(tree));
    } else {
-      if (dup && root->left && (node = remove_x(&root->left, x_key, keyoffs, ind, usrcmp, dup, depth))) {
-         if (*depth == LESS) {
-            /* left subtree depth decreased */
-            if (IS_DEEPER(root->right)) {
-               *depth = rebalance_x(p_root, RIGHTUNBAL);
-            } else if (IS_DEEPER(root->left)) {
-               root->leftval  &= ~DEEPER;
+      if ((size_t)n > ((size_t)-1 - SIZEOF_P_L - CNT_SIZE(tree)) / L_NODESIZE(tree)) return false;
+      alloc_base = TREE_MALLOC(tree, SIZEOF_P_L + CNT_SIZE(tree) + n * L_NODESIZE(tree));
+      if ( !alloc_base) return false;
+      l_node_v = PTRADD(alloc_base, SIZEOF_P_L + CNT_SIZE(tree));
+      prev_keytail = NULL;
+      for (i = 0, l_node = l_node_v, l_prev = NULL; i < n; i++, l_prev = l_node, l_node = PTRADD(l_node, L_NODESIZE(tree))) {
+         l_node->data = data_v[i];
+         l_node->key  = l_key_of_data(tree, data_v[i], &keytail);
+         if (l_prev) {
+            if (l_prev->key != l_node->key) {
+               cmp = l_prev->key > l_node->key ? 1 : -1;
+            } else if (prev_keytail) {
+               cmp = TAILCMP(prev_keytail, data_v[i], tree->keyoffs, IS_IND(tree));
             } else {
-               root->rightval |=  DEEPER;
-               *depth = SAME;
+               cmp = 0;
             }
-         }
-      } else {
-         node = root;
-         if ( !node->right) {
-            *p_root = PTRADD(PTR_OF(node->left), root_deeper);
-            *depth = LESS;
-         } else if ( !node->left) {
-            *p_root = PTRADD(PTR_OF(node->right), root_deeper);
-            *depth = LESS;
-         } else {
-            /* replace by the leftmost node of the right subtree */
-            root = fetch_leftmost_x(&node->right, depth);
-            root->left  = node->left;
-            root->right = node->right;
-            if (*depth == LESS) {
-               /* right subtree depth decreased */
-               if (IS_DEEPER(root->left)) {
-                  *depth = rebalance_x(&root, LEFTUNBAL);
-               } else if (IS_DEEPER(root->right)) {
-                  root->rightval &= ~DEEPER;
-               } else {
-                  root->leftval  |=  DEEPER;
-                  *depth = SAME;
-               }
-            } else {
-               *depth = SAME;
+            if (cmp > 0 || (cmp == 0 && !IS_DUP(tree))) {
+               TREE_FREE(tree, alloc_base);
+               return false;
             }
-            *p_root = PTRADD(root, root_deeper);
          }
+         prev_keytail = keytail;
       }
-      return node;
+      tree->l_root  = build_l(tree, l_node_v, n);
+      tree->l_store = l_node_v;
+      tree->l_first = l_node_v;
+      tree->l_last  = PTRADD(l_node_v, (n - 1) * L_NODESIZE(tree));
    }
+   *(void **)alloc_base = NULL;
+   tree->nodes = n;
+   tree->alloc = n;
+   tree->avail = 0;
+   return true;
 }
 
-/*---------------------------------------------------------------------------*/
+/*===========================================================================*/
 
-static L_NODE *remove_l(L_NODE **p_root, long l_key, char *keytail, UINT keyoffs, bool ind, bool dup, DEPTH *depth)
+static X_NODE *fetch_leftmost_x(X_NODE **p_root, bool cnt, DEPTH *depth, X_NODE **p_next)
 {
-   L_NODE *root        = PTR_OF   (*p_root);
-   UINTPTR root_deeper = IS_DEEPER(*p_root);
-   L_NODE *node;
+   X_NODE **p_link_v[MAX_PATHDEPTH + 1];
+   X_NODE **p_link = p_root;
+   X_NODE  *root, *node;
+   int      n = 0;
 
-   if (l_key < root->key) {
-      remove_lt:
-      if ( !root->left) {
-         return NULL;
+   node = PTR_OF(*p_link);
+   if ( !node) {
+      *depth = SAME;
+      return NULL;
+   }
+   while (node->left) {
+      p_link_v[n++] = p_link;
+      p_link = &node->left;
+      node = PTR_OF(*p_link);
+   }
+   if (p_next) {
+      *p_next = node->right ? PTR_OF(node->right) : n > 0 ? PTR_OF(*p_link_v[n - 1]) : NULL;
+   }
+   *p_link = PTRADD(PTR_OF(node->right), IS_DEEPER(*p_link));
+   *depth = LESS;
+   while (n > 0) {
+      p_link = p_link_v[--n];
+      root = PTR_OF(*p_link);
+      if (cnt) {
+         COUNT(root)--;
       }
-      node = remove_l(&root->left, l_key, keytail, keyoffs, ind, dup, depth);
-      if (node && *depth == LESS) {
+      if (*depth == SAME) {
+         if ( !cnt) break;
+      } else {
          /* left subtree depth decreased */
-         if (IS_DEEPER(root->right)) {
-            *depth = rebalance_l(p_root, RIGHTUNBAL);
-         } else if (IS_DEEPER(root->left)) {
+         if (IS_DEEPER(root->rightval)) {
+            *depth = rebalance_x(p_link, RIGHTUNBAL, cnt);
+         } else if (IS_DEEPER(root->leftval)) {
             root->leftval  &= ~DEEPER;
          } else {
             root->rightval |=  DEEPER;
             *depth = SAME;
          }
       }
-      return node;
-   } else if (l_key > root->key) {
-      remove_gt:
-      if ( !root->right) {
-         return NULL;
+   }
+   return node;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static X_NODE *fetch_rightmost_x(X_NODE **p_root, bool cnt, DEPTH *depth, X_NODE **p_prev)
+{
+   X_NODE **p_link_v[MAX_PATHDEPTH + 1];
+   X_NODE **p_link = p_root;
+   X_NODE  *root, *node;
+   int      n = 0;
+
+   node = PTR_OF(*p_link);
+   if ( !node) {
+      *depth = SAME;
+      return NULL;
+   }
+   while (node->right) {
+      p_link_v[n++] = p_link;
+      p_link = &node->right;
+      node = PTR_OF(*p_link);
+   }
+   if (p_prev) {
+      *p_prev = node->left ? PTR_OF(node->left) : n > 0 ? PTR_OF(*p_link_v[n - 1]) : NULL;
+   }
+   *p_link = PTRADD(PTR_OF(node->left), IS_DEEPER(*p_link));
+   *depth = LESS;
+   while (n > 0) {
+      p_link = p_link_v[--n];
+      root = PTR_OF(*p_link);
+      if (cnt) {
+         COUNT(root)--;
       }
-      node = remove_l(&root->right, l_key, keytail, keyoffs, ind, dup, depth);
-      if (node && *depth == LESS) {
+      if (*depth == SAME) {
+         if ( !cnt) break;
+      } else {
          /* right subtree depth decreased */
-         if (IS_DEEPER(root->left)) {
-            *depth = rebalance_l(p_root, LEFTUNBAL);
-         } else if (IS_DEEPER(root->right)) {
+         if (IS_DEEPER(root->leftval)) {
+            *depth = rebalance_x(p_link, LEFTUNBAL, cnt);
+         } else if (IS_DEEPER(root->rightval)) {
             root->rightval &= ~DEEPER;
          } else {
             root->leftval  |=  DEEPER;
             *depth = SAME;
          }
       }
-      return node;
-   } else if ( !keytail) {
-      remove_eq:
-      if (dup && root->left && (node = remove_l(&root->left, l_key, keytail, keyoffs, ind, dup, depth))) {
-         if (*depth == LESS) {
-            /* left subtree depth decreased */
-            if (IS_DEEPER(root->right)) {
-               *depth = rebalance_l(p_root, RIGHTUNBAL);
-            } else if (IS_DEEPER(root->left)) {
-               root->leftval  &= ~DEEPER;
-            } else {
-               root->rightval |=  DEEPER;
-               *depth = SAME;
-            }
-         }
+   }
+   return node;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static L_NODE *fetch_leftmost_l(L_NODE **p_root, bool cnt, DEPTH *depth, L_NODE **p_next)
+{
+   L_NODE **p_link_v[MAX_PATHDEPTH + 1];
+   L_NODE **p_link = p_root;
+   L_NODE  *root, *node;
+   int      n = 0;
+
+   node = PTR_OF(*p_link);
+   if ( !node) {
+      *depth = SAME;
+      return NULL;
+   }
+   while (node->left) {
+      p_link_v[n++] = p_link;
+      p_link = &node->left;
+      node = PTR_OF(*p_link);
+   }
+   if (p_next) {
+      *p_next = node->right ? PTR_OF(node->right) : n > 0 ? PTR_OF(*p_link_v[n - 1]) : NULL;
+   }
+   *p_link = PTRADD(PTR_OF(node->right), IS_DEEPER(*p_link));
+   *depth = LESS;
+   while (n > 0) {
+      p_link = p_link_v[--n];
+      root = PTR_OF(*p_link);
+      if (cnt) {
+         COUNT(root)--;
+      }
+      if (*depth == SAME) {
+         if ( !cnt) break;
       } else {
-         node = root;
-         if ( !node->right) {
-            *p_root = PTRADD(PTR_OF(node->left), root_deeper);
-            *depth = LESS;
-         } else if ( !node->left) {
-            *p_root = PTRADD(PTR_OF(node->right), root_deeper);
-            *depth = LESS;
+         /* left subtree depth decreased */
+         if (IS_DEEPER(root->rightval)) {
+            *depth = rebalance_l(p_link, RIGHTUNBAL, cnt);
+         } else if (IS_DEEPER(root->leftval)) {
+            root->leftval  &= ~DEEPER;
          } else {
-            /* replace by the leftmost node of the right subtree */
-            root = fetch_leftmost_l(&node->right, depth);
-            root->left  = node->left;
-            root->right = node->right;
-            if (*depth == LESS) {
-               /* right subtree depth decreased */
-               if (IS_DEEPER(root->left)) {
-                  *depth = rebalance_l(&root, LEFTUNBAL);
-               } else if (IS_DEEPER(root->right)) {
-                  root->rightval &= ~DEEPER;
-               } else {
-                  root->leftval  |=  DEEPER;
-                  *depth = SAME;
-               }
-            } else {
-               *depth = SAME;
-            }
-            *p_root = PTRADD(root, root_deeper);
+            root->rightval |=  DEEPER;
+            *depth = SAME;
          }
       }
-      return node;
-   } else {
-      int cmp = TAILCMP(keytail, root->data, keyoffs, ind);
-      if (cmp < 0) {
-         goto remove_lt;
-      } else if (cmp > 0) {
-         goto remove_gt;
-      } else {
-         goto remove_eq;
-      }
    }
+   return node;
 }
 
 /*---------------------------------------------------------------------------*/
 
-void *avl_remove(TREE *tree, void *key)
+static L_NODE *fetch_rightmost_l(L_NODE **p_root, bool cnt, DEPTH *depth, L_NODE **p_prev)
 {
-   X_NODE *x_node = NULL;
-   L_NODE *l_node = NULL;
-   long    l_key;
+   L_NODE **p_link_v[MAX_PATHDEPTH + 1];
+   L_NODE **p_link = p_root;
+   L_NODE  *root, *node;
+   int      n = 0;
+
+   node = PTR_OF(*p_link);
+   if ( !node) {
+      *depth = SAME;
+      return NULL;
+   }
+   while (node->right) {
+      p_link_v[n++] = p_link;
+      p_link = &node->right;
+      node = PTR_OF(*p_link);
+   }
+   if (p_prev) {
+      *p_prev = node->left ? PTR_OF(node->left) : n > 0 ? PTR_OF(*p_link_v[n - 1]) : NULL;
+   }
+   *p_link = PTRADD(PTR_OF(node->left), IS_DEEPER(*p_link));
+   *depth = LESS;
+   while (n > 0) {
+      p_link = p_link_v[--n];
+      root = PTR_OF(*p_link);
+      if (cnt) {
+         COUNT(root)--;
+      }
+      if (*depth == SAME) {
+         if ( !cnt) break;
+      } else {
+         /* right subtree depth decreased */
+         if (IS_DEEPER(root->leftval)) {
+            *depth = rebalance_l(p_link, LEFTUNBAL, cnt);
+         } else if (IS_DEEPER(root->rightval)) {
+            root->rightval &= ~DEEPER;
+         } else {
+            root->leftval  |=  DEEPER;
+            *depth = SAME;
+         }
+      }
+   }
+   return node;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Unlink the node at the end of the given path, i.e., the one p_link_v[n] points to (see insert_at_x()),
+ * and return it. The links of the path beyond n are overwritten.
+ */
+static ALWAYS_INLINE X_NODE *remove_at_x(X_NODE **p_link_v[], char right_v[], int n, bool cnt, DEPTH *depth)
+{
+   X_NODE **p_link, **p_found_link = p_link_v[n];
+   X_NODE  *root, *node, *leftmost;
+   UINTPTR  root_deeper;
+   int      n_found = n;
+
+   node        = PTR_OF   (*p_found_link);
+   root_deeper = IS_DEEPER(*p_found_link);
+   if ( !node->right) {
+      *p_found_link = PTRADD(PTR_OF(node->left), root_deeper);
+   } else if ( !node->left) {
+      *p_found_link = PTRADD(PTR_OF(node->right), root_deeper);
+   } else {
+      /* replace by the leftmost node of the right subtree */
+      p_link_v[n] = p_found_link;
+      right_v[n++] = true;
+      p_link = &node->right;
+      leftmost = PTR_OF(*p_link);
+      while (leftmost->left) {
+         p_link_v[n] = p_link;
+         right_v[n++] = false;
+         p_link = &leftmost->left;
+         leftmost = PTR_OF(*p_link);
+      }
+      *p_link = PTRADD(PTR_OF(leftmost->right), IS_DEEPER(*p_link));
+      leftmost->left  = node->left;
+      leftmost->right = node->right;
+      if (cnt) {
+         COUNT(leftmost) = COUNT(node);
+      }
+      *p_found_link = PTRADD(leftmost, root_deeper);
+      if (n > n_found + 1) {
+         /* the link to the right subtree has moved from node to leftmost */
+         p_link_v[n_found + 1] = &leftmost->right;
+      }
+   }
+   *depth = LESS;
+   while (n > 0) {
+      p_link = p_link_v[--n];
+      root = PTR_OF(*p_link);
+      if (cnt) {
+         COUNT(root)--;
+      }
+      if (*depth == SAME) {
+         if ( !cnt) break;
+      } else if ( !right_v[n]) {
+         /* left subtree depth decreased */
+         if (IS_DEEPER(root->right)) {
+            *depth = rebalance_x(p_link, RIGHTUNBAL, cnt);
+         } else if (IS_DEEPER(root->left)) {
+            root->leftval  &= ~DEEPER;
+         } else {
+            root->rightval |=  DEEPER;
+            *depth = SAME;
+         }
+      } else {
+         /* right subtree depth decreased */
+         if (IS_DEEPER(root->left)) {
+            *depth = rebalance_x(p_link, LEFTUNBAL, cnt);
+         } else if (IS_DEEPER(root->right)) {
+            root->rightval &= ~DEEPER;
+         } else {
+            root->leftval  |=  DEEPER;
+            *depth = SAME;
+         }
+      }
+   }
+   return node;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Remove the node with the given key (the leftmost one, in dup trees) from the tree of the given root.
+ * Like insert_x(), this is iterative, with the followed links kept on a stack.
+ */
+static ALWAYS_INLINE X_NODE *remove_x(X_NODE **p_root, void *x_key, UINT keyoffs, bool ind, CMPFUN usrcmp, bool dup, bool cnt, DEPTH *depth)
+{
+   X_NODE **p_link_v[MAX_PATHDEPTH + 1];
+   char     right_v [MAX_PATHDEPTH + 1];
+   X_NODE **p_link = p_root;
+   X_NODE  *root;
+   int      n = 0, n_found = -1;
+   int      cmp;
+
+   while ((root = PTR_OF(*p_link))) {
+      p_link_v[n] = p_link;
+      cmp = CMP(usrcmp, x_key, root->data, keyoffs, ind);
+      if (cmp == 0) {
+         n_found = n;
+         if ( !dup) break;
+      }
+      right_v[n++] = cmp > 0;
+      p_link = cmp > 0 ? &root->right : &root->left;
+   }
+   if (n_found < 0) {
+      *depth = SAME;
+      return NULL;
+   }
+   return remove_at_x(p_link_v, right_v, n_found, cnt, depth);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Like remove_at_x().
+ */
+static ALWAYS_INLINE L_NODE *remove_at_l(L_NODE **p_link_v[], char right_v[], int n, bool cnt, DEPTH *depth)
+{
+   L_NODE **p_link, **p_found_link = p_link_v[n];
+   L_NODE  *root, *node, *leftmost;
+   UINTPTR  root_deeper;
+   int      n_found = n;
+
+   node        = PTR_OF   (*p_found_link);
+   root_deeper = IS_DEEPER(*p_found_link);
+   if ( !node->right) {
+      *p_found_link = PTRADD(PTR_OF(node->left), root_deeper);
+   } else if ( !node->left) {
+      *p_found_link = PTRADD(PTR_OF(node->right), root_deeper);
+   } else {
+      /* replace by the leftmost node of the right subtree */
+      p_link_v[n] = p_found_link;
+      right_v[n++] = true;
+      p_link = &node->right;
+      leftmost = PTR_OF(*p_link);
+      while (leftmost->left) {
+         p_link_v[n] = p_link;
+         right_v[n++] = false;
+         p_link = &leftmost->left;
+         leftmost = PTR_OF(*p_link);
+      }
+      *p_link = PTRADD(PTR_OF(leftmost->right), IS_DEEPER(*p_link));
+      leftmost->left  = node->left;
+      leftmost->right = node->right;
+      if (cnt) {
+         COUNT(leftmost) = COUNT(node);
+      }
+      *p_found_link = PTRADD(leftmost, root_deeper);
+      if (n > n_found + 1) {
+         /* the link to the right subtree has moved from node to leftmost */
+         p_link_v[n_found + 1] = &leftmost->right;
+      }
+   }
+   *depth = LESS;
+   while (n > 0) {
+      p_link = p_link_v[--n];
+      root = PTR_OF(*p_link);
+      if (cnt) {
+         COUNT(root)--;
+      }
+      if (*depth == SAME) {
+         if ( !cnt) break;
+      } else if ( !right_v[n]) {
+         /* left subtree depth decreased */
+         if (IS_DEEPER(root->right)) {
+            *depth = rebalance_l(p_link, RIGHTUNBAL, cnt);
+         } else if (IS_DEEPER(root->left)) {
+            root->leftval  &= ~DEEPER;
+         } else {
+            root->rightval |=  DEEPER;
+            *depth = SAME;
+         }
+      } else {
+         /* right subtree depth decreased */
+         if (IS_DEEPER(root->left)) {
+            *depth = rebalance_l(p_link, LEFTUNBAL, cnt);
+         } else if (IS_DEEPER(root->right)) {
+            root->rightval &= ~DEEPER;
+         } else {
+            root->leftval  |=  DEEPER;
+            *depth = SAME;
+         }
+      }
+   }
+   return node;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Like remove_x().
+ */
+static ALWAYS_INLINE L_NODE *remove_l(L_NODE **p_root, long l_key, char *keytail, UINT keyoffs, bool ind, bool dup, bool cnt, DEPTH *depth)
+{
+   L_NODE **p_link_v[MAX_PATHDEPTH + 1];
+   char     right_v [MAX_PATHDEPTH + 1];
+   L_NODE **p_link = p_root;
+   L_NODE  *root;
+   int      n = 0, n_found = -1;
+   int      cmp;
+
+   while ((root = PTR_OF(*p_link))) {
+      p_link_v[n] = p_link;
+      if      (l_key < root->key) cmp = -1;
+      else if (l_key > root->key) cmp =  1;
+      else if (keytail)           cmp = TAILCMP(keytail, root->data, keyoffs, ind);
+      else                        cmp =  0;
+      if (cmp == 0) {
+         n_found = n;
+         if ( !dup) break;
+      }
+      right_v[n++] = cmp > 0;
+      p_link = cmp > 0 ? &root->right : &root->left;
+   }
+   if (n_found < 0) {
+      *depth = SAME;
+      return NULL;
+   }
+   return remove_at_l(p_link_v, right_v, n_found, cnt, depth);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Specialized instances of insert_x/l() and remove_x/l(). In VAL (and COR) trees there is never a keytail. */
+#define X_OPS(name, ind, dup, cnt) \
+static INS_T insert_##name(X_NODE **p_root, X_NODE *node, X_NODE **p_found, void *x_key, UINT keyoffs, CMPFUN usrcmp) \
+{ \
+   return insert_x(p_root, node, p_found, x_key, keyoffs, ind, usrcmp, dup, cnt); \
+} \
+static X_NODE *remove_##name(X_NODE **p_root, void *x_key, UINT keyoffs, CMPFUN usrcmp, DEPTH *depth) \
+{ \
+   return remove_x(p_root, x_key, keyoffs, ind, usrcmp, dup, cnt, depth); \
+}
+#define L_OPS(name, tail, ind, dup, cnt) \
+static INS_T insert_##name(L_NODE **p_root, L_NODE *node, L_NODE **p_found, char *keytail, UINT keyoffs) \
+{ \
+   return insert_l(p_root, node, p_found, (tail) ? keytail : NULL, keyoffs, ind, dup, cnt); \
+} \
+static L_NODE *remove_##name(L_NODE **p_root, long l_key, char *keytail, UINT keyoffs, DEPTH *depth) \
+{ \
+   return remove_l(p_root, l_key, (tail) ? keytail : NULL, keyoffs, ind, dup, cnt, depth); \
+}
+
+X_OPS(x_nodup,          false, false, false)
+X_OPS(x_dup,            false, true,  false)
+X_OPS(x_ind_nodup,      true,  false, false)
+X_OPS(x_ind_dup,        true,  true,  false)
+X_OPS(x_nodup_cnt,      false, false, true )
+X_OPS(x_dup_cnt,        false, true,  true )
+X_OPS(x_ind_nodup_cnt,  true,  false, true )
+X_OPS(x_ind_dup_cnt,    true,  true,  true )
+L_OPS(l_cha_nodup,      true,  false, false, false)
+L_OPS(l_cha_dup,        true,  false, true,  false)
+L_OPS(l_str_nodup,      true,  true,  false, false)
+L_OPS(l_str_dup,        true,  true,  true,  false)
+L_OPS(l_val_nodup,      false, false, false, false)
+L_OPS(l_val_dup,        false, false, true,  false)
+L_OPS(l_cha_nodup_cnt,  true,  false, false, true )
+L_OPS(l_cha_dup_cnt,    true,  false, true,  true )
+L_OPS(l_str_nodup_cnt,  true,  true,  false, true )
+L_OPS(l_str_dup_cnt,    true,  true,  true,  true )
+L_OPS(l_val_nodup_cnt,  false, false, false, true )
+L_OPS(l_val_dup_cnt,    false, false, true,  true )
+
+#define X_OPS_OF(name) { insert_##name, NULL, remove_##name, NULL }
+#define L_OPS_OF(name) { NULL, insert_##name, NULL, remove_##name }
+
+/* indexed by IS_RANK(tree) != 0 and tree->bits */
+static const OPS ops_v[2][X_BIT << 1] = {
+   {
+      [X_USR_NODUP] = X_OPS_OF(x_nodup),
+      [X_MBR_NODUP] = X_OPS_OF(x_nodup),
+      [X_PTR_NODUP] = X_OPS_OF(x_ind_nodup),
+      [L_CHA_NODUP] = L_OPS_OF(l_cha_nodup),
+      [L_STR_NODUP] = L_OPS_OF(l_str_nodup),
+      [L_VAL_NODUP] = L_OPS_OF(l_val_nodup),
+      [L_COR_NODUP] = L_OPS_OF(l_val_nodup),
+      [X_USR_DUP  ] = X_OPS_OF(x_dup),
+      [X_MBR_DUP  ] = X_OPS_OF(x_dup),
+      [X_PTR_DUP  ] = X_OPS_OF(x_ind_dup),
+      [L_CHA_DUP  ] = L_OPS_OF(l_cha_dup),
+      [L_STR_DUP  ] = L_OPS_OF(l_str_dup),
+      [L_VAL_DUP  ] = L_OPS_OF(l_val_dup),
+      [L_COR_DUP  ] = L_OPS_OF(l_val_dup),
+   }, {
+      [X_USR_NODUP] = X_OPS_OF(x_nodup_cnt),
+      [X_MBR_NODUP] = X_OPS_OF(x_nodup_cnt),
+      [X_PTR_NODUP] = X_OPS_OF(x_ind_nodup_cnt),
+      [L_CHA_NODUP] = L_OPS_OF(l_cha_nodup_cnt),
+      [L_STR_NODUP] = L_OPS_OF(l_str_nodup_cnt),
+      [L_VAL_NODUP] = L_OPS_OF(l_val_nodup_cnt),
+      [L_COR_NODUP] = L_OPS_OF(l_val_nodup_cnt),
+      [X_USR_DUP  ] = X_OPS_OF(x_dup_cnt),
+      [X_MBR_DUP  ] = X_OPS_OF(x_dup_cnt),
+      [X_PTR_DUP  ] = X_OPS_OF(x_ind_dup_cnt),
+      [L_CHA_DUP  ] = L_OPS_OF(l_cha_dup_cnt),
+      [L_STR_DUP  ] = L_OPS_OF(l_str_dup_cnt),
+      [L_VAL_DUP  ] = L_OPS_OF(l_val_dup_cnt),
+      [L_COR_DUP  ] = L_OPS_OF(l_val_dup_cnt),
+   }
+};
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_remove(TREE *tree, void *key)
+{
+   X_NODE *x_node = NULL;
+   L_NODE *l_node = NULL;
+   long    l_key, i;
    char   *keytail;
    void   *data;
    DEPTH   depth;
+   bool    equal;
 
    if (tree->path) {
-      AVL_FREE_AND_NULL(tree->path);
+      TREE_FREE_AND_NULL(tree, tree->path);
    }
-   if (tree->root) {
+   FORGET_SPINE(tree);
+   if (IS_SMALL(tree)) {
+      i = small_index(tree, key, false, &equal);
+      return equal ? small_take(tree, i) : NULL;
+   }
+   if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) {
-         x_node = remove_x(&tree->x_root, key, tree->keyoffs, IS_IND(tree), tree->usrcmp, IS_DUP(tree), &depth);
+         x_node = OPS_OF(tree)->remove_x(&tree->x_root, key, tree->keyoffs, tree->usrcmp, &depth);
          if ( !x_node) return NULL;
+         note_remove(tree, x_node);
          data = x_node->data;
          PTRPUSH(tree->unused, x_node);
       } else {
          l_key = l_key_of(key, &keytail);
-         l_node = remove_l(&tree->l_root, l_key, keytail, tree->keyoffs, IS_IND(tree), IS_DUP(tree), &depth);
+         l_node = OPS_OF(tree)->remove_l(&tree->l_root, l_key, keytail, tree->keyoffs, &depth);
          if ( !l_node) return NULL;
+         note_remove(tree, l_node);
          data = l_node->data;
          PTRPUSH(tree->unused, l_node);
       }
@@ -1203,20 +2483,28 @@ void *avl_remove_long(TREE *tree, long key)
 {
    L_NODE *l_node;
    void   *data;
+   long    i;
    DEPTH   depth;
+   bool    equal;
 
    if (tree->path) {
-      AVL_FREE_AND_NULL(tree->path);
+      TREE_FREE_AND_NULL(tree, tree->path);
    }
-   if (tree->root) {
+   FORGET_SPINE(tree);
+   if (IS_SMALL(tree)) {
+      i = small_index_long(tree, key, false, &equal);
+      return equal ? small_take(tree, i) : NULL;
+   }
+   if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) {
          return NULL;
       }
       if (IS_CORR(tree)) {
          key = CORRECT(key);
       }
-      l_node = remove_l(&tree->l_root, key, NULL, tree->keyoffs, IS_IND(tree), IS_DUP(tree), &depth);
+      l_node = OPS_OF(tree)->remove_l(&tree->l_root, key, NULL, tree->keyoffs, &depth);
       if ( !l_node) return NULL;
+      note_remove(tree, l_node);
       data = l_node->data;
       PTRPUSH(tree->unused, l_node);
       tree->nodes--;
@@ -1247,6 +2535,143 @@ void *avl_remove_double(TREE *tree, double key)
    else            return avl_remove_long(tree, dbl2lng(key));
 }
 
+/*---------------------------------------------------------------------------*/
+
+void *avl_pop_first(TREE *tree)
+{
+   X_NODE *x_node, *x_next;
+   L_NODE *l_node, *l_next;
+   void   *data;
+   DEPTH   depth;
+
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if (IS_SMALL(tree)) {
+      return small_take(tree, 0);
+   }
+   if ( !tree->root || IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_X(tree)) {
+      x_node = fetch_leftmost_x(&tree->x_root, IS_RANK(tree), &depth, &x_next);
+      tree->x_first = x_next;
+      data = x_node->data;
+      PTRPUSH(tree->unused, x_node);
+   } else {
+      l_node = fetch_leftmost_l(&tree->l_root, IS_RANK(tree), &depth, &l_next);
+      tree->l_first = l_next;
+      data = l_node->data;
+      PTRPUSH(tree->unused, l_node);
+   }
+   if ( !tree->first) {
+      tree->last = NULL;
+   }
+   tree->nodes--;
+   return data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_pop_last(TREE *tree)
+{
+   X_NODE *x_node, *x_prev;
+   L_NODE *l_node, *l_prev;
+   void   *data;
+   DEPTH   depth;
+
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if (IS_SMALL(tree)) {
+      return small_take(tree, tree->nodes - 1);
+   }
+   if ( !tree->root || IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_X(tree)) {
+      x_node = fetch_rightmost_x(&tree->x_root, IS_RANK(tree), &depth, &x_prev);
+      tree->x_last = x_prev;
+      data = x_node->data;
+      PTRPUSH(tree->unused, x_node);
+   } else {
+      l_node = fetch_rightmost_l(&tree->l_root, IS_RANK(tree), &depth, &l_prev);
+      tree->l_last = l_prev;
+      data = l_node->data;
+      PTRPUSH(tree->unused, l_node);
+   }
+   if ( !tree->last) {
+      tree->first = NULL;
+   }
+   tree->nodes--;
+   return data;
+}
+
+/*===========================================================================*/
+
+bool avl_path_insert(TREE *tree, AVL_PATH *path, void *data)
+{
+   X_NODE *x_node;
+
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if (IS_FULL(tree) || !IS_X(tree) || IS_SMALL(tree)) {
+      return false; /* the path of a small tree would lead to its nodes, which it has not got (see AVL_NOSMALL) */
+   }
+   if (tree->unused) {
+      PTRPOP(tree->unused, x_node);
+   } else if (tree->avail) {
+      x_node = tree->x_store = PTRSUB(tree->x_store, X_NODESIZE(tree));
+      tree->avail--;
+   } else {
+      x_node = alloc_node_x(tree);
+      if ( !x_node) return false;
+   }
+   x_node->data  = data;
+   x_node->left  = NULL;
+   x_node->right = NULL;
+   if (IS_RANK(tree)) {
+      COUNT(x_node) = 1;
+      insert_at_x((X_NODE ***)path->link, path->right, path->n, x_node, true,  NULL);
+   } else {
+      insert_at_x((X_NODE ***)path->link, path->right, path->n, x_node, false, NULL);
+   }
+   note_insert(tree, x_node);
+   tree->nodes++;
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_path_remove(TREE *tree, AVL_PATH *path)
+{
+   X_NODE *x_node;
+   void   *data;
+   DEPTH   depth;
+
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if ( !IS_X(tree) || IS_SMALL(tree)) {
+      return NULL;
+   }
+   if (IS_RANK(tree)) {
+      x_node = remove_at_x((X_NODE ***)path->link, path->right, path->n, true,  &depth);
+   } else {
+      x_node = remove_at_x((X_NODE ***)path->link, path->right, path->n, false, &depth);
+   }
+   note_remove(tree, x_node);
+   data = x_node->data;
+   PTRPUSH(tree->unused, x_node);
+   tree->nodes--;
+   return data;
+}
+
 /*===========================================================================*/
 
 #define CONTINUE_LEFT( node)       ((node) = PTR_OF((node)->left))
@@ -1261,9 +2686,17 @@ void *avl_locate(TREE *tree, void *key)
    X_NODE *x_node, *x_save;
    L_NODE *l_node, *l_save;
    int     cmp;
-   long    l_key;
+   long    l_key, i;
    char   *keytail;
+   bool    equal;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      i = small_index(tree, key, false, &equal);
+      return equal ? tree->small[i] : NULL;
+   }
    switch (tree->bits) {
    CASE X_USR_NODUP:
       for (x_node = tree->x_root; x_node; ) {
@@ -1374,7 +2807,16 @@ void *avl_locate_str  (TREE *tree, char *key) { return avl_locate(tree, key); }
 void *avl_locate_long(TREE *tree, long key)
 {
    L_NODE *l_node, *l_save;
+   long    i;
+   bool    equal;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      i = small_index_long(tree, key, false, &equal);
+      return equal ? tree->small[i] : NULL;
+   }
    switch (tree->bits) {
    CASE L_COR_NODUP:
       key = CORRECT(key);
@@ -1421,56 +2863,605 @@ void *avl_locate_double(TREE *tree, double key)
 
 /*---------------------------------------------------------------------------*/
 
-void *avl_locate_ge(TREE *tree, void *key)
+/* The avl_locate_many*() functions locate up to AVL_LOCATE_MANY_WAYS keys at a time, by descending the tree
+ * one level at a time for all of them, in lockstep, and prefetching the next node of each descent,
+ * so that the cache misses of the descents overlap instead of adding up. The X trees compare the keys
+ * of the data, not of the nodes: once the nodes have arrived, the data of all of them are prefetched
+ * before the first comparison of the level. The L trees only read the data to compare keytails.
+ * Every locate_many_*() function returns the number of keys found.
+ */
+static long locate_many_x(TREE *tree, void **key_v, int n, void **results)
 {
-   X_NODE *x_node, *x_save;
-   L_NODE *l_node, *l_save;
-   int     cmp;
-   long    l_key;
-   char   *keytail;
-
-   switch (tree->bits) {
-   CASE X_USR_NODUP:
-      for (x_node = tree->x_root, x_save = NULL; x_node; ) {
-         cmp = CMP(tree->usrcmp, key, x_node->data, 0, false);
-         if      (cmp < 0) SAVE_AND_LEFT (x_node, x_save);
-         else if (cmp > 0) CONTINUE_RIGHT(x_node);
-         else              return x_node->data;
+   X_NODE *node_v[AVL_LOCATE_MANY_WAYS], *save_v[AVL_LOCATE_MANY_WAYS], *x_node;
+   UINT    keyoffs = CMPTYPE(tree) == X_USR_CMP ? 0 : tree->keyoffs;
+   bool    ind = IS_IND(tree), dup = IS_DUP(tree);
+   int     cmp, i, active;
+   long    found = 0;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < n; i++) {
+         results[i] = small_locate(tree, key_v[i], 0L, NULL);
+         found += results[i] != NULL;
       }
-      if (x_save) return x_save->data;
-   CASE X_MBR_NODUP:
-      for (x_node = tree->x_root, x_save = NULL; x_node; ) {
-         cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, false);
-         if      (cmp < 0) SAVE_AND_LEFT (x_node, x_save);
-         else if (cmp > 0) CONTINUE_RIGHT(x_node);
-         else              return x_node->data;
+      return found;
+   }
+   for (i = 0; i < n; i++) {
+      node_v[i] = tree->x_root;
+      save_v[i] = NULL;
+   }
+   for (active = tree->x_root ? n : 0; active; ) {
+      for (i = 0; i < n; i++) {
+         if (node_v[i]) PREFETCH(PTRADD(node_v[i]->data, keyoffs));
       }
-      if (x_save) return x_save->data;
-   CASE X_PTR_NODUP:
-      for (x_node = tree->x_root, x_save = NULL; x_node; ) {
-         cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, true);
-         if      (cmp < 0) SAVE_AND_LEFT (x_node, x_save);
+      active = 0;
+      for (i = 0; i < n; i++) {
+         x_node = node_v[i];
+         if ( !x_node) continue;
+         cmp = CMP(tree->usrcmp, key_v[i], x_node->data, keyoffs, ind);
+         if      (cmp < 0) CONTINUE_LEFT (x_node);
          else if (cmp > 0) CONTINUE_RIGHT(x_node);
-         else              return x_node->data;
+         else if (dup)     SAVE_AND_LEFT (x_node, save_v[i]);
+         else {            save_v[i] = x_node; x_node = NULL; }
+         node_v[i] = x_node;
+         if (x_node) {
+            PREFETCH(x_node);
+            active++;
+         }
       }
-      if (x_save) return x_save->data;
-   CASE L_CHA_NODUP:
-      l_key = l_key_of(key, &keytail);
-      for (l_node = tree->l_root, l_save = NULL; l_node; ) {
-         if      (l_key < l_node->key) SAVE_AND_LEFT (l_node, l_save);
-         else if (l_key > l_node->key) CONTINUE_RIGHT(l_node);
-         else if (keytail) {
-            cmp = TAILCMP(keytail, l_node->data, tree->keyoffs, false);
-            if      (cmp < 0) SAVE_AND_LEFT (l_node, l_save);
-            else if (cmp > 0) CONTINUE_RIGHT(l_node);
-            else              return l_node->data;
-         } else               return l_node->data;
+   }
+   for (i = 0; i < n; i++) {
+      results[i] = save_v[i] ? save_v[i]->data : NULL;
+      found += save_v[i] != NULL;
+   }
+   return found;
+}
+
+static long locate_many_s(TREE *tree, void **key_v, int n, void **results)
+{
+   L_NODE *node_v[AVL_LOCATE_MANY_WAYS], *save_v[AVL_LOCATE_MANY_WAYS], *l_node;
+   long    l_key_v[AVL_LOCATE_MANY_WAYS];
+   char   *keytail_v[AVL_LOCATE_MANY_WAYS];
+   bool    ind = IS_IND(tree), dup = IS_DUP(tree);
+   int     cmp, i, active;
+   long    found = 0;
+
+   for (i = 0; i < n; i++) {
+      l_key_v[i] = l_key_of(key_v[i], &keytail_v[i]);
+      node_v[i] = tree->l_root;
+      save_v[i] = NULL;
+   }
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < n; i++) {
+         results[i] = small_locate(tree, NULL, l_key_v[i], keytail_v[i]);
+         found += results[i] != NULL;
       }
-      if (l_save) return l_save->data;
-   CASE L_STR_NODUP:
-      l_key = l_key_of(key, &keytail);
-      for (l_node = tree->l_root, l_save = NULL; l_node; ) {
-         if      (l_key < l_node->key) SAVE_AND_LEFT (l_node, l_save);
+      return found;
+   }
+   for (active = tree->l_root ? n : 0; active; ) {
+      active = 0;
+      for (i = 0; i < n; i++) {
+         l_node = node_v[i];
+         if ( !l_node) continue;
+         if      (l_key_v[i] < l_node->key) cmp = -1;
+         else if (l_key_v[i] > l_node->key) cmp =  1;
+         else if (keytail_v[i])             cmp = TAILCMP(keytail_v[i], l_node->data, tree->keyoffs, ind);
+         else                               cmp =  0;
+         if      (cmp < 0) CONTINUE_LEFT (l_node);
+         else if (cmp > 0) CONTINUE_RIGHT(l_node);
+         else if (dup)     SAVE_AND_LEFT (l_node, save_v[i]);
+         else {            save_v[i] = l_node; l_node = NULL; }
+         node_v[i] = l_node;
+         if (l_node) {
+            PREFETCH(l_node);
+            active++;
+         }
+      }
+   }
+   for (i = 0; i < n; i++) {
+      results[i] = save_v[i] ? save_v[i]->data : NULL;
+      found += save_v[i] != NULL;
+   }
+   return found;
+}
+
+static long locate_many_l(TREE *tree, long *key_v, int n, void **results)
+{
+   L_NODE *node_v[AVL_LOCATE_MANY_WAYS], *save_v[AVL_LOCATE_MANY_WAYS], *l_node;
+   bool    dup = IS_DUP(tree);
+   int     i, active;
+   long    found = 0;
+
+   if (CMPTYPE(tree) == L_COR_CMP) {
+      for (i = 0; i < n; i++) {
+         key_v[i] = CORRECT(key_v[i]);
+      }
+   }
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < n; i++) {
+         results[i] = small_locate(tree, NULL, key_v[i], NULL);
+         found += results[i] != NULL;
+      }
+      return found;
+   }
+   for (i = 0; i < n; i++) {
+      node_v[i] = tree->l_root;
+      save_v[i] = NULL;
+   }
+   for (active = tree->l_root ? n : 0; active; ) {
+      active = 0;
+      for (i = 0; i < n; i++) {
+         l_node = node_v[i];
+         if ( !l_node) continue;
+         if      (key_v[i] < l_node->key) CONTINUE_LEFT (l_node);
+         else if (key_v[i] > l_node->key) CONTINUE_RIGHT(l_node);
+         else if (dup)                    SAVE_AND_LEFT (l_node, save_v[i]);
+         else {                           save_v[i] = l_node; l_node = NULL; }
+         node_v[i] = l_node;
+         if (l_node) {
+            PREFETCH(l_node);
+            active++;
+         }
+      }
+   }
+   for (i = 0; i < n; i++) {
+      results[i] = save_v[i] ? save_v[i]->data : NULL;
+      found += save_v[i] != NULL;
+   }
+   return found;
+}
+
+/*---------------------------------------------------------------------------*/
+
+long avl_locate_many(TREE *tree, void **keys, long n, void **results)
+{
+   long i, found = 0;
+   int  m;
+
+   for (i = 0; i < n; i += m) {
+      m = (int)MIN(n - i, AVL_LOCATE_MANY_WAYS);
+      if (IS_X(tree)) {
+         found += locate_many_x(tree, keys + i, m, results + i);
+      } else if (CMPTYPE(tree) == L_CHA_CMP || CMPTYPE(tree) == L_STR_CMP) {
+         found += locate_many_s(tree, keys + i, m, results + i);
+      } else {
+         memset(results + i, 0, m * sizeof(void *));
+      }
+   }
+   return found;
+}
+
+long avl_locate_many_mbr  (TREE *tree, void **keys, long n, void **results) { return avl_locate_many(tree,          keys, n, results); }
+long avl_locate_many_ptr  (TREE *tree, void **keys, long n, void **results) { return avl_locate_many(tree,          keys, n, results); }
+long avl_locate_many_chars(TREE *tree, char **keys, long n, void **results) { return avl_locate_many(tree, (void **)keys, n, results); }
+long avl_locate_many_str  (TREE *tree, char **keys, long n, void **results) { return avl_locate_many(tree, (void **)keys, n, results); }
+
+/*---------------------------------------------------------------------------*/
+
+/* the integer keys are converted as by avl_locate_long(), up to AVL_LOCATE_MANY_WAYS at a time */
+#define LOCATE_MANY_L \
+   long key_v[AVL_LOCATE_MANY_WAYS], i, found = 0; \
+   int  m, j; \
+   for (i = 0; i < n; i += m) { \
+      m = (int)MIN(n - i, AVL_LOCATE_MANY_WAYS); \
+      if ((CMPTYPE(tree) == L_VAL_CMP || CMPTYPE(tree) == L_COR_CMP) && !IS_SET(tree)) { \
+         for (j = 0; j < m; j++) key_v[j] = (long)keys[i + j]; \
+         found += locate_many_l(tree, key_v, m, results + i); \
+      } else { \
+         memset(results + i, 0, m * sizeof(void *)); \
+      } \
+   } \
+   return found;
+
+long avl_locate_many_long  (TREE *tree, long   *keys, long n, void **results) { LOCATE_MANY_L }
+long avl_locate_many_int   (TREE *tree, int    *keys, long n, void **results) { LOCATE_MANY_L }
+long avl_locate_many_short (TREE *tree, short  *keys, long n, void **results) { LOCATE_MANY_L }
+long avl_locate_many_schar (TREE *tree, SCHAR  *keys, long n, void **results) { LOCATE_MANY_L }
+long avl_locate_many_ulong (TREE *tree, ULONG  *keys, long n, void **results) { LOCATE_MANY_L }
+long avl_locate_many_uint  (TREE *tree, UINT   *keys, long n, void **results) { LOCATE_MANY_L }
+long avl_locate_many_ushort(TREE *tree, USHORT *keys, long n, void **results) { LOCATE_MANY_L }
+long avl_locate_many_uchar (TREE *tree, UCHAR  *keys, long n, void **results) { LOCATE_MANY_L }
+
+/*---------------------------------------------------------------------------*/
+
+long avl_locate_many_float(TREE *tree, float *keys, long n, void **results)
+{
+   void *key_v[AVL_LOCATE_MANY_WAYS];
+   long  l_key_v[AVL_LOCATE_MANY_WAYS], i, found = 0;
+   int   m, j;
+
+   for (i = 0; i < n; i += m) {
+      m = (int)MIN(n - i, AVL_LOCATE_MANY_WAYS);
+      if (IS_X(tree)) {
+         for (j = 0; j < m; j++) key_v[j] = &keys[i + j];
+         found += locate_many_x(tree, key_v, m, results + i);
+      } else if ((CMPTYPE(tree) == L_VAL_CMP || CMPTYPE(tree) == L_COR_CMP) && !IS_SET(tree)) {
+         for (j = 0; j < m; j++) l_key_v[j] = flt2lng(keys[i + j]);
+         found += locate_many_l(tree, l_key_v, m, results + i);
+      } else {
+         memset(results + i, 0, m * sizeof(void *));
+      }
+   }
+   return found;
+}
+
+long avl_locate_many_double(TREE *tree, double *keys, long n, void **results)
+{
+   void *key_v[AVL_LOCATE_MANY_WAYS];
+   long  l_key_v[AVL_LOCATE_MANY_WAYS], i, found = 0;
+   int   m, j;
+
+   for (i = 0; i < n; i += m) {
+      m = (int)MIN(n - i, AVL_LOCATE_MANY_WAYS);
+      if (IS_X(tree)) {
+         for (j = 0; j < m; j++) key_v[j] = &keys[i + j];
+         found += locate_many_x(tree, key_v, m, results + i);
+      } else if ((CMPTYPE(tree) == L_VAL_CMP || CMPTYPE(tree) == L_COR_CMP) && !IS_SET(tree)) {
+         for (j = 0; j < m; j++) l_key_v[j] = dbl2lng(keys[i + j]);
+         found += locate_many_l(tree, l_key_v, m, results + i);
+      } else {
+         memset(results + i, 0, m * sizeof(void *));
+      }
+   }
+   return found;
+}
+
+/*===========================================================================*/
+
+/* Consecutive keys of a sorted batch share most of their path from the root. The path of the previous key is kept,
+ * as the links followed and the turns taken (like in insert_x()), and it is climbed only as far as needed
+ * for the subtree of its last link to contain the next key, i.e., up to the first node it turned right from
+ * whose key is less than the next key, and to the first node it turned left from whose key is greater.
+ * Then the path descends from there to the next key. The path ends with the link to the node found (in trees
+ * without duplicates) or with the empty link where the search ended. When inserting into a tree with duplicates
+ * the path goes right of equal keys, otherwise left, and the leftmost node with the key is returned.
+ */
+static X_NODE *path_to_x(TREE *tree, AVL_PATH *path, void *key, UINT keyoffs, bool ind, bool dup, bool ins)
+{
+   X_NODE ***p_link_v = (X_NODE ***)path->link;
+   X_NODE   *x_node, *x_save = NULL;
+   bool      lo_ok = false, hi_ok = false;
+   int       i, n = path->n, cmp;
+
+   for (i = n - 1; i >= 0 && !(lo_ok && hi_ok); i--) {
+      x_node = PTR_OF(*p_link_v[i]);
+      if (path->right[i]) {
+         if ( !lo_ok) {
+            if (CMP(tree->usrcmp, key, x_node->data, keyoffs, ind) > 0) lo_ok = true;
+            else n = i;
+         }
+      } else {
+         if ( !hi_ok) {
+            if (CMP(tree->usrcmp, key, x_node->data, keyoffs, ind) < 0) hi_ok = true;
+            else n = i;
+         }
+      }
+   }
+   for (x_node = PTR_OF(*p_link_v[n]); x_node; x_node = PTR_OF(*p_link_v[n])) {
+      cmp = CMP(tree->usrcmp, key, x_node->data, keyoffs, ind);
+      if (cmp == 0) {
+         if ( !dup) break;
+         if ( !ins) x_save = x_node;
+         cmp = ins ? 1 : -1;
+      }
+      path->right[n] = cmp > 0;
+      p_link_v[n + 1] = cmp > 0 ? &x_node->right : &x_node->left;
+      n++;
+   }
+   path->n = n;
+   return x_node ? x_node : x_save;
+}
+
+static L_NODE *path_to_l(TREE *tree, AVL_PATH *path, long key, char *keytail, bool ind, bool dup, bool ins)
+{
+   L_NODE ***p_link_v = (L_NODE ***)path->link;
+   L_NODE   *l_node, *l_save = NULL;
+   bool      lo_ok = false, hi_ok = false;
+   int       i, n = path->n, cmp;
+
+   for (i = n - 1; i >= 0 && !(lo_ok && hi_ok); i--) {
+      l_node = PTR_OF(*p_link_v[i]);
+      if (path->right[i]) {
+         if ( !lo_ok) {
+            if (cmp_l(key, keytail, l_node, tree->keyoffs, ind) > 0) lo_ok = true;
+            else n = i;
+         }
+      } else {
+         if ( !hi_ok) {
+            if (cmp_l(key, keytail, l_node, tree->keyoffs, ind) < 0) hi_ok = true;
+            else n = i;
+         }
+      }
+   }
+   for (l_node = PTR_OF(*p_link_v[n]); l_node; l_node = PTR_OF(*p_link_v[n])) {
+      cmp = cmp_l(key, keytail, l_node, tree->keyoffs, ind);
+      if (cmp == 0) {
+         if ( !dup) break;
+         if ( !ins) l_save = l_node;
+         cmp = ins ? 1 : -1;
+      }
+      path->right[n] = cmp > 0;
+      p_link_v[n + 1] = cmp > 0 ? &l_node->right : &l_node->left;
+      n++;
+   }
+   path->n = n;
+   return l_node ? l_node : l_save;
+}
+
+/*---------------------------------------------------------------------------*/
+
+long avl_locate_sorted_batch(TREE *tree, void **keys, long n, void **results)
+{
+   AVL_PATH path;
+   X_NODE  *x_node;
+   L_NODE  *l_node;
+   UINT     keyoffs = CMPTYPE(tree) == X_USR_CMP ? 0 : tree->keyoffs;
+   long     l_key, i, found = 0;
+   char    *keytail;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < n; i++) {
+         results[i] = avl_locate(tree, keys[i]);
+         found += results[i] != NULL;
+      }
+      return found;
+   }
+   path.link[0] = &tree->root;
+   path.n = 0;
+   for (i = 0; i < n; i++) {
+      if (IS_X(tree)) {
+         x_node = path_to_x(tree, &path, keys[i], keyoffs, IS_IND(tree), IS_DUP(tree), false);
+         results[i] = x_node ? x_node->data : NULL;
+      } else if (CMPTYPE(tree) == L_CHA_CMP || CMPTYPE(tree) == L_STR_CMP) {
+         l_key  = l_key_of(keys[i], &keytail);
+         l_node = path_to_l(tree, &path, l_key, keytail, IS_IND(tree), IS_DUP(tree), false);
+         results[i] = l_node ? l_node->data : NULL;
+      } else {
+         results[i] = NULL;
+      }
+      found += results[i] != NULL;
+   }
+   return found;
+}
+
+long avl_locate_sorted_batch_long(TREE *tree, long *keys, long n, void **results)
+{
+   AVL_PATH path;
+   L_NODE  *l_node;
+   long     i, found = 0;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < n; i++) {
+         results[i] = avl_locate_long(tree, keys[i]);
+         found += results[i] != NULL;
+      }
+      return found;
+   }
+   path.link[0] = &tree->root;
+   path.n = 0;
+   for (i = 0; i < n; i++) {
+      if ((CMPTYPE(tree) == L_VAL_CMP || CMPTYPE(tree) == L_COR_CMP) && !IS_SET(tree)) {
+         l_node = path_to_l(tree, &path, CORR_IF(keys[i], CMPTYPE(tree) == L_COR_CMP), NULL, false, IS_DUP(tree), false);
+         results[i] = l_node ? l_node->data : NULL;
+      } else {
+         results[i] = NULL;
+      }
+      found += results[i] != NULL;
+   }
+   return found;
+}
+
+long avl_locate_sorted_batch_float(TREE *tree, float *keys, long n, void **results)
+{
+   AVL_PATH path;
+   X_NODE  *x_node;
+   L_NODE  *l_node;
+   UINT     keyoffs = CMPTYPE(tree) == X_USR_CMP ? 0 : tree->keyoffs;
+   long     i, found = 0;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < n; i++) {
+         results[i] = avl_locate_float(tree, keys[i]);
+         found += results[i] != NULL;
+      }
+      return found;
+   }
+   path.link[0] = &tree->root;
+   path.n = 0;
+   for (i = 0; i < n; i++) {
+      if (IS_X(tree)) {
+         x_node = path_to_x(tree, &path, &keys[i], keyoffs, IS_IND(tree), IS_DUP(tree), false);
+         results[i] = x_node ? x_node->data : NULL;
+      } else if ((CMPTYPE(tree) == L_VAL_CMP || CMPTYPE(tree) == L_COR_CMP) && !IS_SET(tree)) {
+         l_node = path_to_l(tree, &path, CORR_IF(flt2lng(keys[i]), CMPTYPE(tree) == L_COR_CMP), NULL, false, IS_DUP(tree), false);
+         results[i] = l_node ? l_node->data : NULL;
+      } else {
+         results[i] = NULL;
+      }
+      found += results[i] != NULL;
+   }
+   return found;
+}
+
+long avl_locate_sorted_batch_double(TREE *tree, double *keys, long n, void **results)
+{
+   AVL_PATH path;
+   X_NODE  *x_node;
+   L_NODE  *l_node;
+   UINT     keyoffs = CMPTYPE(tree) == X_USR_CMP ? 0 : tree->keyoffs;
+   long     i, found = 0;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < n; i++) {
+         results[i] = avl_locate_double(tree, keys[i]);
+         found += results[i] != NULL;
+      }
+      return found;
+   }
+   path.link[0] = &tree->root;
+   path.n = 0;
+   for (i = 0; i < n; i++) {
+      if (IS_X(tree)) {
+         x_node = path_to_x(tree, &path, &keys[i], keyoffs, IS_IND(tree), IS_DUP(tree), false);
+         results[i] = x_node ? x_node->data : NULL;
+      } else if ((CMPTYPE(tree) == L_VAL_CMP || CMPTYPE(tree) == L_COR_CMP) && !IS_SET(tree)) {
+         l_node = path_to_l(tree, &path, CORR_IF(dbl2lng(keys[i]), CMPTYPE(tree) == L_COR_CMP), NULL, false, IS_DUP(tree), false);
+         results[i] = l_node ? l_node->data : NULL;
+      } else {
+         results[i] = NULL;
+      }
+      found += results[i] != NULL;
+   }
+   return found;
+}
+
+/*---------------------------------------------------------------------------*/
+
+long avl_insert_sorted_batch(TREE *tree, void *data_v[], long n)
+{
+   AVL_PATH path;
+   X_NODE  *x_node;
+   L_NODE  *l_node;
+   char    *keytail;
+   void   **slot;
+   long     i = 0, inserted = 0;
+
+   for ( ; i < n && (IS_SMALL(tree) || CAN_BE_SMALL(tree)); i++) {
+      if (small_insert(tree, data_v[i], false, &slot)) {
+         inserted++;
+      } else if ( !slot) {
+         return inserted;
+      }
+   }
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if (IS_FULL(tree) || IS_SET(tree)) {
+      return inserted;
+   }
+   path.link[0] = &tree->root;
+   path.n = 0;
+   for ( ; i < n; i++) {
+      if (IS_X(tree)) {
+         if (tree->unused) {
+            PTRPOP(tree->unused, x_node);
+         } else if (tree->avail) {
+            x_node = tree->x_store = PTRSUB(tree->x_store, X_NODESIZE(tree));
+            tree->avail--;
+         } else {
+            x_node = alloc_node_x(tree);
+            if ( !x_node) break;
+         }
+         x_node->data  = data_v[i];
+         x_node->left  = NULL;
+         x_node->right = NULL;
+         if (IS_RANK(tree)) {
+            COUNT(x_node) = 1;
+         }
+         if (path_to_x(tree, &path, x_key_of(tree, data_v[i]), tree->keyoffs, IS_IND(tree), IS_DUP(tree), true)) {
+            if (x_node == tree->x_store) {
+               tree->x_store = PTRADD(x_node, X_NODESIZE(tree));
+               tree->avail++;
+            } else {
+               PTRPUSH(tree->unused, x_node);
+            }
+            continue;
+         }
+         insert_at_x((X_NODE ***)path.link, path.right, path.n, x_node, IS_RANK(tree), &path.n);
+         note_insert(tree, x_node);
+      } else {
+         if (tree->unused) {
+            PTRPOP(tree->unused, l_node);
+         } else if (tree->avail) {
+            l_node = tree->l_store = PTRSUB(tree->l_store, L_NODESIZE(tree));
+            tree->avail--;
+         } else {
+            l_node = alloc_node_l(tree);
+            if ( !l_node) break;
+         }
+         l_node->data  = data_v[i];
+         l_node->left  = NULL;
+         l_node->right = NULL;
+         if (IS_RANK(tree)) {
+            COUNT(l_node) = 1;
+         }
+         l_node->key   = l_key_of_data(tree, data_v[i], &keytail);
+         if (path_to_l(tree, &path, l_node->key, keytail, IS_IND(tree), IS_DUP(tree), true)) {
+            if (l_node == tree->l_store) {
+               tree->l_store = PTRADD(l_node, L_NODESIZE(tree));
+               tree->avail++;
+            } else {
+               PTRPUSH(tree->unused, l_node);
+            }
+            continue;
+         }
+         insert_at_l((L_NODE ***)path.link, path.right, path.n, l_node, IS_RANK(tree), &path.n);
+         note_insert(tree, l_node);
+      }
+      tree->nodes++;
+      inserted++;
+   }
+   return inserted;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_locate_ge(TREE *tree, void *key)
+{
+   X_NODE *x_node, *x_save;
+   L_NODE *l_node, *l_save;
+   int     cmp;
+   long    l_key;
+   char   *keytail;
+
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, small_index(tree, key, false, NULL));
+   }
+   switch (tree->bits) {
+   CASE X_USR_NODUP:
+      for (x_node = tree->x_root, x_save = NULL; x_node; ) {
+         cmp = CMP(tree->usrcmp, key, x_node->data, 0, false);
+         if      (cmp < 0) SAVE_AND_LEFT (x_node, x_save);
+         else if (cmp > 0) CONTINUE_RIGHT(x_node);
+         else              return x_node->data;
+      }
+      if (x_save) return x_save->data;
+   CASE X_MBR_NODUP:
+      for (x_node = tree->x_root, x_save = NULL; x_node; ) {
+         cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, false);
+         if      (cmp < 0) SAVE_AND_LEFT (x_node, x_save);
+         else if (cmp > 0) CONTINUE_RIGHT(x_node);
+         else              return x_node->data;
+      }
+      if (x_save) return x_save->data;
+   CASE X_PTR_NODUP:
+      for (x_node = tree->x_root, x_save = NULL; x_node; ) {
+         cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, true);
+         if      (cmp < 0) SAVE_AND_LEFT (x_node, x_save);
+         else if (cmp > 0) CONTINUE_RIGHT(x_node);
+         else              return x_node->data;
+      }
+      if (x_save) return x_save->data;
+   CASE L_CHA_NODUP:
+      l_key = l_key_of(key, &keytail);
+      for (l_node = tree->l_root, l_save = NULL; l_node; ) {
+         if      (l_key < l_node->key) SAVE_AND_LEFT (l_node, l_save);
+         else if (l_key > l_node->key) CONTINUE_RIGHT(l_node);
+         else if (keytail) {
+            cmp = TAILCMP(keytail, l_node->data, tree->keyoffs, false);
+            if      (cmp < 0) SAVE_AND_LEFT (l_node, l_save);
+            else if (cmp > 0) CONTINUE_RIGHT(l_node);
+            else              return l_node->data;
+         } else               return l_node->data;
+      }
+      if (l_save) return l_save->data;
+   CASE L_STR_NODUP:
+      l_key = l_key_of(key, &keytail);
+      for (l_node = tree->l_root, l_save = NULL; l_node; ) {
+         if      (l_key < l_node->key) SAVE_AND_LEFT (l_node, l_save);
          else if (l_key > l_node->key) CONTINUE_RIGHT(l_node);
          else if (keytail) {
             cmp = TAILCMP(keytail, l_node->data, tree->keyoffs, true);
@@ -1540,6 +3531,12 @@ void *avl_locate_ge_long(TREE *tree, long key)
 {
    L_NODE *l_node, *l_save;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, small_index_long(tree, key, false, NULL));
+   }
    switch (tree->bits) {
    CASE L_COR_NODUP:
       key = CORRECT(key);
@@ -1594,6 +3591,12 @@ void *avl_locate_gt(TREE *tree, void *key)
    long    l_key;
    char   *keytail;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, small_index(tree, key, true, NULL));
+   }
    switch (CMPTYPE(tree)) {
    CASE X_USR_CMP:
       for (x_node = tree->x_root, x_save = NULL; x_node; ) {
@@ -1655,6 +3658,12 @@ void *avl_locate_gt_long(TREE *tree, long key)
 {
    L_NODE *l_node, *l_save;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, small_index_long(tree, key, true, NULL));
+   }
    switch (CMPTYPE(tree)) {
    CASE L_COR_CMP:
       key = CORRECT(key);
@@ -1700,6 +3709,12 @@ void *avl_locate_le(TREE *tree, void *key)
    long    l_key;
    char   *keytail;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, small_index(tree, key, true, NULL) - 1);
+   }
    switch (tree->bits) {
    CASE X_USR_NODUP:
       for (x_node = tree->x_root, x_save = NULL; x_node; ) {
@@ -1811,6 +3826,12 @@ void *avl_locate_le_long(TREE *tree, long key)
 {
    L_NODE *l_node, *l_save;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, small_index_long(tree, key, true, NULL) - 1);
+   }
    switch (tree->bits) {
    CASE L_COR_NODUP:
       key = CORRECT(key);
@@ -1865,6 +3886,12 @@ void *avl_locate_lt(TREE *tree, void *key)
    long    l_key;
    char   *keytail;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, small_index(tree, key, false, NULL) - 1);
+   }
    switch (CMPTYPE(tree)) {
    CASE X_USR_CMP:
       for (x_node = tree->x_root, x_save = NULL; x_node; ) {
@@ -1926,6 +3953,12 @@ void *avl_locate_lt_long(TREE *tree, long key)
 {
    L_NODE *l_node, *l_save;
 
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, small_index_long(tree, key, false, NULL) - 1);
+   }
    switch (CMPTYPE(tree)) {
    CASE L_COR_CMP:
       key = CORRECT(key);
@@ -1965,17 +3998,11 @@ void *avl_locate_lt_double(TREE *tree, double key)
 
 void *avl_locate_first(TREE *tree)
 {
-   X_NODE *x_node;
-   L_NODE *l_node;
-
-   if (tree->root) {
-      if (IS_X(tree)) {
-         for (x_node = tree->root; x_node->left; CONTINUE_LEFT(x_node)) {}
-         return x_node->data;
-      } else {
-         for (l_node = tree->root; l_node->left; CONTINUE_LEFT(l_node)) {}
-         return l_node->data;
-      }
+   if (IS_SMALL(tree)) {
+      return small_item(tree, 0);
+   }
+   if (tree->first && !IS_SET(tree)) {
+      return IS_X(tree) ? tree->x_first->data : tree->l_first->data;
    }
    return NULL;
 }
@@ -1983,25 +4010,445 @@ void *avl_locate_first(TREE *tree)
 /*---------------------------------------------------------------------------*/
 
 void *avl_locate_last(TREE *tree)
+{
+   if (IS_SMALL(tree)) {
+      return small_item(tree, tree->nodes - 1);
+   }
+   if (tree->last && !IS_SET(tree)) {
+      return IS_X(tree) ? tree->x_last->data : tree->l_last->data;
+   }
+   return NULL;
+}
+
+/*===========================================================================*/
+
+/* Count the nodes whose key is less than (or, if le, less than or equal to) the given key.
+ */
+static long rank_x(TREE *tree, void *key, bool le)
 {
    X_NODE *x_node;
-   L_NODE *l_node;
+   long    rank = 0;
+   int     cmp;
 
-   if (tree->root) {
-      if (IS_X(tree)) {
-         for (x_node = tree->root; x_node->right; CONTINUE_RIGHT(x_node)) {}
-         return x_node->data;
+   if (IS_SMALL(tree)) {
+      return small_bound(tree, key, 0L, NULL, le, NULL);
+   }
+   for (x_node = tree->x_root; x_node; ) {
+      cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, IS_IND(tree));
+      if (cmp < 0 || (cmp == 0 && !le)) {
+         CONTINUE_LEFT(x_node);
       } else {
-         for (l_node = tree->root; l_node->right; CONTINUE_RIGHT(l_node)) {}
-         return l_node->data;
+         rank += COUNT_OF(x_node->left) + 1;
+         CONTINUE_RIGHT(x_node);
       }
    }
-   return NULL;
+   return rank;
 }
 
-/*===========================================================================*/
+/*---------------------------------------------------------------------------*/
 
-static void *scan_x(X_NODE *x_root, bool (*callback)(void *))
+static long rank_l(TREE *tree, long l_key, char *keytail, bool le)
+{
+   L_NODE *l_node;
+   long    rank = 0;
+   int     cmp;
+
+   if (IS_SMALL(tree)) {
+      return small_bound(tree, NULL, l_key, keytail, le, NULL);
+   }
+   for (l_node = tree->l_root; l_node; ) {
+      if      (l_key < l_node->key) cmp = -1;
+      else if (l_key > l_node->key) cmp =  1;
+      else if (keytail)             cmp = TAILCMP(keytail, l_node->data, tree->keyoffs, IS_IND(tree));
+      else                          cmp =  0;
+      if (cmp < 0 || (cmp == 0 && !le)) {
+         CONTINUE_LEFT(l_node);
+      } else {
+         rank += COUNT_OF(l_node->left) + 1;
+         CONTINUE_RIGHT(l_node);
+      }
+   }
+   return rank;
+}
+
+/*---------------------------------------------------------------------------*/
+
+long avl_rank(TREE *tree, void *key)
+{
+   long  l_key;
+   char *keytail;
+
+   if ( !IS_RANK(tree)) {
+      return -1;
+   }
+   if (IS_X(tree)) {
+      return rank_x(tree, key, false);
+   }
+   if (CMPTYPE(tree) == L_CHA_CMP || CMPTYPE(tree) == L_STR_CMP) {
+      l_key = l_key_of(key, &keytail);
+      return rank_l(tree, l_key, keytail, false);
+   }
+   return -1;
+}
+
+long avl_rank_mbr  (TREE *tree, void *key) { return avl_rank(tree, key); }
+long avl_rank_ptr  (TREE *tree, void *key) { return avl_rank(tree, key); }
+long avl_rank_chars(TREE *tree, char *key) { return avl_rank(tree, key); }
+long avl_rank_str  (TREE *tree, char *key) { return avl_rank(tree, key); }
+
+/*---------------------------------------------------------------------------*/
+
+long avl_rank_long(TREE *tree, long key)
+{
+   if ( !IS_RANK(tree) || IS_X(tree)) {
+      return -1;
+   }
+   if (IS_CORR(tree)) {
+      key = CORRECT(key);
+   }
+   return rank_l(tree, key, NULL, false);
+}
+
+long avl_rank_int   (TREE *tree, int    key) { return avl_rank_long(tree, key); }
+long avl_rank_short (TREE *tree, short  key) { return avl_rank_long(tree, key); }
+long avl_rank_schar (TREE *tree, SCHAR  key) { return avl_rank_long(tree, key); }
+long avl_rank_ulong (TREE *tree, ULONG  key) { return avl_rank_long(tree, key); }
+long avl_rank_uint  (TREE *tree, UINT   key) { return avl_rank_long(tree, key); }
+long avl_rank_ushort(TREE *tree, USHORT key) { return avl_rank_long(tree, key); }
+long avl_rank_uchar (TREE *tree, UCHAR  key) { return avl_rank_long(tree, key); }
+
+/*---------------------------------------------------------------------------*/
+
+long avl_rank_float(TREE *tree, float key)
+{
+   if (IS_X(tree)) return avl_rank     (tree, &key);
+   else            return avl_rank_long(tree, flt2lng(key));
+}
+
+long avl_rank_double(TREE *tree, double key)
+{
+   if (IS_X(tree)) return avl_rank     (tree, &key);
+   else            return avl_rank_long(tree, dbl2lng(key));
+}
+
+/*---------------------------------------------------------------------------*/
+
+long avl_count_range(TREE *tree, void *lo, void *hi)
+{
+   long  l_lo, l_hi, count;
+   char *lo_keytail, *hi_keytail;
+
+   if ( !IS_RANK(tree)) {
+      return -1;
+   }
+   if (IS_X(tree)) {
+      count = rank_x(tree, hi, true) - rank_x(tree, lo, false);
+   } else if (CMPTYPE(tree) == L_CHA_CMP || CMPTYPE(tree) == L_STR_CMP) {
+      l_lo = l_key_of(lo, &lo_keytail);
+      l_hi = l_key_of(hi, &hi_keytail);
+      count = rank_l(tree, l_hi, hi_keytail, true) - rank_l(tree, l_lo, lo_keytail, false);
+   } else {
+      return -1;
+   }
+   return count > 0 ? count : 0;
+}
+
+long avl_count_range_mbr  (TREE *tree, void *lo, void *hi) { return avl_count_range(tree, lo, hi); }
+long avl_count_range_ptr  (TREE *tree, void *lo, void *hi) { return avl_count_range(tree, lo, hi); }
+long avl_count_range_chars(TREE *tree, char *lo, char *hi) { return avl_count_range(tree, lo, hi); }
+long avl_count_range_str  (TREE *tree, char *lo, char *hi) { return avl_count_range(tree, lo, hi); }
+
+/*---------------------------------------------------------------------------*/
+
+long avl_count_range_long(TREE *tree, long lo, long hi)
+{
+   long count;
+
+   if ( !IS_RANK(tree) || IS_X(tree)) {
+      return -1;
+   }
+   if (IS_CORR(tree)) {
+      lo = CORRECT(lo);
+      hi = CORRECT(hi);
+   }
+   count = rank_l(tree, hi, NULL, true) - rank_l(tree, lo, NULL, false);
+   return count > 0 ? count : 0;
+}
+
+long avl_count_range_int   (TREE *tree, int    lo, int    hi) { return avl_count_range_long(tree, lo, hi); }
+long avl_count_range_short (TREE *tree, short  lo, short  hi) { return avl_count_range_long(tree, lo, hi); }
+long avl_count_range_schar (TREE *tree, SCHAR  lo, SCHAR  hi) { return avl_count_range_long(tree, lo, hi); }
+long avl_count_range_ulong (TREE *tree, ULONG  lo, ULONG  hi) { return avl_count_range_long(tree, lo, hi); }
+long avl_count_range_uint  (TREE *tree, UINT   lo, UINT   hi) { return avl_count_range_long(tree, lo, hi); }
+long avl_count_range_ushort(TREE *tree, USHORT lo, USHORT hi) { return avl_count_range_long(tree, lo, hi); }
+long avl_count_range_uchar (TREE *tree, UCHAR  lo, UCHAR  hi) { return avl_count_range_long(tree, lo, hi); }
+
+/*---------------------------------------------------------------------------*/
+
+long avl_count_range_float(TREE *tree, float lo, float hi)
+{
+   if (IS_X(tree)) return avl_count_range     (tree, &lo, &hi);
+   else            return avl_count_range_long(tree, flt2lng(lo), flt2lng(hi));
+}
+
+long avl_count_range_double(TREE *tree, double lo, double hi)
+{
+   if (IS_X(tree)) return avl_count_range     (tree, &lo, &hi);
+   else            return avl_count_range_long(tree, dbl2lng(lo), dbl2lng(hi));
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_select(TREE *tree, long k)
+{
+   X_NODE *x_node;
+   L_NODE *l_node;
+   long    n_left;
+
+   if ( !IS_RANK(tree) || IS_SET(tree) || k < 0 || k >= tree->nodes) {
+      return NULL;
+   }
+   if (IS_SMALL(tree)) {
+      return tree->small[k];
+   }
+   if (IS_X(tree)) {
+      for (x_node = tree->x_root; x_node; ) {
+         n_left = COUNT_OF(x_node->left);
+         if (k < n_left) {
+            CONTINUE_LEFT(x_node);
+         } else if (k > n_left) {
+            k -= n_left + 1;
+            CONTINUE_RIGHT(x_node);
+         } else {
+            return x_node->data;
+         }
+      }
+   } else {
+      for (l_node = tree->l_root; l_node; ) {
+         n_left = COUNT_OF(l_node->left);
+         if (k < n_left) {
+            CONTINUE_LEFT(l_node);
+         } else if (k > n_left) {
+            k -= n_left + 1;
+            CONTINUE_RIGHT(l_node);
+         } else {
+            return l_node->data;
+         }
+      }
+   }
+   return NULL;
+}
+
+/*===========================================================================*/
+
+/* Set trees (see AVL_SET) are L trees whose nodes end before the data pointer,
+ * or, in map trees, hold a value of keyoffs bytes in its place.
+ * Their keys are stored like those of the other trees with the same key type.
+ */
+/* Insert the key, returning its new node, whose value is zeroed, or NULL if memory allocation failed.
+ * If the key is found in a tree without duplicates, NULL is returned and *p_found is set to its node.
+ */
+static L_NODE *set_insert(TREE *tree, long key, L_NODE **p_found)
+{
+   L_NODE *l_node, *l_found;
+
+   *p_found = NULL;
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if (IS_FULL(tree)) {
+      return NULL;
+   }
+   if (tree->unused) {
+      PTRPOP(tree->unused, l_node);
+   } else if (tree->avail) {
+      l_node = tree->l_store = PTRSUB(tree->l_store, L_NODESIZE(tree));
+      tree->avail--;
+   } else {
+      l_node = alloc_node_l(tree);
+      if ( !l_node) return NULL;
+   }
+   l_node->key   = key;
+   l_node->left  = NULL;
+   l_node->right = NULL;
+   if (IS_MAP(tree)) {
+      memset(VALUE_OF(l_node), 0, VALSIZE(tree));
+   }
+   if (IS_RANK(tree)) {
+      COUNT(l_node) = 1;
+   }
+   if (tree->l_root) {
+      if (OPS_OF(tree)->insert_l(&tree->l_root, l_node, &l_found, NULL, tree->keyoffs) == NOT_INS) {
+         if (l_node == tree->l_store) {
+            tree->l_store = PTRADD(l_node, L_NODESIZE(tree));
+            tree->avail++;
+         } else {
+            PTRPUSH(tree->unused, l_node);
+         }
+         *p_found = l_found;
+         return NULL;
+      }
+   } else {
+      tree->l_root = l_node;
+   }
+   note_insert(tree, l_node);
+   tree->nodes++;
+   return l_node;
+}
+
+static bool set_insert_key(TREE *tree, long key)
+{
+   L_NODE *l_found;
+
+   return set_insert(tree, key, &l_found) != NULL;
+}
+
+bool avl_set_insert_long  (TREE *tree, long  key) { return IS_SET(tree) && KEYTYPE(tree) == LNG_KEY && set_insert_key(tree, key); }
+bool avl_set_insert_ulong (TREE *tree, ULONG key) { return IS_SET(tree) && KEYTYPE(tree) == ULN_KEY && set_insert_key(tree, CORRECT(key)); }
+bool avl_set_insert_double(TREE *tree, double key) { return IS_SET(tree) && KEYTYPE(tree) == DBL_KEY && set_insert_key(tree, dbl2lng(key)); }
+
+/*---------------------------------------------------------------------------*/
+
+static L_NODE *set_locate(TREE *tree, long key)
+{
+   L_NODE *l_node;
+
+   for (l_node = tree->l_root; l_node; ) {
+      if      (key < l_node->key) CONTINUE_LEFT (l_node);
+      else if (key > l_node->key) CONTINUE_RIGHT(l_node);
+      else return l_node;
+   }
+   return NULL;
+}
+
+bool avl_set_contains_long  (TREE *tree, long  key) { return IS_SET(tree) && KEYTYPE(tree) == LNG_KEY && set_locate(tree, key); }
+bool avl_set_contains_ulong (TREE *tree, ULONG key) { return IS_SET(tree) && KEYTYPE(tree) == ULN_KEY && set_locate(tree, CORRECT(key)); }
+bool avl_set_contains_double(TREE *tree, double key) { return IS_SET(tree) && KEYTYPE(tree) == DBL_KEY && set_locate(tree, dbl2lng(key)); }
+
+/*---------------------------------------------------------------------------*/
+
+static bool set_remove(TREE *tree, long key)
+{
+   L_NODE *l_node;
+   DEPTH   depth;
+
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if ( !tree->root) {
+      return false;
+   }
+   l_node = OPS_OF(tree)->remove_l(&tree->l_root, key, NULL, tree->keyoffs, &depth);
+   if ( !l_node) return false;
+   note_remove(tree, l_node);
+   PTRPUSH(tree->unused, l_node);
+   tree->nodes--;
+   return true;
+}
+
+bool avl_set_remove_long  (TREE *tree, long  key) { return IS_SET(tree) && KEYTYPE(tree) == LNG_KEY && set_remove(tree, key); }
+bool avl_set_remove_ulong (TREE *tree, ULONG key) { return IS_SET(tree) && KEYTYPE(tree) == ULN_KEY && set_remove(tree, CORRECT(key)); }
+bool avl_set_remove_double(TREE *tree, double key) { return IS_SET(tree) && KEYTYPE(tree) == DBL_KEY && set_remove(tree, dbl2lng(key)); }
+
+/*---------------------------------------------------------------------------*/
+
+/* Pass the keys between lo and hi (both included) to the callback, converted back to the key type of the tree.
+ * The stack holds the nodes with keys >= lo whose left subtrees have been visited.
+ */
+static void set_do_range(TREE *tree, long lo, long hi, void (*callback)(), void *context)
+{
+   L_NODE *stack[MAX_PATHDEPTH + 1], *l_node;
+   int     n = 0;
+
+   for (l_node = tree->l_root; l_node; ) {
+      if (lo <= l_node->key) {
+         stack[n++] = l_node;
+         CONTINUE_LEFT(l_node);
+      } else {
+         CONTINUE_RIGHT(l_node);
+      }
+   }
+   while (n > 0) {
+      l_node = stack[--n];
+      if (l_node->key > hi) break;
+      switch (KEYTYPE(tree)) {
+      CASE LNG_KEY: (*callback)(l_node->key, context);
+      CASE ULN_KEY: (*callback)((ULONG)l_node->key - (ULONG)LONG_MIN, context);
+      CASE DBL_KEY: (*callback)(lng2dbl(l_node->key), context);
+      }
+      for (CONTINUE_RIGHT(l_node); l_node; CONTINUE_LEFT(l_node)) {
+         stack[n++] = l_node;
+      }
+   }
+}
+
+void avl_set_do_range_long(TREE *tree, long lo, long hi, void (*callback)(long, void *), void *context)
+{
+   if (IS_SET(tree) && KEYTYPE(tree) == LNG_KEY) set_do_range(tree, lo, hi, (void (*)())callback, context);
+}
+
+void avl_set_do_range_ulong(TREE *tree, ULONG lo, ULONG hi, void (*callback)(ULONG, void *), void *context)
+{
+   if (IS_SET(tree) && KEYTYPE(tree) == ULN_KEY) set_do_range(tree, CORRECT(lo), CORRECT(hi), (void (*)())callback, context);
+}
+
+void avl_set_do_range_double(TREE *tree, double lo, double hi, void (*callback)(double, void *), void *context)
+{
+   if (IS_SET(tree) && KEYTYPE(tree) == DBL_KEY) set_do_range(tree, dbl2lng(lo), dbl2lng(hi), (void (*)())callback, context);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Insert the key with a copy of the value, or overwrite the value of the key if it is found.
+ */
+static bool map_put(TREE *tree, long key, const void *value)
+{
+   L_NODE *l_node, *l_found;
+
+   l_node = set_insert(tree, key, &l_found);
+   if ( !l_node) {
+      if ( !l_found) return false;
+      l_node = l_found;
+   }
+   memcpy(VALUE_OF(l_node), value, tree->keyoffs);
+   return true;
+}
+
+bool avl_map_put_long  (TREE *tree, long   key, const void *value) { return IS_MAP(tree) && KEYTYPE(tree) == LNG_KEY && map_put(tree, key, value); }
+bool avl_map_put_ulong (TREE *tree, ULONG  key, const void *value) { return IS_MAP(tree) && KEYTYPE(tree) == ULN_KEY && map_put(tree, CORRECT(key), value); }
+bool avl_map_put_double(TREE *tree, double key, const void *value) { return IS_MAP(tree) && KEYTYPE(tree) == DBL_KEY && map_put(tree, dbl2lng(key), value); }
+
+/*---------------------------------------------------------------------------*/
+
+static void *map_ptr(TREE *tree, long key)
+{
+   L_NODE *l_node = set_locate(tree, key);
+
+   return l_node ? VALUE_OF(l_node) : NULL;
+}
+
+void *avl_map_ptr_long  (TREE *tree, long   key) { return IS_MAP(tree) && KEYTYPE(tree) == LNG_KEY ? map_ptr(tree, key) : NULL; }
+void *avl_map_ptr_ulong (TREE *tree, ULONG  key) { return IS_MAP(tree) && KEYTYPE(tree) == ULN_KEY ? map_ptr(tree, CORRECT(key)) : NULL; }
+void *avl_map_ptr_double(TREE *tree, double key) { return IS_MAP(tree) && KEYTYPE(tree) == DBL_KEY ? map_ptr(tree, dbl2lng(key)) : NULL; }
+
+/*---------------------------------------------------------------------------*/
+
+static bool map_get(TREE *tree, void *ptr, void *value)
+{
+   if ( !ptr) return false;
+   memcpy(value, ptr, tree->keyoffs);
+   return true;
+}
+
+bool avl_map_get_long  (TREE *tree, long   key, void *value) { return map_get(tree, avl_map_ptr_long  (tree, key), value); }
+bool avl_map_get_ulong (TREE *tree, ULONG  key, void *value) { return map_get(tree, avl_map_ptr_ulong (tree, key), value); }
+bool avl_map_get_double(TREE *tree, double key, void *value) { return map_get(tree, avl_map_ptr_double(tree, key), value); }
+
+/*===========================================================================*/
+
+static void *scan_x(X_NODE *x_root, bool (*callback)(void *))
 {
    void *data;
 
@@ -2051,7 +4498,15 @@ static void *rev_scan_l(L_NODE *l_root, bool (*callback)(void *))
 
 void *avl_scan(TREE *tree, bool (*callback)(void *))
 {
-   if (tree->root) {
+   long i;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < tree->nodes; i++) {
+         if ((*callback)(tree->small[i])) return tree->small[i];
+      }
+      return NULL;
+   }
+   if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) return scan_x(tree->x_root, callback);
       else            return scan_l(tree->l_root, callback);
    }
@@ -2062,7 +4517,15 @@ void *avl_scan(TREE *tree, bool (*callback)(void *))
 
 void *avl_rev_scan(TREE *tree, bool (*callback)(void *))
 {
-   if (tree->root) {
+   long i;
+
+   if (IS_SMALL(tree)) {
+      for (i = tree->nodes - 1; i >= 0; i--) {
+         if ((*callback)(tree->small[i])) return tree->small[i];
+      }
+      return NULL;
+   }
+   if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) return rev_scan_x(tree->x_root, callback);
       else            return rev_scan_l(tree->l_root, callback);
    }
@@ -2121,7 +4584,15 @@ static void *rev_scan_w_ctx_l(L_NODE *l_root, bool (*callback)(void *, void *),
 
 void *avl_scan_w_ctx(TREE *tree, bool (*callback)(void *, void *), void *context)
 {
-   if (tree->root) {
+   long i;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < tree->nodes; i++) {
+         if ((*callback)(tree->small[i], context)) return tree->small[i];
+      }
+      return NULL;
+   }
+   if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) return scan_w_ctx_x(tree->x_root, callback, context);
       else            return scan_w_ctx_l(tree->l_root, callback, context);
    }
@@ -2132,7 +4603,15 @@ void *avl_scan_w_ctx(TREE *tree, bool (*callback)(void *, void *), void *context
 
 void *avl_rev_scan_w_ctx(TREE *tree, bool (*callback)(void *, void *), void *context)
 {
-   if (tree->root) {
+   long i;
+
+   if (IS_SMALL(tree)) {
+      for (i = tree->nodes - 1; i >= 0; i--) {
+         if ((*callback)(tree->small[i], context)) return tree->small[i];
+      }
+      return NULL;
+   }
+   if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) return rev_scan_w_ctx_x(tree->x_root, callback, context);
       else            return rev_scan_w_ctx_l(tree->l_root, callback, context);
    }
@@ -2179,7 +4658,13 @@ static void rev_do_l(L_NODE *l_root, void (*callback)(void *))
 
 void avl_do(TREE *tree, void (*callback)(void *))
 {
-   if (tree->root) {
+   long i;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < tree->nodes; i++) {
+         (*callback)(tree->small[i]);
+      }
+   } else if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) do_x(tree->x_root, callback);
       else            do_l(tree->l_root, callback);
    }
@@ -2189,7 +4674,13 @@ void avl_do(TREE *tree, void (*callback)(void *))
 
 void avl_rev_do(TREE *tree, void (*callback)(void *))
 {
-   if (tree->root) {
+   long i;
+
+   if (IS_SMALL(tree)) {
+      for (i = tree->nodes - 1; i >= 0; i--) {
+         (*callback)(tree->small[i]);
+      }
+   } else if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) rev_do_x(tree->x_root, callback);
       else            rev_do_l(tree->l_root, callback);
    }
@@ -2235,7 +4726,13 @@ static void rev_do_w_ctx_l(L_NODE *l_root, void (*callback)(void *, void *), voi
 
 void avl_do_w_ctx(TREE *tree, void (*callback)(void *, void *), void *context)
 {
-   if (tree->root) {
+   long i;
+
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < tree->nodes; i++) {
+         (*callback)(tree->small[i], context);
+      }
+   } else if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) do_w_ctx_x(tree->x_root, callback, context);
       else            do_w_ctx_l(tree->l_root, callback, context);
    }
@@ -2245,7 +4742,13 @@ void avl_do_w_ctx(TREE *tree, void (*callback)(void *, void *), void *context)
 
 void avl_rev_do_w_ctx(TREE *tree, void (*callback)(void *, void *), void *context)
 {
-   if (tree->root) {
+   long i;
+
+   if (IS_SMALL(tree)) {
+      for (i = tree->nodes - 1; i >= 0; i--) {
+         (*callback)(tree->small[i], context);
+      }
+   } else if (tree->root && !IS_SET(tree)) {
       if (IS_X(tree)) rev_do_w_ctx_x(tree->x_root, callback, context);
       else            rev_do_w_ctx_l(tree->l_root, callback, context);
    }
@@ -2253,22 +4756,27 @@ void avl_rev_do_w_ctx(TREE *tree, void (*callback)(void *, void *), void *contex
 
 /*===========================================================================*/
 
-void *avl_first(TREE *tree)
+/* Position the path of a small tree on the item at index i, returning it, or NULL if there is none.
+ * Instead of nodes, the path then points into the array of the tree, and just moves along it.
+ */
+static void *small_path_at(TREE *tree, PATH *path, long i)
+{
+   if (i < 0 || i >= tree->nodes) return NULL;
+   path->pathnode = &tree->small[i];
+   return tree->small[i];
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void *path_first(TREE *tree, PATH *path)
 {
-   PATH   *path;
    char   *pathright;
    void  **pathnode;
    X_NODE *x_node;
    L_NODE *l_node;
 
+   if (IS_SMALL(tree)) return small_path_at(tree, path, 0);
    if ( !tree->root) return NULL;
-   if ( !tree->path) {
-      path = AVL_MALLOC(sizeof(*path));
-      if ( !path) return NULL;
-      tree->path = path;
-   } else {
-      path = tree->path;
-   }
    pathnode  = &path->node [0];
    pathright = &path->right[1];
    *  pathnode  = NULL; /* sentinels */
@@ -2295,22 +4803,15 @@ void *avl_first(TREE *tree)
 
 /*---------------------------------------------------------------------------*/
 
-void *avl_last(TREE *tree)
+static void *path_last(TREE *tree, PATH *path)
 {
-   PATH   *path;
    char   *pathright;
    void  **pathnode;
    X_NODE *x_node;
    L_NODE *l_node;
 
+   if (IS_SMALL(tree)) return small_path_at(tree, path, tree->nodes - 1);
    if ( !tree->root) return NULL;
-   if ( !tree->path) {
-      path = AVL_MALLOC(sizeof(*path));
-      if ( !path) return NULL;
-      tree->path = path;
-   } else {
-      path = tree->path;
-   }
    pathnode  = &path->node [0];
    pathright = &path->right[1];
    *  pathnode  = NULL; /* sentinels */
@@ -2358,9 +4859,12 @@ void *avl_last(TREE *tree)
 
 /*---------------------------------------------------------------------------*/
 
-static void *start_x_l(TREE *tree, void *key, bool rev)
+/* Position the path on the node that would be found by avl_locate_ge [avl_locate_le] (q.v.).
+ * If near is true, the descent starts from the node the path is on, whose ancestors must bound the key
+ * strictly on both sides (see cursor_near_x_l()).
+ */
+static void *path_start_x_l(TREE *tree, PATH *path, void *key, bool rev, bool near)
 {
-   PATH    *path;
    char    *pathright;
    X_NODE **x_pathnode;
    L_NODE **l_pathnode;
@@ -2374,34 +4878,44 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
    int      cmp;
    bool     ind = false;
 
+   if (IS_SMALL(tree)) return small_path_at(tree, path, small_index(tree, key, rev, NULL) - rev);
    if ( !tree->root) return NULL;
-   if ( !tree->path) {
-      path = AVL_MALLOC(sizeof(*path));
-      if ( !path) return NULL;
-      tree->path = path;
-   } else {
-      path = tree->path;
-   }
-   x_pathnode    = &path->x_node[0];
-   l_pathnode    = &path->l_node[0];
-   pathright     = &path->right [1];
    saveright     = NULL;
    x_savenode    = NULL;
    l_savenode    = NULL;
-   *x_pathnode   = NULL; /* sentinels */
-   *pathright    = !rev;
-   *++x_pathnode = NULL;
-    ++l_pathnode;
-   *++pathright  = rev;
-   *++x_pathnode = tree->root;
-    ++l_pathnode;
+   if (near) {
+      x_pathnode = path->x_pathnode;
+      l_pathnode = path->l_pathnode;
+      pathright  = path->pathright;
+      /* the node to return if the subtree has none is the nearest ancestor whose subtree the path enters
+       * from the left [right], if it's not the sentinel */
+      for (saveright = pathright; *saveright != rev; saveright--) {}
+      saveright--;
+      if (path->node[saveright - path->right]) {
+         if (IS_X(tree)) x_savenode = &path->x_node[saveright - path->right];
+         else            l_savenode = &path->l_node[saveright - path->right];
+      } else {
+         saveright = NULL;
+      }
+   } else {
+      x_pathnode    = &path->x_node[0];
+      l_pathnode    = &path->l_node[0];
+      pathright     = &path->right [1];
+      *x_pathnode   = NULL; /* sentinels */
+      *pathright    = !rev;
+      *++x_pathnode = NULL;
+       ++l_pathnode;
+      *++pathright  = rev;
+      *++x_pathnode = tree->root;
+       ++l_pathnode;
+   }
    switch (tree->bits) {
    CASE X_PTR_NODUP:
       ind = true;
    case X_MBR_NODUP:
    case X_USR_NODUP:
       if (rev) {
-         for (x_node = tree->root; ; ) {
+         for (x_node = *x_pathnode; ; ) {
             cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, ind);
             if (cmp > 0) {
                saveright  = pathright;
@@ -2416,7 +4930,7 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
             }
          }
       } else {
-         for (x_node = tree->root; ; ) {
+         for (x_node = *x_pathnode; ; ) {
             cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, ind);
             if (cmp < 0) {
                saveright  = pathright;
@@ -2436,7 +4950,7 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
    case L_CHA_NODUP:
       l_key = l_key_of(key, &keytail);
       if (rev) {
-         for (l_node = tree->root; ; ) {
+         for (l_node = *l_pathnode; ; ) {
             if (l_key > l_node->key) {
                rev_start_nodup_gt:
                saveright  = pathright;
@@ -2462,7 +4976,7 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
             }
          }
       } else {
-         for (l_node = tree->root; ; ) {
+         for (l_node = *l_pathnode; ; ) {
             if (l_key < l_node->key) {
                start_nodup_lt:
                saveright  = pathright;
@@ -2493,7 +5007,7 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
    case X_MBR_DUP:
    case X_USR_DUP:
       if (rev) {
-         for (x_node = tree->root; ; ) {
+         for (x_node = *x_pathnode; ; ) {
             cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, ind);
             if (cmp >= 0) {
                saveright  = pathright;
@@ -2504,7 +5018,7 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
             }
          }
       } else {
-         for (x_node = tree->root; ; ) {
+         for (x_node = *x_pathnode; ; ) {
             cmp = CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, ind);
             if (cmp <= 0) {
                saveright  = pathright;
@@ -2520,7 +5034,7 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
    case L_CHA_DUP:
       l_key = l_key_of(key, &keytail);
       if (rev) {
-         for (l_node = tree->root; ; ) {
+         for (l_node = *l_pathnode; ; ) {
             if (l_key < l_node->key) {
                rev_start_dup_lt:
                DOWN_LEFT_OR_BREAK (l_node, pathright, l_pathnode)
@@ -2539,7 +5053,7 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
             }
          }
       } else {
-         for (l_node = tree->root; ; ) {
+         for (l_node = *l_pathnode; ; ) {
             if (l_key > l_node->key) {
                start_dup_gt:
                DOWN_RIGHT_OR_BREAK(l_node, pathright, l_pathnode)
@@ -2569,56 +5083,48 @@ static void *start_x_l(TREE *tree, void *key, bool rev)
       path->l_pathnode = l_savenode;
       return (*l_savenode)->data;
    }
-   AVL_FREE_AND_NULL(tree->path);
    return NULL;
 }
 
-void *avl_start          (TREE *tree, void *key) { return start_x_l(tree, key, false); }
-void *avl_start_mbr      (TREE *tree, void *key) { return start_x_l(tree, key, false); }
-void *avl_start_ptr      (TREE *tree, void *key) { return start_x_l(tree, key, false); }
-void *avl_start_chars    (TREE *tree, char *key) { return start_x_l(tree, key, false); }
-void *avl_start_str      (TREE *tree, char *key) { return start_x_l(tree, key, false); }
-
-void *avl_rev_start      (TREE *tree, void *key) { return start_x_l(tree, key, true); }
-void *avl_rev_start_mbr  (TREE *tree, void *key) { return start_x_l(tree, key, true); }
-void *avl_rev_start_ptr  (TREE *tree, void *key) { return start_x_l(tree, key, true); }
-void *avl_rev_start_chars(TREE *tree, char *key) { return start_x_l(tree, key, true); }
-void *avl_rev_start_str  (TREE *tree, char *key) { return start_x_l(tree, key, true); }
-
-/*---------------------------------------------------------------------------*/
-
-static void *start_l(TREE *tree, long key, bool rev)
+/* Like path_start_x_l().
+ */
+static void *path_start_l(TREE *tree, PATH *path, long key, bool rev, bool near)
 {
-   PATH    *path;
    char    *pathright;
    L_NODE **l_pathnode;
    L_NODE  *l_node;
    char    *saveright;
    L_NODE **l_savenode;
 
+   if (IS_SMALL(tree)) return small_path_at(tree, path, small_index_long(tree, key, rev, NULL) - rev);
    if ( !tree->root) return NULL;
-   if ( !tree->path) {
-      path = AVL_MALLOC(sizeof(*path));
-      if ( !path) return NULL;
-      tree->path = path;
-   } else {
-      path = tree->path;
-   }
-   l_pathnode    = &path->l_node[0];
-   pathright     = &path->right [1];
    saveright     = NULL;
    l_savenode    = NULL;
-   *l_pathnode   = NULL; /* sentinels */
-   *pathright    = !rev;
-   *++l_pathnode = NULL;
-   *++pathright  = rev;
-   *++l_pathnode = tree->root;
+   if (near) {
+      l_pathnode = path->l_pathnode;
+      pathright  = path->pathright;
+      for (saveright = pathright; *saveright != rev; saveright--) {}
+      saveright--;
+      if (path->node[saveright - path->right]) {
+         l_savenode = &path->l_node[saveright - path->right];
+      } else {
+         saveright = NULL;
+      }
+   } else {
+      l_pathnode    = &path->l_node[0];
+      pathright     = &path->right [1];
+      *l_pathnode   = NULL; /* sentinels */
+      *pathright    = !rev;
+      *++l_pathnode = NULL;
+      *++pathright  = rev;
+      *++l_pathnode = tree->root;
+   }
    switch (tree->bits) {
    CASE L_COR_NODUP:
       key = CORRECT(key);
    case L_VAL_NODUP:
       if (rev) {
-         for (l_node = tree->root; ; ) {
+         for (l_node = *l_pathnode; ; ) {
             if (key > l_node->key) {
                saveright  = pathright;
                l_savenode = l_pathnode;
@@ -2632,7 +5138,7 @@ static void *start_l(TREE *tree, long key, bool rev)
             }
          }
       } else {
-         for (l_node = tree->root; ; ) {
+         for (l_node = *l_pathnode; ; ) {
             if (key < l_node->key) {
                saveright  = pathright;
                l_savenode = l_pathnode;
@@ -2650,7 +5156,7 @@ static void *start_l(TREE *tree, long key, bool rev)
       key = CORRECT(key);
    case L_VAL_DUP:
       if (rev) {
-         for (l_node = tree->root; ; ) {
+         for (l_node = *l_pathnode; ; ) {
             if (key >= l_node->key) {
                saveright  = pathright;
                l_savenode = l_pathnode;
@@ -2660,7 +5166,7 @@ static void *start_l(TREE *tree, long key, bool rev)
             }
          }
       } else {
-         for (l_node = tree->root; ; ) {
+         for (l_node = *l_pathnode; ; ) {
             if (key <= l_node->key) {
                saveright  = pathright;
                l_savenode = l_pathnode;
@@ -2676,66 +5182,17 @@ static void *start_l(TREE *tree, long key, bool rev)
       path->l_pathnode = l_savenode;
       return (*l_savenode)->data;
    }
-   AVL_FREE_AND_NULL(tree->path);
    return NULL;
 }
 
-void *avl_start_long      (TREE *tree, long   key) { return start_l(tree, key, false); }
-void *avl_start_int       (TREE *tree, int    key) { return start_l(tree, key, false); }
-void *avl_start_short     (TREE *tree, short  key) { return start_l(tree, key, false); }
-void *avl_start_schar     (TREE *tree, SCHAR  key) { return start_l(tree, key, false); }
-void *avl_start_ulong     (TREE *tree, ULONG  key) { return start_l(tree, key, false); }
-void *avl_start_uint      (TREE *tree, UINT   key) { return start_l(tree, key, false); }
-void *avl_start_ushort    (TREE *tree, USHORT key) { return start_l(tree, key, false); }
-void *avl_start_uchar     (TREE *tree, UCHAR  key) { return start_l(tree, key, false); }
-
-void *avl_rev_start_long  (TREE *tree, long   key) { return start_l(tree, key, true); }
-void *avl_rev_start_int   (TREE *tree, int    key) { return start_l(tree, key, true); }
-void *avl_rev_start_short (TREE *tree, short  key) { return start_l(tree, key, true); }
-void *avl_rev_start_schar (TREE *tree, SCHAR  key) { return start_l(tree, key, true); }
-void *avl_rev_start_ulong (TREE *tree, ULONG  key) { return start_l(tree, key, true); }
-void *avl_rev_start_uint  (TREE *tree, UINT   key) { return start_l(tree, key, true); }
-void *avl_rev_start_ushort(TREE *tree, USHORT key) { return start_l(tree, key, true); }
-void *avl_rev_start_uchar (TREE *tree, UCHAR  key) { return start_l(tree, key, true); }
-
-/*---------------------------------------------------------------------------*/
-
-void *avl_start_float(TREE *tree, float key)
-{
-   if (IS_X(tree)) return start_x_l(tree, &key,         false);
-   else            return start_l  (tree, flt2lng(key), false);
-}
-
-void *avl_start_double(TREE *tree, double key)
-{
-   if (IS_X(tree)) return start_x_l(tree, &key,         false);
-   else            return start_l  (tree, dbl2lng(key), false);
-}
-
-void *avl_rev_start_float(TREE *tree, float key)
-{
-   if (IS_X(tree)) return start_x_l(tree, &key,         true);
-   else            return start_l  (tree, flt2lng(key), true);
-}
-
-void *avl_rev_start_double(TREE *tree, double key)
-{
-   if (IS_X(tree)) return start_x_l(tree, &key,         true);
-   else            return start_l  (tree, dbl2lng(key), true);
-}
-
-/*---------------------------------------------------------------------------*/
-
-void *avl_next(TREE *tree)
+static void *path_next(TREE *tree, PATH *path)
 {
-   PATH   *path;
    char   *pathright;
    void  **pathnode;
    X_NODE *x_node;
    L_NODE *l_node;
 
-   path = tree->path;
-   if ( !path) return NULL;
+   if (IS_SMALL(tree)) return small_path_at(tree, path, path->pathnode - tree->small + 1);
    pathright = path->pathright;
    pathnode  = path->pathnode;
    if (IS_X(tree)) {
@@ -2756,10 +5213,7 @@ void *avl_next(TREE *tree)
          }
          --pathright;
          --pathnode;
-         if ( !*pathnode) {
-            AVL_FREE_AND_NULL(tree->path);
-            return NULL;
-         }
+         if ( !*pathnode) return NULL;
       }
       path->pathright = pathright;
       path->pathnode  = pathnode;
@@ -2782,10 +5236,7 @@ void *avl_next(TREE *tree)
          }
          --pathright;
          --pathnode;
-         if ( !*pathnode) {
-            AVL_FREE_AND_NULL(tree->path);
-            return NULL;
-         }
+         if ( !*pathnode) return NULL;
       }
       path->pathright = pathright;
       path->pathnode  = pathnode;
@@ -2796,16 +5247,14 @@ void *avl_next(TREE *tree)
 
 /*---------------------------------------------------------------------------*/
 
-void *avl_prev(TREE *tree)
+static void *path_prev(TREE *tree, PATH *path)
 {
-   PATH  *path;
-   char  *pathright;
-   void **pathnode;
+   char   *pathright;
+   void  **pathnode;
    X_NODE *x_node;
    L_NODE *l_node;
 
-   path = tree->path;
-   if ( !path) return NULL;
+   if (IS_SMALL(tree)) return small_path_at(tree, path, path->pathnode - tree->small - 1);
    pathright = path->pathright;
    pathnode  = path->pathnode;
    if (IS_X(tree)) {
@@ -2826,10 +5275,7 @@ void *avl_prev(TREE *tree)
          }
          --pathright;
          --pathnode;
-         if ( !*pathnode) {
-            AVL_FREE_AND_NULL(tree->path);
-            return NULL;
-         }
+         if ( !*pathnode) return NULL;
       }
       path->pathright = pathright;
       path->pathnode  = pathnode;
@@ -2852,10 +5298,7 @@ void *avl_prev(TREE *tree)
          }
          --pathright;
          --pathnode;
-         if ( !*pathnode) {
-            AVL_FREE_AND_NULL(tree->path);
-            return NULL;
-         }
+         if ( !*pathnode) return NULL;
       }
       path->pathright = pathright;
       path->pathnode  = pathnode;
@@ -2864,156 +5307,589 @@ void *avl_prev(TREE *tree)
    return NULL;
 }
 
-/*---------------------------------------------------------------------------*/
+/*===========================================================================*/
 
-void avl_stop(TREE *tree)
+static PATH *tree_path(TREE *tree)
 {
-   if (tree->path) {
-      AVL_FREE_AND_NULL(tree->path);
+   if ( !tree->path) {
+      tree->path = TREE_MALLOC(tree, sizeof(PATH));
    }
+   return tree->path;
 }
 
-/*===========================================================================*/
+/*---------------------------------------------------------------------------*/
 
-typedef struct {
-   size_t offset;
-   void  *data;
-} LINK;
+void *avl_first(TREE *tree)
+{
+   if (IS_EMPTY(tree) || IS_SET(tree) || !tree_path(tree)) return NULL;
+   return path_first(tree, tree->path);
+}
+
+void *avl_last(TREE *tree)
+{
+   if (IS_EMPTY(tree) || IS_SET(tree) || !tree_path(tree)) return NULL;
+   return path_last(tree, tree->path);
+}
 
 /*---------------------------------------------------------------------------*/
 
-static void link_x(X_NODE *x_node, LINK *link)
+static void *start_x_l(TREE *tree, void *key, bool rev)
 {
-   if (x_node->right) link_x(PTR_OF(x_node->right), link);
-   *(void **)PTRADD(x_node->data, link->offset) = link->data;
-   link->data = x_node->data;
-   if (x_node->left)  link_x(PTR_OF(x_node->left),  link);
+   void *data;
+
+   if (IS_EMPTY(tree) || IS_SET(tree) || !tree_path(tree)) return NULL;
+   data = path_start_x_l(tree, tree->path, key, rev, false);
+   if ( !data) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   return data;
 }
 
+void *avl_start          (TREE *tree, void *key) { return start_x_l(tree, key, false); }
+void *avl_start_mbr      (TREE *tree, void *key) { return start_x_l(tree, key, false); }
+void *avl_start_ptr      (TREE *tree, void *key) { return start_x_l(tree, key, false); }
+void *avl_start_chars    (TREE *tree, char *key) { return start_x_l(tree, key, false); }
+void *avl_start_str      (TREE *tree, char *key) { return start_x_l(tree, key, false); }
+
+void *avl_rev_start      (TREE *tree, void *key) { return start_x_l(tree, key, true); }
+void *avl_rev_start_mbr  (TREE *tree, void *key) { return start_x_l(tree, key, true); }
+void *avl_rev_start_ptr  (TREE *tree, void *key) { return start_x_l(tree, key, true); }
+void *avl_rev_start_chars(TREE *tree, char *key) { return start_x_l(tree, key, true); }
+void *avl_rev_start_str  (TREE *tree, char *key) { return start_x_l(tree, key, true); }
+
 /*---------------------------------------------------------------------------*/
 
-static void link_l(L_NODE *l_node, LINK *link)
+static void *start_l(TREE *tree, long key, bool rev)
 {
-   if (l_node->right) link_l(PTR_OF(l_node->right), link);
-   *(void **)PTRADD(l_node->data, link->offset) = link->data;
-   link->data = l_node->data;
-   if (l_node->left)  link_l(PTR_OF(l_node->left),  link);
+   void *data;
+
+   if (IS_EMPTY(tree) || IS_SET(tree) || !tree_path(tree)) return NULL;
+   data = path_start_l(tree, tree->path, key, rev, false);
+   if ( !data) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   return data;
 }
 
+void *avl_start_long      (TREE *tree, long   key) { return start_l(tree, key, false); }
+void *avl_start_int       (TREE *tree, int    key) { return start_l(tree, key, false); }
+void *avl_start_short     (TREE *tree, short  key) { return start_l(tree, key, false); }
+void *avl_start_schar     (TREE *tree, SCHAR  key) { return start_l(tree, key, false); }
+void *avl_start_ulong     (TREE *tree, ULONG  key) { return start_l(tree, key, false); }
+void *avl_start_uint      (TREE *tree, UINT   key) { return start_l(tree, key, false); }
+void *avl_start_ushort    (TREE *tree, USHORT key) { return start_l(tree, key, false); }
+void *avl_start_uchar     (TREE *tree, UCHAR  key) { return start_l(tree, key, false); }
+
+void *avl_rev_start_long  (TREE *tree, long   key) { return start_l(tree, key, true); }
+void *avl_rev_start_int   (TREE *tree, int    key) { return start_l(tree, key, true); }
+void *avl_rev_start_short (TREE *tree, short  key) { return start_l(tree, key, true); }
+void *avl_rev_start_schar (TREE *tree, SCHAR  key) { return start_l(tree, key, true); }
+void *avl_rev_start_ulong (TREE *tree, ULONG  key) { return start_l(tree, key, true); }
+void *avl_rev_start_uint  (TREE *tree, UINT   key) { return start_l(tree, key, true); }
+void *avl_rev_start_ushort(TREE *tree, USHORT key) { return start_l(tree, key, true); }
+void *avl_rev_start_uchar (TREE *tree, UCHAR  key) { return start_l(tree, key, true); }
+
 /*---------------------------------------------------------------------------*/
 
-static void rev_link_x(X_NODE *x_node, LINK *link)
+void *avl_start_float(TREE *tree, float key)
 {
-   if (x_node->left)  rev_link_x(PTR_OF(x_node->left),  link);
-   *(void **)PTRADD(x_node->data, link->offset) = link->data;
-   link->data = x_node->data;
-   if (x_node->right) rev_link_x(PTR_OF(x_node->right), link);
+   if (IS_X(tree)) return start_x_l(tree, &key,         false);
+   else            return start_l  (tree, flt2lng(key), false);
 }
 
-/*---------------------------------------------------------------------------*/
+void *avl_start_double(TREE *tree, double key)
+{
+   if (IS_X(tree)) return start_x_l(tree, &key,         false);
+   else            return start_l  (tree, dbl2lng(key), false);
+}
 
-static void rev_link_l(L_NODE *l_node, LINK *link)
+void *avl_rev_start_float(TREE *tree, float key)
 {
-   if (l_node->left)  rev_link_l(PTR_OF(l_node->left),  link);
-   *(void **)PTRADD(l_node->data, link->offset) = link->data;
-   link->data = l_node->data;
-   if (l_node->right) rev_link_l(PTR_OF(l_node->right), link);
+   if (IS_X(tree)) return start_x_l(tree, &key,         true);
+   else            return start_l  (tree, flt2lng(key), true);
+}
+
+void *avl_rev_start_double(TREE *tree, double key)
+{
+   if (IS_X(tree)) return start_x_l(tree, &key,         true);
+   else            return start_l  (tree, dbl2lng(key), true);
 }
 
 /*---------------------------------------------------------------------------*/
 
-void *avl_linked_list(TREE *tree, size_t ptroffs, bool rev)
+void *avl_next(TREE *tree)
 {
-   LINK link;
-   link.offset = ptroffs;
-   link.data   = NULL;
-   if (tree->root) {
-      if (IS_X(tree)) {
-         if (rev) rev_link_x(tree->root, &link);
-         else     link_x    (tree->root, &link);
-      } else {
-         if (rev) rev_link_l(tree->root, &link);
-         else     link_l    (tree->root, &link);
-      }
+   void *data;
+
+   if ( !tree->path) return NULL;
+   data = path_next(tree, tree->path);
+   if ( !data) {
+      TREE_FREE_AND_NULL(tree, tree->path);
    }
-   return link.data;
+   return data;
 }
 
-/*===========================================================================*/
+void *avl_prev(TREE *tree)
+{
+   void *data;
 
-long avl_nodes(TREE *tree)
+   if ( !tree->path) return NULL;
+   data = path_prev(tree, tree->path);
+   if ( !data) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   return data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void avl_stop(TREE *tree)
 {
-   return tree->nodes;
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
 }
 
 /*===========================================================================*/
 
-static bool copy_x(TREE *newtree, X_NODE *x_newroot, X_NODE *x_root)
+void *avl_cursor_first(TREE *tree, AVL_CURSOR *cursor)
 {
-   x_newroot->data = x_root->data;
-   if (x_root->left) {
-      if (newtree->avail) {
-         x_newroot->left = --newtree->x_store;
-         newtree->avail--;
-      } else {
-         x_newroot->left = alloc_node_x(newtree);
-         if ( !x_newroot->left) return false;
-      }
-      if ( !copy_x(newtree, x_newroot->left, PTR_OF(x_root->left))) {
-         return false;
-      }
-      if (IS_DEEPER(x_root->left)) {
-         x_newroot->leftval |= DEEPER;
-      }
-   } else {
-      x_newroot->left = NULL;
+   if (IS_EMPTY(tree) || IS_SET(tree)) {
+      cursor->tree = NULL;
+      return NULL;
    }
-   if (x_root->right) {
-      if (newtree->avail) {
-         x_newroot->right = --newtree->x_store;
-         newtree->avail--;
-      } else {
-         x_newroot->right = alloc_node_x(newtree);
-         if ( !x_newroot->right) return false;
-      }
-      if ( !copy_x(newtree, x_newroot->right, PTR_OF(x_root->right))) {
-         return false;
-      }
-      if (IS_DEEPER(x_root->right)) {
-         x_newroot->rightval |= DEEPER;
-      }
-   } else {
-      x_newroot->right = NULL;
+   cursor->tree = tree;
+   return path_first(tree, cursor);
+}
+
+void *avl_cursor_last(TREE *tree, AVL_CURSOR *cursor)
+{
+   if (IS_EMPTY(tree) || IS_SET(tree)) {
+      cursor->tree = NULL;
+      return NULL;
    }
-   return true;
+   cursor->tree = tree;
+   return path_last(tree, cursor);
 }
 
 /*---------------------------------------------------------------------------*/
 
-static bool copy_l(TREE *newtree, L_NODE *l_newroot, L_NODE *l_root)
+static void *cursor_start_x_l(TREE *tree, AVL_CURSOR *cursor, void *key, bool rev)
 {
-   l_newroot->key  = l_root->key;
-   l_newroot->data = l_root->data;
-   if (l_root->left) {
-      if (newtree->avail) {
-         l_newroot->left = --newtree->l_store;
-         newtree->avail--;
-      } else {
-         l_newroot->left = alloc_node_l(newtree);
-         if ( !l_newroot->left) return false;
-      }
-      if ( !copy_l(newtree, l_newroot->left,  PTR_OF(l_root->left))) {
-         return false;
-      }
-      if (IS_DEEPER(l_root->left)) {
-         l_newroot->leftval |= DEEPER;
-      }
-   } else {
-      l_newroot->left = NULL;
-   }
+   void *data;
+
+   if (IS_SET(tree)) {
+      cursor->tree = NULL;
+      return NULL;
+   }
+   data = path_start_x_l(tree, cursor, key, rev, false);
+   cursor->tree = data ? tree : NULL;
+   return data;
+}
+
+void *avl_cursor_start          (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_start_x_l(tree, cursor, key, false); }
+void *avl_cursor_start_mbr      (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_start_x_l(tree, cursor, key, false); }
+void *avl_cursor_start_ptr      (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_start_x_l(tree, cursor, key, false); }
+void *avl_cursor_start_chars    (TREE *tree, AVL_CURSOR *cursor, char *key) { return cursor_start_x_l(tree, cursor, key, false); }
+void *avl_cursor_start_str      (TREE *tree, AVL_CURSOR *cursor, char *key) { return cursor_start_x_l(tree, cursor, key, false); }
+
+void *avl_cursor_rev_start      (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_start_x_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_mbr  (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_start_x_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_ptr  (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_start_x_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_chars(TREE *tree, AVL_CURSOR *cursor, char *key) { return cursor_start_x_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_str  (TREE *tree, AVL_CURSOR *cursor, char *key) { return cursor_start_x_l(tree, cursor, key, true); }
+
+/*---------------------------------------------------------------------------*/
+
+static void *cursor_start_l(TREE *tree, AVL_CURSOR *cursor, long key, bool rev)
+{
+   void *data;
+
+   if (IS_SET(tree)) {
+      cursor->tree = NULL;
+      return NULL;
+   }
+   data = path_start_l(tree, cursor, key, rev, false);
+   cursor->tree = data ? tree : NULL;
+   return data;
+}
+
+void *avl_cursor_start_long      (TREE *tree, AVL_CURSOR *cursor, long   key) { return cursor_start_l(tree, cursor, key, false); }
+void *avl_cursor_start_int       (TREE *tree, AVL_CURSOR *cursor, int    key) { return cursor_start_l(tree, cursor, key, false); }
+void *avl_cursor_start_short     (TREE *tree, AVL_CURSOR *cursor, short  key) { return cursor_start_l(tree, cursor, key, false); }
+void *avl_cursor_start_schar     (TREE *tree, AVL_CURSOR *cursor, SCHAR  key) { return cursor_start_l(tree, cursor, key, false); }
+void *avl_cursor_start_ulong     (TREE *tree, AVL_CURSOR *cursor, ULONG  key) { return cursor_start_l(tree, cursor, key, false); }
+void *avl_cursor_start_uint      (TREE *tree, AVL_CURSOR *cursor, UINT   key) { return cursor_start_l(tree, cursor, key, false); }
+void *avl_cursor_start_ushort    (TREE *tree, AVL_CURSOR *cursor, USHORT key) { return cursor_start_l(tree, cursor, key, false); }
+void *avl_cursor_start_uchar     (TREE *tree, AVL_CURSOR *cursor, UCHAR  key) { return cursor_start_l(tree, cursor, key, false); }
+
+void *avl_cursor_rev_start_long  (TREE *tree, AVL_CURSOR *cursor, long   key) { return cursor_start_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_int   (TREE *tree, AVL_CURSOR *cursor, int    key) { return cursor_start_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_short (TREE *tree, AVL_CURSOR *cursor, short  key) { return cursor_start_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_schar (TREE *tree, AVL_CURSOR *cursor, SCHAR  key) { return cursor_start_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_ulong (TREE *tree, AVL_CURSOR *cursor, ULONG  key) { return cursor_start_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_uint  (TREE *tree, AVL_CURSOR *cursor, UINT   key) { return cursor_start_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_ushort(TREE *tree, AVL_CURSOR *cursor, USHORT key) { return cursor_start_l(tree, cursor, key, true); }
+void *avl_cursor_rev_start_uchar (TREE *tree, AVL_CURSOR *cursor, UCHAR  key) { return cursor_start_l(tree, cursor, key, true); }
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_cursor_start_float(TREE *tree, AVL_CURSOR *cursor, float key)
+{
+   if (IS_X(tree)) return cursor_start_x_l(tree, cursor, &key,         false);
+   else            return cursor_start_l  (tree, cursor, flt2lng(key), false);
+}
+
+void *avl_cursor_start_double(TREE *tree, AVL_CURSOR *cursor, double key)
+{
+   if (IS_X(tree)) return cursor_start_x_l(tree, cursor, &key,         false);
+   else            return cursor_start_l  (tree, cursor, dbl2lng(key), false);
+}
+
+void *avl_cursor_rev_start_float(TREE *tree, AVL_CURSOR *cursor, float key)
+{
+   if (IS_X(tree)) return cursor_start_x_l(tree, cursor, &key,         true);
+   else            return cursor_start_l  (tree, cursor, flt2lng(key), true);
+}
+
+void *avl_cursor_rev_start_double(TREE *tree, AVL_CURSOR *cursor, double key)
+{
+   if (IS_X(tree)) return cursor_start_x_l(tree, cursor, &key,         true);
+   else            return cursor_start_l  (tree, cursor, dbl2lng(key), true);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Like cursor_start_x_l(), but climbing from the node the cursor is on only up to the lowest node
+ * whose ancestors bound the key strictly on both sides (like path_to_x() does), and descending from there.
+ */
+static void *cursor_near_x_l(TREE *tree, AVL_CURSOR *cursor, void *key)
+{
+   X_NODE *x_node;
+   L_NODE *l_node;
+   long    l_key;
+   char   *keytail;
+   void   *data;
+   bool    ind = IS_IND(tree), lo_ok = false, hi_ok = false;
+   int     i, n;
+
+   if (cursor->tree != tree || IS_SMALL(tree) || (tree->bits & VAL_BIT && !IS_X(tree))) {
+      return cursor_start_x_l(tree, cursor, key, false);
+   }
+   n = (int)(cursor->pathnode - cursor->node);
+   if (IS_X(tree)) {
+      for (i = n - 1; i >= 2 && !(lo_ok && hi_ok); i--) {
+         x_node = cursor->x_node[i];
+         if (cursor->right[i + 1]) {
+            if ( !lo_ok) {
+               if (CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, ind) > 0) lo_ok = true;
+               else n = i;
+            }
+         } else {
+            if ( !hi_ok) {
+               if (CMP(tree->usrcmp, key, x_node->data, tree->keyoffs, ind) < 0) hi_ok = true;
+               else n = i;
+            }
+         }
+      }
+   } else {
+      l_key = l_key_of(key, &keytail);
+      for (i = n - 1; i >= 2 && !(lo_ok && hi_ok); i--) {
+         l_node = cursor->l_node[i];
+         if (cursor->right[i + 1]) {
+            if ( !lo_ok) {
+               if (cmp_l(l_key, keytail, l_node, tree->keyoffs, ind) > 0) lo_ok = true;
+               else n = i;
+            }
+         } else {
+            if ( !hi_ok) {
+               if (cmp_l(l_key, keytail, l_node, tree->keyoffs, ind) < 0) hi_ok = true;
+               else n = i;
+            }
+         }
+      }
+   }
+   cursor->pathnode  = &cursor->node [n];
+   cursor->pathright = &cursor->right[n];
+   data = path_start_x_l(tree, cursor, key, false, true);
+   cursor->tree = data ? tree : NULL;
+   return data;
+}
+
+void *avl_locate_near      (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_near_x_l(tree, cursor, key); }
+void *avl_locate_near_mbr  (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_near_x_l(tree, cursor, key); }
+void *avl_locate_near_ptr  (TREE *tree, AVL_CURSOR *cursor, void *key) { return cursor_near_x_l(tree, cursor, key); }
+void *avl_locate_near_chars(TREE *tree, AVL_CURSOR *cursor, char *key) { return cursor_near_x_l(tree, cursor, key); }
+void *avl_locate_near_str  (TREE *tree, AVL_CURSOR *cursor, char *key) { return cursor_near_x_l(tree, cursor, key); }
+
+/*---------------------------------------------------------------------------*/
+
+/* Like cursor_near_x_l().
+ */
+static void *cursor_near_l(TREE *tree, AVL_CURSOR *cursor, long key)
+{
+   L_NODE *l_node;
+   long    l_key = IS_CORR(tree) ? CORRECT(key) : key;
+   void   *data;
+   bool    lo_ok = false, hi_ok = false;
+   int     i, n;
+
+   if (cursor->tree != tree || IS_SMALL(tree) || !(tree->bits & VAL_BIT) || IS_X(tree)) {
+      return cursor_start_l(tree, cursor, key, false);
+   }
+   n = (int)(cursor->pathnode - cursor->node);
+   for (i = n - 1; i >= 2 && !(lo_ok && hi_ok); i--) {
+      l_node = cursor->l_node[i];
+      if (cursor->right[i + 1]) {
+         if ( !lo_ok) {
+            if (l_key > l_node->key) lo_ok = true;
+            else n = i;
+         }
+      } else {
+         if ( !hi_ok) {
+            if (l_key < l_node->key) hi_ok = true;
+            else n = i;
+         }
+      }
+   }
+   cursor->pathnode  = &cursor->node [n];
+   cursor->pathright = &cursor->right[n];
+   data = path_start_l(tree, cursor, key, false, true);
+   cursor->tree = data ? tree : NULL;
+   return data;
+}
+
+void *avl_locate_near_long  (TREE *tree, AVL_CURSOR *cursor, long   key) { return cursor_near_l(tree, cursor, key); }
+void *avl_locate_near_int   (TREE *tree, AVL_CURSOR *cursor, int    key) { return cursor_near_l(tree, cursor, key); }
+void *avl_locate_near_short (TREE *tree, AVL_CURSOR *cursor, short  key) { return cursor_near_l(tree, cursor, key); }
+void *avl_locate_near_schar (TREE *tree, AVL_CURSOR *cursor, SCHAR  key) { return cursor_near_l(tree, cursor, key); }
+void *avl_locate_near_ulong (TREE *tree, AVL_CURSOR *cursor, ULONG  key) { return cursor_near_l(tree, cursor, key); }
+void *avl_locate_near_uint  (TREE *tree, AVL_CURSOR *cursor, UINT   key) { return cursor_near_l(tree, cursor, key); }
+void *avl_locate_near_ushort(TREE *tree, AVL_CURSOR *cursor, USHORT key) { return cursor_near_l(tree, cursor, key); }
+void *avl_locate_near_uchar (TREE *tree, AVL_CURSOR *cursor, UCHAR  key) { return cursor_near_l(tree, cursor, key); }
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_locate_near_float(TREE *tree, AVL_CURSOR *cursor, float key)
+{
+   if (IS_X(tree)) return cursor_near_x_l(tree, cursor, &key);
+   else            return cursor_near_l  (tree, cursor, flt2lng(key));
+}
+
+void *avl_locate_near_double(TREE *tree, AVL_CURSOR *cursor, double key)
+{
+   if (IS_X(tree)) return cursor_near_x_l(tree, cursor, &key);
+   else            return cursor_near_l  (tree, cursor, dbl2lng(key));
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_cursor_next(AVL_CURSOR *cursor)
+{
+   void *data;
+
+   if ( !cursor->tree) return NULL;
+   data = path_next(cursor->tree, cursor);
+   if ( !data) {
+      cursor->tree = NULL;
+   }
+   return data;
+}
+
+void *avl_cursor_prev(AVL_CURSOR *cursor)
+{
+   void *data;
+
+   if ( !cursor->tree) return NULL;
+   data = path_prev(cursor->tree, cursor);
+   if ( !data) {
+      cursor->tree = NULL;
+   }
+   return data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void avl_cursor_stop(AVL_CURSOR *cursor)
+{
+   cursor->tree = NULL;
+}
+
+/*===========================================================================*/
+
+typedef struct {
+   size_t offset;
+   void  *data;
+} LINK;
+
+/*---------------------------------------------------------------------------*/
+
+static void link_x(X_NODE *x_node, LINK *link)
+{
+   if (x_node->right) link_x(PTR_OF(x_node->right), link);
+   *(void **)PTRADD(x_node->data, link->offset) = link->data;
+   link->data = x_node->data;
+   if (x_node->left)  link_x(PTR_OF(x_node->left),  link);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void link_l(L_NODE *l_node, LINK *link)
+{
+   if (l_node->right) link_l(PTR_OF(l_node->right), link);
+   *(void **)PTRADD(l_node->data, link->offset) = link->data;
+   link->data = l_node->data;
+   if (l_node->left)  link_l(PTR_OF(l_node->left),  link);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void rev_link_x(X_NODE *x_node, LINK *link)
+{
+   if (x_node->left)  rev_link_x(PTR_OF(x_node->left),  link);
+   *(void **)PTRADD(x_node->data, link->offset) = link->data;
+   link->data = x_node->data;
+   if (x_node->right) rev_link_x(PTR_OF(x_node->right), link);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void rev_link_l(L_NODE *l_node, LINK *link)
+{
+   if (l_node->left)  rev_link_l(PTR_OF(l_node->left),  link);
+   *(void **)PTRADD(l_node->data, link->offset) = link->data;
+   link->data = l_node->data;
+   if (l_node->right) rev_link_l(PTR_OF(l_node->right), link);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *avl_linked_list(TREE *tree, size_t ptroffs, bool rev)
+{
+   LINK link;
+   long i, n = tree->nodes;
+   link.offset = ptroffs;
+   link.data   = NULL;
+   if (IS_SMALL(tree)) {
+      for (i = 0; i < n; i++) {
+         *(void **)PTRADD(tree->small[rev ? i : n - 1 - i], ptroffs) = link.data;
+         link.data = tree->small[rev ? i : n - 1 - i];
+      }
+   } else if (tree->root && !IS_SET(tree)) {
+      if (IS_X(tree)) {
+         if (rev) rev_link_x(tree->root, &link);
+         else     link_x    (tree->root, &link);
+      } else {
+         if (rev) rev_link_l(tree->root, &link);
+         else     link_l    (tree->root, &link);
+      }
+   }
+   return link.data;
+}
+
+/*===========================================================================*/
+
+static long count_nodes_x(X_NODE *root)
+{
+   return root ? count_nodes_x(PTR_OF(root->left)) + count_nodes_x(PTR_OF(root->right)) + 1 : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static long count_nodes_l(L_NODE *root)
+{
+   return root ? count_nodes_l(PTR_OF(root->left)) + count_nodes_l(PTR_OF(root->right)) + 1 : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+long avl_nodes(TREE *tree)
+{
+   if ( !tree->counted) {
+      tree->nodes   = IS_X(tree) ? count_nodes_x(tree->x_root) : count_nodes_l(tree->l_root);
+      tree->counted = true;
+   }
+   return tree->nodes;
+}
+
+/*===========================================================================*/
+
+static bool copy_x(TREE *newtree, X_NODE *x_newroot, X_NODE *x_root)
+{
+   x_newroot->data = x_root->data;
+   if (IS_RANK(newtree)) {
+      COUNT(x_newroot) = COUNT(x_root);
+   }
+   if (x_root->left) {
+      if (newtree->avail) {
+         x_newroot->left = newtree->x_store = PTRSUB(newtree->x_store, X_NODESIZE(newtree));
+         newtree->avail--;
+      } else {
+         x_newroot->left = alloc_node_x(newtree);
+         if ( !x_newroot->left) return false;
+      }
+      if ( !copy_x(newtree, x_newroot->left, PTR_OF(x_root->left))) {
+         return false;
+      }
+      if (IS_DEEPER(x_root->left)) {
+         x_newroot->leftval |= DEEPER;
+      }
+   } else {
+      x_newroot->left = NULL;
+   }
+   if (x_root->right) {
+      if (newtree->avail) {
+         x_newroot->right = newtree->x_store = PTRSUB(newtree->x_store, X_NODESIZE(newtree));
+         newtree->avail--;
+      } else {
+         x_newroot->right = alloc_node_x(newtree);
+         if ( !x_newroot->right) return false;
+      }
+      if ( !copy_x(newtree, x_newroot->right, PTR_OF(x_root->right))) {
+         return false;
+      }
+      if (IS_DEEPER(x_root->right)) {
+         x_newroot->rightval |= DEEPER;
+      }
+   } else {
+      x_newroot->right = NULL;
+   }
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool copy_l(TREE *newtree, L_NODE *l_newroot, L_NODE *l_root)
+{
+   l_newroot->key  = l_root->key;
+   if ( !IS_SET(newtree)) {
+      l_newroot->data = l_root->data;
+   } else if (IS_MAP(newtree)) {
+      memcpy(VALUE_OF(l_newroot), VALUE_OF(l_root), newtree->keyoffs);
+   }
+   if (IS_RANK(newtree)) {
+      COUNT(l_newroot) = COUNT(l_root);
+   }
+   if (l_root->left) {
+      if (newtree->avail) {
+         l_newroot->left = newtree->l_store = PTRSUB(newtree->l_store, L_NODESIZE(newtree));
+         newtree->avail--;
+      } else {
+         l_newroot->left = alloc_node_l(newtree);
+         if ( !l_newroot->left) return false;
+      }
+      if ( !copy_l(newtree, l_newroot->left,  PTR_OF(l_root->left))) {
+         return false;
+      }
+      if (IS_DEEPER(l_root->left)) {
+         l_newroot->leftval |= DEEPER;
+      }
+   } else {
+      l_newroot->left = NULL;
+   }
    if (l_root->right) {
       if (newtree->avail) {
-         l_newroot->right = --newtree->l_store;
+         l_newroot->right = newtree->l_store = PTRSUB(newtree->l_store, L_NODESIZE(newtree));
          newtree->avail--;
       } else {
          l_newroot->right = alloc_node_l(newtree);
@@ -3037,23 +5913,42 @@ TREE *avl_copy(TREE *tree)
 {
    TREE *newtree;
 
-   newtree = AVL_MALLOC(sizeof(*newtree));
+   newtree = TREE_MALLOC(tree, sizeof(*newtree));
    if ( !newtree) return NULL;
    newtree->usrcmp  = tree->usrcmp;
    newtree->path    = NULL;
+   newtree->spine   = NULL;
+   newtree->first   = NULL;
+   newtree->last    = NULL;
    newtree->unused  = NULL;
    newtree->store   = NULL;
-   newtree->nodes   = tree->nodes;
+   newtree->small   = NULL;
+   newtree->sharing = newtree;
+   newtree->allocator = tree->allocator;
+   newtree->context   = tree->context;
+   newtree->nodes   = avl_nodes(tree);
    newtree->alloc   = 0;
    newtree->avail   = 0;
+   newtree->incmax  = tree->incmax;
    newtree->keyoffs = tree->keyoffs;
    newtree->bits    = tree->bits;
    newtree->type    = tree->type;
-   if (tree->root) {
+   newtree->shift   = tree->shift;
+   newtree->counted = true;
+   newtree->nosmall = tree->nosmall;
+   if (IS_SMALL(tree)) {
+      newtree->root  = NULL;
+      newtree->small = TREE_MALLOC(newtree, AVL_SMALL_MAX * SIZEOF_P);
+      if ( !newtree->small) {
+         TREE_FREE(newtree, newtree);
+         return NULL;
+      }
+      memcpy(newtree->small, tree->small, tree->nodes * SIZEOF_P);
+   } else if (tree->root) {
       if (IS_X(tree)) {
          newtree->x_root = alloc_node_x(newtree);
          if ( !newtree->x_root) {
-            AVL_FREE(newtree);
+            TREE_FREE(newtree, newtree);
             return NULL;
          }
          if ( !copy_x(newtree, newtree->x_root, tree->x_root)) {
@@ -3063,7 +5958,7 @@ TREE *avl_copy(TREE *tree)
       } else {
          newtree->l_root = alloc_node_l(newtree);
          if ( !newtree->l_root) {
-            AVL_FREE(newtree);
+            TREE_FREE(newtree, newtree);
             return NULL;
          }
          if ( !copy_l(newtree, newtree->l_root, tree->l_root)) {
@@ -3074,45 +5969,2077 @@ TREE *avl_copy(TREE *tree)
    } else {
       newtree->root = NULL;
    }
+   reset_ends(newtree);
    return newtree;
 }
 
 /*===========================================================================*/
 
-void avl_empty(TREE *tree)
+/* Return the base of the most recently allocated node block of the tree (NULL if none).
+ */
+static void *alloc_base_of(TREE *tree)
+{
+   if ( !tree->store) {
+      return NULL;
+   }
+   if (IS_X(tree)) {
+      return PTRSUB(tree->x_store, tree->avail * X_NODESIZE(tree) + SIZEOF_P   + CNT_SIZE(tree));
+   } else {
+      return PTRSUB(tree->l_store, tree->avail * L_NODESIZE(tree) + SIZEOF_P_L + CNT_SIZE(tree));
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avl_set_growth(TREE *tree, int shift, int max)
+{
+   if (shift < 0 || shift >= (int)(sizeof(long) * CHAR_BIT) || max < 1) {
+      return false;
+   }
+   tree->shift   = (char)shift;
+   tree->incmax  = max;
+   tree->nosmall = true; /* its nodes are to come in blocks of the given growth, not from a sorted array */
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avl_reserve(TREE *tree, long n)
+{
+   void  *alloc_base;
+   size_t header_size, nodesize;
+
+   if (IS_SMALL(tree) && n <= AVL_SMALL_MAX - tree->nodes) {
+      return true;
+   }
+   if ( !TO_NODES(tree)) {
+      return false;
+   }
+   if (n <= tree->avail) {
+      return true;
+   }
+   if (n > INT_MAX || n > LONG_MAX - tree->alloc) {
+      return false;
+   }
+   header_size = (IS_X(tree) ? SIZEOF_P        : SIZEOF_P_L       ) + CNT_SIZE(tree);
+   nodesize    =  IS_X(tree) ? X_NODESIZE(tree) : L_NODESIZE(tree);
+   if ((size_t)n > ((size_t)-1 - header_size) / nodesize) {
+      return false;
+   }
+   alloc_base = TREE_MALLOC(tree, header_size + n * nodesize);
+   if ( !alloc_base) {
+      return false;
+   }
+   /* the nodes still available in the last block join the removed ones, so that they are used first */
+   while (tree->avail) {
+      tree->store = PTRSUB(tree->store, nodesize);
+      tree->avail--;
+      PTRPUSH(tree->unused, tree->store);
+   }
+   *(void **)alloc_base = alloc_base_of(tree);
+   tree->store  = PTRADD(alloc_base, header_size + n * nodesize);
+   tree->avail  = (int)n;
+   tree->alloc += n;
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Trees resulting from avl_split() and avl_join() may have nodes in each other's node blocks.
+ * Such trees are linked in a circular list through tree->sharing (a tree alone points to itself).
+ * When a tree of the list is emptied, its blocks are handed over to the next tree of the list.
+ */
+static void share_blocks(TREE *tree, TREE *other)
+{
+   TREE *t, *next;
+
+   if (POOL_OF(tree)) {
+      return; /* all blocks belong to the pool */
+   }
+   for (t = tree; t->sharing != tree; t = t->sharing) {
+      if (t->sharing == other) return;
+   }
+   next = tree->sharing;
+   tree->sharing  = other->sharing;
+   other->sharing = next;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void unshare_blocks(TREE *tree)
+{
+   TREE *prev, *next = tree->sharing;
+   void *alloc_base, *last_alloc_base, *next_alloc_base;
+
+   for (prev = next; prev->sharing != tree; prev = prev->sharing) {}
+   prev->sharing = next;
+   tree->sharing = tree;
+   if ( !tree->alloc) {
+      return;
+   }
+   if ( !next->alloc) {
+      next->store = tree->store;
+      next->avail = tree->avail;
+   } else {
+      alloc_base = alloc_base_of(tree);
+      for (last_alloc_base = alloc_base; *(void **)last_alloc_base; last_alloc_base = *(void **)last_alloc_base) {}
+      next_alloc_base = alloc_base_of(next);
+      *(void **)last_alloc_base = *(void **)next_alloc_base;
+      *(void **)next_alloc_base = alloc_base;
+   }
+   next->alloc += tree->alloc;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int height_x(X_NODE *root)
+{
+   int height;
+
+   for (height = 0; root; height++) {
+      root = IS_DEEPER(root->left) ? PTR_OF(root->left) : PTR_OF(root->right);
+   }
+   return height;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int height_l(L_NODE *root)
+{
+   int height;
+
+   for (height = 0; root; height++) {
+      root = IS_DEEPER(root->left) ? PTR_OF(root->left) : PTR_OF(root->right);
+   }
+   return height;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static INS_T join_right_x(X_NODE **p_root, int height, X_NODE *node, X_NODE *right, int right_height, bool cnt);
+static INS_T join_left_x (X_NODE **p_root, int height, X_NODE *left, int left_height, X_NODE *node, bool cnt);
+
+/* Join left, node and right (in this order) into a single tree, whose root is stored into *p_root,
+ * and whose height is returned. The node links of node are overwritten.
+ */
+static int join_x(X_NODE **p_root, X_NODE *left, int left_height, X_NODE *node, X_NODE *right, int right_height, bool cnt)
+{
+   if (left_height > right_height + 1) {
+      *p_root = left;
+      return left_height  + (join_right_x(p_root, left_height, node, right, right_height, cnt) == INS_DEEPER);
+   } else if (right_height > left_height + 1) {
+      *p_root = right;
+      return right_height + (join_left_x(p_root, right_height, left, left_height, node, cnt) == INS_DEEPER);
+   } else {
+      node->left  = left;
+      node->right = right;
+      if (left_height > right_height) {
+         node->leftval  |= DEEPER;
+      } else if (right_height > left_height) {
+         node->rightval |= DEEPER;
+      }
+      if (cnt) {
+         RECOUNT(node);
+      }
+      *p_root = node;
+      return MAX(left_height, right_height) + 1;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Descend the right spine of *p_root until a subtree not much higher than right is found,
+ * and replace it by its join with node and right, rebalancing on the way back.
+ */
+static INS_T join_right_x(X_NODE **p_root, int height, X_NODE *node, X_NODE *right, int right_height, bool cnt)
+{
+   X_NODE *root        = PTR_OF   (*p_root);
+   UINTPTR root_deeper = IS_DEEPER(*p_root);
+
+   if (height <= right_height + 1) {
+      join_x(p_root, root, height, node, right, right_height, cnt);
+      *p_root = PTRADD(*p_root, root_deeper);
+      return INS_DEEPER;
+   }
+   if (cnt) {
+      COUNT(root) += COUNT_OF(right) + 1;
+   }
+   if (join_right_x(&root->right, IS_DEEPER(root->left) ? height - 2 : height - 1, node, right, right_height, cnt) == INS) {
+      return INS;
+   }
+   if (IS_DEEPER(root->right)) {
+      return rebalance_x(p_root, RIGHTUNBAL, cnt) == LESS ? INS : INS_DEEPER;
+   } else if (IS_DEEPER(root->left)) {
+      root->leftval &= ~DEEPER;
+      return INS;
+   } else {
+      root->rightval |= DEEPER;
+      return INS_DEEPER;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static INS_T join_left_x(X_NODE **p_root, int height, X_NODE *left, int left_height, X_NODE *node, bool cnt)
+{
+   X_NODE *root        = PTR_OF   (*p_root);
+   UINTPTR root_deeper = IS_DEEPER(*p_root);
+
+   if (height <= left_height + 1) {
+      join_x(p_root, left, left_height, node, root, height, cnt);
+      *p_root = PTRADD(*p_root, root_deeper);
+      return INS_DEEPER;
+   }
+   if (cnt) {
+      COUNT(root) += COUNT_OF(left) + 1;
+   }
+   if (join_left_x(&root->left, IS_DEEPER(root->right) ? height - 2 : height - 1, left, left_height, node, cnt) == INS) {
+      return INS;
+   }
+   if (IS_DEEPER(root->left)) {
+      return rebalance_x(p_root, LEFTUNBAL, cnt) == LESS ? INS : INS_DEEPER;
+   } else if (IS_DEEPER(root->right)) {
+      root->rightval &= ~DEEPER;
+      return INS;
+   } else {
+      root->leftval |= DEEPER;
+      return INS_DEEPER;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static INS_T join_right_l(L_NODE **p_root, int height, L_NODE *node, L_NODE *right, int right_height, bool cnt);
+static INS_T join_left_l (L_NODE **p_root, int height, L_NODE *left, int left_height, L_NODE *node, bool cnt);
+
+static int join_l(L_NODE **p_root, L_NODE *left, int left_height, L_NODE *node, L_NODE *right, int right_height, bool cnt)
+{
+   if (left_height > right_height + 1) {
+      *p_root = left;
+      return left_height  + (join_right_l(p_root, left_height, node, right, right_height, cnt) == INS_DEEPER);
+   } else if (right_height > left_height + 1) {
+      *p_root = right;
+      return right_height + (join_left_l(p_root, right_height, left, left_height, node, cnt) == INS_DEEPER);
+   } else {
+      node->left  = left;
+      node->right = right;
+      if (left_height > right_height) {
+         node->leftval  |= DEEPER;
+      } else if (right_height > left_height) {
+         node->rightval |= DEEPER;
+      }
+      if (cnt) {
+         RECOUNT(node);
+      }
+      *p_root = node;
+      return MAX(left_height, right_height) + 1;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static INS_T join_right_l(L_NODE **p_root, int height, L_NODE *node, L_NODE *right, int right_height, bool cnt)
+{
+   L_NODE *root        = PTR_OF   (*p_root);
+   UINTPTR root_deeper = IS_DEEPER(*p_root);
+
+   if (height <= right_height + 1) {
+      join_l(p_root, root, height, node, right, right_height, cnt);
+      *p_root = PTRADD(*p_root, root_deeper);
+      return INS_DEEPER;
+   }
+   if (cnt) {
+      COUNT(root) += COUNT_OF(right) + 1;
+   }
+   if (join_right_l(&root->right, IS_DEEPER(root->left) ? height - 2 : height - 1, node, right, right_height, cnt) == INS) {
+      return INS;
+   }
+   if (IS_DEEPER(root->right)) {
+      return rebalance_l(p_root, RIGHTUNBAL, cnt) == LESS ? INS : INS_DEEPER;
+   } else if (IS_DEEPER(root->left)) {
+      root->leftval &= ~DEEPER;
+      return INS;
+   } else {
+      root->rightval |= DEEPER;
+      return INS_DEEPER;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static INS_T join_left_l(L_NODE **p_root, int height, L_NODE *left, int left_height, L_NODE *node, bool cnt)
+{
+   L_NODE *root        = PTR_OF   (*p_root);
+   UINTPTR root_deeper = IS_DEEPER(*p_root);
+
+   if (height <= left_height + 1) {
+      join_l(p_root, left, left_height, node, root, height, cnt);
+      *p_root = PTRADD(*p_root, root_deeper);
+      return INS_DEEPER;
+   }
+   if (cnt) {
+      COUNT(root) += COUNT_OF(left) + 1;
+   }
+   if (join_left_l(&root->left, IS_DEEPER(root->right) ? height - 2 : height - 1, left, left_height, node, cnt) == INS) {
+      return INS;
+   }
+   if (IS_DEEPER(root->left)) {
+      return rebalance_l(p_root, LEFTUNBAL, cnt) == LESS ? INS : INS_DEEPER;
+   } else if (IS_DEEPER(root->right)) {
+      root->rightval &= ~DEEPER;
+      return INS;
+   } else {
+      root->leftval |= DEEPER;
+      return INS_DEEPER;
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Split the tree of the given root and height into the nodes with a key less than x_key,
+ * stored into *p_left, and the other ones, stored into *p_right, together with their heights.
+ */
+static void split_x(X_NODE *root, int height, void *x_key, UINT keyoffs, bool ind, CMPFUN usrcmp, bool cnt,
+                    X_NODE **p_left, int *p_left_height, X_NODE **p_right, int *p_right_height)
+{
+   X_NODE *left, *right;
+   int     left_height, right_height;
+
+   if ( !root) {
+      *p_left  = NULL;
+      *p_right = NULL;
+      *p_left_height  = 0;
+      *p_right_height = 0;
+      return;
+   }
+   left  = PTR_OF(root->left);
+   right = PTR_OF(root->right);
+   left_height  = IS_DEEPER(root->right) ? height - 2 : height - 1;
+   right_height = IS_DEEPER(root->left)  ? height - 2 : height - 1;
+   if (CMP(usrcmp, x_key, root->data, keyoffs, ind) <= 0) {
+      split_x(left,  left_height,  x_key, keyoffs, ind, usrcmp, cnt, p_left, p_left_height, p_right, p_right_height);
+      *p_right_height = join_x(p_right, *p_right, *p_right_height, root, right, right_height, cnt);
+   } else {
+      split_x(right, right_height, x_key, keyoffs, ind, usrcmp, cnt, p_left, p_left_height, p_right, p_right_height);
+      *p_left_height  = join_x(p_left, left, left_height, root, *p_left, *p_left_height, cnt);
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void split_l(L_NODE *root, int height, long l_key, char *keytail, UINT keyoffs, bool ind, bool cnt,
+                    L_NODE **p_left, int *p_left_height, L_NODE **p_right, int *p_right_height)
+{
+   L_NODE *left, *right;
+   int     left_height, right_height, cmp;
+
+   if ( !root) {
+      *p_left  = NULL;
+      *p_right = NULL;
+      *p_left_height  = 0;
+      *p_right_height = 0;
+      return;
+   }
+   left  = PTR_OF(root->left);
+   right = PTR_OF(root->right);
+   left_height  = IS_DEEPER(root->right) ? height - 2 : height - 1;
+   right_height = IS_DEEPER(root->left)  ? height - 2 : height - 1;
+   if      (l_key < root->key) cmp = -1;
+   else if (l_key > root->key) cmp =  1;
+   else if (keytail)           cmp = TAILCMP(keytail, root->data, keyoffs, ind);
+   else                        cmp =  0;
+   if (cmp <= 0) {
+      split_l(left,  left_height,  l_key, keytail, keyoffs, ind, cnt, p_left, p_left_height, p_right, p_right_height);
+      *p_right_height = join_l(p_right, *p_right, *p_right_height, root, right, right_height, cnt);
+   } else {
+      split_l(right, right_height, l_key, keytail, keyoffs, ind, cnt, p_left, p_left_height, p_right, p_right_height);
+      *p_left_height  = join_l(p_left, left, left_height, root, *p_left, *p_left_height, cnt);
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Return a new empty tree of the same kind as the given tree (NULL if out of memory).
+ */
+static TREE *empty_tree_like(TREE *tree)
+{
+   TREE *newtree;
+
+   newtree = TREE_MALLOC(tree, sizeof(*newtree));
+   if ( !newtree) return NULL;
+   newtree->root    = NULL;
+   newtree->usrcmp  = tree->usrcmp;
+   newtree->path    = NULL;
+   newtree->spine   = NULL;
+   newtree->first   = NULL;
+   newtree->last    = NULL;
+   newtree->unused  = NULL;
+   newtree->store   = NULL;
+   newtree->small   = NULL;
+   newtree->sharing = newtree;
+   newtree->allocator = tree->allocator;
+   newtree->context   = tree->context;
+   newtree->nodes   = 0;
+   newtree->alloc   = 0;
+   newtree->avail   = 0;
+   newtree->incmax  = tree->incmax;
+   newtree->keyoffs = tree->keyoffs;
+   newtree->bits    = tree->bits;
+   newtree->type    = tree->type;
+   newtree->shift   = tree->shift;
+   newtree->counted = true;
+   newtree->nosmall = tree->nosmall;
+   return newtree;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static TREE *split_tree(TREE *tree, void *x_key, long l_key, char *keytail)
+{
+   TREE   *newtree;
+   X_NODE *x_left, *x_right;
+   L_NODE *l_left, *l_right;
+   int     left_height, right_height;
+   long    i;
+
+   if (IS_SET(tree)) {
+      return NULL;
+   }
+   newtree = empty_tree_like(tree);
+   if ( !newtree) return NULL;
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if (IS_SMALL(tree)) {
+      /* the items from the split point on are copied into the array of the new tree */
+      i = small_bound(tree, x_key, l_key, keytail, false, NULL);
+      if (i < tree->nodes) {
+         newtree->small = TREE_MALLOC(newtree, AVL_SMALL_MAX * SIZEOF_P);
+         if ( !newtree->small) {
+            TREE_FREE(newtree, newtree);
+            return NULL;
+         }
+         memcpy(newtree->small, tree->small + i, (tree->nodes - i) * SIZEOF_P);
+         newtree->nodes = tree->nodes - i;
+         tree->nodes    = i;
+      }
+   } else if (tree->root) {
+      if (IS_X(tree)) {
+         split_x(tree->x_root, height_x(tree->x_root), x_key, tree->keyoffs, IS_IND(tree), tree->usrcmp, IS_RANK(tree),
+                 &x_left, &left_height, &x_right, &right_height);
+         tree->x_root    = x_left;
+         newtree->x_root = x_right;
+         if (x_right && IS_RANK(tree)) {
+            newtree->nodes = COUNT(x_right);
+         }
+      } else {
+         split_l(tree->l_root, height_l(tree->l_root), l_key, keytail, tree->keyoffs, IS_IND(tree), IS_RANK(tree),
+                 &l_left, &left_height, &l_right, &right_height);
+         tree->l_root    = l_left;
+         newtree->l_root = l_right;
+         if (l_right && IS_RANK(tree)) {
+            newtree->nodes = COUNT(l_right);
+         }
+      }
+      if (newtree->root) {
+         if (IS_RANK(tree)) {
+            tree->nodes -= newtree->nodes;
+         } else {
+            /* counting the nodes would take O(n): avl_nodes() will do it if needed */
+            newtree->counted = false;
+            tree->counted    = false;
+         }
+         share_blocks(tree, newtree);
+      }
+      reset_ends(tree);
+      reset_ends(newtree);
+   }
+   return newtree;
+}
+
+/*---------------------------------------------------------------------------*/
+
+TREE *avl_split(TREE *tree, void *key)
+{
+   long  l_key;
+   char *keytail;
+
+   if (IS_X(tree)) {
+      return split_tree(tree, key, 0L, NULL);
+   }
+   if (CMPTYPE(tree) == L_CHA_CMP || CMPTYPE(tree) == L_STR_CMP) {
+      l_key = l_key_of(key, &keytail);
+      return split_tree(tree, NULL, l_key, keytail);
+   }
+   return NULL;
+}
+
+TREE *avl_split_mbr  (TREE *tree, void *key) { return avl_split(tree, key); }
+TREE *avl_split_ptr  (TREE *tree, void *key) { return avl_split(tree, key); }
+TREE *avl_split_chars(TREE *tree, char *key) { return avl_split(tree, key); }
+TREE *avl_split_str  (TREE *tree, char *key) { return avl_split(tree, key); }
+
+/*---------------------------------------------------------------------------*/
+
+TREE *avl_split_long(TREE *tree, long key)
+{
+   if (IS_X(tree)) {
+      return NULL;
+   }
+   if (IS_CORR(tree)) {
+      key = CORRECT(key);
+   }
+   return split_tree(tree, NULL, key, NULL);
+}
+
+TREE *avl_split_int   (TREE *tree, int    key) { return avl_split_long(tree, key); }
+TREE *avl_split_short (TREE *tree, short  key) { return avl_split_long(tree, key); }
+TREE *avl_split_schar (TREE *tree, SCHAR  key) { return avl_split_long(tree, key); }
+TREE *avl_split_ulong (TREE *tree, ULONG  key) { return avl_split_long(tree, key); }
+TREE *avl_split_uint  (TREE *tree, UINT   key) { return avl_split_long(tree, key); }
+TREE *avl_split_ushort(TREE *tree, USHORT key) { return avl_split_long(tree, key); }
+TREE *avl_split_uchar (TREE *tree, UCHAR  key) { return avl_split_long(tree, key); }
+
+/*---------------------------------------------------------------------------*/
+
+TREE *avl_split_float(TREE *tree, float key)
+{
+   if (IS_X(tree)) return avl_split     (tree, &key);
+   else            return avl_split_long(tree, flt2lng(key));
+}
+
+TREE *avl_split_double(TREE *tree, double key)
+{
+   if (IS_X(tree)) return avl_split     (tree, &key);
+   else            return avl_split_long(tree, dbl2lng(key));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Join two trees whose items fit together into the array of a small tree (see avl_join()).
+ */
+static bool small_join(TREE *left, TREE *right)
+{
+   if (left->path) {
+      TREE_FREE_AND_NULL(left, left->path);
+   }
+   if (right->path) {
+      TREE_FREE_AND_NULL(right, right->path);
+   }
+   if ( !left->small) {
+      left->small  = right->small;
+      right->small = NULL;
+   } else {
+      memcpy(left->small + left->nodes, right->small, right->nodes * SIZEOF_P);
+   }
+   left->nodes += right->nodes;
+   right->nodes = 0;
+   avl_empty(right);
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avl_join(TREE *left, TREE *right)
+{
+   void   *first, *last;
+   char   *first_keytail, *last_keytail;
+   long    first_key, last_key;
+   int     cmp;
+   X_NODE *x_node;
+   L_NODE *l_node;
+   DEPTH   depth;
+
+   if (left == right || IS_SET(left) || left->type != right->type || left->bits != right->bits
+    || left->keyoffs != right->keyoffs || left->usrcmp != right->usrcmp
+    || left->allocator != right->allocator || left->context != right->context) {
+      return false;
+   }
+   if (IS_FULL(left) || IS_FULL(right)
+    || (left->counted && right->counted && right->nodes > LONG_MAX - left->nodes)) {
+      return false;
+   }
+   if (IS_EMPTY(right)) {
+      return true;
+   }
+   if ( !IS_EMPTY(left)) {
+      first = avl_locate_first(right);
+      last  = avl_locate_last (left);
+      if (IS_X(left)) {
+         cmp = CMP(left->usrcmp, x_key_of(left, first), last, left->keyoffs, IS_IND(left));
+      } else {
+         first_key = l_key_of_data(left, first, &first_keytail);
+         last_key  = l_key_of_data(left, last,  &last_keytail);
+         if (first_key != last_key) {
+            cmp = first_key > last_key ? 1 : -1;
+         } else if (first_keytail) {
+            cmp = TAILCMP(first_keytail, last, left->keyoffs, IS_IND(left));
+         } else {
+            cmp = 0;
+         }
+      }
+      if (cmp < 0 || (cmp == 0 && !IS_DUP(left))) {
+         return false;
+      }
+   }
+   if (IS_SMALL(right) && (IS_SMALL(left) || CAN_BE_SMALL(left)) && right->nodes <= AVL_SMALL_MAX - left->nodes) {
+      return small_join(left, right);
+   }
+   if ( !TO_NODES(left) || !TO_NODES(right)) {
+      return false;
+   }
+   if (left->path) {
+      TREE_FREE_AND_NULL(left, left->path);
+   }
+   FORGET_SPINE(left);
+   FORGET_SPINE(right);
+   if (left->root) {
+      if (IS_X(left)) {
+         x_node = fetch_leftmost_x(&right->x_root, IS_RANK(right), &depth, NULL);
+         join_x(&left->x_root, left->x_root, height_x(left->x_root), x_node, right->x_root, height_x(right->x_root), IS_RANK(left));
+      } else {
+         l_node = fetch_leftmost_l(&right->l_root, IS_RANK(right), &depth, NULL);
+         join_l(&left->l_root, left->l_root, height_l(left->l_root), l_node, right->l_root, height_l(right->l_root), IS_RANK(left));
+      }
+      left->last  = right->last;
+   } else {
+      left->root  = right->root;
+      left->first = right->first;
+      left->last  = right->last;
+   }
+   left->nodes += right->nodes;
+   left->counted = left->counted && right->counted;
+   share_blocks(left, right);
+   right->root  = NULL;
+   right->first = NULL;
+   right->last  = NULL;
+   avl_empty(right);
+   return true;
+}
+
+/*===========================================================================*/
+
+typedef enum avl_setop {
+   UNION,
+   INTERSECTION,
+   DIFFERENCE
+} SETOP;
+
+/* The state of a merge of two trees into a sorted array of new nodes.
+ * The nodes of the "driver" tree are all visited in order, while the other tree is only searched.
+ */
+typedef struct {
+   TREE *tree;
+   SETOP setop;
+   bool  driver_is_a; /* whether the driver tree is the first operand */
+   void *prev;        /* the previously visited driver node          */
+   void *next;        /* the next new node to be filled in            */
+   long  n;           /* the number of new nodes filled in            */
+} MERGE;
+
+/*---------------------------------------------------------------------------*/
+
+static int cmp_nodes_x(TREE *tree, X_NODE *x_node, X_NODE *x_other)
+{
+   return CMP(tree->usrcmp, x_key_of(tree, x_node->data), x_other->data, tree->keyoffs, IS_IND(tree));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Compare the keys of two nodes, accessing the data only if the stored long keys are equal and have a tail.
+ */
+static int cmp_nodes_l(TREE *tree, L_NODE *l_node, L_NODE *l_other)
+{
+   char *keytail;
+
+   if (l_node->key != l_other->key) {
+      return l_node->key > l_other->key ? 1 : -1;
+   }
+   if (CMPTYPE(tree) != L_CHA_CMP && CMPTYPE(tree) != L_STR_CMP) {
+      return 0;
+   }
+   l_key_of_data(tree, l_node->data, &keytail);
+   return keytail ? TAILCMP(keytail, l_other->data, tree->keyoffs, IS_IND(tree)) : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Starting from root, descend to the root of the smallest subtree that contains all nodes
+ * with keys between those of lo and hi (both included; NULL means unbounded).
+ */
+static X_NODE *narrow_x(TREE *tree, X_NODE *root, X_NODE *lo, X_NODE *hi)
+{
+   while (root) {
+      if (hi && cmp_nodes_x(tree, root, hi) > 0) {
+         root = PTR_OF(root->left);
+      } else if (lo && cmp_nodes_x(tree, root, lo) < 0) {
+         root = PTR_OF(root->right);
+      } else {
+         break;
+      }
+   }
+   return root;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static L_NODE *narrow_l(TREE *tree, L_NODE *root, L_NODE *lo, L_NODE *hi)
+{
+   while (root) {
+      if (hi && cmp_nodes_l(tree, root, hi) > 0) {
+         root = PTR_OF(root->left);
+      } else if (lo && cmp_nodes_l(tree, root, lo) < 0) {
+         root = PTR_OF(root->right);
+      } else {
+         break;
+      }
+   }
+   return root;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void emit_x(MERGE *merge, X_NODE *x_node)
+{
+   X_NODE *x_new = merge->next;
+
+   x_new->data = x_node->data;
+   merge->next = PTRADD(x_new, X_NODESIZE(merge->tree));
+   merge->n++;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void emit_l(MERGE *merge, L_NODE *l_node)
+{
+   L_NODE *l_new = merge->next;
+
+   l_new->key  = l_node->key;
+   l_new->data = l_node->data;
+   merge->next = PTRADD(l_new, L_NODESIZE(merge->tree));
+   merge->n++;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Emit in order all nodes under root with keys between those of lo and hi (NULL means unbounded).
+ */
+static void emit_range_x(MERGE *merge, X_NODE *root, X_NODE *lo, bool lo_incl, X_NODE *hi, bool hi_incl)
+{
+   int cmp;
+
+   while (root) {
+      if (lo && ((cmp = cmp_nodes_x(merge->tree, root, lo)) < 0 || (cmp == 0 && !lo_incl))) {
+         root = PTR_OF(root->right);
+      } else if (hi && ((cmp = cmp_nodes_x(merge->tree, root, hi)) > 0 || (cmp == 0 && !hi_incl))) {
+         root = PTR_OF(root->left);
+      } else {
+         emit_range_x(merge, PTR_OF(root->left), lo, lo_incl, NULL, false);
+         emit_x(merge, root);
+         emit_range_x(merge, PTR_OF(root->right), NULL, false, hi, hi_incl);
+         break;
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void emit_range_l(MERGE *merge, L_NODE *root, L_NODE *lo, bool lo_incl, L_NODE *hi, bool hi_incl)
+{
+   int cmp;
+
+   while (root) {
+      if (lo && ((cmp = cmp_nodes_l(merge->tree, root, lo)) < 0 || (cmp == 0 && !lo_incl))) {
+         root = PTR_OF(root->right);
+      } else if (hi && ((cmp = cmp_nodes_l(merge->tree, root, hi)) > 0 || (cmp == 0 && !hi_incl))) {
+         root = PTR_OF(root->left);
+      } else {
+         emit_range_l(merge, PTR_OF(root->left), lo, lo_incl, NULL, false);
+         emit_l(merge, root);
+         emit_range_l(merge, PTR_OF(root->right), NULL, false, hi, hi_incl);
+         break;
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Visit in order the driver subtree rooted at driver, whose keys lie between those of lo and hi,
+ * knowing that all nodes of the other tree in the same key range lie under other.
+ * Since other is narrowed down at every step, visiting m driver nodes costs O(m log(n/m + 1)).
+ */
+static void merge_x(MERGE *merge, X_NODE *driver, X_NODE *other, X_NODE *lo, X_NODE *hi)
+{
+   TREE   *tree = merge->tree;
+   X_NODE *found;
+
+   if ( !driver) {
+      if (merge->setop == UNION) {
+         emit_range_x(merge, other, lo, IS_DUP(tree), hi, false);
+      }
+      return;
+   }
+   merge_x(merge, PTR_OF(driver->left), narrow_x(tree, other, lo, driver), lo, driver);
+   found = narrow_x(tree, other, driver, driver);
+   switch (merge->setop) {
+   CASE UNION:
+      emit_x(merge, driver);
+   CASE INTERSECTION:
+      if (merge->driver_is_a) {
+         if (found) emit_x(merge, driver);
+      } else if ( !merge->prev || cmp_nodes_x(tree, driver, merge->prev) != 0) {
+         emit_range_x(merge, found, driver, true, driver, true);
+      }
+   CASE DIFFERENCE:
+      if ( !found) emit_x(merge, driver);
+   }
+   merge->prev = driver;
+   merge_x(merge, PTR_OF(driver->right), narrow_x(tree, other, driver, hi), driver, hi);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void merge_l(MERGE *merge, L_NODE *driver, L_NODE *other, L_NODE *lo, L_NODE *hi)
+{
+   TREE   *tree = merge->tree;
+   L_NODE *found;
+
+   if ( !driver) {
+      if (merge->setop == UNION) {
+         emit_range_l(merge, other, lo, IS_DUP(tree), hi, false);
+      }
+      return;
+   }
+   merge_l(merge, PTR_OF(driver->left), narrow_l(tree, other, lo, driver), lo, driver);
+   found = narrow_l(tree, other, driver, driver);
+   switch (merge->setop) {
+   CASE UNION:
+      emit_l(merge, driver);
+   CASE INTERSECTION:
+      if (merge->driver_is_a) {
+         if (found) emit_l(merge, driver);
+      } else if ( !merge->prev || cmp_nodes_l(tree, driver, merge->prev) != 0) {
+         emit_range_l(merge, found, driver, true, driver, true);
+      }
+   CASE DIFFERENCE:
+      if ( !found) emit_l(merge, driver);
+   }
+   merge->prev = driver;
+   merge_l(merge, PTR_OF(driver->right), narrow_l(tree, other, driver, hi), driver, hi);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Return the tree itself if it has nodes, else a new tree with nodes holding the same data (NULL if out of memory).
+ */
+static TREE *with_nodes(TREE *tree)
+{
+   TREE *newtree;
+
+   if ( !IS_SMALL(tree)) {
+      return tree;
+   }
+   newtree = empty_tree_like(tree);
+   if (newtree && !avl_build_sorted(newtree, tree->small, tree->nodes)) {
+      avl_free(newtree);
+      newtree = NULL;
+   }
+   return newtree;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Build a new tree out of the result of a set operation. The new nodes are allocated in a single block,
+ * sized for the largest possible result and filled from the start. If the result turns out to be smaller,
+ * the new nodes are moved up, so that the free ones below them are available for insertions,
+ * unless these would be more than the new nodes: then the new nodes are copied into a block of their own size
+ * (if the allocator can release the larger one).
+ */
+static TREE *set_operation(TREE *a, TREE *b, SETOP setop)
+{
+   TREE  *newtree;
+   MERGE  merge;
+   void  *alloc_base, *node_v, *exact_base;
+   size_t header_size, nodesize;
+   long   max_nodes;
+   int    avail;
+   TREE  *a_nodes, *b_nodes;
+
+   if (IS_SET(a) || a->type != b->type || a->bits != b->bits || a->keyoffs != b->keyoffs || a->usrcmp != b->usrcmp) {
+      return NULL;
+   }
+   if (avl_nodes(a) < 0 || avl_nodes(b) < 0) {
+      return NULL;
+   }
+   if (IS_SMALL(a) || IS_SMALL(b)) {
+      /* the merge needs nodes: small operands are replaced by temporary copies with nodes */
+      a_nodes = with_nodes(a);
+      b_nodes = with_nodes(b);
+      newtree = a_nodes && b_nodes ? set_operation(a_nodes, b_nodes, setop) : NULL;
+      if (a_nodes && a_nodes != a) avl_free(a_nodes);
+      if (b_nodes && b_nodes != b) avl_free(b_nodes);
+      return newtree;
+   }
+   switch (setop) {
+   CASE UNION:
+      if (b->nodes > LONG_MAX - a->nodes) return NULL;
+      max_nodes = a->nodes + b->nodes;
+   CASE INTERSECTION:
+      max_nodes = IS_DUP(a) ? a->nodes : MIN(a->nodes, b->nodes);
+   DEFAULT:
+      max_nodes = a->nodes;
+   }
+   newtree = empty_tree_like(a);
+   if ( !newtree || max_nodes == 0) {
+      return newtree;
+   }
+   header_size = (IS_X(a) ? SIZEOF_P     : SIZEOF_P_L    ) + CNT_SIZE(a);
+   nodesize    =  IS_X(a) ? X_NODESIZE(a) : L_NODESIZE(a);
+   if ((size_t)max_nodes > ((size_t)-1 - header_size) / nodesize) {
+      TREE_FREE(newtree, newtree);
+      return NULL;
+   }
+   alloc_base = TREE_MALLOC(newtree, header_size + max_nodes * nodesize);
+   if ( !alloc_base) {
+      TREE_FREE(newtree, newtree);
+      return NULL;
+   }
+   node_v = PTRADD(alloc_base, header_size);
+   merge.tree  = a;
+   merge.setop = setop;
+   merge.driver_is_a = setop != INTERSECTION || a->nodes <= b->nodes;
+   merge.prev  = NULL;
+   merge.next  = node_v;
+   merge.n     = 0;
+   if (IS_X(a)) {
+      if (merge.driver_is_a) merge_x(&merge, a->x_root, b->x_root, NULL, NULL);
+      else                   merge_x(&merge, b->x_root, a->x_root, NULL, NULL);
+   } else {
+      if (merge.driver_is_a) merge_l(&merge, a->l_root, b->l_root, NULL, NULL);
+      else                   merge_l(&merge, b->l_root, a->l_root, NULL, NULL);
+   }
+   if (merge.n == 0) {
+      TREE_FREE(newtree, alloc_base);
+      return newtree;
+   }
+   if (max_nodes - merge.n > MIN(merge.n, INT_MAX) && ( !newtree->allocator || newtree->allocator->release)) {
+      /* the new nodes aren't linked yet, so they can be copied */
+      exact_base = TREE_MALLOC(newtree, header_size + merge.n * nodesize);
+      if ( !exact_base) {
+         TREE_FREE(newtree, alloc_base);
+         TREE_FREE(newtree, newtree);
+         return NULL;
+      }
+      memcpy(PTRADD(exact_base, header_size), node_v, merge.n * nodesize);
+      TREE_FREE(newtree, alloc_base);
+      alloc_base = exact_base;
+      node_v     = PTRADD(alloc_base, header_size);
+      max_nodes  = merge.n;
+   }
+   avail = (int)MIN(max_nodes - merge.n, INT_MAX); /* more can only be left over with an allocator not releasing */
+   if (avail) {
+      memmove(PTRADD(node_v, avail * nodesize), node_v, merge.n * nodesize);
+      node_v = PTRADD(node_v, avail * nodesize);
+   }
+   *(void **)alloc_base = NULL;
+   newtree->store = node_v;
+   newtree->avail = avail;
+   newtree->alloc = max_nodes;
+   newtree->nodes = merge.n;
+   newtree->first = node_v;
+   newtree->last  = PTRADD(node_v, (merge.n - 1) * nodesize);
+   if (IS_X(a)) {
+      newtree->x_root = build_x(newtree, node_v, merge.n);
+   } else {
+      newtree->l_root = build_l(newtree, node_v, merge.n);
+   }
+   return newtree;
+}
+
+/*---------------------------------------------------------------------------*/
+
+TREE *avl_union       (TREE *a, TREE *b) { return set_operation(a, b, UNION);        }
+TREE *avl_intersection(TREE *a, TREE *b) { return set_operation(a, b, INTERSECTION); }
+TREE *avl_difference  (TREE *a, TREE *b) { return set_operation(a, b, DIFFERENCE);   }
+
+
+/*===========================================================================*/
+
+static void give_back_x(TREE *tree, POOL_CLASS *sclass, X_NODE *x_node)
+{
+   X_NODE *left, *right;
+
+   while (x_node) {
+      left  = PTR_OF(x_node->left);
+      right = PTR_OF(x_node->right);
+      give_back_x(tree, sclass, left);
+      PTRPUSH(sclass->unused, PTRSUB(x_node, CNT_SIZE(tree)));
+      x_node = right;
+   }
+}
+
+static void give_back_l(TREE *tree, POOL_CLASS *sclass, L_NODE *l_node)
+{
+   L_NODE *left, *right;
+
+   while (l_node) {
+      left  = PTR_OF(l_node->left);
+      right = PTR_OF(l_node->right);
+      give_back_l(tree, sclass, left);
+      PTRPUSH(sclass->unused, PTRSUB(l_node, CNT_SIZE(tree)));
+      l_node = right;
+   }
+}
+
+/* Give the nodes of the subtree with the given root, the removed nodes and the available nodes
+ * of a tree created in a pool back to the pool. Return the number of removed and available nodes.
+ */
+static long give_back_nodes(TREE *tree, void *root)
+{
+   POOL_CLASS *sclass;
+   size_t      nodesize = IS_X(tree) ? X_NODESIZE(tree) : L_NODESIZE(tree);
+   void       *node;
+   long        n = 0;
+
+   sclass = pool_class_of(POOL_OF(tree), nodesize);
+   if (IS_X(tree)) give_back_x(tree, sclass, root);
+   else            give_back_l(tree, sclass, root);
+   while (tree->unused) {
+      PTRPOP(tree->unused, node);
+      PTRPUSH(sclass->unused, PTRSUB(node, CNT_SIZE(tree)));
+      n++;
+   }
+   for (; tree->avail; tree->avail--, n++) {
+      tree->store = PTRSUB(tree->store, nodesize);
+      PTRPUSH(sclass->unused, PTRSUB(tree->store, CNT_SIZE(tree)));
+   }
+   tree->store = NULL;
+   return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Free the node blocks of the tree, or hand them over to the trees it shares them with,
+ * or give its nodes back to the pool it was created in.
+ */
+static void release_blocks(TREE *tree)
 {
    void *alloc_base, *next_alloc_base;
 
-   if (tree->alloc) {
-      if (tree->path) {
-         AVL_FREE_AND_NULL(tree->path);
+   if (POOL_OF(tree)) {
+      give_back_nodes(tree, tree->root);
+   } else if (tree->sharing != tree) {
+      unshare_blocks(tree);
+   } else if ( !tree->allocator || tree->allocator->release) {
+      alloc_base = alloc_base_of(tree);
+      while (alloc_base) {
+         next_alloc_base = *(void **)alloc_base;
+         TREE_FREE(tree, alloc_base);
+         alloc_base = next_alloc_base;
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* The nodes are copied into the new block in the order of the layout. The data pointer of every
+ * copied node is replaced by the address of its copy, and relink_x/l() use it to redirect the links.
+ */
+static void place_x(TREE *tree, X_NODE *x_node, X_NODE **p_next)
+{
+   memcpy(PTRSUB(*p_next, CNT_SIZE(tree)), PTRSUB(x_node, CNT_SIZE(tree)), X_NODESIZE(tree));
+   x_node->data = *p_next;
+   *p_next = PTRADD(*p_next, X_NODESIZE(tree));
+}
+
+static void place_l(TREE *tree, L_NODE *l_node, L_NODE **p_next)
+{
+   memcpy(PTRSUB(*p_next, CNT_SIZE(tree)), PTRSUB(l_node, CNT_SIZE(tree)), L_NODESIZE(tree));
+   l_node->data = *p_next;
+   *p_next = PTRADD(*p_next, L_NODESIZE(tree));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void place_in_order_x(TREE *tree, X_NODE *x_node, X_NODE **p_next)
+{
+   if (x_node->left) {
+      place_in_order_x(tree, PTR_OF(x_node->left), p_next);
+   }
+   place_x(tree, x_node, p_next);
+   if (x_node->right) {
+      place_in_order_x(tree, PTR_OF(x_node->right), p_next);
+   }
+}
+
+static void place_in_order_l(TREE *tree, L_NODE *l_node, L_NODE **p_next)
+{
+   if (l_node->left) {
+      place_in_order_l(tree, PTR_OF(l_node->left), p_next);
+   }
+   place_l(tree, l_node, p_next);
+   if (l_node->right) {
+      place_in_order_l(tree, PTR_OF(l_node->right), p_next);
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* The copies already placed still link to the original nodes, so they serve as the queue.
+ */
+static void place_bfs_x(TREE *tree, X_NODE *x_root, X_NODE **p_next)
+{
+   X_NODE *x_node = *p_next;
+
+   place_x(tree, x_root, p_next);
+   for (; x_node != *p_next; x_node = PTRADD(x_node, X_NODESIZE(tree))) {
+      if (x_node->left ) place_x(tree, PTR_OF(x_node->left ), p_next);
+      if (x_node->right) place_x(tree, PTR_OF(x_node->right), p_next);
+   }
+}
+
+static void place_bfs_l(TREE *tree, L_NODE *l_root, L_NODE **p_next)
+{
+   L_NODE *l_node = *p_next;
+
+   place_l(tree, l_root, p_next);
+   for (; l_node != *p_next; l_node = PTRADD(l_node, L_NODESIZE(tree))) {
+      if (l_node->left ) place_l(tree, PTR_OF(l_node->left ), p_next);
+      if (l_node->right) place_l(tree, PTR_OF(l_node->right), p_next);
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* van Emde Boas layout: the top height/2 levels of the subtree are laid out recursively,
+ * followed by each of the subtrees hanging from them, from left to right, also recursively.
+ */
+static void place_veb_bottoms_x(TREE *tree, X_NODE *x_node, int depth, int height, X_NODE **p_next);
+static void place_veb_bottoms_l(TREE *tree, L_NODE *l_node, int depth, int height, L_NODE **p_next);
+
+static void place_veb_x(TREE *tree, X_NODE *x_node, int height, X_NODE **p_next)
+{
+   if (height == 1) {
+      place_x(tree, x_node, p_next);
+   } else {
+      place_veb_x(tree, x_node, height / 2, p_next);
+      place_veb_bottoms_x(tree, x_node, height / 2, height - height / 2, p_next);
+   }
+}
+
+static void place_veb_bottoms_x(TREE *tree, X_NODE *x_node, int depth, int height, X_NODE **p_next)
+{
+   if (depth == 0) {
+      place_veb_x(tree, x_node, height, p_next);
+   } else {
+      if (x_node->left ) place_veb_bottoms_x(tree, PTR_OF(x_node->left ), depth - 1, height, p_next);
+      if (x_node->right) place_veb_bottoms_x(tree, PTR_OF(x_node->right), depth - 1, height, p_next);
+   }
+}
+
+static void place_veb_l(TREE *tree, L_NODE *l_node, int height, L_NODE **p_next)
+{
+   if (height == 1) {
+      place_l(tree, l_node, p_next);
+   } else {
+      place_veb_l(tree, l_node, height / 2, p_next);
+      place_veb_bottoms_l(tree, l_node, height / 2, height - height / 2, p_next);
+   }
+}
+
+static void place_veb_bottoms_l(TREE *tree, L_NODE *l_node, int depth, int height, L_NODE **p_next)
+{
+   if (depth == 0) {
+      place_veb_l(tree, l_node, height, p_next);
+   } else {
+      if (l_node->left ) place_veb_bottoms_l(tree, PTR_OF(l_node->left ), depth - 1, height, p_next);
+      if (l_node->right) place_veb_bottoms_l(tree, PTR_OF(l_node->right), depth - 1, height, p_next);
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Redirect the links of the n placed nodes from the original nodes to their copies.
+ */
+static void relink_x(TREE *tree, X_NODE *x_node_v, long n)
+{
+   X_NODE *x_node;
+   UINTPTR deeper;
+   long    i;
+
+   for (i = 0, x_node = x_node_v; i < n; i++, x_node = PTRADD(x_node, X_NODESIZE(tree))) {
+      if (x_node->left) {
+         deeper = x_node->leftval & DEEPER;
+         x_node->left = ((X_NODE *)PTR_OF(x_node->left))->data;
+         x_node->leftval |= deeper;
+      }
+      if (x_node->right) {
+         deeper = x_node->rightval & DEEPER;
+         x_node->right = ((X_NODE *)PTR_OF(x_node->right))->data;
+         x_node->rightval |= deeper;
+      }
+   }
+}
+
+static void relink_l(TREE *tree, L_NODE *l_node_v, long n)
+{
+   L_NODE *l_node;
+   UINTPTR deeper;
+   long    i;
+
+   for (i = 0, l_node = l_node_v; i < n; i++, l_node = PTRADD(l_node, L_NODESIZE(tree))) {
+      if (l_node->left) {
+         deeper = l_node->leftval & DEEPER;
+         l_node->left = ((L_NODE *)PTR_OF(l_node->left))->data;
+         l_node->leftval |= deeper;
+      }
+      if (l_node->right) {
+         deeper = l_node->rightval & DEEPER;
+         l_node->right = ((L_NODE *)PTR_OF(l_node->right))->data;
+         l_node->rightval |= deeper;
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avl_compact(TREE *tree, int layout)
+{
+   X_NODE *x_node_v, *x_next;
+   L_NODE *l_node_v, *l_next;
+   void   *alloc_base, *old_root = tree->root;
+   size_t  header_size, nodesize;
+
+   if (avl_nodes(tree) < 0 || IS_SET(tree) || (layout != AVL_IN_ORDER && layout != AVL_BFS && layout != AVL_VEB)) {
+      return false;
+   }
+   if (IS_SMALL(tree)) {
+      return true; /* its array is already in order */
+   }
+   if (tree->nodes == 0) {
+      avl_empty(tree);
+      return true;
+   }
+   header_size = (IS_X(tree) ? SIZEOF_P        : SIZEOF_P_L       ) + CNT_SIZE(tree);
+   nodesize    =  IS_X(tree) ? X_NODESIZE(tree) : L_NODESIZE(tree);
+   if ((size_t)tree->nodes > ((size_t)-1 - header_size) / nodesize) {
+      return false;
+   }
+   alloc_base = TREE_MALLOC(tree, header_size + tree->nodes * nodesize);
+   if ( !alloc_base) {
+      return false;
+   }
+   if (tree->path) {
+      TREE_FREE_AND_NULL(tree, tree->path);
+   }
+   FORGET_SPINE(tree);
+   if (IS_X(tree)) {
+      x_node_v = x_next = PTRADD(alloc_base, header_size);
+      switch (layout) {
+      CASE AVL_IN_ORDER: place_in_order_x(tree, tree->x_root, &x_next);
+      CASE AVL_BFS:      place_bfs_x     (tree, tree->x_root, &x_next);
+      CASE AVL_VEB:      place_veb_x     (tree, tree->x_root, height_x(tree->x_root), &x_next);
+      }
+      relink_x(tree, x_node_v, tree->nodes);
+      tree->x_root = tree->x_root->data;
+   } else {
+      l_node_v = l_next = PTRADD(alloc_base, header_size);
+      switch (layout) {
+      CASE AVL_IN_ORDER: place_in_order_l(tree, tree->l_root, &l_next);
+      CASE AVL_BFS:      place_bfs_l     (tree, tree->l_root, &l_next);
+      CASE AVL_VEB:      place_veb_l     (tree, tree->l_root, height_l(tree->l_root), &l_next);
+      }
+      relink_l(tree, l_node_v, tree->nodes);
+      tree->l_root = tree->l_root->data;
+   }
+   if (POOL_OF(tree)) {
+      give_back_nodes(tree, old_root); /* the links of the old nodes are untouched by relink_x/l() */
+   } else {
+      release_blocks(tree);
+   }
+   *(void **)alloc_base = NULL;
+   tree->store  = PTRADD(alloc_base, header_size);
+   tree->unused = NULL;
+   tree->alloc  = tree->nodes;
+   tree->avail  = 0;
+   reset_ends(tree);
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int cmp_addresses(const void *p1, const void *p2)
+{
+   UINTPTR a1 = (UINTPTR)*(void **)p1;
+   UINTPTR a2 = (UINTPTR)*(void **)p2;
+
+   return a1 < a2 ? -1 : a1 > a2;
+}
+
+/* Return the index of the block that contains the node, given the n_blocks block bases sorted by address.
+ */
+static long block_of(void **base_v, long n_blocks, void *node)
+{
+   long lo = 0, hi = n_blocks - 1, mid;
+
+   while (lo < hi) {
+      mid = (lo + hi + 1) / 2;
+      if ((UINTPTR)base_v[mid] <= (UINTPTR)node) lo = mid;
+      else                                       hi = mid - 1;
+   }
+   return lo;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void mark_live_x(X_NODE *x_node, void **base_v, long n_blocks, char *live_v)
+{
+   live_v[block_of(base_v, n_blocks, x_node)] = true;
+   if (x_node->left ) mark_live_x(PTR_OF(x_node->left ), base_v, n_blocks, live_v);
+   if (x_node->right) mark_live_x(PTR_OF(x_node->right), base_v, n_blocks, live_v);
+}
+
+static void mark_live_l(L_NODE *l_node, void **base_v, long n_blocks, char *live_v)
+{
+   live_v[block_of(base_v, n_blocks, l_node)] = true;
+   if (l_node->left ) mark_live_l(PTR_OF(l_node->left ), base_v, n_blocks, live_v);
+   if (l_node->right) mark_live_l(PTR_OF(l_node->right), base_v, n_blocks, live_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Blocks don't know their size, but a block without live nodes only contains removed nodes,
+ * which are on the unused list, and the available nodes, if it's the most recently allocated block.
+ * If this block is freed, another block becomes the first one, with no available nodes.
+ */
+long avl_trim(TREE *tree)
+{
+   void  *store_base, *alloc_base, *first, **p_next, **p_node, **base_v;
+   char  *live_v;
+   size_t header_size;
+   long   n_blocks, store_i, i, released = 0;
+
+   if (POOL_OF(tree)) {
+      released = give_back_nodes(tree, NULL);
+      tree->alloc = avl_nodes(tree);
+      return released;
+   }
+   if (tree->sharing != tree || !tree->store) {
+      return 0;
+   }
+   store_base = alloc_base_of(tree);
+   for (n_blocks = 0, alloc_base = store_base; alloc_base; alloc_base = *(void **)alloc_base) {
+      n_blocks++;
+   }
+   base_v = TREE_MALLOC(tree, n_blocks * (sizeof(void *) + sizeof(char)));
+   if ( !base_v) {
+      return -1;
+   }
+   live_v = (char *)(base_v + n_blocks);
+   for (i = 0, alloc_base = store_base; alloc_base; alloc_base = *(void **)alloc_base) {
+      base_v[i++] = alloc_base;
+   }
+   qsort(base_v, n_blocks, sizeof(void *), cmp_addresses);
+   memset(live_v, false, n_blocks);
+   if (tree->root) {
+      if (IS_X(tree)) mark_live_x(tree->x_root, base_v, n_blocks, live_v);
+      else            mark_live_l(tree->l_root, base_v, n_blocks, live_v);
+   }
+   for (p_node = &tree->unused; *p_node; ) {
+      if (live_v[block_of(base_v, n_blocks, *p_node)]) {
+         p_node = *p_node;
+      } else {
+         *p_node = *(void **)*p_node;
+         released++;
+      }
+   }
+   store_i = block_of(base_v, n_blocks, store_base);
+   first  = NULL;
+   p_next = &first;
+   if (live_v[store_i]) {
+      *p_next = store_base;
+      p_next  = store_base;
+   }
+   for (i = 0; i < n_blocks; i++) {
+      if ( !live_v[i]) {
+         TREE_FREE(tree, base_v[i]);
+      } else if (i != store_i) {
+         *p_next = base_v[i];
+         p_next  = base_v[i];
+      }
+   }
+   *p_next = NULL;
+   if ( !live_v[store_i]) {
+      header_size = (IS_X(tree) ? SIZEOF_P : SIZEOF_P_L) + CNT_SIZE(tree);
+      released += tree->avail;
+      tree->avail = 0;
+      tree->store = first ? PTRADD(first, header_size) : NULL;
+   }
+   tree->alloc = first ? tree->alloc - released : 0;
+   TREE_FREE(tree, base_v);
+   return released;
+}
+
+/*===========================================================================*/
+
+void avl_empty(TREE *tree)
+{
+   if (tree->spine) {
+      TREE_FREE_AND_NULL(tree, tree->spine);
+   }
+   if (IS_SMALL(tree)) {
+      if (tree->path) {
+         TREE_FREE_AND_NULL(tree, tree->path);
+      }
+      TREE_FREE_AND_NULL(tree, tree->small);
+      tree->nodes = 0;
+   }
+   /* the trees created in a pool may have nodes without having allocated any, after avl_split() or avl_join(),
+    * and without having counted them, after avl_split()
+    */
+   if (tree->root || !tree->counted || tree->alloc || tree->sharing != tree || tree->nodes || tree->unused) {
+      if (tree->path) {
+         TREE_FREE_AND_NULL(tree, tree->path);
+      }
+      release_blocks(tree);
+      tree->root   = NULL;
+      tree->first  = NULL;
+      tree->last   = NULL;
+      tree->unused = NULL;
+      tree->store  = NULL;
+      tree->nodes  = 0;
+      tree->avail  = 0;
+      tree->alloc  = 0;
+   }
+   tree->counted = true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void avl_free(TREE *tree)
+{
+   avl_empty(tree);
+   tree->root = (void *)255;
+   TREE_FREE(tree, tree);
+}
+
+/*===========================================================================*/
+
+/* Index trees (see AVL_DEFINE_INDEX_TREE() in avl_define.h) work like the trees with external keys,
+ * but their links are indexes into a single node array, shifted left by one to make room for the DEEPER bit.
+ * The nodes of long index trees begin like the others, so all nodes are reached through the node size.
+ */
+#define IDX_OF(link)  ((link) >> 1)
+#define IDX_MAX       (UINT_MAX >> 1)
+#define IDX_NODE(tree, idx) ((AVL_INDEX_NODE *)((char *)(tree)->node_v + (size_t)(idx) * (tree)->nodesize))
+
+static DEPTH rebalance_i(AVL_INDEX_TREE *tree, unsigned *p_root, UNBAL unbal)
+{
+   unsigned root        = IDX_OF(*p_root);
+   unsigned root_deeper = *p_root & DEEPER;
+   unsigned root_left, root_right, half, newroot;
+
+   if (unbal == LEFTUNBAL) {
+      root_left = IDX_OF(IDX_NODE(tree, root)->left);
+      if (IDX_NODE(tree, root_left)->left & DEEPER) {
+         /* simple rotation, tree depth decreased */
+         newroot = root_left;
+         IDX_NODE(tree, root)->left   = IDX_NODE(tree, newroot)->right & ~DEEPER;
+         IDX_NODE(tree, root)->right &= ~DEEPER;
+         IDX_NODE(tree, newroot)->right = root << 1;
+         IDX_NODE(tree, newroot)->left &= ~DEEPER;
+         *p_root = newroot << 1 | root_deeper;
+         return LESS;
+      } else if (IDX_NODE(tree, root_left)->right & DEEPER) {
+         /* double rotation */
+         half    = root_left;
+         newroot = IDX_OF(IDX_NODE(tree, half)->right);
+         IDX_NODE(tree, root)->left  = IDX_NODE(tree, newroot)->right;
+         IDX_NODE(tree, half)->right = IDX_NODE(tree, newroot)->left;
+         if (IDX_NODE(tree, newroot)->left & DEEPER) {
+            IDX_NODE(tree, root)->right |=  DEEPER;
+            IDX_NODE(tree, root)->left  &= ~DEEPER;
+            IDX_NODE(tree, half)->right &= ~DEEPER;
+         } else if (IDX_NODE(tree, newroot)->right & DEEPER) {
+            IDX_NODE(tree, root)->right &= ~DEEPER;
+            IDX_NODE(tree, root)->left  &= ~DEEPER;
+            IDX_NODE(tree, half)->right &= ~DEEPER;
+            IDX_NODE(tree, half)->left  |=  DEEPER;
+         } else {
+            IDX_NODE(tree, root)->right &= ~DEEPER;
+            IDX_NODE(tree, root)->left  &= ~DEEPER;
+            IDX_NODE(tree, half)->right &= ~DEEPER;
+         }
+         IDX_NODE(tree, newroot)->left  = half << 1;
+         IDX_NODE(tree, newroot)->right = root << 1;
+         *p_root = newroot << 1 | root_deeper;
+         return LESS;
+      } else {
+         /* simple rotation, tree depth unchanged */
+         newroot = root_left;
+         IDX_NODE(tree, root)->left   = IDX_NODE(tree, newroot)->right | DEEPER;
+         IDX_NODE(tree, root)->right &= ~DEEPER;
+         IDX_NODE(tree, newroot)->right = root << 1 | DEEPER;
+         IDX_NODE(tree, newroot)->left &= ~DEEPER;
+         *p_root = newroot << 1 | root_deeper;
+         return SAME;
+      }
+   } else {
+      root_right = IDX_OF(IDX_NODE(tree, root)->right);
+      if (IDX_NODE(tree, root_right)->right & DEEPER) {
+         /* simple rotation, tree depth decreased */
+         newroot = root_right;
+         IDX_NODE(tree, root)->right = IDX_NODE(tree, newroot)->left & ~DEEPER;
+         IDX_NODE(tree, root)->left &= ~DEEPER;
+         IDX_NODE(tree, newroot)->left = root << 1;
+         IDX_NODE(tree, newroot)->right &= ~DEEPER;
+         *p_root = newroot << 1 | root_deeper;
+         return LESS;
+      } else if (IDX_NODE(tree, root_right)->left & DEEPER) {
+         /* double rotation */
+         half    = root_right;
+         newroot = IDX_OF(IDX_NODE(tree, half)->left);
+         IDX_NODE(tree, root)->right = IDX_NODE(tree, newroot)->left;
+         IDX_NODE(tree, half)->left  = IDX_NODE(tree, newroot)->right;
+         if (IDX_NODE(tree, newroot)->right & DEEPER) {
+            IDX_NODE(tree, root)->left  |=  DEEPER;
+            IDX_NODE(tree, root)->right &= ~DEEPER;
+            IDX_NODE(tree, half)->left  &= ~DEEPER;
+         } else if (IDX_NODE(tree, newroot)->left & DEEPER) {
+            IDX_NODE(tree, root)->left  &= ~DEEPER;
+            IDX_NODE(tree, root)->right &= ~DEEPER;
+            IDX_NODE(tree, half)->left  &= ~DEEPER;
+            IDX_NODE(tree, half)->right |=  DEEPER;
+         } else {
+            IDX_NODE(tree, root)->left  &= ~DEEPER;
+            IDX_NODE(tree, root)->right &= ~DEEPER;
+            IDX_NODE(tree, half)->left  &= ~DEEPER;
+         }
+         IDX_NODE(tree, newroot)->right = half << 1;
+         IDX_NODE(tree, newroot)->left  = root << 1;
+         *p_root = newroot << 1 | root_deeper;
+         return LESS;
+      } else {
+         /* simple rotation, tree depth unchanged */
+         newroot = root_right;
+         IDX_NODE(tree, root)->right = IDX_NODE(tree, newroot)->left | DEEPER;
+         IDX_NODE(tree, root)->left &= ~DEEPER;
+         IDX_NODE(tree, newroot)->left = root << 1 | DEEPER;
+         IDX_NODE(tree, newroot)->right &= ~DEEPER;
+         *p_root = newroot << 1 | root_deeper;
+         return SAME;
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Return the address of the link reached through n links from the root along the path.
+ */
+static unsigned *index_link(AVL_INDEX_TREE *tree, AVL_INDEX_PATH *path, int n)
+{
+   if (n == 0) {
+      return &tree->root;
+   }
+   return path->right[n - 1] ? &IDX_NODE(tree, path->node[n - 1])->right : &IDX_NODE(tree, path->node[n - 1])->left;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static AVL_INDEX_TREE *index_tree(size_t nodesize)
+{
+   AVL_INDEX_TREE *tree;
+
+   tree = AVL_MALLOC(sizeof(*tree));
+   if ( !tree) return NULL;
+   tree->node_v   = NULL;
+   tree->root     = 0;
+   tree->unused   = 0;
+   tree->used     = 0;
+   tree->size     = 0;
+   tree->nodesize = (unsigned)nodesize;
+   tree->nodes    = 0;
+   return tree;
+}
+
+AVL_INDEX_TREE *avl_index_tree     (void) { return index_tree(sizeof(AVL_INDEX_NODE));      }
+AVL_INDEX_TREE *avl_index_long_tree(void) { return index_tree(sizeof(AVL_INDEX_LONG_NODE)); }
+
+/*---------------------------------------------------------------------------*/
+
+long avl_index_nodes(AVL_INDEX_TREE *tree)
+{
+   return tree->nodes;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Insert a new node at the end of the path, returning its index (0 if out of memory or if the tree is full).
+ * The node array doubles when full. The indexes don't change, so the path stays valid.
+ */
+static unsigned index_insert(AVL_INDEX_TREE *tree, AVL_INDEX_PATH *path, void *data)
+{
+   AVL_INDEX_NODE *new_v;
+   unsigned       *p_link, root, node, size;
+   int             n = path->n;
+   INS_T           ins = INS_DEEPER;
+
+   if (tree->unused) {
+      node = tree->unused;
+      tree->unused = IDX_NODE(tree, node)->left;
+   } else {
+      if (tree->used == tree->size) {
+         if (tree->size == IDX_MAX) return 0;
+         size  = tree->size > IDX_MAX / 2 ? IDX_MAX : tree->size ? tree->size * 2 : 15;
+         if ((size_t)size + 1 > (size_t)-1 / tree->nodesize) return 0;
+         new_v = AVL_MALLOC(((size_t)size + 1) * tree->nodesize);
+         if ( !new_v) return 0;
+         if (tree->node_v) {
+            memcpy(new_v, tree->node_v, ((size_t)tree->used + 1) * tree->nodesize);
+            AVL_FREE(tree->node_v);
+         }
+         tree->node_v = new_v;
+         tree->size   = size;
       }
-      if (IS_X(tree)) {
-         alloc_base = PTRSUB(tree->x_store - tree->avail, SIZEOF_P);
+      node = ++tree->used;
+   }
+   IDX_NODE(tree, node)->data  = data;
+   IDX_NODE(tree, node)->left  = 0;
+   IDX_NODE(tree, node)->right = 0;
+   *index_link(tree, path, n) = node << 1;
+   while (n > 0) {
+      p_link = index_link(tree, path, --n);
+      root = IDX_OF(*p_link);
+      if (ins == INS) {
+         break;
+      } else if ( !path->right[n]) {
+         if (IDX_NODE(tree, root)->left & DEEPER) {
+            ins = rebalance_i(tree, p_link, LEFTUNBAL) == LESS ? INS : INS_DEEPER;
+         } else if (IDX_NODE(tree, root)->right & DEEPER) {
+            IDX_NODE(tree, root)->right &= ~DEEPER;
+            ins = INS;
+         } else {
+            IDX_NODE(tree, root)->left |= DEEPER;
+         }
       } else {
-         alloc_base = PTRSUB(tree->l_store - tree->avail, SIZEOF_P_L);
+         if (IDX_NODE(tree, root)->right & DEEPER) {
+            ins = rebalance_i(tree, p_link, RIGHTUNBAL) == LESS ? INS : INS_DEEPER;
+         } else if (IDX_NODE(tree, root)->left & DEEPER) {
+            IDX_NODE(tree, root)->left &= ~DEEPER;
+            ins = INS;
+         } else {
+            IDX_NODE(tree, root)->right |= DEEPER;
+         }
       }
-      while (alloc_base) {
-         next_alloc_base = *(void **)alloc_base;
-         free(alloc_base);
-         alloc_base = next_alloc_base;
+   }
+   tree->nodes++;
+   return node;
+}
+
+bool avl_index_path_insert(AVL_INDEX_TREE *tree, AVL_INDEX_PATH *path, void *data)
+{
+   return index_insert(tree, path, data) != 0;
+}
+
+bool avl_index_path_insert_long(AVL_INDEX_TREE *tree, AVL_INDEX_PATH *path, void *data, long key)
+{
+   unsigned node = index_insert(tree, path, data);
+
+   if (node) {
+      tree->long_node_v[node].key = key;
+   }
+   return node != 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Like remove_at_x(). When the node is replaced by the leftmost node of its right subtree,
+ * the latter takes its place in the path too.
+ */
+void *avl_index_path_remove(AVL_INDEX_TREE *tree, AVL_INDEX_PATH *path)
+{
+   unsigned *p_link, *p_found_link, root, node, leftmost, root_deeper;
+   int       n = path->n, n_found = path->n;
+   DEPTH     depth;
+
+   p_found_link = index_link(tree, path, n);
+   node         = IDX_OF(*p_found_link);
+   root_deeper  = *p_found_link & DEEPER;
+   if ( !IDX_NODE(tree, node)->right) {
+      *p_found_link = (IDX_NODE(tree, node)->left  & ~DEEPER) | root_deeper;
+   } else if ( !IDX_NODE(tree, node)->left) {
+      *p_found_link = (IDX_NODE(tree, node)->right & ~DEEPER) | root_deeper;
+   } else {
+      /* replace by the leftmost node of the right subtree */
+      path->node [n]   = node;
+      path->right[n++] = true;
+      p_link = &IDX_NODE(tree, node)->right;
+      leftmost = IDX_OF(*p_link);
+      while (IDX_NODE(tree, leftmost)->left) {
+         path->node [n]   = leftmost;
+         path->right[n++] = false;
+         p_link = &IDX_NODE(tree, leftmost)->left;
+         leftmost = IDX_OF(*p_link);
+      }
+      *p_link = (IDX_NODE(tree, leftmost)->right & ~DEEPER) | (*p_link & DEEPER);
+      IDX_NODE(tree, leftmost)->left  = IDX_NODE(tree, node)->left;
+      IDX_NODE(tree, leftmost)->right = IDX_NODE(tree, node)->right;
+      *p_found_link = leftmost << 1 | root_deeper;
+      path->node[n_found] = leftmost;
+   }
+   depth = LESS;
+   while (n > 0) {
+      p_link = index_link(tree, path, --n);
+      root = IDX_OF(*p_link);
+      if (depth == SAME) {
+         break;
+      } else if ( !path->right[n]) {
+         /* left subtree depth decreased */
+         if (IDX_NODE(tree, root)->right & DEEPER) {
+            depth = rebalance_i(tree, p_link, RIGHTUNBAL);
+         } else if (IDX_NODE(tree, root)->left & DEEPER) {
+            IDX_NODE(tree, root)->left  &= ~DEEPER;
+         } else {
+            IDX_NODE(tree, root)->right |=  DEEPER;
+            depth = SAME;
+         }
+      } else {
+         /* right subtree depth decreased */
+         if (IDX_NODE(tree, root)->left & DEEPER) {
+            depth = rebalance_i(tree, p_link, LEFTUNBAL);
+         } else if (IDX_NODE(tree, root)->right & DEEPER) {
+            IDX_NODE(tree, root)->right &= ~DEEPER;
+         } else {
+            IDX_NODE(tree, root)->left  |=  DEEPER;
+            depth = SAME;
+         }
       }
-      tree->root   = NULL;
-      tree->unused = NULL;
-      tree->store  = NULL;
-      tree->nodes  = 0;
-      tree->avail  = 0;
-      tree->alloc  = 0;
    }
+   IDX_NODE(tree, node)->left = tree->unused;
+   tree->unused = node;
+   tree->nodes--;
+   return IDX_NODE(tree, node)->data;
 }
 
 /*---------------------------------------------------------------------------*/
 
-void avl_free(TREE *tree)
+void avl_index_do_w_ctx(AVL_INDEX_TREE *tree, void (*callback)(), void *context)
 {
-   avl_empty(tree);
-   tree->root = (void *)255;
+   unsigned stack[MAX_PATHDEPTH + 1], link, node;
+   int      n = 0;
+
+   for (link = tree->root; link; link = IDX_NODE(tree, IDX_OF(link))->left) {
+      stack[n++] = IDX_OF(link);
+   }
+   while (n > 0) {
+      node = stack[--n];
+      (*callback)(IDX_NODE(tree, node)->data, context);
+      for (link = IDX_NODE(tree, node)->right; link; link = IDX_NODE(tree, IDX_OF(link))->left) {
+         stack[n++] = IDX_OF(link);
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void avl_index_empty(AVL_INDEX_TREE *tree)
+{
+   if (tree->node_v) {
+      AVL_FREE(tree->node_v);
+   }
+   tree->node_v = NULL;
+   tree->root   = 0;
+   tree->unused = 0;
+   tree->used   = 0;
+   tree->size   = 0;
+   tree->nodes  = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void avl_index_free(AVL_INDEX_TREE *tree)
+{
+   avl_index_empty(tree);
    AVL_FREE(tree);
 }
 
+/*===========================================================================*/
+
+/* Intrusive trees (see AVL_DEFINE_INTRUSIVE_TREE() in avl_define.h) work like the trees with external keys,
+ * but their nodes are the AVL_LINKS embedded in the data, which N_NODE overlays to get at the link values.
+ */
+typedef struct avl_n_node N_NODE;
+
+struct avl_n_node {
+   union {
+      N_NODE *left;
+      UINTPTR leftval;
+   };
+   union {
+      N_NODE *right;
+      UINTPTR rightval;
+   };
+};
+
+#define DATA_OF_LINKS(tree, links) ((void *)((char *)(links) - (tree)->linkoffs))
+
+static DEPTH rebalance_n(N_NODE **p_root, UNBAL unbal)
+{
+   N_NODE *root        = PTR_OF   (*p_root);
+   UINTPTR root_deeper = IS_DEEPER(*p_root);
+   N_NODE *root_left, *root_right, *half, *newroot;
+
+   if (unbal == LEFTUNBAL) {
+      root_left = PTR_OF(root->left);
+      if (IS_DEEPER(root_left->left)) {
+         /* simple rotation, tree depth decreased */
+         newroot = root_left;
+         root->leftval  = newroot->rightval & ~DEEPER;
+         root->rightval &= ~DEEPER;
+         newroot->right = root;
+         newroot->leftval &= ~DEEPER;
+         *p_root = PTRADD(newroot, root_deeper);
+         return LESS;
+      } else if (IS_DEEPER(root_left->right)) {
+         /* double rotation */
+         half    = root_left;
+         newroot = PTR_OF(half->right);
+         root->left  = newroot->right;
+         half->right = newroot->left;
+         if (IS_DEEPER(newroot->left)) {
+            root->rightval |=  DEEPER;
+            root->leftval  &= ~DEEPER;
+            half->rightval &= ~DEEPER;
+         } else if (IS_DEEPER(newroot->right)) {
+            root->rightval &= ~DEEPER;
+            root->leftval  &= ~DEEPER;
+            half->rightval &= ~DEEPER;
+            half->leftval  |=  DEEPER;
+         } else {
+            root->rightval &= ~DEEPER;
+            root->leftval  &= ~DEEPER;
+            half->rightval &= ~DEEPER;
+         }
+         newroot->left  = half;
+         newroot->right = root;
+         *p_root = PTRADD(newroot, root_deeper);
+         return LESS;
+      } else {
+         /* simple rotation, tree depth unchanged */
+         newroot = root_left;
+         root->leftval = newroot->rightval | DEEPER;
+         root->rightval &= ~DEEPER;
+         newroot->rightval = VAL_OF(root) | DEEPER;
+         newroot->leftval &= ~DEEPER;
+         *p_root = PTRADD(newroot, root_deeper);
+         return SAME;
+      }
+   } else {
+      root_right = PTR_OF(root->right);
+      if (IS_DEEPER(root_right->right)) {
+         /* simple rotation, tree depth decreased */
+         newroot = root_right;
+         root->rightval = newroot->leftval & ~DEEPER;
+         root->leftval &= ~DEEPER;
+         newroot->left = root;
+         newroot->rightval &= ~DEEPER;
+         *p_root = PTRADD(newroot, root_deeper);
+         return LESS;
+      } else if (IS_DEEPER(root_right->left)) {
+         /* double rotation */
+         half    = root_right;
+         newroot = PTR_OF(half->left);
+         root->right = newroot->left;
+         half->left  = newroot->right;
+         if (IS_DEEPER(newroot->right)) {
+            root->leftval  |=  DEEPER;
+            root->rightval &= ~DEEPER;
+            half->leftval  &= ~DEEPER;
+         } else if (IS_DEEPER(newroot->left)) {
+            root->leftval  &= ~DEEPER;
+            root->rightval &= ~DEEPER;
+            half->leftval  &= ~DEEPER;
+            half->rightval |=  DEEPER;
+         } else {
+            root->leftval  &= ~DEEPER;
+            root->rightval &= ~DEEPER;
+            half->leftval  &= ~DEEPER;
+         }
+         newroot->right = half;
+         newroot->left  = root;
+         *p_root = PTRADD(newroot, root_deeper);
+         return LESS;
+      } else {
+         /* simple rotation, tree depth unchanged */
+         newroot = root_right;
+         root->rightval = newroot->leftval | DEEPER;
+         root->leftval &= ~DEEPER;
+         newroot->leftval = VAL_OF(root) | DEEPER;
+         newroot->rightval &= ~DEEPER;
+         *p_root = PTRADD(newroot, root_deeper);
+         return SAME;
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void avl_intrusive_tree(AVL_INTRUSIVE_TREE *tree, size_t linkoffs)
+{
+   tree->root     = NULL;
+   tree->nodes    = 0;
+   tree->linkoffs = linkoffs;
+}
+
+/*---------------------------------------------------------------------------*/
+
+long avl_intrusive_nodes(AVL_INTRUSIVE_TREE *tree)
+{
+   return tree->nodes;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Like insert_at_x().
+ */
+void avl_intrusive_path_insert(AVL_INTRUSIVE_TREE *tree, AVL_PATH *path, AVL_LINKS *links)
+{
+   N_NODE **p_link;
+   N_NODE  *root, *node = (N_NODE *)links;
+   int      n = path->n;
+   INS_T    ins = INS_DEEPER;
+
+   node->left  = NULL;
+   node->right = NULL;
+   *(N_NODE **)path->link[n] = node;
+   while (n > 0) {
+      p_link = (N_NODE **)path->link[--n];
+      root = PTR_OF(*p_link);
+      if (ins == INS) {
+         break;
+      } else if ( !path->right[n]) {
+         if (IS_DEEPER(root->left)) {
+            ins = rebalance_n(p_link, LEFTUNBAL) == LESS ? INS : INS_DEEPER;
+         } else if (IS_DEEPER(root->right)) {
+            root->rightval &= ~DEEPER;
+            ins = INS;
+         } else {
+            root->leftval |= DEEPER;
+         }
+      } else {
+         if (IS_DEEPER(root->right)) {
+            ins = rebalance_n(p_link, RIGHTUNBAL) == LESS ? INS : INS_DEEPER;
+         } else if (IS_DEEPER(root->left)) {
+            root->leftval &= ~DEEPER;
+            ins = INS;
+         } else {
+            root->rightval |= DEEPER;
+         }
+      }
+   }
+   tree->nodes++;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Like remove_at_x(). The removed links are cleared.
+ */
+AVL_LINKS *avl_intrusive_path_remove(AVL_INTRUSIVE_TREE *tree, AVL_PATH *path)
+{
+   N_NODE **p_link, **p_found_link;
+   N_NODE  *root, *node, *leftmost;
+   UINTPTR  root_deeper;
+   int      n = path->n, n_found = path->n;
+   DEPTH    depth;
+
+   p_found_link = (N_NODE **)path->link[n];
+   node         = PTR_OF   (*p_found_link);
+   root_deeper  = IS_DEEPER(*p_found_link);
+   if ( !node->right) {
+      *p_found_link = PTRADD(PTR_OF(node->left), root_deeper);
+   } else if ( !node->left) {
+      *p_found_link = PTRADD(PTR_OF(node->right), root_deeper);
+   } else {
+      /* replace by the leftmost node of the right subtree */
+      path->link [n]   = (void **)p_found_link;
+      path->right[n++] = true;
+      p_link = &node->right;
+      leftmost = PTR_OF(*p_link);
+      while (leftmost->left) {
+         path->link [n]   = (void **)p_link;
+         path->right[n++] = false;
+         p_link = &leftmost->left;
+         leftmost = PTR_OF(*p_link);
+      }
+      *p_link = PTRADD(PTR_OF(leftmost->right), IS_DEEPER(*p_link));
+      leftmost->left  = node->left;
+      leftmost->right = node->right;
+      *p_found_link = PTRADD(leftmost, root_deeper);
+      if (n > n_found + 1) {
+         /* the link to the right subtree has moved from node to leftmost */
+         path->link[n_found + 1] = (void **)&leftmost->right;
+      }
+   }
+   depth = LESS;
+   while (n > 0) {
+      p_link = (N_NODE **)path->link[--n];
+      root = PTR_OF(*p_link);
+      if (depth == SAME) {
+         break;
+      } else if ( !path->right[n]) {
+         /* left subtree depth decreased */
+         if (IS_DEEPER(root->right)) {
+            depth = rebalance_n(p_link, RIGHTUNBAL);
+         } else if (IS_DEEPER(root->left)) {
+            root->leftval  &= ~DEEPER;
+         } else {
+            root->rightval |=  DEEPER;
+            depth = SAME;
+         }
+      } else {
+         /* right subtree depth decreased */
+         if (IS_DEEPER(root->left)) {
+            depth = rebalance_n(p_link, LEFTUNBAL);
+         } else if (IS_DEEPER(root->right)) {
+            root->rightval &= ~DEEPER;
+         } else {
+            root->leftval  |=  DEEPER;
+            depth = SAME;
+         }
+      }
+   }
+   node->left  = NULL;
+   node->right = NULL;
+   tree->nodes--;
+   return (AVL_LINKS *)node;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void avl_intrusive_do_w_ctx(AVL_INTRUSIVE_TREE *tree, void (*callback)(), void *context)
+{
+   N_NODE *stack[MAX_PATHDEPTH + 1], *node;
+   int     n = 0;
+
+   for (node = PTR_OF(tree->root); node; node = PTR_OF(node->left)) {
+      stack[n++] = node;
+   }
+   while (n > 0) {
+      node = stack[--n];
+      (*callback)(DATA_OF_LINKS(tree, node), context);
+      for (node = PTR_OF(node->right); node; node = PTR_OF(node->left)) {
+         stack[n++] = node;
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void avl_intrusive_empty(AVL_INTRUSIVE_TREE *tree)
+{
+   tree->root  = NULL;
+   tree->nodes = 0;
+}
+
 /*---------------------------------------------------------------------------*/
@@ -4,7 +4,7 @@
  |                                                                            |
  |                         An AVL Trees Library in C                          |
  |                                                                            |
- |                                  v 3.0.1                                   |
+ |                                  v 3.1.0                                   |
  |                                                                            |
  *----------------------------------------------------------------------------*/
 /*
@@ -37,9 +37,108 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <limits.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef struct avl_tree TREE;
 
+/* The maximum depth of a tree, i.e., the height of the tallest AVL tree that can hold LONG_MAX + 1 nodes.
+ */
+#define AVL_LOG_2_MAX_NODES (sizeof(long) * CHAR_BIT - 1)
+#define AVL_MAX_PATHDEPTH   ((4761964 * AVL_LOG_2_MAX_NODES - 1083441) / 3305955)
+
+/* A cursor keeps track of the path to the current node of a traversal (see avl_cursor_first() etc.).
+ * It is allocated by the caller, normally on the stack. Its members should be considered private.
+ */
+typedef struct avl_cursor {
+   union {
+      void              **  pathnode;
+      struct avl_x_node **x_pathnode;
+      struct avl_l_node **l_pathnode;
+   };
+   char *pathright;
+   union {
+      void              *  node[AVL_MAX_PATHDEPTH + 2];
+      struct avl_x_node *x_node[AVL_MAX_PATHDEPTH + 2];
+      struct avl_l_node *l_node[AVL_MAX_PATHDEPTH + 2];
+   };
+   char  right[AVL_MAX_PATHDEPTH + 2];
+   TREE *tree;
+} AVL_CURSOR;
+
+/* A path is filled by the functions defined by AVL_DEFINE_TREE() (see avl_define.h)
+ * and passed to avl_path_insert() and avl_path_remove(). Its members should be considered private.
+ */
+typedef struct avl_path {
+   void **link [AVL_MAX_PATHDEPTH + 1];
+   char   right[AVL_MAX_PATHDEPTH + 1];
+   int    n;
+} AVL_PATH;
+
+/* An index tree (see AVL_DEFINE_INDEX_TREE() in avl_define.h) keeps all of its nodes in a single array
+ * and links them by index instead of by pointer, so that a node takes a pointer and two unsigned ints
+ * (normally 16 bytes on 64-bit systems instead of 24). Index 0 is the empty link, and the lowest bit of
+ * a link tells whether the subtree it leads to is the deeper one. Its members should be considered private.
+ */
+typedef struct avl_index_node {
+   void    *data;
+   unsigned left;
+   unsigned right;
+} AVL_INDEX_NODE;
+
+/* The nodes of long index trees (see AVL_DEFINE_INDEX_LONG_TREE()) also hold the key, as a long,
+ * so that searches don't follow the data pointers. They normally take 24 bytes on 64-bit systems
+ * instead of the 32 of the nodes of trees with long keys. They begin like the other index nodes.
+ */
+typedef struct avl_index_long_node {
+   void    *data;
+   unsigned left;
+   unsigned right;
+   long     key;
+} AVL_INDEX_LONG_NODE;
+
+typedef struct avl_index_tree {
+   union {
+      AVL_INDEX_NODE      *     node_v; /* node_v[0] is not used */
+      AVL_INDEX_LONG_NODE *long_node_v; /* the same, in long index trees */
+   };
+   unsigned root;
+   unsigned unused;        /* the first removed node, the others are linked through left */
+   unsigned used;          /* node_v[1 .. used] have been used */
+   unsigned size;          /* node_v[1 .. size] have been allocated */
+   unsigned nodesize;      /* the size of AVL_INDEX_NODE or of AVL_INDEX_LONG_NODE */
+   long     nodes;
+} AVL_INDEX_TREE;
+
+/* The path of an index tree: node[i] is the index of the node reached through i links from the root.
+ */
+typedef struct avl_index_path {
+   unsigned node [AVL_MAX_PATHDEPTH + 1];
+   char     right[AVL_MAX_PATHDEPTH + 1];
+   int      n;
+} AVL_INDEX_PATH;
+
+/* The links of an intrusive tree (see AVL_DEFINE_INTRUSIVE_TREE() in avl_define.h) are embedded
+ * in the data, as an AVL_LINKS member, so that the tree allocates no memory at all, and the keys
+ * are reached without following a data pointer. A data item can be in as many intrusive trees at
+ * the same time as it has AVL_LINKS members. The links point to the AVL_LINKS of the other items,
+ * and their lowest bit tells whether the subtree they lead to is the deeper one. The members of
+ * both structs should be considered private.
+ */
+typedef struct avl_links {
+   void *left;
+   void *right;
+} AVL_LINKS;
+
+typedef struct avl_intrusive_tree {
+   void  *root;
+   long   nodes;
+   size_t linkoffs; /* the offset of the AVL_LINKS member in the data */
+} AVL_INTRUSIVE_TREE;
+
 /*      AVL_USR is guaranteed to be 0 */
 #define AVL_USR      0
 #define AVL_MBR    ( 1 << 1)
@@ -61,6 +160,29 @@ typedef struct avl_tree TREE;
 #define AVL_NODUP 0
 #define AVL_DUP   1
 
+/*      AVL_RANK may be or-ed to the treetype passed to avl_tree() in order to get a "rank tree",
+ *      whose nodes keep the size of their subtrees (see avl_rank() etc.).
+ *      E.g.: avl_tree(AVL_DOUBLE|AVL_DUP|AVL_RANK, offsetof(mystruct, mymember), NULL)
+ */
+#define AVL_RANK  (1 << 5)
+
+/*      AVL_SET may be or-ed to AVL_LONG, AVL_ULONG or AVL_DOUBLE in order to get a "set tree",
+ *      which holds keys instead of data: its nodes have no data pointer (see avl_set_insert_long() etc.).
+ *      If a nonzero keyoffs is given, it is the size of a value held by each node in place of the
+ *      data pointer, which makes the set tree a "map tree" (see avl_map_put_long() etc.), without duplicates.
+ *      AVL_DOUBLE set trees can only be created if avl_has_fast_doubles().
+ */
+#define AVL_SET   (1 << 6)
+
+/*      AVL_NOSMALL may be or-ed to the treetype passed to avl_tree() in order to keep the tree in nodes from its
+ *      first insertion on. Otherwise, a tree of up to AVL_SMALL_MAX (16) items is kept in a sorted array,
+ *      which all the reading functions (cursors included) and most of the modifying ones work on, and gets
+ *      its nodes when it grows larger, or when avl_reserve() or avl_join() need more room. The trees whose root
+ *      is read directly, like those of avl_define.h, need it. Set trees, trees in a pool and trees whose growth
+ *      has been set (see avl_set_growth()) always have nodes.
+ */
+#define AVL_NOSMALL (1 << 7)
+
 /* Tree creation macros (to be used like functions).
  * Nodup trees don't allow duplicate keys, dup trees do (conserving insertion order).
  * The usrcmp() function is passed two pointers and should return an int just like strcmp() (q.v.).
@@ -111,11 +233,63 @@ typedef struct avl_tree TREE;
 #define avl_string_tree_nodup() avl_tree(AVL_CHARS,         0, NULL);
 #define avl_string_tree_dup()   avl_tree(AVL_CHARS|AVL_DUP, 0, NULL);
 
+/* Set trees store keys instead of structs (see AVL_SET).
+ */
+#define avl_set_long()   avl_tree(AVL_LONG  |AVL_SET, 0, NULL)
+#define avl_set_ulong()  avl_tree(AVL_ULONG |AVL_SET, 0, NULL)
+#define avl_set_double() avl_tree(AVL_DOUBLE|AVL_SET, 0, NULL)
+
+/* Map trees store keys and values of the given size instead of structs (see AVL_SET).
+ */
+#define avl_map_long(valsize)   avl_tree(AVL_LONG  |AVL_SET, valsize, NULL)
+#define avl_map_ulong(valsize)  avl_tree(AVL_ULONG |AVL_SET, valsize, NULL)
+#define avl_map_double(valsize) avl_tree(AVL_DOUBLE|AVL_SET, valsize, NULL)
+
 /* It is suggested to use the avl_tree_[no]dup[_TYPE]() macros instead of avl_tree(),
  * unless the tree type has to be parametric.
  */
 TREE *avl_tree(int treetype, size_t keyoffs, int (*usrcmp)());
 
+/* An allocator for all the memory of a tree (see avl_tree_with_allocator()).
+ * allocate() and release() get the context passed at tree creation. release may be NULL
+ * if the memory is released all at once by other means (e.g., by resetting an arena).
+ */
+typedef struct avl_allocator {
+   void *(*allocate)(void *context, size_t size);
+   void  (*release) (void *context, void *ptr);
+} AVL_ALLOCATOR;
+
+/* Like avl_tree(), but the tree, its node blocks and its path get their memory from allocator,
+ * which must outlive the tree. With a NULL allocator this is the same as avl_tree().
+ * Copies, splits and set operation results of the tree use the same allocator and context.
+ */
+TREE *avl_tree_with_allocator(int treetype, size_t keyoffs, int (*usrcmp)(),
+                              const AVL_ALLOCATOR *allocator, void *context);
+
+/* A pool of nodes shared by several trees, e.g., by the trees indexing the same items by different keys.
+ * The trees created in a pool take their nodes from blocks shared by all trees with nodes of the same size,
+ * and give them back when they are emptied, trimmed or freed. avl_pool() returns NULL if out of memory.
+ * avl_pool_free() frees all the memory of the pool, including the trees created in it,
+ * which must not be used afterwards (there is no need to free them before).
+ * Map trees (see AVL_SET) can't be created in a pool: avl_tree_in_pool() returns NULL for them.
+ */
+typedef struct avl_pool AVL_POOL;
+
+AVL_POOL *avl_pool(void);
+TREE     *avl_tree_in_pool(AVL_POOL *pool, int treetype, size_t keyoffs, int (*usrcmp)());
+void      avl_pool_free(AVL_POOL *pool);
+
+/* Set the growth of the node blocks of a tree: every new block gets (allocated nodes >> shift) + 1 nodes,
+ * but not more than max. The defaults are AVL_NODE_INCREMENT_SHIFT and AVL_NODE_INCREMENT_MAX (see avl.c).
+ * Return false, leaving the tree untouched, if shift is negative or not less than the bits of a long, or if max < 1.
+ */
+bool avl_set_growth(TREE *tree, int shift, int max);
+
+/* Make sure that n nodes can be inserted without allocating memory, allocating a single block if needed.
+ * Return false if out of memory or if n > INT_MAX.
+ */
+bool avl_reserve(TREE *tree, long n);
+
 /* Functions to check whether floats/doubles are handled by "type punning" or by callbacks.
  */
 bool avl_has_fast_floats (void);
@@ -130,6 +304,47 @@ bool avl_has_fast_doubles(void);
  */
 bool avl_insert(TREE *tree, void *data);
 
+/* Insert data into the tree, but only as its new last item, i.e., only if its key is not less than
+ * the greatest key in the tree (in nodup trees, greater). False is returned if the key is out of order,
+ * or if avl_insert() would fail. The links to the rightmost nodes are cached, so that in-order insertions
+ * take amortized constant time. avl_insert() uses the same cache when the key turns out to be the greatest.
+ */
+bool avl_append(TREE *tree, void *data);
+
+/* Insert data into the tree, or locate the data with the same key, in a single descent.
+ * True is returned if the data was inserted. Otherwise false is returned, and *p_existing (if p_existing
+ * is not NULL) is set to the data with the same key, or to NULL if the insertion failed for other reasons.
+ * No node is used up when the key is found. In dup trees, this is the same as avl_insert().
+ */
+bool avl_insert_or_locate(TREE *tree, void *data, void **p_existing);
+
+/* Insert data into the tree, or replace the data with the same key, in a single descent.
+ * True is returned for success, and *p_replaced (if p_replaced is not NULL) is set to the replaced data,
+ * or to NULL if the data was inserted. False is returned only if the insertion failed for other reasons.
+ * The replacing data must have the same key as the replaced one.
+ */
+bool avl_insert_or_replace(TREE *tree, void *data, void **p_replaced);
+
+/* Build a perfectly balanced tree out of an array of n data pointers, in O(n) time.
+ * The data must already be sorted by key, as required by the tree type (strictly ascending for
+ * nodup trees, non-descending for dup trees, which keep the order of the array for equal keys).
+ * All nodes are allocated in a single block. True is returned for success, false for failure.
+ * The build fails (leaving the tree unchanged) if
+ * - the tree is not empty,
+ * - the data is not sorted as required, or
+ * - memory allocation has failed.
+ */
+bool avl_build_sorted(TREE *tree, void *data_v[], long n);
+
+/* Insert n data pointers into the tree, as avl_insert() would, and return the number of them inserted.
+ * If the data is sorted by key, consecutive insertions share the upper part of their paths:
+ * the path of each insertion is climbed only as far as needed for the next key, so that k sorted insertions
+ * into a tree of n nodes take about O(k log(n/k)) comparisons instead of O(k log n).
+ * Unsorted data is inserted correctly too, just less efficiently.
+ * Data whose key is already present in a nodup tree is skipped. The insertion stops if memory allocation fails.
+ */
+long avl_insert_sorted_batch(TREE *tree, void *data_v[], long n);
+
 /* Remove a node with the given key from the tree (data is untouched).
  * In case of dup trees, the oldest/leftmost node with the given key is removed.
  * The pointer to the data is returned, or NULL if the key was not found.
@@ -152,9 +367,17 @@ void *avl_remove_uchar (TREE *tree, unsigned char  key);
 void *avl_remove_float (TREE *tree, float          key);
 void *avl_remove_double(TREE *tree, double         key);
 
+/* Remove the first/last (leftmost/rightmost) node of the tree (data is untouched), without comparing any keys.
+ * The pointer to the data is returned, or NULL if the tree is empty or is a set tree.
+ * Used together with avl_insert(), these make a tree a priority queue (a double-ended one).
+ */
+void *avl_pop_first(TREE *tree);
+void *avl_pop_last (TREE *tree);
+
 /* Locate a key in the tree (the oldest/leftmost key in case of a tree with duplicates),
  * returning the pointer to the data, or NULL if not found.
- * Use these function before an avl_insert that can easily fail, because it is faster.
+ * Use these function before an avl_insert that can easily fail, because it is faster,
+ * unless you need the inserted or the existing data anyway (see avl_insert_or_locate()).
  * The functions with pointer keys are interchangeable, and so are those with integer keys.
  * E.g., you can avl_locate(tree, "abc") instead of avl_locate_str(tree, "abc").
  */
@@ -174,6 +397,40 @@ void *avl_locate_uchar (TREE *tree, unsigned char  key);
 void *avl_locate_float (TREE *tree, float          key);
 void *avl_locate_double(TREE *tree, double         key);
 
+/* Locate n keys in the tree at once, storing in results[i] what avl_locate*() would return for keys[i],
+ * and return the number of keys found.
+ * The descents of the keys advance in lockstep, up to AVL_LOCATE_MANY_WAYS (default 16) at a time,
+ * prefetching the next node of each descent (and the data it points to, unless the node holds the key),
+ * so that their cache misses overlap:
+ * in trees much larger than the CPU caches this is faster than calling avl_locate*() for each key.
+ */
+long avl_locate_many       (TREE *tree, void          **keys, long n, void **results);
+long avl_locate_many_mbr   (TREE *tree, void          **keys, long n, void **results);
+long avl_locate_many_ptr   (TREE *tree, void          **keys, long n, void **results);
+long avl_locate_many_chars (TREE *tree, char          **keys, long n, void **results);
+long avl_locate_many_str   (TREE *tree, char          **keys, long n, void **results);
+long avl_locate_many_long  (TREE *tree, long           *keys, long n, void **results);
+long avl_locate_many_int   (TREE *tree, int            *keys, long n, void **results);
+long avl_locate_many_short (TREE *tree, short          *keys, long n, void **results);
+long avl_locate_many_schar (TREE *tree, signed char    *keys, long n, void **results);
+long avl_locate_many_ulong (TREE *tree, unsigned long  *keys, long n, void **results);
+long avl_locate_many_uint  (TREE *tree, unsigned int   *keys, long n, void **results);
+long avl_locate_many_ushort(TREE *tree, unsigned short *keys, long n, void **results);
+long avl_locate_many_uchar (TREE *tree, unsigned char  *keys, long n, void **results);
+long avl_locate_many_float (TREE *tree, float          *keys, long n, void **results);
+long avl_locate_many_double(TREE *tree, double         *keys, long n, void **results);
+
+/* Locate n keys sorted in ascending order, storing in results[i] what avl_locate*() would return for keys[i],
+ * and return the number of keys found. The path to each key is climbed only as far as needed for the next key,
+ * as in avl_insert_sorted_batch(). The keys of avl_locate_sorted_batch() are those of avl_locate(), avl_locate_mbr(),
+ * avl_locate_ptr(), avl_locate_chars() or avl_locate_str(); those of avl_locate_sorted_batch_long() are
+ * the values of any integer type, converted to long (unsigned ones included).
+ */
+long avl_locate_sorted_batch       (TREE *tree, void  **keys, long n, void **results);
+long avl_locate_sorted_batch_long  (TREE *tree, long   *keys, long n, void **results);
+long avl_locate_sorted_batch_float (TREE *tree, float  *keys, long n, void **results);
+long avl_locate_sorted_batch_double(TREE *tree, double *keys, long n, void **results);
+
 /* Locate the first key that is >=, >, <= or < the given one,
  * returning the pointer to the data, or NULL if not found.
  * First means the leftmost for >= and >, and the rightmost for <= and <.
@@ -242,10 +499,108 @@ void *avl_locate_le_double(TREE *tree, double         key);
 void *avl_locate_lt_double(TREE *tree, double         key);
 
 /* Locate the first/last (leftmost/rightmost) node of the tree (NULL if not found).
+ * These run in O(1) time, since the tree keeps track of its first and last nodes.
  */
 void *avl_locate_first(TREE *tree);
 void *avl_locate_last (TREE *tree);
 
+/* BEGIN Functions for order statistics, which run in O(log n) time but are available in rank trees only
+ * (see AVL_RANK). The functions with pointer keys are interchangeable, and so are those with integer keys.
+ */
+/* Return the number of nodes with a key less than the given key, i.e., the 0-based position
+ * of the [oldest/leftmost] node with the given key, if present. -1 is returned if the tree is not a rank tree.
+ */
+long avl_rank       (TREE *tree, void *key);
+long avl_rank_mbr   (TREE *tree, void *key);
+long avl_rank_ptr   (TREE *tree, void *key);
+long avl_rank_chars (TREE *tree, char *key);
+long avl_rank_str   (TREE *tree, char *key);
+long avl_rank_long  (TREE *tree, long           key);
+long avl_rank_int   (TREE *tree, int            key);
+long avl_rank_short (TREE *tree, short          key);
+long avl_rank_schar (TREE *tree, signed char    key);
+long avl_rank_ulong (TREE *tree, unsigned long  key);
+long avl_rank_uint  (TREE *tree, unsigned int   key);
+long avl_rank_ushort(TREE *tree, unsigned short key);
+long avl_rank_uchar (TREE *tree, unsigned char  key);
+long avl_rank_float (TREE *tree, float          key);
+long avl_rank_double(TREE *tree, double         key);
+
+/* Return the number of nodes with a key between lo and hi (both included; 0 if lo > hi).
+ * -1 is returned if the tree is not a rank tree.
+ */
+long avl_count_range       (TREE *tree, void *lo, void *hi);
+long avl_count_range_mbr   (TREE *tree, void *lo, void *hi);
+long avl_count_range_ptr   (TREE *tree, void *lo, void *hi);
+long avl_count_range_chars (TREE *tree, char *lo, char *hi);
+long avl_count_range_str   (TREE *tree, char *lo, char *hi);
+long avl_count_range_long  (TREE *tree, long           lo, long           hi);
+long avl_count_range_int   (TREE *tree, int            lo, int            hi);
+long avl_count_range_short (TREE *tree, short          lo, short          hi);
+long avl_count_range_schar (TREE *tree, signed char    lo, signed char    hi);
+long avl_count_range_ulong (TREE *tree, unsigned long  lo, unsigned long  hi);
+long avl_count_range_uint  (TREE *tree, unsigned int   lo, unsigned int   hi);
+long avl_count_range_ushort(TREE *tree, unsigned short lo, unsigned short hi);
+long avl_count_range_uchar (TREE *tree, unsigned char  lo, unsigned char  hi);
+long avl_count_range_float (TREE *tree, float          lo, float          hi);
+long avl_count_range_double(TREE *tree, double         lo, double         hi);
+
+/* Return the data of the k-th node (0-based, in traversal order),
+ * or NULL if k is out of range or the tree is not a rank tree.
+ */
+void *avl_select(TREE *tree, long k);
+/* END Functions for order statistics.
+ */
+
+/* BEGIN Functions for set and map trees (see AVL_SET), taking the keys by value.
+ * Each function only works on the set (and map) trees of its key type (it returns false or does nothing otherwise).
+ * Besides these, only avl_nodes(), avl_copy(), avl_empty(), avl_free(), avl_trim(), avl_set_growth(), avl_reserve()
+ * and, in rank set trees, avl_rank_T() and avl_count_range_T() of the key type T can be used on set trees:
+ * the functions that insert data fail on them, the ones that return or remove data return NULL (or find nothing),
+ * and the ones that pass data to a callback don't call it.
+ */
+/* Insert a key (with a zeroed value, in map trees), returning true if successful,
+ * false if memory allocation failed or the key was found in a tree without duplicates (a set proper).
+ */
+bool avl_set_insert_long  (TREE *tree, long          key);
+bool avl_set_insert_ulong (TREE *tree, unsigned long key);
+bool avl_set_insert_double(TREE *tree, double        key);
+/* Return true if the key is in the tree.
+ */
+bool avl_set_contains_long  (TREE *tree, long          key);
+bool avl_set_contains_ulong (TREE *tree, unsigned long key);
+bool avl_set_contains_double(TREE *tree, double        key);
+/* Remove a key (once, in dup trees), returning true if it was found.
+ */
+bool avl_set_remove_long  (TREE *tree, long          key);
+bool avl_set_remove_ulong (TREE *tree, unsigned long key);
+bool avl_set_remove_double(TREE *tree, double        key);
+/* Pass all keys between lo and hi (both included), in order, to callback(key, context).
+ */
+void avl_set_do_range_long  (TREE *tree, long          lo, long          hi, void (*callback)(long,          void *), void *context);
+void avl_set_do_range_ulong (TREE *tree, unsigned long lo, unsigned long hi, void (*callback)(unsigned long, void *), void *context);
+void avl_set_do_range_double(TREE *tree, double        lo, double        hi, void (*callback)(double,        void *), void *context);
+/* The following functions only work on the map trees (see AVL_SET) of their key type.
+ * Insert a key with a copy of the value, or overwrite the value of the key if it is found,
+ * returning false only if memory allocation failed (or if the tree is of the wrong type).
+ */
+bool avl_map_put_long  (TREE *tree, long          key, const void *value);
+bool avl_map_put_ulong (TREE *tree, unsigned long key, const void *value);
+bool avl_map_put_double(TREE *tree, double        key, const void *value);
+/* Copy the value of the key into *value and return true, or return false if the key is not in the tree.
+ */
+bool avl_map_get_long  (TREE *tree, long          key, void *value);
+bool avl_map_get_ulong (TREE *tree, unsigned long key, void *value);
+bool avl_map_get_double(TREE *tree, double        key, void *value);
+/* Return a pointer to the value of the key, or NULL if the key is not in the tree. The value
+ * is aligned like a long or a pointer, and stays where it is until the key is removed.
+ */
+void *avl_map_ptr_long  (TREE *tree, long          key);
+void *avl_map_ptr_ulong (TREE *tree, unsigned long key);
+void *avl_map_ptr_double(TREE *tree, double        key);
+/* END Functions for set and map trees.
+ */
+
 /* Scan a tree [in reverse] passing all data pointers to a callback function,
  * which may return true to stop the scan and return the current data pointer.
  * If the callback never returns true, a full scan is made and NULL is returned.
@@ -331,6 +686,113 @@ void avl_stop(TREE *tree);
 /* END Macros and functions for traversing trees without callback functions.
  */
 
+/* BEGIN Functions for traversing trees with caller-owned cursors.
+ * E.g.: AVL_CURSOR cur; mystruct *p; for (p = avl_cursor_first(tree, &cur); p; p = avl_cursor_next(&cur)) { ... }
+ * These functions work like their counterparts above, but keep the path in the given cursor
+ * instead of allocating one in the tree, so they never allocate memory and never modify the tree.
+ * Any number of cursors may traverse the same tree at the same time (also from different threads),
+ * but the tree must not be modified while a cursor on it is in use: the cursor is not notified.
+ * A cursor is stopped any time NULL is returned, after which avl_cursor_next/prev() return NULL.
+ */
+
+/* Start a cursor traversal from the leftmost/rightmost node (NULL if the tree is empty).
+ */
+void *avl_cursor_first(TREE *tree, AVL_CURSOR *cursor);
+void *avl_cursor_last (TREE *tree, AVL_CURSOR *cursor);
+
+/* Start a cursor traversal from the node that would be found by avl_locate_ge [avl_locate_le] (q.v.).
+ */
+void *avl_cursor_start       (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_cursor_start_mbr   (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_cursor_start_ptr   (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_cursor_start_chars (TREE *tree, AVL_CURSOR *cursor, char *key);
+void *avl_cursor_start_str   (TREE *tree, AVL_CURSOR *cursor, char *key);
+void *avl_cursor_start_long  (TREE *tree, AVL_CURSOR *cursor, long           key);
+void *avl_cursor_start_int   (TREE *tree, AVL_CURSOR *cursor, int            key);
+void *avl_cursor_start_short (TREE *tree, AVL_CURSOR *cursor, short          key);
+void *avl_cursor_start_schar (TREE *tree, AVL_CURSOR *cursor, signed char    key);
+void *avl_cursor_start_ulong (TREE *tree, AVL_CURSOR *cursor, unsigned long  key);
+void *avl_cursor_start_uint  (TREE *tree, AVL_CURSOR *cursor, unsigned int   key);
+void *avl_cursor_start_ushort(TREE *tree, AVL_CURSOR *cursor, unsigned short key);
+void *avl_cursor_start_uchar (TREE *tree, AVL_CURSOR *cursor, unsigned char  key);
+void *avl_cursor_start_float (TREE *tree, AVL_CURSOR *cursor, float          key);
+void *avl_cursor_start_double(TREE *tree, AVL_CURSOR *cursor, double         key);
+void *avl_cursor_rev_start       (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_cursor_rev_start_mbr   (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_cursor_rev_start_ptr   (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_cursor_rev_start_chars (TREE *tree, AVL_CURSOR *cursor, char *key);
+void *avl_cursor_rev_start_str   (TREE *tree, AVL_CURSOR *cursor, char *key);
+void *avl_cursor_rev_start_long  (TREE *tree, AVL_CURSOR *cursor, long           key);
+void *avl_cursor_rev_start_int   (TREE *tree, AVL_CURSOR *cursor, int            key);
+void *avl_cursor_rev_start_short (TREE *tree, AVL_CURSOR *cursor, short          key);
+void *avl_cursor_rev_start_schar (TREE *tree, AVL_CURSOR *cursor, signed char    key);
+void *avl_cursor_rev_start_ulong (TREE *tree, AVL_CURSOR *cursor, unsigned long  key);
+void *avl_cursor_rev_start_uint  (TREE *tree, AVL_CURSOR *cursor, unsigned int   key);
+void *avl_cursor_rev_start_ushort(TREE *tree, AVL_CURSOR *cursor, unsigned short key);
+void *avl_cursor_rev_start_uchar (TREE *tree, AVL_CURSOR *cursor, unsigned char  key);
+void *avl_cursor_rev_start_float (TREE *tree, AVL_CURSOR *cursor, float          key);
+void *avl_cursor_rev_start_double(TREE *tree, AVL_CURSOR *cursor, double         key);
+
+/* Locate like avl_cursor_start[_TYPE] (i.e., like avl_locate_ge), but starting from the node the cursor is on,
+ * to which the cursor is then moved. The search climbs only as far as needed to bound the key on both sides
+ * before descending, so it typically takes O(log d) time, where d is the number of nodes between the two,
+ * and at worst about twice the time of avl_cursor_start[_TYPE] (when the key is across the root).
+ * The cursor must have been started before (e.g., by avl_cursor_first()): if it has been stopped in the meantime,
+ * or is on another tree, the search starts from the root.
+ */
+void *avl_locate_near       (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_locate_near_mbr   (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_locate_near_ptr   (TREE *tree, AVL_CURSOR *cursor, void *key);
+void *avl_locate_near_chars (TREE *tree, AVL_CURSOR *cursor, char *key);
+void *avl_locate_near_str   (TREE *tree, AVL_CURSOR *cursor, char *key);
+void *avl_locate_near_long  (TREE *tree, AVL_CURSOR *cursor, long           key);
+void *avl_locate_near_int   (TREE *tree, AVL_CURSOR *cursor, int            key);
+void *avl_locate_near_short (TREE *tree, AVL_CURSOR *cursor, short          key);
+void *avl_locate_near_schar (TREE *tree, AVL_CURSOR *cursor, signed char    key);
+void *avl_locate_near_ulong (TREE *tree, AVL_CURSOR *cursor, unsigned long  key);
+void *avl_locate_near_uint  (TREE *tree, AVL_CURSOR *cursor, unsigned int   key);
+void *avl_locate_near_ushort(TREE *tree, AVL_CURSOR *cursor, unsigned short key);
+void *avl_locate_near_uchar (TREE *tree, AVL_CURSOR *cursor, unsigned char  key);
+void *avl_locate_near_float (TREE *tree, AVL_CURSOR *cursor, float          key);
+void *avl_locate_near_double(TREE *tree, AVL_CURSOR *cursor, double         key);
+
+/* Advance the cursor to the next/previous node (NULL if there is none).
+ */
+void *avl_cursor_next(AVL_CURSOR *cursor);
+void *avl_cursor_prev(AVL_CURSOR *cursor);
+
+/* Stop the cursor (not needed, since there is nothing to deallocate, unless you want
+ * subsequent calls of avl_cursor_next/prev() to return NULL).
+ */
+void avl_cursor_stop(AVL_CURSOR *cursor);
+
+/* END Functions for traversing trees with caller-owned cursors.
+ */
+
+/* BEGIN Functions used by the trees defined by AVL_DEFINE_TREE() (see avl_define.h), not to be called directly.
+ */
+/* Insert data at the end of the path, which must lead from the root to an empty link.
+ * True is returned for success, false if memory allocation has failed or the tree is full.
+ */
+bool avl_path_insert(TREE *tree, AVL_PATH *path, void *data);
+/* Remove the node at the end of the path, returning the pointer to its data.
+ */
+void *avl_path_remove(TREE *tree, AVL_PATH *path);
+/* The same for the trees defined by AVL_DEFINE_INDEX_TREE(). Insertions fail also when the tree
+ * holds the maximum number of nodes, which is UINT_MAX / 2 (normally 2^31 - 1).
+ * The trees defined by AVL_DEFINE_INDEX_LONG_TREE() insert through avl_index_path_insert_long(),
+ * which also stores the key into the new node.
+ */
+bool  avl_index_path_insert     (AVL_INDEX_TREE *tree, AVL_INDEX_PATH *path, void *data);
+bool  avl_index_path_insert_long(AVL_INDEX_TREE *tree, AVL_INDEX_PATH *path, void *data, long key);
+void *avl_index_path_remove     (AVL_INDEX_TREE *tree, AVL_INDEX_PATH *path);
+/* The same for the trees defined by AVL_DEFINE_INTRUSIVE_TREE(), which link the given links
+ * (the AVL_LINKS member of the inserted data) and return the unlinked ones. Insertions can't fail.
+ */
+void       avl_intrusive_path_insert(AVL_INTRUSIVE_TREE *tree, AVL_PATH *path, AVL_LINKS *links);
+AVL_LINKS *avl_intrusive_path_remove(AVL_INTRUSIVE_TREE *tree, AVL_PATH *path);
+/* END Functions used by the trees defined by AVL_DEFINE_TREE().
+ */
 /* Make a linked list out of the data in a tree by providing the "next"/"prev" pointer member,
  * returning the head of the list.
  */
@@ -340,6 +802,7 @@ void *avl_linked_list(TREE *tree, size_t ptroffs, bool rev);
 
 /* Return the number of nodes in a tree. LONG_MIN means that the tree has reached its
  * maximum capacity (which is LONG_MAX + 1) and won't allow further inserts.
+ * This takes O(1) time, except after avl_split() on a tree that is not a rank tree (see avl_split()).
  */
 long avl_nodes(TREE *tree);
 
@@ -347,6 +810,64 @@ long avl_nodes(TREE *tree);
  */
 TREE *avl_copy(TREE *tree);
 
+/* Split a tree, moving all nodes with a key greater than or equal to the given key
+ * into a new tree, which is returned (NULL if out of memory or if the key type does not match).
+ * The split takes O(log n) time. Outside of rank trees, the number of nodes of the two trees is then counted
+ * in O(n) time when it's first needed (by avl_nodes(), avl_copy(), avl_compact() or a set operation).
+ * The two trees may keep sharing node memory, which is freed along with the last of them.
+ * The functions with pointer keys are interchangeable, and so are those with integer keys.
+ */
+TREE *avl_split       (TREE *tree, void *key);
+TREE *avl_split_mbr   (TREE *tree, void *key);
+TREE *avl_split_ptr   (TREE *tree, void *key);
+TREE *avl_split_chars (TREE *tree, char *key);
+TREE *avl_split_str   (TREE *tree, char *key);
+TREE *avl_split_long  (TREE *tree, long           key);
+TREE *avl_split_int   (TREE *tree, int            key);
+TREE *avl_split_short (TREE *tree, short          key);
+TREE *avl_split_schar (TREE *tree, signed char    key);
+TREE *avl_split_ulong (TREE *tree, unsigned long  key);
+TREE *avl_split_uint  (TREE *tree, unsigned int   key);
+TREE *avl_split_ushort(TREE *tree, unsigned short key);
+TREE *avl_split_uchar (TREE *tree, unsigned char  key);
+TREE *avl_split_float (TREE *tree, float          key);
+TREE *avl_split_double(TREE *tree, double         key);
+
+/* Join two trees of the same kind in O(log n) time, moving all nodes of the right tree into the left one,
+ * provided that no key of the right tree is less than any key of the left tree (nor equal to one, if AVL_DUP is not set).
+ * Return false, leaving both trees untouched, if the trees don't match. The right tree is left empty, but not freed.
+ */
+bool avl_join(TREE *left, TREE *right);
+
+/* Return a new tree with the data of all nodes of a and b (union), of the nodes of a with a key that is also found in b
+ * (intersection), or of the nodes of a with a key not found in b (difference). The data of a precedes that of b
+ * among equal keys. NULL is returned if out of memory or if the trees are not of the same kind.
+ * The intersection and the difference of m and n nodes (m <= n) take O(m log(n/m + 1)) time, plus the size of the result.
+ */
+TREE *avl_union       (TREE *a, TREE *b);
+TREE *avl_intersection(TREE *a, TREE *b);
+TREE *avl_difference  (TREE *a, TREE *b);
+
+/* Node layouts for avl_compact(): nodes in key order, level by level (breadth-first), or van Emde Boas
+ * (recursively, the top half of the levels followed by the subtrees hanging from them).
+ */
+#define AVL_IN_ORDER 0
+#define AVL_BFS      1
+#define AVL_VEB      2
+
+/* Move all nodes into a single new block of exactly avl_nodes(tree) nodes, in the given layout, keeping the shape
+ * of the tree, and free the old blocks, including those of removed nodes. Stop the "callback-less" traversal.
+ * Return false, leaving the tree untouched, if out of memory or if the layout is unknown.
+ */
+bool avl_compact(TREE *tree, int layout);
+
+/* Free the node blocks that contain no nodes in use, taking their removed nodes off the list of removed nodes.
+ * Return the number of nodes released this way, or -1 if out of memory. Trees that share node blocks with
+ * other trees (see avl_split() and avl_join()) are not trimmed. The tree is scanned in O(n log b) time,
+ * where b is the number of blocks.
+ */
+long avl_trim(TREE *tree);
+
 /* Empty a tree and free all node and path memory (the data is untouched).
  */
 void avl_empty(TREE *tree);
@@ -355,5 +876,31 @@ void avl_empty(TREE *tree);
  */
 void avl_free(TREE *tree);
 
+/* Create, traverse, empty and free the index trees of AVL_DEFINE_INDEX_TREE() and AVL_DEFINE_INDEX_LONG_TREE()
+ * (see avl_define.h). avl_index_tree() and avl_index_long_tree() (which creates the latter) return NULL
+ * if out of memory. avl_index_do_w_ctx() is like avl_do_w_ctx().
+ * avl_index_empty() frees the node array, avl_index_free() the tree too.
+ */
+AVL_INDEX_TREE *avl_index_tree     (void);
+AVL_INDEX_TREE *avl_index_long_tree(void);
+long            avl_index_nodes    (AVL_INDEX_TREE *tree);
+void            avl_index_do_w_ctx (AVL_INDEX_TREE *tree, void (*callback)(), void *context);
+void            avl_index_empty    (AVL_INDEX_TREE *tree);
+void            avl_index_free     (AVL_INDEX_TREE *tree);
+
+/* Initialize, traverse and empty the intrusive trees of AVL_DEFINE_INTRUSIVE_TREE() (see avl_define.h),
+ * given the offset of the AVL_LINKS member (offsetof(_struct, member)) in the data.
+ * avl_intrusive_do_w_ctx() is like avl_do_w_ctx(). avl_intrusive_empty() only forgets the data,
+ * whose links become free for reuse.
+ */
+void avl_intrusive_tree     (AVL_INTRUSIVE_TREE *tree, size_t linkoffs);
+long avl_intrusive_nodes    (AVL_INTRUSIVE_TREE *tree);
+void avl_intrusive_do_w_ctx (AVL_INTRUSIVE_TREE *tree, void (*callback)(), void *context);
+void avl_intrusive_empty    (AVL_INTRUSIVE_TREE *tree);
+
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
@@ -0,0 +1,348 @@
+/*----------------------------------------------------------------------------*
+ |                                                                            |
+ |                                  avl.hpp                                   |
+ |                                                                            |
+ |                   C++ interface to the AVL Trees Library                   |
+ |                                                                            |
+ |                                  v 3.1.0                                   |
+ |                                                                            |
+ *----------------------------------------------------------------------------*/
+/*
+Copyright (c) 2013, Walter Tross <waltertross at gmail dot com>
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AVL_HPP
+#define AVL_HPP
+
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "avl_define.h"
+
+namespace avl {
+
+/* A key extractor for trees keyed by a member of T, e.g. avl::member<EMPLOYEE, long, &EMPLOYEE::id>.
+ */
+template <class T, class K, K T::*M>
+struct member {
+   const K &operator()(const T &t) const { return t.*M; }
+};
+
+/* avl::tree<T, KeyOf, Compare, Dup> is a tree of pointers to T items, keyed by KeyOf()(item)
+ * and ordered by Compare (a strict weak ordering like std::less), with duplicates if Dup is true.
+ * The comparisons are inlined into the member functions, which share the nodes and the rebalancing
+ * code of the library (see AVL_DEFINE_TREE() in avl_define.h), so get() may be passed to any
+ * avl_...() function that takes a pointer to a T as key. KeyOf and Compare must be default-constructible.
+ * Like the library, the tree does not own the items: it only frees its own memory when destroyed.
+ * A tree can be moved but not copied (use avl_copy() on get() for that).
+ * Iterators are bidirectional. Like cursors (see AVL_CURSOR), on which they are built, they are
+ * invalidated by any modification of the tree, and they are big (about 1 KB), so avoid needless copies.
+ */
+template <class T, class KeyOf, class Compare = std::less<typename std::decay<
+          decltype(std::declval<KeyOf>()(std::declval<const T &>()))>::type>, bool Dup = false>
+class tree {
+public:
+   typedef typename std::decay<decltype(std::declval<KeyOf>()(std::declval<const T &>()))>::type key_type;
+   typedef T           value_type;
+   typedef T          &reference;
+   typedef T          *pointer;
+   typedef long        size_type;
+   typedef std::ptrdiff_t difference_type;
+
+   class iterator {
+   public:
+      typedef std::bidirectional_iterator_tag iterator_category;
+      typedef T              value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef T             *pointer;
+      typedef T             &reference;
+
+      iterator() : tree_(NULL), data_(NULL) { cursor_.tree = NULL; }
+      iterator(const iterator &other) { copy(other); }
+      iterator &operator=(const iterator &other) { if (this != &other) copy(other); return *this; }
+
+      T &operator* () const { return *data_; }
+      T *operator->() const { return  data_; }
+
+      iterator &operator++()    { data_ = (T *)avl_cursor_next(&cursor_); return *this; }
+      iterator &operator--()
+      {
+         data_ = (T *)(data_ ? avl_cursor_prev(&cursor_) : avl_cursor_last(tree_, &cursor_));
+         return *this;
+      }
+      iterator  operator++(int) { iterator it(*this); ++*this; return it; }
+      iterator  operator--(int) { iterator it(*this); --*this; return it; }
+
+      /* Iterators are compared by node, not by item, because the same item may be stored twice
+       */
+      bool operator==(const iterator &other) const { return node() == other.node(); }
+      bool operator!=(const iterator &other) const { return node() != other.node(); }
+
+   private:
+      friend class tree;
+
+      TREE      *tree_;
+      T         *data_;
+      AVL_CURSOR cursor_;
+
+      explicit iterator(TREE *tree) : tree_(tree), data_(NULL) { cursor_.tree = NULL; }
+
+      void *node() const { return data_ ? *cursor_.pathnode : NULL; }
+
+      /* The cursor points into itself, so only its used part is copied, and its pointers are rebased
+       */
+      void copy(const iterator &other)
+      {
+         tree_ = other.tree_;
+         data_ = other.data_;
+         cursor_.tree = other.cursor_.tree;
+         if (data_) {
+            std::ptrdiff_t n = other.cursor_.pathnode - other.cursor_.node;
+            std::memcpy(cursor_.node,  other.cursor_.node,  (n + 1) * sizeof(cursor_.node[0]));
+            std::memcpy(cursor_.right, other.cursor_.right, (n + 1) * sizeof(cursor_.right[0]));
+            cursor_.pathnode  = cursor_.node  + n;
+            cursor_.pathright = cursor_.right + n;
+         }
+      }
+   };
+
+   typedef iterator                              const_iterator;
+   typedef std::reverse_iterator<iterator>       reverse_iterator;
+   typedef std::reverse_iterator<iterator>       const_reverse_iterator;
+
+   /* Create an empty tree (a rank tree if rank is true, see AVL_RANK). Throws std::bad_alloc.
+    */
+   explicit tree(bool rank = false)
+   : tree_(avl_tree(AVL_USR | (Dup ? AVL_DUP : AVL_NODUP) | (rank ? AVL_RANK : 0) | AVL_NOSMALL, 0,
+                    reinterpret_cast<int (*)()>(reinterpret_cast<void (*)()>(&usrcmp))))
+   {
+      if ( !tree_) throw std::bad_alloc();
+   }
+
+   tree(tree &&other) noexcept : tree_(other.tree_) { other.tree_ = NULL; }
+
+   tree &operator=(tree &&other) noexcept
+   {
+      if (this != &other) {
+         if (tree_) avl_free(tree_);
+         tree_ = other.tree_;
+         other.tree_ = NULL;
+      }
+      return *this;
+   }
+
+   tree(const tree &) = delete;
+   tree &operator=(const tree &) = delete;
+
+   ~tree() { if (tree_) avl_free(tree_); }
+
+   /* The underlying tree, for use with the avl_...() functions. It stays owned by this object.
+    */
+   TREE *get() const { return tree_; }
+
+   size_type size () const { return avl_nodes(tree_); }
+   bool      empty() const { return avl_nodes(tree_) == 0; }
+   void      clear()       { avl_empty(tree_); }
+
+   /* Like avl_insert(): false if the key is already present (without duplicates) or memory is exhausted.
+    * With duplicates, the item is inserted after the items with the same key.
+    */
+   bool insert(T *item)
+   {
+      AVL_PATH      path;
+      AVL_DEF_NODE *node;
+      void        **p_link = &AVL_DEF_ROOT(tree_);
+      const key_type &key = KeyOf()(*item);
+      int           n = 0;
+      bool          right;
+
+      while ((node = AVL_DEF_PTR_OF(*p_link))) {
+         if (Dup) {
+            right = !Compare()(key, key_of(node));
+         } else {
+            int c = cmp(key, key_of(node));
+            if (c == 0) return false;
+            right = c > 0;
+         }
+         path.link [n]   = p_link;
+         path.right[n++] = right;
+         p_link = right ? &node->right : &node->left;
+      }
+      path.link[n] = p_link;
+      path.n = n;
+      return avl_path_insert(tree_, &path, item);
+   }
+
+   /* Like avl_remove(): remove the first item with the given key and return it (NULL if there is none).
+    */
+   T *erase(const key_type &key)
+   {
+      AVL_PATH      path;
+      AVL_DEF_NODE *node;
+      void        **p_link = &AVL_DEF_ROOT(tree_);
+      int           n = 0, n_found = -1;
+      int           c;
+
+      while ((node = AVL_DEF_PTR_OF(*p_link))) {
+         path.link[n] = p_link;
+         c = cmp(key, key_of(node));
+         if (c == 0) {
+            n_found = n;
+            if ( !Dup) break;
+         }
+         path.right[n++] = c > 0;
+         p_link = c > 0 ? &node->right : &node->left;
+      }
+      if (n_found < 0) return NULL;
+      path.n = n_found;
+      return (T *)avl_path_remove(tree_, &path);
+   }
+
+   /* Remove the item at pos (which must not be end()) and return it. All iterators must be restarted.
+    */
+   T *erase(const iterator &pos)
+   {
+      AVL_PATH              path;
+      void        *const   *pathnode = pos.cursor_.node + 2; /* the root follows two sentinels */
+      const char           *pathright = pos.cursor_.right + 3;
+      int                   n;
+
+      path.link[0] = &AVL_DEF_ROOT(tree_);
+      for (n = 0; pathnode != pos.cursor_.pathnode; n++, pathnode++, pathright++) {
+         path.right[n]    = *pathright;
+         path.link [n + 1] = *pathright ? &((AVL_DEF_NODE *)*pathnode)->right
+                                        : &((AVL_DEF_NODE *)*pathnode)->left;
+      }
+      path.n = n;
+      return (T *)avl_path_remove(tree_, &path);
+   }
+
+   iterator begin() const { iterator it(tree_); it.data_ = (T *)avl_cursor_first(tree_, &it.cursor_); return it; }
+   iterator end  () const { return iterator(tree_); }
+
+   reverse_iterator rbegin() const { return reverse_iterator(end  ()); }
+   reverse_iterator rend  () const { return reverse_iterator(begin()); }
+
+   /* The first item with a key not less than / greater than the given key, or end()
+    */
+   iterator lower_bound(const key_type &key) const { return start([&key](const key_type &k) { return !Compare()(k, key); }); }
+   iterator upper_bound(const key_type &key) const { return start([&key](const key_type &k) { return  Compare()(key, k); }); }
+
+   std::pair<iterator, iterator> equal_range(const key_type &key) const
+   {
+      return std::make_pair(lower_bound(key), upper_bound(key));
+   }
+
+   /* Like avl_locate(): the first item with the given key, or NULL
+    */
+   T *locate(const key_type &key) const
+   {
+      AVL_DEF_NODE *node, *save = NULL;
+      int           c;
+
+      for (node = AVL_DEF_PTR_OF(AVL_DEF_ROOT(tree_)); node; ) {
+         c = cmp(key, key_of(node));
+         if      (c < 0) node = AVL_DEF_PTR_OF(node->left);
+         else if (c > 0) node = AVL_DEF_PTR_OF(node->right);
+         else if ( !Dup) return (T *)node->data;
+         else            node = AVL_DEF_PTR_OF((save = node)->left);
+      }
+      return save ? (T *)save->data : NULL;
+   }
+
+   iterator find(const key_type &key) const
+   {
+      iterator it = lower_bound(key);
+      return it.data_ && !Compare()(key, KeyOf()(*it.data_)) ? it : end();
+   }
+
+   size_type count(const key_type &key) const
+   {
+      size_type n = 0;
+      for (iterator it = lower_bound(key); it.data_ && !Compare()(key, KeyOf()(*it.data_)); ++it) n++;
+      return n;
+   }
+
+private:
+   TREE *tree_;
+
+   static const key_type &key_of(const AVL_DEF_NODE *node) { return KeyOf()(*(const T *)node->data); }
+
+   static int cmp(const key_type &a, const key_type &b)
+   {
+      return Compare()(a, b) ? -1 : Compare()(b, a);
+   }
+
+   static int usrcmp(void *data1, void *data2)
+   {
+      return cmp(KeyOf()(*(const T *)data1), KeyOf()(*(const T *)data2));
+   }
+
+   /* Position a cursor on the first node whose key satisfies go_left, i.e., is not before the wanted ones.
+    * The path is recorded like avl_cursor_start() does (see AVL_DEFINE_TREE()).
+    */
+   template <class GoLeft>
+   iterator start(GoLeft go_left) const
+   {
+      iterator      it(tree_);
+      AVL_CURSOR   *cursor = &it.cursor_;
+      AVL_DEF_NODE *node = AVL_DEF_PTR_OF(AVL_DEF_ROOT(tree_));
+      void        **pathnode, **savenode = NULL;
+      char         *pathright, *saveright = NULL;
+      bool          right;
+
+      if ( !node) return it;
+      pathnode  = &cursor->node [0];
+      pathright = &cursor->right[1];
+      *  pathnode  = NULL; /* sentinels */
+      *  pathright = true;
+      *++pathnode  = NULL;
+      *++pathright = false;
+      *++pathnode  = node;
+      for (;;) {
+         right = !go_left(key_of(node));
+         if ( !right) {
+            savenode  = pathnode;
+            saveright = pathright;
+         }
+         node = AVL_DEF_PTR_OF(right ? node->right : node->left);
+         if ( !node) break;
+         *++pathright = right;
+         *++pathnode  = node;
+      }
+      if ( !savenode) return it;
+      cursor->pathnode  = savenode;
+      cursor->pathright = saveright;
+      cursor->tree      = tree_;
+      it.data_ = (T *)((AVL_DEF_NODE *)*savenode)->data;
+      return it;
+   }
+};
+
+} /* namespace avl */
+
+#endif
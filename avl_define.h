@@ -0,0 +1,736 @@
+/*----------------------------------------------------------------------------*
+ |                                                                            |
+ |                               avl_define.h                                 |
+ |                                                                            |
+ |            Type-specialized trees for the AVL Trees Library in C           |
+ |                                                                            |
+ |                                  v 3.1.0                                   |
+ |                                                                            |
+ *----------------------------------------------------------------------------*/
+/*
+Copyright (c) 2013, Walter Tross <waltertross at gmail dot com>
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef AVL_DEFINE_H
+#define AVL_DEFINE_H
+
+#include "avl.h"
+
+#ifndef AVL_UINTPTR_T
+#include <stdint.h>
+#define AVL_DEF_UINTPTR uintptr_t
+#else
+#define AVL_DEF_UINTPTR AVL_UINTPTR_T
+#endif
+
+/* AVL_DEFINE_TREE(prefix, _struct, member, key_t, cmp, dup) defines static inline functions
+ * for the trees of _struct data keyed by the given member, with AVL_NODUP or AVL_DUP as dup.
+ * The comparison cmp(key, member) is inlined into the functions, where key is a key_t and member
+ * is the member of a _struct, and cmp returns an int just like strcmp() (q.v.).
+ * cmp may be a function or a function-like macro, e.g. AVL_CMP for numbers or strcmp for strings.
+ * E.g.: AVL_DEFINE_TREE(emp, EMPLOYEE, id, long, AVL_CMP, AVL_NODUP)
+ * defines emp_tree(), emp_insert(), emp_locate(), etc., with emp_locate(TREE *tree, long key).
+ *
+ * The trees are ordinary trees with external keys (like those of avl_tree_[no]dup()), so all functions
+ * of the library can be used on them as well, but those functions take a pointer to a _struct as key,
+ * and they call the comparison through a function pointer.
+ *
+ * The defined functions are:
+ * TREE    *prefix_tree            (bool rank)       create a tree (a rank tree if rank is true, see AVL_RANK)
+ * bool     prefix_insert          (tree, data)      like avl_insert()
+ * _struct *prefix_remove          (tree, key)       like avl_remove()
+ * _struct *prefix_locate          (tree, key)       like avl_locate()
+ * _struct *prefix_locate_ge       (tree, key)       like avl_locate_ge() (and so on for _gt, _le and _lt)
+ * _struct *prefix_cursor_start    (tree, cursor, key)   like avl_cursor_start()
+ * _struct *prefix_cursor_rev_start(tree, cursor, key)   like avl_cursor_rev_start()
+ * _struct *prefix_cursor_next     (cursor)          like avl_cursor_next() (and so on for _prev)
+ * void     prefix_do_range(tree, lo, hi, callback, context)
+ *          pass all data with keys between lo and hi (both included), in order,
+ *          to callback(data, context), which is a void function taking a _struct * and a void *
+ */
+#define AVL_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+
+/* Same layout as the nodes of trees with external keys in avl.c.
+ * The lowest bit of a link tells whether the subtree it points to is the deeper one.
+ */
+typedef struct avl_def_node {
+   void *data;
+   void *left;
+   void *right;
+} AVL_DEF_NODE;
+
+#define AVL_DEF_PTR_OF(link)   ((AVL_DEF_NODE *)((AVL_DEF_UINTPTR)(link) & ~(AVL_DEF_UINTPTR)1))
+#define AVL_DEF_ROOT(tree)     (*(void **)(tree)) /* the root is the first member of a tree */
+#define AVL_DEF_KEY(_struct, member, node) (((_struct *)(node)->data)->member)
+
+#define AVL_DEFINE_TREE(prefix, _struct, member, key_t, cmp, dup) \
+\
+static inline int prefix##_usrcmp(void *data1, void *data2) \
+{ \
+   return cmp(((_struct *)data1)->member, ((_struct *)data2)->member); \
+} \
+\
+static inline TREE *prefix##_tree(bool rank) \
+{ \
+   return avl_tree(AVL_USR | (dup) | (rank ? AVL_RANK : 0) | AVL_NOSMALL, 0, prefix##_usrcmp); \
+} \
+\
+static inline bool prefix##_insert(TREE *tree, _struct *data) \
+{ \
+   AVL_PATH      path; \
+   AVL_DEF_NODE *node; \
+   void        **p_link = &AVL_DEF_ROOT(tree); \
+   int           n = 0; \
+   int           c; \
+\
+   while ((node = AVL_DEF_PTR_OF(*p_link))) { \
+      c = cmp(data->member, AVL_DEF_KEY(_struct, member, node)); \
+      if (c == 0 && !(dup)) return false; \
+      path.link [n]   = p_link; \
+      path.right[n++] = c >= 0; \
+      p_link = c >= 0 ? &node->right : &node->left; \
+   } \
+   path.link[n] = p_link; \
+   path.n = n; \
+   return avl_path_insert(tree, &path, data); \
+} \
+\
+static inline _struct *prefix##_remove(TREE *tree, key_t key) \
+{ \
+   AVL_PATH      path; \
+   AVL_DEF_NODE *node; \
+   void        **p_link = &AVL_DEF_ROOT(tree); \
+   int           n = 0, n_found = -1; \
+   int           c; \
+\
+   while ((node = AVL_DEF_PTR_OF(*p_link))) { \
+      path.link[n] = p_link; \
+      c = cmp(key, AVL_DEF_KEY(_struct, member, node)); \
+      if (c == 0) { \
+         n_found = n; \
+         if ( !(dup)) break; \
+      } \
+      path.right[n++] = c > 0; \
+      p_link = c > 0 ? &node->right : &node->left; \
+   } \
+   if (n_found < 0) return NULL; \
+   path.n = n_found; \
+   return avl_path_remove(tree, &path); \
+} \
+\
+static inline _struct *prefix##_locate(TREE *tree, key_t key) \
+{ \
+   AVL_DEF_NODE *node, *save = NULL; \
+   int           c; \
+\
+   for (node = AVL_DEF_PTR_OF(AVL_DEF_ROOT(tree)); node; ) { \
+      c = cmp(key, AVL_DEF_KEY(_struct, member, node)); \
+      if      (c < 0)   node = AVL_DEF_PTR_OF(node->left); \
+      else if (c > 0)   node = AVL_DEF_PTR_OF(node->right); \
+      else if ( !(dup)) return node->data; \
+      else              node = AVL_DEF_PTR_OF((save = node)->left); \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_ge(TREE *tree, key_t key) \
+{ \
+   AVL_DEF_NODE *node, *save = NULL; \
+   int           c; \
+\
+   for (node = AVL_DEF_PTR_OF(AVL_DEF_ROOT(tree)); node; ) { \
+      c = cmp(key, AVL_DEF_KEY(_struct, member, node)); \
+      if      (c > 0)             node = AVL_DEF_PTR_OF(node->right); \
+      else if (c == 0 && !(dup))  return node->data; \
+      else                        node = AVL_DEF_PTR_OF((save = node)->left); \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_gt(TREE *tree, key_t key) \
+{ \
+   AVL_DEF_NODE *node, *save = NULL; \
+\
+   for (node = AVL_DEF_PTR_OF(AVL_DEF_ROOT(tree)); node; ) { \
+      if (cmp(key, AVL_DEF_KEY(_struct, member, node)) < 0) node = AVL_DEF_PTR_OF((save = node)->left); \
+      else                                                  node = AVL_DEF_PTR_OF(node->right); \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_le(TREE *tree, key_t key) \
+{ \
+   AVL_DEF_NODE *node, *save = NULL; \
+   int           c; \
+\
+   for (node = AVL_DEF_PTR_OF(AVL_DEF_ROOT(tree)); node; ) { \
+      c = cmp(key, AVL_DEF_KEY(_struct, member, node)); \
+      if      (c < 0)             node = AVL_DEF_PTR_OF(node->left); \
+      else if (c == 0 && !(dup))  return node->data; \
+      else                        node = AVL_DEF_PTR_OF((save = node)->right); \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_lt(TREE *tree, key_t key) \
+{ \
+   AVL_DEF_NODE *node, *save = NULL; \
+\
+   for (node = AVL_DEF_PTR_OF(AVL_DEF_ROOT(tree)); node; ) { \
+      if (cmp(key, AVL_DEF_KEY(_struct, member, node)) > 0) node = AVL_DEF_PTR_OF((save = node)->right); \
+      else                                                  node = AVL_DEF_PTR_OF(node->left); \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_cursor_start_(TREE *tree, AVL_CURSOR *cursor, key_t key, bool rev) \
+{ \
+   AVL_DEF_NODE *node = AVL_DEF_PTR_OF(AVL_DEF_ROOT(tree)); \
+   void        **pathnode, **savenode = NULL; \
+   char         *pathright, *saveright = NULL; \
+   bool          right; \
+   int           c; \
+\
+   cursor->tree = NULL; \
+   if ( !node) return NULL; \
+   pathnode  = &cursor->node [0]; \
+   pathright = &cursor->right[1]; \
+   *  pathnode  = NULL; /* sentinels */ \
+   *  pathright = !rev; \
+   *++pathnode  = NULL; \
+   *++pathright = rev; \
+   *++pathnode  = node; \
+   for (;;) { \
+      c = cmp(key, AVL_DEF_KEY(_struct, member, node)); \
+      if (c == 0 && !(dup)) { \
+         savenode  = pathnode; \
+         saveright = pathright; \
+         break; \
+      } \
+      right = rev ? c >= 0 : c > 0; \
+      if (right == rev) { \
+         savenode  = pathnode; \
+         saveright = pathright; \
+      } \
+      node = AVL_DEF_PTR_OF(right ? node->right : node->left); \
+      if ( !node) break; \
+      *++pathright = right; \
+      *++pathnode  = node; \
+   } \
+   if ( !savenode) return NULL; \
+   cursor->pathnode  = savenode; \
+   cursor->pathright = saveright; \
+   cursor->tree      = tree; \
+   return ((AVL_DEF_NODE *)*savenode)->data; \
+} \
+\
+static inline _struct *prefix##_cursor_start    (TREE *tree, AVL_CURSOR *cursor, key_t key) { return prefix##_cursor_start_(tree, cursor, key, false); } \
+static inline _struct *prefix##_cursor_rev_start(TREE *tree, AVL_CURSOR *cursor, key_t key) { return prefix##_cursor_start_(tree, cursor, key, true ); } \
+static inline _struct *prefix##_cursor_first    (TREE *tree, AVL_CURSOR *cursor) { return avl_cursor_first(tree, cursor); } \
+static inline _struct *prefix##_cursor_last     (TREE *tree, AVL_CURSOR *cursor) { return avl_cursor_last (tree, cursor); } \
+static inline _struct *prefix##_cursor_next     (AVL_CURSOR *cursor)             { return avl_cursor_next(cursor); } \
+static inline _struct *prefix##_cursor_prev     (AVL_CURSOR *cursor)             { return avl_cursor_prev(cursor); } \
+\
+static inline void prefix##_do_range(TREE *tree, key_t lo, key_t hi, void (*callback)(_struct *, void *), void *context) \
+{ \
+   AVL_CURSOR cursor; \
+   _struct   *data; \
+\
+   for (data = prefix##_cursor_start(tree, &cursor, lo); data; data = prefix##_cursor_next(&cursor)) { \
+      if (cmp(hi, data->member) < 0) break; \
+      (*callback)(data, context); \
+   } \
+}
+
+/* AVL_DEFINE_INDEX_TREE(prefix, _struct, member, key_t, cmp, dup) defines the same functions as
+ * AVL_DEFINE_TREE() (with the same arguments) for an AVL_INDEX_TREE instead of a TREE, except for
+ * the cursor functions. An index tree keeps its nodes in a single array and links them by index
+ * (see AVL_INDEX_TREE in avl.h), so that its nodes are smaller, but it can only be used with these
+ * functions and with avl_index_nodes(), avl_index_do_w_ctx(), avl_index_empty() and avl_index_free().
+ * prefix_tree() takes no argument (there are no index rank trees).
+ */
+#define AVL_INDEX_NODE_OF(tree, link) (&(tree)->node_v[(link) >> 1])
+#define AVL_INDEX_KEY(_struct, member, node) (((_struct *)(node)->data)->member)
+
+#define AVL_DEFINE_INDEX_TREE(prefix, _struct, member, key_t, cmp, dup) \
+\
+static inline AVL_INDEX_TREE *prefix##_tree(void) \
+{ \
+   return avl_index_tree(); \
+} \
+\
+static inline bool prefix##_insert(AVL_INDEX_TREE *tree, _struct *data) \
+{ \
+   AVL_INDEX_PATH  path; \
+   AVL_INDEX_NODE *node; \
+   unsigned        link = tree->root; \
+   int             n = 0; \
+   int             c; \
+\
+   while (link) { \
+      node = AVL_INDEX_NODE_OF(tree, link); \
+      c = cmp(data->member, AVL_INDEX_KEY(_struct, member, node)); \
+      if (c == 0 && !(dup)) return false; \
+      path.node [n]   = link >> 1; \
+      path.right[n++] = c >= 0; \
+      link = c >= 0 ? node->right : node->left; \
+   } \
+   path.n = n; \
+   return avl_index_path_insert(tree, &path, data); \
+} \
+\
+static inline _struct *prefix##_remove(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_PATH  path; \
+   AVL_INDEX_NODE *node; \
+   unsigned        link = tree->root; \
+   int             n = 0, n_found = -1; \
+   int             c; \
+\
+   while (link) { \
+      node = AVL_INDEX_NODE_OF(tree, link); \
+      path.node[n] = link >> 1; \
+      c = cmp(key, AVL_INDEX_KEY(_struct, member, node)); \
+      if (c == 0) { \
+         n_found = n; \
+         if ( !(dup)) break; \
+      } \
+      path.right[n++] = c > 0; \
+      link = c > 0 ? node->right : node->left; \
+   } \
+   if (n_found < 0) return NULL; \
+   path.n = n_found; \
+   return avl_index_path_remove(tree, &path); \
+} \
+\
+static inline _struct *prefix##_locate(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_NODE *node, *save = NULL; \
+   unsigned        link; \
+   int             c; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_NODE_OF(tree, link); \
+      c = cmp(key, AVL_INDEX_KEY(_struct, member, node)); \
+      if      (c < 0)   link = node->left; \
+      else if (c > 0)   link = node->right; \
+      else if ( !(dup)) return node->data; \
+      else              link = (save = node)->left; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_ge(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_NODE *node, *save = NULL; \
+   unsigned        link; \
+   int             c; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_NODE_OF(tree, link); \
+      c = cmp(key, AVL_INDEX_KEY(_struct, member, node)); \
+      if      (c > 0)             link = node->right; \
+      else if (c == 0 && !(dup))  return node->data; \
+      else                        link = (save = node)->left; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_gt(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_NODE *node, *save = NULL; \
+   unsigned        link; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_NODE_OF(tree, link); \
+      if (cmp(key, AVL_INDEX_KEY(_struct, member, node)) < 0) link = (save = node)->left; \
+      else                                                    link = node->right; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_le(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_NODE *node, *save = NULL; \
+   unsigned        link; \
+   int             c; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_NODE_OF(tree, link); \
+      c = cmp(key, AVL_INDEX_KEY(_struct, member, node)); \
+      if      (c < 0)             link = node->left; \
+      else if (c == 0 && !(dup))  return node->data; \
+      else                        link = (save = node)->right; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_lt(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_NODE *node, *save = NULL; \
+   unsigned        link; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_NODE_OF(tree, link); \
+      if (cmp(key, AVL_INDEX_KEY(_struct, member, node)) > 0) link = (save = node)->right; \
+      else                                                    link = node->left; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline void prefix##_do_range(AVL_INDEX_TREE *tree, key_t lo, key_t hi, void (*callback)(_struct *, void *), void *context) \
+{ \
+   unsigned  stack[AVL_MAX_PATHDEPTH + 1], link; \
+   _struct  *data; \
+   int       n = 0; \
+\
+   /* the stack holds the nodes with keys >= lo whose left subtrees have been visited */ \
+   for (link = tree->root; link; ) { \
+      if (cmp(lo, AVL_INDEX_KEY(_struct, member, AVL_INDEX_NODE_OF(tree, link))) <= 0) { \
+         stack[n++] = link; \
+         link = AVL_INDEX_NODE_OF(tree, link)->left; \
+      } else { \
+         link = AVL_INDEX_NODE_OF(tree, link)->right; \
+      } \
+   } \
+   while (n > 0) { \
+      link = stack[--n]; \
+      data = AVL_INDEX_NODE_OF(tree, link)->data; \
+      if (cmp(hi, data->member) < 0) break; \
+      (*callback)(data, context); \
+      for (link = AVL_INDEX_NODE_OF(tree, link)->right; link; link = AVL_INDEX_NODE_OF(tree, link)->left) { \
+         stack[n++] = link; \
+      } \
+   } \
+}
+
+/* AVL_DEFINE_INDEX_LONG_TREE(prefix, _struct, member, key_t, dup) defines the same functions as
+ * AVL_DEFINE_INDEX_TREE() for a long index tree, whose nodes also hold the key of their data converted
+ * to a long (see AVL_INDEX_LONG_NODE in avl.h), so that searches don't access the data.
+ * key_t is an integer type all of whose values are represented by a long (e.g., int or unsigned short),
+ * and the keys are compared as longs. prefix_tree() creates the tree through avl_index_long_tree().
+ * E.g.: AVL_DEFINE_INDEX_LONG_TREE(emp, EMPLOYEE, id, long, AVL_NODUP)
+ */
+#define AVL_INDEX_LONG_NODE_OF(tree, link) (&(tree)->long_node_v[(link) >> 1])
+
+#define AVL_DEFINE_INDEX_LONG_TREE(prefix, _struct, member, key_t, dup) \
+\
+static inline AVL_INDEX_TREE *prefix##_tree(void) \
+{ \
+   return avl_index_long_tree(); \
+} \
+\
+static inline bool prefix##_insert(AVL_INDEX_TREE *tree, _struct *data) \
+{ \
+   AVL_INDEX_PATH       path; \
+   AVL_INDEX_LONG_NODE *node; \
+   unsigned             link = tree->root; \
+   long                 key  = (long)data->member; \
+   int                  n = 0; \
+   int                  c; \
+\
+   while (link) { \
+      node = AVL_INDEX_LONG_NODE_OF(tree, link); \
+      c = AVL_CMP(key, node->key); \
+      if (c == 0 && !(dup)) return false; \
+      path.node [n]   = link >> 1; \
+      path.right[n++] = c >= 0; \
+      link = c >= 0 ? node->right : node->left; \
+   } \
+   path.n = n; \
+   return avl_index_path_insert_long(tree, &path, data, key); \
+} \
+\
+static inline _struct *prefix##_remove(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_PATH       path; \
+   AVL_INDEX_LONG_NODE *node; \
+   unsigned             link = tree->root; \
+   int                  n = 0, n_found = -1; \
+   int                  c; \
+\
+   while (link) { \
+      node = AVL_INDEX_LONG_NODE_OF(tree, link); \
+      path.node[n] = link >> 1; \
+      c = AVL_CMP((long)key, node->key); \
+      if (c == 0) { \
+         n_found = n; \
+         if ( !(dup)) break; \
+      } \
+      path.right[n++] = c > 0; \
+      link = c > 0 ? node->right : node->left; \
+   } \
+   if (n_found < 0) return NULL; \
+   path.n = n_found; \
+   return avl_index_path_remove(tree, &path); \
+} \
+\
+static inline _struct *prefix##_locate(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_LONG_NODE *node, *save = NULL; \
+   unsigned             link; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_LONG_NODE_OF(tree, link); \
+      if      ((long)key < node->key) link = node->left; \
+      else if ((long)key > node->key) link = node->right; \
+      else if ( !(dup))               return node->data; \
+      else                            link = (save = node)->left; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_ge(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_LONG_NODE *node, *save = NULL; \
+   unsigned             link; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_LONG_NODE_OF(tree, link); \
+      if      ((long)key > node->key)              link = node->right; \
+      else if ((long)key == node->key && !(dup))   return node->data; \
+      else                                         link = (save = node)->left; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_gt(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_LONG_NODE *node, *save = NULL; \
+   unsigned             link; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_LONG_NODE_OF(tree, link); \
+      if ((long)key < node->key) link = (save = node)->left; \
+      else                       link = node->right; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_le(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_LONG_NODE *node, *save = NULL; \
+   unsigned             link; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_LONG_NODE_OF(tree, link); \
+      if      ((long)key < node->key)              link = node->left; \
+      else if ((long)key == node->key && !(dup))   return node->data; \
+      else                                         link = (save = node)->right; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_lt(AVL_INDEX_TREE *tree, key_t key) \
+{ \
+   AVL_INDEX_LONG_NODE *node, *save = NULL; \
+   unsigned             link; \
+\
+   for (link = tree->root; link; ) { \
+      node = AVL_INDEX_LONG_NODE_OF(tree, link); \
+      if ((long)key > node->key) link = (save = node)->right; \
+      else                       link = node->left; \
+   } \
+   return save ? save->data : NULL; \
+} \
+\
+static inline void prefix##_do_range(AVL_INDEX_TREE *tree, key_t lo, key_t hi, void (*callback)(_struct *, void *), void *context) \
+{ \
+   unsigned             stack[AVL_MAX_PATHDEPTH + 1], link; \
+   AVL_INDEX_LONG_NODE *node; \
+   int                  n = 0; \
+\
+   /* the stack holds the nodes with keys >= lo whose left subtrees have been visited */ \
+   for (link = tree->root; link; ) { \
+      if ((long)lo <= AVL_INDEX_LONG_NODE_OF(tree, link)->key) { \
+         stack[n++] = link; \
+         link = AVL_INDEX_LONG_NODE_OF(tree, link)->left; \
+      } else { \
+         link = AVL_INDEX_LONG_NODE_OF(tree, link)->right; \
+      } \
+   } \
+   while (n > 0) { \
+      node = AVL_INDEX_LONG_NODE_OF(tree, stack[--n]); \
+      if ((long)hi < node->key) break; \
+      (*callback)(node->data, context); \
+      for (link = node->right; link; link = AVL_INDEX_LONG_NODE_OF(tree, link)->left) { \
+         stack[n++] = link; \
+      } \
+   } \
+}
+
+/* AVL_DEFINE_INTRUSIVE_TREE(prefix, _struct, links, member, key_t, cmp, dup) defines the same functions as
+ * AVL_DEFINE_INDEX_TREE() for an AVL_INTRUSIVE_TREE, whose nodes are the AVL_LINKS member links of the
+ * _struct data (see AVL_INTRUSIVE_TREE in avl.h). Nothing is allocated, so insertions only fail on
+ * duplicates in AVL_NODUP trees, and a _struct must not be inserted again before it has been removed
+ * (or the tree emptied). Besides these functions, only avl_intrusive_nodes(), avl_intrusive_do_w_ctx()
+ * and avl_intrusive_empty() can be used on the trees. prefix_tree() initializes a caller-owned tree:
+ * void prefix_tree(AVL_INTRUSIVE_TREE *tree)
+ * E.g.: AVL_DEFINE_INTRUSIVE_TREE(emp, EMPLOYEE, id_links, id, long, AVL_CMP, AVL_NODUP)
+ */
+#define AVL_INTRUSIVE_KEY(_struct, links, member, node) (((_struct *)((char *)(node) - offsetof(_struct, links)))->member)
+#define AVL_INTRUSIVE_DATA(_struct, links, node) ((_struct *)((char *)(node) - offsetof(_struct, links)))
+
+#define AVL_DEFINE_INTRUSIVE_TREE(prefix, _struct, links, member, key_t, cmp, dup) \
+\
+static inline void prefix##_tree(AVL_INTRUSIVE_TREE *tree) \
+{ \
+   avl_intrusive_tree(tree, offsetof(_struct, links)); \
+} \
+\
+static inline bool prefix##_insert(AVL_INTRUSIVE_TREE *tree, _struct *data) \
+{ \
+   AVL_PATH   path; \
+   AVL_LINKS *node; \
+   void     **p_link = &tree->root; \
+   int        n = 0; \
+   int        c; \
+\
+   while ((node = (AVL_LINKS *)AVL_DEF_PTR_OF(*p_link))) { \
+      c = cmp(data->member, AVL_INTRUSIVE_KEY(_struct, links, member, node)); \
+      if (c == 0 && !(dup)) return false; \
+      path.link [n]   = p_link; \
+      path.right[n++] = c >= 0; \
+      p_link = c >= 0 ? &node->right : &node->left; \
+   } \
+   path.link[n] = p_link; \
+   path.n = n; \
+   avl_intrusive_path_insert(tree, &path, &data->links); \
+   return true; \
+} \
+\
+static inline _struct *prefix##_remove(AVL_INTRUSIVE_TREE *tree, key_t key) \
+{ \
+   AVL_PATH   path; \
+   AVL_LINKS *node; \
+   void     **p_link = &tree->root; \
+   int        n = 0, n_found = -1; \
+   int        c; \
+\
+   while ((node = (AVL_LINKS *)AVL_DEF_PTR_OF(*p_link))) { \
+      path.link[n] = p_link; \
+      c = cmp(key, AVL_INTRUSIVE_KEY(_struct, links, member, node)); \
+      if (c == 0) { \
+         n_found = n; \
+         if ( !(dup)) break; \
+      } \
+      path.right[n++] = c > 0; \
+      p_link = c > 0 ? &node->right : &node->left; \
+   } \
+   if (n_found < 0) return NULL; \
+   path.n = n_found; \
+   return AVL_INTRUSIVE_DATA(_struct, links, avl_intrusive_path_remove(tree, &path)); \
+} \
+\
+static inline _struct *prefix##_locate(AVL_INTRUSIVE_TREE *tree, key_t key) \
+{ \
+   AVL_LINKS *node, *save = NULL; \
+   int        c; \
+\
+   for (node = (AVL_LINKS *)AVL_DEF_PTR_OF(tree->root); node; ) { \
+      c = cmp(key, AVL_INTRUSIVE_KEY(_struct, links, member, node)); \
+      if      (c < 0)   node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->left); \
+      else if (c > 0)   node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->right); \
+      else if ( !(dup)) return AVL_INTRUSIVE_DATA(_struct, links, node); \
+      else              node = (AVL_LINKS *)AVL_DEF_PTR_OF((save = node)->left); \
+   } \
+   return save ? AVL_INTRUSIVE_DATA(_struct, links, save) : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_ge(AVL_INTRUSIVE_TREE *tree, key_t key) \
+{ \
+   AVL_LINKS *node, *save = NULL; \
+   int        c; \
+\
+   for (node = (AVL_LINKS *)AVL_DEF_PTR_OF(tree->root); node; ) { \
+      c = cmp(key, AVL_INTRUSIVE_KEY(_struct, links, member, node)); \
+      if      (c > 0)             node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->right); \
+      else if (c == 0 && !(dup))  return AVL_INTRUSIVE_DATA(_struct, links, node); \
+      else                        node = (AVL_LINKS *)AVL_DEF_PTR_OF((save = node)->left); \
+   } \
+   return save ? AVL_INTRUSIVE_DATA(_struct, links, save) : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_gt(AVL_INTRUSIVE_TREE *tree, key_t key) \
+{ \
+   AVL_LINKS *node, *save = NULL; \
+\
+   for (node = (AVL_LINKS *)AVL_DEF_PTR_OF(tree->root); node; ) { \
+      if (cmp(key, AVL_INTRUSIVE_KEY(_struct, links, member, node)) < 0) node = (AVL_LINKS *)AVL_DEF_PTR_OF((save = node)->left); \
+      else                                                               node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->right); \
+   } \
+   return save ? AVL_INTRUSIVE_DATA(_struct, links, save) : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_le(AVL_INTRUSIVE_TREE *tree, key_t key) \
+{ \
+   AVL_LINKS *node, *save = NULL; \
+   int        c; \
+\
+   for (node = (AVL_LINKS *)AVL_DEF_PTR_OF(tree->root); node; ) { \
+      c = cmp(key, AVL_INTRUSIVE_KEY(_struct, links, member, node)); \
+      if      (c < 0)             node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->left); \
+      else if (c == 0 && !(dup))  return AVL_INTRUSIVE_DATA(_struct, links, node); \
+      else                        node = (AVL_LINKS *)AVL_DEF_PTR_OF((save = node)->right); \
+   } \
+   return save ? AVL_INTRUSIVE_DATA(_struct, links, save) : NULL; \
+} \
+\
+static inline _struct *prefix##_locate_lt(AVL_INTRUSIVE_TREE *tree, key_t key) \
+{ \
+   AVL_LINKS *node, *save = NULL; \
+\
+   for (node = (AVL_LINKS *)AVL_DEF_PTR_OF(tree->root); node; ) { \
+      if (cmp(key, AVL_INTRUSIVE_KEY(_struct, links, member, node)) > 0) node = (AVL_LINKS *)AVL_DEF_PTR_OF((save = node)->right); \
+      else                                                               node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->left); \
+   } \
+   return save ? AVL_INTRUSIVE_DATA(_struct, links, save) : NULL; \
+} \
+\
+static inline void prefix##_do_range(AVL_INTRUSIVE_TREE *tree, key_t lo, key_t hi, void (*callback)(_struct *, void *), void *context) \
+{ \
+   AVL_LINKS *stack[AVL_MAX_PATHDEPTH + 1], *node; \
+   _struct   *data; \
+   int        n = 0; \
+\
+   /* the stack holds the nodes with keys >= lo whose left subtrees have been visited */ \
+   for (node = (AVL_LINKS *)AVL_DEF_PTR_OF(tree->root); node; ) { \
+      if (cmp(lo, AVL_INTRUSIVE_KEY(_struct, links, member, node)) <= 0) { \
+         stack[n++] = node; \
+         node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->left); \
+      } else { \
+         node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->right); \
+      } \
+   } \
+   while (n > 0) { \
+      data = AVL_INTRUSIVE_DATA(_struct, links, stack[--n]); \
+      if (cmp(hi, data->member) < 0) break; \
+      (*callback)(data, context); \
+      for (node = (AVL_LINKS *)AVL_DEF_PTR_OF(data->links.right); node; node = (AVL_LINKS *)AVL_DEF_PTR_OF(node->left)) { \
+         stack[n++] = node; \
+      } \
+   } \
+}
+
+#endif
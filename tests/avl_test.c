@@ -98,12 +98,86 @@ int avl_depth(TREE *tree)
 
 /*---------------------------------------------------------------------------*/
 
+static long count_x(X_NODE *root)
+{
+   long count;
+
+   count = (root->left  ? count_x(PTR_OF(root->left )) : 0)
+         + (root->right ? count_x(PTR_OF(root->right)) : 0) + 1;
+   assert(COUNT(root) == count);
+   return count;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static long count_l(L_NODE *root)
+{
+   long count;
+
+   count = (root->left  ? count_l(PTR_OF(root->left )) : 0)
+         + (root->right ? count_l(PTR_OF(root->right)) : 0) + 1;
+   assert(COUNT(root) == count);
+   return count;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Check that the array of a small tree is sorted like its nodes would be
+ */
+static void check_small(TREE *tree)
+{
+   long  i, l_key = 0;
+   char *keytail = NULL;
+   void *x_key = NULL;
+   int   cmp;
+
+   assert( !tree->root && !tree->first && !tree->last && !tree->alloc);
+   assert(tree->nodes >= 0 && tree->nodes <= AVL_SMALL_MAX);
+   for (i = 1; i < tree->nodes; i++) {
+      if (IS_X(tree)) x_key = x_key_of(tree, tree->small[i - 1]);
+      else            l_key = l_key_of_data(tree, tree->small[i - 1], &keytail);
+      cmp = small_cmp(tree, x_key, l_key, keytail, tree->small[i]);
+      assert(cmp < 0 || (cmp == 0 && IS_DUP(tree)));
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avl_is_small(TREE *tree)
+{
+   return IS_SMALL(tree);
+}
+
+int avl_small_max(void)
+{
+   return AVL_SMALL_MAX;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void avl_check_balance(TREE *tree)
 {
+   void *first = tree->first, *last = tree->last;
+
+   if (IS_SMALL(tree)) {
+      check_small(tree);
+      return;
+   }
+   reset_ends(tree); /* the cached ends must be those found by walking down the tree */
+   assert(tree->first == first);
+   assert(tree->last  == last);
    if (tree->root) {
       assert( !IS_DEEPER(tree->root));
       if (IS_X(tree)) depth_x(tree->x_root, true);
       else            depth_l(tree->l_root, true);
+      if (IS_RANK(tree)) {
+         if (IS_X(tree)) assert(count_x(tree->x_root) == tree->nodes);
+         else            assert(count_l(tree->l_root) == tree->nodes);
+      }
+   }
+   if (tree->counted) { /* otherwise, after avl_split(), avl_nodes() has yet to count the nodes */
+      if (IS_X(tree)) assert(count_nodes_x(tree->x_root) == tree->nodes);
+      else            assert(count_nodes_l(tree->l_root) == tree->nodes);
    }
 }
 
@@ -195,3 +269,157 @@ int avl_tree_type(TREE *tree)
 {
    return tree->type;
 }
+
+/*---------------------------------------------------------------------------*/
+
+static void *child_of(TREE *tree, void *node, bool right)
+{
+   if (IS_X(tree)) return right ? PTR_OF(((X_NODE *)node)->right) : PTR_OF(((X_NODE *)node)->left);
+   else            return right ? PTR_OF(((L_NODE *)node)->right) : PTR_OF(((L_NODE *)node)->left);
+}
+
+static long index_of(TREE *tree, void *node)
+{
+   size_t nodesize = IS_X(tree) ? X_NODESIZE(tree) : L_NODESIZE(tree);
+
+   assert((char *)node >= (char *)tree->store);
+   assert(((char *)node - (char *)tree->store) % nodesize == 0);
+   return ((char *)node - (char *)tree->store) / nodesize;
+}
+
+static void check_in_order(TREE *tree, void *node, long *p_next)
+{
+   if (child_of(tree, node, false)) check_in_order(tree, child_of(tree, node, false), p_next);
+   assert(index_of(tree, node) == (*p_next)++);
+   if (child_of(tree, node, true )) check_in_order(tree, child_of(tree, node, true ), p_next);
+}
+
+/* Check that the tree has been compacted by avl_compact() with the given layout
+ */
+void avl_check_compact(TREE *tree, int layout)
+{
+   size_t nodesize = IS_X(tree) ? X_NODESIZE(tree) : L_NODESIZE(tree);
+   void  *node, *child;
+   long   i, next;
+
+   if (IS_SMALL(tree)) {
+      check_small(tree);
+      return;
+   }
+   assert(tree->sharing == tree);
+   assert( !tree->unused);
+   assert( !tree->path);
+   assert(tree->avail == 0);
+   assert(tree->alloc == tree->nodes);
+   if ( !tree->root) {
+      assert( !tree->store);
+      return;
+   }
+   assert( !*(void **)alloc_base_of(tree));
+   assert(index_of(tree, tree->root) == 0 || layout == AVL_IN_ORDER);
+   switch (layout) {
+   CASE AVL_IN_ORDER:
+      next = 0;
+      check_in_order(tree, tree->root, &next);
+      assert(next == tree->nodes);
+   CASE AVL_BFS:
+      for (i = 0, next = 1, node = tree->store; i < tree->nodes; i++, node = PTRADD(node, nodesize)) {
+         if ((child = child_of(tree, node, false))) assert(index_of(tree, child) == next++);
+         if ((child = child_of(tree, node, true ))) assert(index_of(tree, child) == next++);
+      }
+      assert(next == tree->nodes);
+   CASE AVL_VEB:
+      for (i = 0, node = tree->store; i < tree->nodes; i++, node = PTRADD(node, nodesize)) {
+         if ((child = child_of(tree, node, false))) assert(index_of(tree, child) < tree->nodes);
+         if ((child = child_of(tree, node, true ))) assert(index_of(tree, child) < tree->nodes);
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+long avl_blocks(TREE *tree)
+{
+   void *alloc_base;
+   long  n_blocks = 0;
+
+   for (alloc_base = alloc_base_of(tree); alloc_base; alloc_base = *(void **)alloc_base) {
+      n_blocks++;
+   }
+   return n_blocks;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Return the number of chunks of memory obtained by the pool, for node blocks, trees and paths.
+ */
+long avl_pool_chunks(AVL_POOL *pool)
+{
+   POOL_CHUNK *chunk;
+   long        n_chunks = 0;
+
+   for (chunk = pool->chunks.next; chunk != &pool->chunks; chunk = chunk->next) {
+      n_chunks++;
+   }
+   return n_chunks;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int depth_i(AVL_INDEX_TREE *tree, unsigned root, long *p_count)
+{
+   AVL_INDEX_NODE *node = IDX_NODE(tree, root);
+   int             depth_left, depth_right;
+
+   depth_left  = node->left  ? depth_i(tree, IDX_OF(node->left ), p_count) : 0;
+   depth_right = node->right ? depth_i(tree, IDX_OF(node->right), p_count) : 0;
+   assert(depth_left  <= depth_right + 1);
+   assert(depth_right <= depth_left  + 1);
+   assert(( !(node->left  & DEEPER)) == (depth_left  <= depth_right));
+   assert(( !(node->right & DEEPER)) == (depth_right <= depth_left ));
+   ++*p_count;
+   return (depth_left > depth_right ? depth_left : depth_right) + 1;
+}
+
+/* Check the balance of an index tree, and that it holds as many nodes as it says.
+ */
+void avl_index_check_balance(AVL_INDEX_TREE *tree)
+{
+   long count = 0;
+
+   if (tree->root) {
+      assert( !(tree->root & DEEPER));
+      depth_i(tree, IDX_OF(tree->root), &count);
+   }
+   assert(count == tree->nodes);
+   assert(tree->used <= tree->size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int depth_n(N_NODE *root, long *p_count)
+{
+   int depth_left, depth_right;
+
+   depth_left  = root->left  ? depth_n(PTR_OF(root->left ), p_count) : 0;
+   depth_right = root->right ? depth_n(PTR_OF(root->right), p_count) : 0;
+   assert(depth_left  <= depth_right + 1);
+   assert(depth_right <= depth_left  + 1);
+   assert(( !IS_DEEPER(root->left )) == (depth_left  <= depth_right));
+   assert(( !IS_DEEPER(root->right)) == (depth_right <= depth_left ));
+   ++*p_count;
+   return (depth_left > depth_right ? depth_left : depth_right) + 1;
+}
+
+/* Check the balance of an intrusive tree, and that it holds as many nodes as it says.
+ */
+void avl_intrusive_check_balance(AVL_INTRUSIVE_TREE *tree)
+{
+   long count = 0;
+
+   if (tree->root) {
+      assert( !IS_DEEPER(tree->root));
+      depth_n(tree->root, &count);
+   }
+   assert(count == tree->nodes);
+}
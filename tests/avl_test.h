@@ -38,9 +38,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 int  avl_depth        (TREE *tree);
 void avl_check_balance(TREE *tree);
 
+bool avl_is_small (TREE *tree);
+int  avl_small_max(void);
+
 void avl_dump      (TREE *tree, void (*callback)());
 void avl_dump_w_ctx(TREE *tree, void (*callback)(), void *context);
 
 int avl_tree_type(TREE *tree);
 
+void avl_check_compact(TREE *tree, int layout);
+long avl_blocks       (TREE *tree);
+long avl_pool_chunks  (AVL_POOL *pool);
+
+void avl_index_check_balance(AVL_INDEX_TREE *tree);
+void avl_intrusive_check_balance(AVL_INTRUSIVE_TREE *tree);
+
 #endif
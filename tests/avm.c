@@ -180,12 +180,10 @@ VECT *avm_vect(int vecttype, size_t keyoffs, int (*usrcmp)(void *, void *))
 
 /*---------------------------------------------------------------------------*/
 
-bool avm_insert(VECT *vect, void *data)
+static bool data2qkey(VECT *vect, void *data, QKEY *p_qkey)
 {
-   size_t i;
    QKEY qkey;
    void *kp = PTRADD(data, vect->keyoffs);
-   vect->cur = NULL;
    qkey.keyoffs = vect->keyoffs;
    qkey.keytype = vect->keytype;
    qkey.usrcmp  = vect->usrcmp;
@@ -207,6 +205,20 @@ bool avm_insert(VECT *vect, void *data)
    CASE DBL_KEY: qkey.k.d  = *(double*)kp;
    DEFAULT: assert( !"bad keytype"); return false;
    }
+   *p_qkey = qkey;
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avm_insert(VECT *vect, void *data)
+{
+   size_t i;
+   QKEY qkey;
+   vect->cur = NULL;
+   if ( !data2qkey(vect, data, &qkey)) {
+      return false;
+   }
    for (i = 0; i < vect->elems; i++) {
       if (qkey2pcmp(&qkey, vect->v[i]) < 0) {
          break;
@@ -276,6 +288,32 @@ void *avm_remove_double(VECT *vect, double         key) { GKEY gkey; gkey.d  = k
 
 /*---------------------------------------------------------------------------*/
 
+void *avm_pop_first(VECT *vect)
+{
+   void *data;
+   vect->cur = NULL;
+   if ( !vect->elems) {
+      return NULL;
+   }
+   data = vect->v[0];
+   vect->elems--;
+   memmove(vect->v, vect->v + 1, vect->elems * sizeof(void *));
+   return data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *avm_pop_last(VECT *vect)
+{
+   vect->cur = NULL;
+   if ( !vect->elems) {
+      return NULL;
+   }
+   return vect->v[--vect->elems];
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void *avm_locate_gkey(VECT *vect, GKEY gkey)
 {
    QKEY qkey;
@@ -462,6 +500,80 @@ void *avm_locate_last(VECT *vect)
 
 /*---------------------------------------------------------------------------*/
 
+static long avm_rank_gkey(VECT *vect, GKEY gkey)
+{
+   size_t i;
+   QKEY qkey;
+   FILL_QKEY(qkey, vect, gkey)
+   for (i = 0; i < vect->elems; i++) {
+      if (qkey2pcmp(&qkey, vect->v[i]) <= 0) {
+         break;
+      }
+   }
+   return (long)i;
+}
+
+long avm_rank       (VECT *vect, void          *key) { GKEY gkey; gkey.p  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_mbr   (VECT *vect, void          *key) { GKEY gkey; gkey.p  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_chars (VECT *vect, char          *key) { GKEY gkey; gkey.p  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_ptr   (VECT *vect, void          *key) { GKEY gkey; gkey.p  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_str   (VECT *vect, char          *key) { GKEY gkey; gkey.p  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_long  (VECT *vect, long           key) { GKEY gkey; gkey.l  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_int   (VECT *vect, int            key) { GKEY gkey; gkey.i  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_short (VECT *vect, short          key) { GKEY gkey; gkey.s  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_schar (VECT *vect, signed char    key) { GKEY gkey; gkey.sc = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_ulong (VECT *vect, unsigned long  key) { GKEY gkey; gkey.ul = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_uint  (VECT *vect, unsigned int   key) { GKEY gkey; gkey.ui = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_ushort(VECT *vect, unsigned short key) { GKEY gkey; gkey.us = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_uchar (VECT *vect, unsigned char  key) { GKEY gkey; gkey.uc = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_float (VECT *vect, float          key) { GKEY gkey; gkey.f  = key; return avm_rank_gkey(vect, gkey); }
+long avm_rank_double(VECT *vect, double         key) { GKEY gkey; gkey.d  = key; return avm_rank_gkey(vect, gkey); }
+
+/*---------------------------------------------------------------------------*/
+
+static long avm_count_range_gkey(VECT *vect, GKEY lo_gkey, GKEY hi_gkey)
+{
+   size_t i;
+   long count = 0;
+   QKEY lo_qkey, hi_qkey;
+   FILL_QKEY(lo_qkey, vect, lo_gkey)
+   FILL_QKEY(hi_qkey, vect, hi_gkey)
+   for (i = 0; i < vect->elems; i++) {
+      if (qkey2pcmp(&lo_qkey, vect->v[i]) <= 0 && qkey2pcmp(&hi_qkey, vect->v[i]) >= 0) {
+         count++;
+      }
+   }
+   return count;
+}
+
+long avm_count_range       (VECT *vect, void          *lo, void          *hi) { GKEY lo_gkey, hi_gkey; lo_gkey.p  = lo; hi_gkey.p  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_mbr   (VECT *vect, void          *lo, void          *hi) { GKEY lo_gkey, hi_gkey; lo_gkey.p  = lo; hi_gkey.p  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_chars (VECT *vect, char          *lo, char          *hi) { GKEY lo_gkey, hi_gkey; lo_gkey.p  = lo; hi_gkey.p  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_ptr   (VECT *vect, void          *lo, void          *hi) { GKEY lo_gkey, hi_gkey; lo_gkey.p  = lo; hi_gkey.p  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_str   (VECT *vect, char          *lo, char          *hi) { GKEY lo_gkey, hi_gkey; lo_gkey.p  = lo; hi_gkey.p  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_long  (VECT *vect, long           lo, long           hi) { GKEY lo_gkey, hi_gkey; lo_gkey.l  = lo; hi_gkey.l  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_int   (VECT *vect, int            lo, int            hi) { GKEY lo_gkey, hi_gkey; lo_gkey.i  = lo; hi_gkey.i  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_short (VECT *vect, short          lo, short          hi) { GKEY lo_gkey, hi_gkey; lo_gkey.s  = lo; hi_gkey.s  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_schar (VECT *vect, signed char    lo, signed char    hi) { GKEY lo_gkey, hi_gkey; lo_gkey.sc = lo; hi_gkey.sc = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_ulong (VECT *vect, unsigned long  lo, unsigned long  hi) { GKEY lo_gkey, hi_gkey; lo_gkey.ul = lo; hi_gkey.ul = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_uint  (VECT *vect, unsigned int   lo, unsigned int   hi) { GKEY lo_gkey, hi_gkey; lo_gkey.ui = lo; hi_gkey.ui = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_ushort(VECT *vect, unsigned short lo, unsigned short hi) { GKEY lo_gkey, hi_gkey; lo_gkey.us = lo; hi_gkey.us = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_uchar (VECT *vect, unsigned char  lo, unsigned char  hi) { GKEY lo_gkey, hi_gkey; lo_gkey.uc = lo; hi_gkey.uc = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_float (VECT *vect, float          lo, float          hi) { GKEY lo_gkey, hi_gkey; lo_gkey.f  = lo; hi_gkey.f  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+long avm_count_range_double(VECT *vect, double         lo, double         hi) { GKEY lo_gkey, hi_gkey; lo_gkey.d  = lo; hi_gkey.d  = hi; return avm_count_range_gkey(vect, lo_gkey, hi_gkey); }
+
+/*---------------------------------------------------------------------------*/
+
+void *avm_select(VECT *vect, long k)
+{
+   if (k < 0 || (size_t)k >= vect->elems) {
+      return NULL;
+   }
+   return vect->v[k];
+}
+
+/*---------------------------------------------------------------------------*/
+
 void *avm_scan(VECT *vect, bool (*callback)())
 {
    size_t i;
@@ -718,6 +830,175 @@ VECT *avm_copy(VECT *vect)
 
 /*---------------------------------------------------------------------------*/
 
+static VECT *avm_split_gkey(VECT *vect, GKEY gkey)
+{
+   size_t i;
+   QKEY qkey;
+   VECT *part = avm_vect((vect->keytype << 1) | vect->dup, vect->keyoffs, vect->usrcmp);
+   FILL_QKEY(qkey, vect, gkey)
+   vect->cur = NULL;
+   for (i = 0; i < vect->elems; i++) {
+      if (qkey2pcmp(&qkey, vect->v[i]) <= 0) {
+         break;
+      }
+   }
+   for ( ; i < vect->elems; vect->elems--) {
+      avm_insert(part, vect->v[i]);
+      memmove(vect->v + i, vect->v + i + 1, (vect->elems - i - 1) * sizeof(void *));
+   }
+   return part;
+}
+
+VECT *avm_split       (VECT *vect, void          *key) { GKEY gkey; gkey.p  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_mbr   (VECT *vect, void          *key) { GKEY gkey; gkey.p  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_chars (VECT *vect, char          *key) { GKEY gkey; gkey.p  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_ptr   (VECT *vect, void          *key) { GKEY gkey; gkey.p  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_str   (VECT *vect, char          *key) { GKEY gkey; gkey.p  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_long  (VECT *vect, long           key) { GKEY gkey; gkey.l  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_int   (VECT *vect, int            key) { GKEY gkey; gkey.i  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_short (VECT *vect, short          key) { GKEY gkey; gkey.s  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_schar (VECT *vect, signed char    key) { GKEY gkey; gkey.sc = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_ulong (VECT *vect, unsigned long  key) { GKEY gkey; gkey.ul = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_uint  (VECT *vect, unsigned int   key) { GKEY gkey; gkey.ui = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_ushort(VECT *vect, unsigned short key) { GKEY gkey; gkey.us = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_uchar (VECT *vect, unsigned char  key) { GKEY gkey; gkey.uc = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_float (VECT *vect, float          key) { GKEY gkey; gkey.f  = key; return avm_split_gkey(vect, gkey); }
+VECT *avm_split_double(VECT *vect, double         key) { GKEY gkey; gkey.d  = key; return avm_split_gkey(vect, gkey); }
+
+/*---------------------------------------------------------------------------*/
+
+bool avm_join(VECT *left, VECT *right)
+{
+   size_t i;
+   QKEY qkey;
+   int cmp;
+   if (left == right || left->keytype != right->keytype || left->dup != right->dup
+    || left->keyoffs != right->keyoffs || left->usrcmp != right->usrcmp) {
+      return false;
+   }
+   if (left->elems && right->elems) {
+      data2qkey(left, right->v[0], &qkey);
+      cmp = qkey2pcmp(&qkey, left->v[left->elems - 1]);
+      if (cmp < 0 || (cmp == 0 && !left->dup)) {
+         return false;
+      }
+   }
+   left->cur = NULL;
+   for (i = 0; i < right->elems; i++) {
+      avm_insert(left, right->v[i]);
+   }
+   avm_empty(right);
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void **avm_find_key_of(VECT *vect, void *data)
+{
+   size_t i;
+   QKEY qkey;
+   data2qkey(vect, data, &qkey);
+   for (i = 0; i < vect->elems; i++) {
+      if (qkey2pcmp(&qkey, vect->v[i]) == 0) {
+         return &vect->v[i];
+      }
+   }
+   return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool avm_same_kind(VECT *a, VECT *b)
+{
+   return a->keytype == b->keytype && a->dup == b->dup && a->keyoffs == b->keyoffs && a->usrcmp == b->usrcmp;
+}
+
+/*---------------------------------------------------------------------------*/
+
+VECT *avm_union(VECT *a, VECT *b)
+{
+   size_t i;
+   VECT *result;
+   if ( !avm_same_kind(a, b)) {
+      return NULL;
+   }
+   result = avm_copy(a);
+   for (i = 0; i < b->elems; i++) {
+      avm_insert(result, b->v[i]);
+   }
+   return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+VECT *avm_intersection(VECT *a, VECT *b)
+{
+   size_t i;
+   VECT *result;
+   if ( !avm_same_kind(a, b)) {
+      return NULL;
+   }
+   result = avm_vect((a->keytype << 1) | a->dup, a->keyoffs, a->usrcmp);
+   for (i = 0; i < a->elems; i++) {
+      if (avm_find_key_of(b, a->v[i])) {
+         avm_insert(result, a->v[i]);
+      }
+   }
+   return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+VECT *avm_difference(VECT *a, VECT *b)
+{
+   size_t i;
+   VECT *result;
+   if ( !avm_same_kind(a, b)) {
+      return NULL;
+   }
+   result = avm_vect((a->keytype << 1) | a->dup, a->keyoffs, a->usrcmp);
+   for (i = 0; i < a->elems; i++) {
+      if ( !avm_find_key_of(b, a->v[i])) {
+         avm_insert(result, a->v[i]);
+      }
+   }
+   return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avm_insert_or_locate(VECT *vect, void *data, void **p_existing)
+{
+   void **p_elem;
+   if (avm_insert(vect, data)) {
+      *p_existing = NULL;
+      return true;
+   }
+   p_elem = avm_find_key_of(vect, data);
+   *p_existing = p_elem ? *p_elem : NULL;
+   return false;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool avm_insert_or_replace(VECT *vect, void *data, void **p_replaced)
+{
+   void **p_elem;
+   if (avm_insert(vect, data)) {
+      *p_replaced = NULL;
+      return true;
+   }
+   p_elem = avm_find_key_of(vect, data);
+   if ( !p_elem) {
+      return false;
+   }
+   *p_replaced = *p_elem;
+   *p_elem = data;
+   return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void avm_empty(VECT *vect)
 {
    free(vect->v);
@@ -129,6 +129,9 @@ void *avm_remove_uchar (VECT *vect, unsigned char  key);
 void *avm_remove_float (VECT *vect, float  key);
 void *avm_remove_double(VECT *vect, double key);
 
+void *avm_pop_first(VECT *vect);
+void *avm_pop_last (VECT *vect);
+
 void *avm_locate       (VECT *vect, void *key);
 void *avm_locate_mbr   (VECT *vect, void *key);
 void *avm_locate_ptr   (VECT *vect, void *key);
@@ -209,6 +212,40 @@ void *avm_locate_lt_double(VECT *vect, double key);
 void *avm_locate_first(VECT *vect);
 void *avm_locate_last (VECT *vect);
 
+long avm_rank       (VECT *vect, void          *key);
+long avm_rank_mbr   (VECT *vect, void          *key);
+long avm_rank_chars (VECT *vect, char          *key);
+long avm_rank_ptr   (VECT *vect, void          *key);
+long avm_rank_str   (VECT *vect, char          *key);
+long avm_rank_long  (VECT *vect, long           key);
+long avm_rank_int   (VECT *vect, int            key);
+long avm_rank_short (VECT *vect, short          key);
+long avm_rank_schar (VECT *vect, signed char    key);
+long avm_rank_ulong (VECT *vect, unsigned long  key);
+long avm_rank_uint  (VECT *vect, unsigned int   key);
+long avm_rank_ushort(VECT *vect, unsigned short key);
+long avm_rank_uchar (VECT *vect, unsigned char  key);
+long avm_rank_float (VECT *vect, float          key);
+long avm_rank_double(VECT *vect, double         key);
+
+long avm_count_range       (VECT *vect, void          *lo, void          *hi);
+long avm_count_range_mbr   (VECT *vect, void          *lo, void          *hi);
+long avm_count_range_chars (VECT *vect, char          *lo, char          *hi);
+long avm_count_range_ptr   (VECT *vect, void          *lo, void          *hi);
+long avm_count_range_str   (VECT *vect, char          *lo, char          *hi);
+long avm_count_range_long  (VECT *vect, long           lo, long           hi);
+long avm_count_range_int   (VECT *vect, int            lo, int            hi);
+long avm_count_range_short (VECT *vect, short          lo, short          hi);
+long avm_count_range_schar (VECT *vect, signed char    lo, signed char    hi);
+long avm_count_range_ulong (VECT *vect, unsigned long  lo, unsigned long  hi);
+long avm_count_range_uint  (VECT *vect, unsigned int   lo, unsigned int   hi);
+long avm_count_range_ushort(VECT *vect, unsigned short lo, unsigned short hi);
+long avm_count_range_uchar (VECT *vect, unsigned char  lo, unsigned char  hi);
+long avm_count_range_float (VECT *vect, float          lo, float          hi);
+long avm_count_range_double(VECT *vect, double         lo, double         hi);
+
+void *avm_select(VECT *vect, long k);
+
 void *avm_scan(    VECT *vect, bool (*callback)());
 void *avm_rev_scan(VECT *vect, bool (*callback)());
 
@@ -268,6 +305,31 @@ long avm_nodes(VECT *vect);
 
 VECT *avm_copy(VECT *vect);
 
+VECT *avm_split       (VECT *vect, void          *key);
+VECT *avm_split_mbr   (VECT *vect, void          *key);
+VECT *avm_split_chars (VECT *vect, char          *key);
+VECT *avm_split_ptr   (VECT *vect, void          *key);
+VECT *avm_split_str   (VECT *vect, char          *key);
+VECT *avm_split_long  (VECT *vect, long           key);
+VECT *avm_split_int   (VECT *vect, int            key);
+VECT *avm_split_short (VECT *vect, short          key);
+VECT *avm_split_schar (VECT *vect, signed char    key);
+VECT *avm_split_ulong (VECT *vect, unsigned long  key);
+VECT *avm_split_uint  (VECT *vect, unsigned int   key);
+VECT *avm_split_ushort(VECT *vect, unsigned short key);
+VECT *avm_split_uchar (VECT *vect, unsigned char  key);
+VECT *avm_split_float (VECT *vect, float          key);
+VECT *avm_split_double(VECT *vect, double         key);
+
+bool avm_join(VECT *left, VECT *right);
+
+VECT *avm_union       (VECT *a, VECT *b);
+VECT *avm_intersection(VECT *a, VECT *b);
+VECT *avm_difference  (VECT *a, VECT *b);
+
+bool avm_insert_or_locate (VECT *vect, void *data, void **p_existing);
+bool avm_insert_or_replace(VECT *vect, void *data, void **p_replaced);
+
 void avm_empty(VECT *vect);
 
 void avm_free(VECT *vect);
@@ -0,0 +1,295 @@
+/*----------------------------------------------------------------------------*
+ |                                                                            |
+ |                                bench_avl.c                                 |
+ |                                                                            |
+ |                     benchmarks for the AVL library                         |
+ |                                                                            |
+ *----------------------------------------------------------------------------*/
+/*
+Copyright (c) 2013, Walter Tross <waltertross at gmail dot com>
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* Usage: bench_avl [n_items [n_rounds]]
+ * Every round inserts n_items items with random keys into a tree, locates them all,
+ * and removes them all, in a different random order. The best time of all rounds
+ * is printed for each operation, in nanoseconds per operation.
+ * The trees that support avl_locate_many*() also locate all items in batches of N_BATCH,
+ * which pays off when the tree is much larger than the CPU caches (e.g., 20000000 items).
+ * Finally, all items are inserted into a new tree in ascending order of their keys,
+ * which takes the append fast path of the trees that have one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../avl.h"
+#include "../avl_define.h"
+#include "test_utils.h"
+
+/*---------------------------------------------------------------------------*/
+
+#define N_ITEMS  1000000
+#define N_ROUNDS       5
+#define N_BATCH       64
+
+/*---------------------------------------------------------------------------*/
+
+typedef struct item {
+   long      key;
+   char      str[12];
+   AVL_LINKS links;
+} ITEM;
+
+typedef struct bench {
+   const char *name;
+   void      *(*new_tree)(void);
+   bool       (*insert)(void *tree, ITEM *item);
+   void      *(*locate)(void *tree, ITEM *item);
+   void      *(*remove)(void *tree, ITEM *item);
+   long       (*nodes)(void *tree);
+   void       (*free_tree)(void *tree);
+   long       (*locate_many)(void *tree, ITEM **item_v, long n, void **results);
+   double      best[5];
+} BENCH;
+
+enum { INSERT, LOCATE, REMOVE, LOCATE_MANY, INSERT_SEQ };
+
+/*---------------------------------------------------------------------------*/
+
+static int item_cmp(void *key, void *data)
+{
+   long k1 = ((ITEM *)key )->key;
+   long k2 = ((ITEM *)data)->key;
+   return k1 < k2 ? -1 : k1 > k2;
+}
+
+AVL_DEFINE_TREE      (def, ITEM, key, long, AVL_CMP, AVL_NODUP)
+AVL_DEFINE_INDEX_TREE(idx, ITEM, key, long, AVL_CMP, AVL_NODUP)
+AVL_DEFINE_INDEX_LONG_TREE(ilg, ITEM, key, long, AVL_NODUP)
+AVL_DEFINE_INTRUSIVE_TREE(itr, ITEM, links, key, long, AVL_CMP, AVL_NODUP)
+
+static void *new_usr_nodup (void) { return avl_tree(AVL_USR|AVL_NODUP, 0, item_cmp); }
+static void *new_usr_dup   (void) { return avl_tree(AVL_USR|AVL_DUP,   0, item_cmp); }
+static void *new_lng_nodup (void) { return avl_tree_nodup_long(ITEM, key); }
+static void *new_lng_dup   (void) { return avl_tree_dup_long  (ITEM, key); }
+static void *new_cha_nodup (void) { return avl_tree_nodup_chars(ITEM, str); }
+static void *new_lng_rank  (void) { return avl_tree(AVL_LONG|AVL_NODUP|AVL_RANK, offsetof(ITEM, key), NULL); }
+static void *new_def_nodup (void) { return def_tree(false); }
+static void *new_idx_nodup (void) { return idx_tree(); }
+static void *new_ilg_nodup (void) { return ilg_tree(); }
+static void *new_itr_nodup (void)
+{
+   AVL_INTRUSIVE_TREE *tree = malloc(sizeof(*tree));
+   if (tree) itr_tree(tree);
+   return tree;
+}
+
+static bool insert_usr   (void *tree, ITEM *item) { return avl_insert(tree, item); }
+static bool insert_def   (void *tree, ITEM *item) { return def_insert(tree, item); }
+static bool insert_idx   (void *tree, ITEM *item) { return idx_insert(tree, item); }
+static bool insert_ilg   (void *tree, ITEM *item) { return ilg_insert(tree, item); }
+static bool insert_itr   (void *tree, ITEM *item) { return itr_insert(tree, item); }
+
+static void *locate_usr  (void *tree, ITEM *item) { return avl_locate      (tree, item);      }
+static void *locate_long (void *tree, ITEM *item) { return avl_locate_long (tree, item->key); }
+static void *locate_chars(void *tree, ITEM *item) { return avl_locate_chars(tree, item->str); }
+static void *remove_usr  (void *tree, ITEM *item) { return avl_remove      (tree, item);      }
+static void *remove_long (void *tree, ITEM *item) { return avl_remove_long (tree, item->key); }
+static void *remove_chars(void *tree, ITEM *item) { return avl_remove_chars(tree, item->str); }
+static void *locate_def  (void *tree, ITEM *item) { return def_locate      (tree, item->key); }
+static void *remove_def  (void *tree, ITEM *item) { return def_remove      (tree, item->key); }
+static void *locate_idx  (void *tree, ITEM *item) { return idx_locate      (tree, item->key); }
+static void *remove_idx  (void *tree, ITEM *item) { return idx_remove      (tree, item->key); }
+static void *locate_ilg  (void *tree, ITEM *item) { return ilg_locate      (tree, item->key); }
+static void *remove_ilg  (void *tree, ITEM *item) { return ilg_remove      (tree, item->key); }
+static void *locate_itr  (void *tree, ITEM *item) { return itr_locate      (tree, item->key); }
+static void *remove_itr  (void *tree, ITEM *item) { return itr_remove      (tree, item->key); }
+
+static long locate_many_usr(void *tree, ITEM **item_v, long n, void **results)
+{
+   return avl_locate_many(tree, (void **)item_v, n, results);
+}
+
+static long locate_many_long(void *tree, ITEM **item_v, long n, void **results)
+{
+   long key_v[N_BATCH], i;
+
+   for (i = 0; i < n; i++) key_v[i] = item_v[i]->key;
+   return avl_locate_many_long(tree, key_v, n, results);
+}
+
+static long locate_many_chars(void *tree, ITEM **item_v, long n, void **results)
+{
+   char *key_v[N_BATCH];
+   long  i;
+
+   for (i = 0; i < n; i++) key_v[i] = item_v[i]->str;
+   return avl_locate_many_chars(tree, key_v, n, results);
+}
+
+static long nodes_avl    (void *tree) { return avl_nodes          (tree); }
+static long nodes_idx    (void *tree) { return avl_index_nodes    (tree); }
+static long nodes_itr    (void *tree) { return avl_intrusive_nodes(tree); }
+static void free_avl     (void *tree) { avl_free      (tree); }
+static void free_idx     (void *tree) { avl_index_free(tree); }
+
+/*---------------------------------------------------------------------------*/
+
+static double elapsed_ns(clock_t start, long n)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void run(BENCH *bench, ITEM *item_v, ITEM **order_v, ITEM **sorted_v, long n)
+{
+   void   *tree = bench->new_tree();
+   clock_t start;
+   double  ns;
+   long    i, found = 0;
+
+   start = clock();
+   for (i = 0; i < n; i++) {
+      bench->insert(tree, &item_v[i]);
+   }
+   ns = elapsed_ns(start, n);
+   if (ns < bench->best[INSERT]) bench->best[INSERT] = ns;
+
+   start = clock();
+   for (i = 0; i < n; i++) {
+      found += bench->locate(tree, order_v[i]) != NULL;
+   }
+   ns = elapsed_ns(start, n);
+   if (ns < bench->best[LOCATE]) bench->best[LOCATE] = ns;
+
+   if (bench->locate_many) {
+      void *result_v[N_BATCH];
+      long  m, found_many = 0;
+
+      start = clock();
+      for (i = 0; i < n; i += m) {
+         m = n - i < N_BATCH ? n - i : N_BATCH;
+         found_many += bench->locate_many(tree, order_v + i, m, result_v);
+      }
+      ns = elapsed_ns(start, n);
+      if (ns < bench->best[LOCATE_MANY]) bench->best[LOCATE_MANY] = ns;
+      if (found_many != found) {
+         fprintf(stderr, "%s: inconsistent results\n", bench->name);
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   start = clock();
+   for (i = 0; i < n; i++) {
+      found -= bench->remove(tree, order_v[i]) != NULL;
+   }
+   ns = elapsed_ns(start, n);
+   if (ns < bench->best[REMOVE]) bench->best[REMOVE] = ns;
+
+   if (found != 0 || bench->nodes(tree) != 0) {
+      fprintf(stderr, "%s: inconsistent results\n", bench->name);
+      exit(EXIT_FAILURE);
+   }
+   bench->free_tree(tree);
+
+   tree = bench->new_tree();
+   start = clock();
+   for (i = 0; i < n; i++) {
+      bench->insert(tree, sorted_v[i]);
+   }
+   ns = elapsed_ns(start, n);
+   if (ns < bench->best[INSERT_SEQ]) bench->best[INSERT_SEQ] = ns;
+   if (bench->nodes(tree) != n) {
+      fprintf(stderr, "%s: inconsistent results\n", bench->name);
+      exit(EXIT_FAILURE);
+   }
+   bench->free_tree(tree);
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+   BENCH bench_v[] = {
+      { "X usr nodup",   new_usr_nodup, insert_usr, locate_usr,   remove_usr,   nodes_avl, free_avl, locate_many_usr,   { 0 } },
+      { "X usr dup",     new_usr_dup,   insert_usr, locate_usr,   remove_usr,   nodes_avl, free_avl, locate_many_usr,   { 0 } },
+      { "L long nodup",  new_lng_nodup, insert_usr, locate_long,  remove_long,  nodes_avl, free_avl, locate_many_long,  { 0 } },
+      { "L long dup",    new_lng_dup,   insert_usr, locate_long,  remove_long,  nodes_avl, free_avl, locate_many_long,  { 0 } },
+      { "L chars nodup", new_cha_nodup, insert_usr, locate_chars, remove_chars, nodes_avl, free_avl, locate_many_chars, { 0 } },
+      { "L long rank",   new_lng_rank,  insert_usr, locate_long,  remove_long,  nodes_avl, free_avl, locate_many_long,  { 0 } },
+      { "X def nodup",   new_def_nodup, insert_def, locate_def,   remove_def,   nodes_avl, free_avl, NULL,              { 0 } },
+      { "I idx nodup",   new_idx_nodup, insert_idx, locate_idx,   remove_idx,   nodes_idx, free_idx, NULL,              { 0 } },
+      { "I idx long",    new_ilg_nodup, insert_ilg, locate_ilg,   remove_ilg,   nodes_idx, free_idx, NULL,              { 0 } },
+      { "N itr nodup",   new_itr_nodup, insert_itr, locate_itr,   remove_itr,   nodes_itr, free,     NULL,              { 0 } },
+   };
+   int    n_bench  = sizeof(bench_v) / sizeof(bench_v[0]);
+   long   n        = argc > 1 ? atol(argv[1]) : N_ITEMS;
+   int    n_rounds = argc > 2 ? atoi(argv[2]) : N_ROUNDS;
+   ITEM  *item_v   = malloc(n * sizeof(ITEM));
+   ITEM **order_v  = malloc(n * sizeof(ITEM *));
+   ITEM **sorted_v = malloc(n * sizeof(ITEM *));
+   ITEM  *tmp;
+   long   i, j, key;
+   int    b, r;
+
+   if (n <= 0 || n_rounds <= 0 || !item_v || !order_v || !sorted_v) {
+      fprintf(stderr, "usage: %s [n_items [n_rounds]]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   for (b = 0; b < n_bench; b++) {
+      bench_v[b].best[INSERT] = bench_v[b].best[LOCATE] = bench_v[b].best[REMOVE] = bench_v[b].best[LOCATE_MANY] = 1e300;
+      bench_v[b].best[INSERT_SEQ] = 1e300;
+   }
+   for (r = 0; r < n_rounds; r++) {
+      /* distinct keys in random order, so that nodup and dup trees do the same work */
+      for (i = 0; i < n; i++) {
+         item_v[i].key = i * 2 + 1;
+         order_v[i] = &item_v[i];
+      }
+      for (i = n - 1; i > 0; i--) {
+         j = random_long(0, i);
+         key = item_v[i].key; item_v[i].key = item_v[j].key; item_v[j].key = key;
+         j = random_long(0, i);
+         tmp = order_v[i]; order_v[i] = order_v[j]; order_v[j] = tmp;
+      }
+      for (i = 0; i < n; i++) {
+         sprintf(item_v[i].str, "k%010ld", item_v[i].key);
+         sorted_v[item_v[i].key / 2] = &item_v[i];
+      }
+      for (b = 0; b < n_bench; b++) {
+         run(&bench_v[b], item_v, order_v, sorted_v, n);
+      }
+   }
+   printf("%ld items, best of %d rounds, ns/op\n", n, n_rounds);
+   printf("%-14s %8s %8s %8s %8s %8s\n", "tree", "insert", "locate", "remove", "loc_many", "ins_seq");
+   for (b = 0; b < n_bench; b++) {
+      printf("%-14s %8.1f %8.1f %8.1f", bench_v[b].name,
+             bench_v[b].best[INSERT], bench_v[b].best[LOCATE], bench_v[b].best[REMOVE]);
+      if (bench_v[b].locate_many) printf(" %8.1f", bench_v[b].best[LOCATE_MANY]);
+      else                        printf(" %8s", "-");
+      printf(" %8.1f\n", bench_v[b].best[INSERT_SEQ]);
+   }
+   return EXIT_SUCCESS;
+}
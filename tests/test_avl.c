@@ -37,6 +37,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdarg.h>
 #include <assert.h>
 #include "avl_test.h"
+#include "../avl_define.h"
 #include "avm.h"
 #include "test_utils.h"
 
@@ -56,6 +57,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef MAX
 #define MAX(a, b) ((a) >= (b) ? (a) : (b))
 #endif
+#ifndef MIN
+#define MIN(a, b) ((a) <= (b) ? (a) : (b))
+#endif
 
 typedef unsigned long  ULONG;
 typedef unsigned int   UINT;
@@ -81,6 +85,8 @@ typedef struct obj {
    UCHAR  uc;
    float  f;
    double d;
+   AVL_LINKS i_links;
+   AVL_LINKS str_links;
 } OBJ;
 
 /*---------------------------------------------------------------------------*/
@@ -205,6 +211,31 @@ void test_avl_insert(TREE *tree, VECT *vect, OBJ *obj)
 
 /*---------------------------------------------------------------------------*/
 
+void test_avl_insert_or_locate(TREE *tree, VECT *vect, OBJ *obj)
+{
+   void *tree_existing, *vect_existing;
+   bool tree_ins = avl_insert_or_locate(tree, obj, &tree_existing);
+   bool vect_ins = avm_insert_or_locate(vect, obj, &vect_existing);
+   assert(tree_ins == vect_ins);
+   assert(tree_existing == vect_existing);
+   assert(tree_ins || tree_existing);
+   check_and_cmp(tree, vect);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void test_avl_insert_or_replace(TREE *tree, VECT *vect, OBJ *obj)
+{
+   void *tree_replaced, *vect_replaced;
+   bool tree_ok = avl_insert_or_replace(tree, obj, &tree_replaced);
+   bool vect_ok = avm_insert_or_replace(vect, obj, &vect_replaced);
+   assert(tree_ok && vect_ok);
+   assert(tree_replaced == vect_replaced);
+   check_and_cmp(tree, vect);
+}
+
+/*---------------------------------------------------------------------------*/
+
 void test_avl_remove(TREE *tree, VECT *vect, void *key)
 {
    OBJ *tree_obj = avl_remove(tree, key);
@@ -431,6 +462,115 @@ void test_avl_locate_gt_double(TREE *tree, VECT *vect, double key) { assert(avl_
 void test_avl_locate_le_double(TREE *tree, VECT *vect, double key) { assert(avl_locate_le_double(tree, key) == avm_locate_le_double(vect, key)); }
 void test_avl_locate_lt_double(TREE *tree, VECT *vect, double key) { assert(avl_locate_lt_double(tree, key) == avm_locate_lt_double(vect, key)); }
 
+/* Locate the keys of all objects at once, and check every result against the mockup
+ */
+#define TEST_AVL_LOCATE_MANY(tree, vect, key_t, key_of_obj, locate_many_fun, avm_locate_fun, obj_v, n) \
+   do { key_t *key_v    = malloc(MAX((n), 1) * sizeof(key_t)); \
+        void **result_v = malloc(MAX((n), 1) * sizeof(void *)); \
+        long   found = 0, j; \
+        for (j = 0; j < (n); j++) key_v[j] = key_of_obj; \
+        found = locate_many_fun((tree), key_v, (n), result_v); \
+        for (j = 0; j < (n); j++) { \
+           assert(result_v[j] == avm_locate_fun((vect), key_v[j])); \
+           found -= result_v[j] != NULL; \
+        } \
+        assert(found == 0); \
+        free(key_v); \
+        free(result_v); } while (0)
+
+void test_avl_locate_many       (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, void  *, &obj_v[j]   , avl_locate_many       , avm_locate       , obj_v, n); }
+void test_avl_locate_many_mbr   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, void  *, obj_v[j].ch1, avl_locate_many_mbr   , avm_locate_mbr   , obj_v, n); }
+void test_avl_locate_many_ptr   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, void  *, obj_v[j].str, avl_locate_many_ptr   , avm_locate_ptr   , obj_v, n); }
+void test_avl_locate_many_chars (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, char  *, obj_v[j].ch0, avl_locate_many_chars , avm_locate_chars , obj_v, n); }
+void test_avl_locate_many_chars1(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, char  *, obj_v[j].ch1, avl_locate_many_chars , avm_locate_chars , obj_v, n); }
+void test_avl_locate_many_str   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, char  *, obj_v[j].str, avl_locate_many_str   , avm_locate_str   , obj_v, n); }
+void test_avl_locate_many_long  (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, long   , obj_v[j].l  , avl_locate_many_long  , avm_locate_long  , obj_v, n); }
+void test_avl_locate_many_int   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, int    , obj_v[j].i  , avl_locate_many_int   , avm_locate_int   , obj_v, n); }
+void test_avl_locate_many_short (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, short  , obj_v[j].s  , avl_locate_many_short , avm_locate_short , obj_v, n); }
+void test_avl_locate_many_schar (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, SCHAR  , obj_v[j].sc , avl_locate_many_schar , avm_locate_schar , obj_v, n); }
+void test_avl_locate_many_ulong (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, ULONG  , obj_v[j].ul , avl_locate_many_ulong , avm_locate_ulong , obj_v, n); }
+void test_avl_locate_many_uint  (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, UINT   , obj_v[j].ui , avl_locate_many_uint  , avm_locate_uint  , obj_v, n); }
+void test_avl_locate_many_ushort(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, USHORT , obj_v[j].us , avl_locate_many_ushort, avm_locate_ushort, obj_v, n); }
+void test_avl_locate_many_uchar (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, UCHAR  , obj_v[j].uc , avl_locate_many_uchar , avm_locate_uchar , obj_v, n); }
+void test_avl_locate_many_float (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, float  , obj_v[j].f  , avl_locate_many_float , avm_locate_float , obj_v, n); }
+void test_avl_locate_many_double(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_MANY(tree, vect, double , obj_v[j].d  , avl_locate_many_double, avm_locate_double, obj_v, n); }
+
+/* Locate the keys of all objects in ascending order, as obtained from a tree of the same type, and then
+ * in the order of obj_v, checking every result against the mockup
+ */
+#define TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, key_t, key_of_p, batch_fun, avm_locate_fun, obj_v, n) \
+   do { TREE  *sorted   = avl_copy(tree); \
+        key_t *key_v    = malloc(MAX((n), 1) * sizeof(key_t)); \
+        void **result_v = malloc(MAX((n), 1) * sizeof(void *)); \
+        OBJ   *p; \
+        long   found, m = 0, j, k; \
+        avl_empty(sorted); \
+        for (j = 0; j < (n); j++) avl_insert(sorted, &(obj_v)[j]); \
+        for (p = avl_first(sorted); p; p = avl_next(sorted)) key_v[m++] = key_of_p; \
+        for (k = 0; k < 2; k++) { \
+           found = batch_fun((tree), key_v, m, result_v); \
+           for (j = 0; j < m; j++) { \
+              assert(result_v[j] == avm_locate_fun((vect), key_v[j])); \
+              found -= result_v[j] != NULL; \
+           } \
+           assert(found == 0); \
+           for (m = 0, p = (obj_v); m < (n); m++, p++) key_v[m] = key_of_p; \
+        } \
+        avl_free(sorted); \
+        free(key_v); \
+        free(result_v); } while (0)
+
+void test_avl_locate_sorted_batch       (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, void  *, p            , avl_locate_sorted_batch       , avm_locate       , obj_v, n); }
+void test_avl_locate_sorted_batch_mbr   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, void  *, p->ch1       , avl_locate_sorted_batch       , avm_locate_mbr   , obj_v, n); }
+void test_avl_locate_sorted_batch_ptr   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, void  *, p->str       , avl_locate_sorted_batch       , avm_locate_ptr   , obj_v, n); }
+void test_avl_locate_sorted_batch_chars (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, void  *, p->ch0       , avl_locate_sorted_batch       , avm_locate_chars , obj_v, n); }
+void test_avl_locate_sorted_batch_chars1(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, void  *, p->ch1       , avl_locate_sorted_batch       , avm_locate_chars , obj_v, n); }
+void test_avl_locate_sorted_batch_str   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, void  *, p->str       , avl_locate_sorted_batch       , avm_locate_str   , obj_v, n); }
+void test_avl_locate_sorted_batch_long  (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, long   , p->l         , avl_locate_sorted_batch_long  , avm_locate_long  , obj_v, n); }
+void test_avl_locate_sorted_batch_int   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, long   , p->i         , avl_locate_sorted_batch_long  , avm_locate_int   , obj_v, n); }
+void test_avl_locate_sorted_batch_short (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, long   , p->s         , avl_locate_sorted_batch_long  , avm_locate_short , obj_v, n); }
+void test_avl_locate_sorted_batch_schar (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, long   , p->sc        , avl_locate_sorted_batch_long  , avm_locate_schar , obj_v, n); }
+void test_avl_locate_sorted_batch_ulong (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, long   , (long)p->ul  , avl_locate_sorted_batch_long  , avm_locate_ulong , obj_v, n); }
+void test_avl_locate_sorted_batch_uint  (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, long   , p->ui        , avl_locate_sorted_batch_long  , avm_locate_uint  , obj_v, n); }
+void test_avl_locate_sorted_batch_ushort(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, long   , p->us        , avl_locate_sorted_batch_long  , avm_locate_ushort, obj_v, n); }
+void test_avl_locate_sorted_batch_uchar (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, long   , p->uc        , avl_locate_sorted_batch_long  , avm_locate_uchar , obj_v, n); }
+void test_avl_locate_sorted_batch_float (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, float  , p->f         , avl_locate_sorted_batch_float , avm_locate_float , obj_v, n); }
+void test_avl_locate_sorted_batch_double(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_SORTED_BATCH(tree, vect, double , p->d         , avl_locate_sorted_batch_double, avm_locate_double, obj_v, n); }
+
+void test_avl_rank       (TREE *tree, VECT *vect, void  *key) { assert(avl_rank       (tree, key) == avm_rank       (vect, key)); }
+void test_avl_rank_mbr   (TREE *tree, VECT *vect, void  *key) { assert(avl_rank_mbr   (tree, key) == avm_rank_mbr   (vect, key)); }
+void test_avl_rank_ptr   (TREE *tree, VECT *vect, void  *key) { assert(avl_rank_ptr   (tree, key) == avm_rank_ptr   (vect, key)); }
+void test_avl_rank_chars (TREE *tree, VECT *vect, char  *key) { assert(avl_rank_chars (tree, key) == avm_rank_chars (vect, key)); }
+void test_avl_rank_str   (TREE *tree, VECT *vect, char  *key) { assert(avl_rank_str   (tree, key) == avm_rank_str   (vect, key)); }
+void test_avl_rank_long  (TREE *tree, VECT *vect, long   key) { assert(avl_rank_long  (tree, key) == avm_rank_long  (vect, key)); }
+void test_avl_rank_int   (TREE *tree, VECT *vect, int    key) { assert(avl_rank_int   (tree, key) == avm_rank_int   (vect, key)); }
+void test_avl_rank_short (TREE *tree, VECT *vect, short  key) { assert(avl_rank_short (tree, key) == avm_rank_short (vect, key)); }
+void test_avl_rank_schar (TREE *tree, VECT *vect, SCHAR  key) { assert(avl_rank_schar (tree, key) == avm_rank_schar (vect, key)); }
+void test_avl_rank_ulong (TREE *tree, VECT *vect, ULONG  key) { assert(avl_rank_ulong (tree, key) == avm_rank_ulong (vect, key)); }
+void test_avl_rank_uint  (TREE *tree, VECT *vect, UINT   key) { assert(avl_rank_uint  (tree, key) == avm_rank_uint  (vect, key)); }
+void test_avl_rank_ushort(TREE *tree, VECT *vect, USHORT key) { assert(avl_rank_ushort(tree, key) == avm_rank_ushort(vect, key)); }
+void test_avl_rank_uchar (TREE *tree, VECT *vect, UCHAR  key) { assert(avl_rank_uchar (tree, key) == avm_rank_uchar (vect, key)); }
+void test_avl_rank_float (TREE *tree, VECT *vect, float  key) { assert(avl_rank_float (tree, key) == avm_rank_float (vect, key)); }
+void test_avl_rank_double(TREE *tree, VECT *vect, double key) { assert(avl_rank_double(tree, key) == avm_rank_double(vect, key)); }
+
+void test_avl_count_range       (TREE *tree, VECT *vect, void  *lo, void  *hi) { assert(avl_count_range       (tree, lo, hi) == avm_count_range       (vect, lo, hi)); }
+void test_avl_count_range_mbr   (TREE *tree, VECT *vect, void  *lo, void  *hi) { assert(avl_count_range_mbr   (tree, lo, hi) == avm_count_range_mbr   (vect, lo, hi)); }
+void test_avl_count_range_ptr   (TREE *tree, VECT *vect, void  *lo, void  *hi) { assert(avl_count_range_ptr   (tree, lo, hi) == avm_count_range_ptr   (vect, lo, hi)); }
+void test_avl_count_range_chars (TREE *tree, VECT *vect, char  *lo, char  *hi) { assert(avl_count_range_chars (tree, lo, hi) == avm_count_range_chars (vect, lo, hi)); }
+void test_avl_count_range_str   (TREE *tree, VECT *vect, char  *lo, char  *hi) { assert(avl_count_range_str   (tree, lo, hi) == avm_count_range_str   (vect, lo, hi)); }
+void test_avl_count_range_long  (TREE *tree, VECT *vect, long   lo, long   hi) { assert(avl_count_range_long  (tree, lo, hi) == avm_count_range_long  (vect, lo, hi)); }
+void test_avl_count_range_int   (TREE *tree, VECT *vect, int    lo, int    hi) { assert(avl_count_range_int   (tree, lo, hi) == avm_count_range_int   (vect, lo, hi)); }
+void test_avl_count_range_short (TREE *tree, VECT *vect, short  lo, short  hi) { assert(avl_count_range_short (tree, lo, hi) == avm_count_range_short (vect, lo, hi)); }
+void test_avl_count_range_schar (TREE *tree, VECT *vect, SCHAR  lo, SCHAR  hi) { assert(avl_count_range_schar (tree, lo, hi) == avm_count_range_schar (vect, lo, hi)); }
+void test_avl_count_range_ulong (TREE *tree, VECT *vect, ULONG  lo, ULONG  hi) { assert(avl_count_range_ulong (tree, lo, hi) == avm_count_range_ulong (vect, lo, hi)); }
+void test_avl_count_range_uint  (TREE *tree, VECT *vect, UINT   lo, UINT   hi) { assert(avl_count_range_uint  (tree, lo, hi) == avm_count_range_uint  (vect, lo, hi)); }
+void test_avl_count_range_ushort(TREE *tree, VECT *vect, USHORT lo, USHORT hi) { assert(avl_count_range_ushort(tree, lo, hi) == avm_count_range_ushort(vect, lo, hi)); }
+void test_avl_count_range_uchar (TREE *tree, VECT *vect, UCHAR  lo, UCHAR  hi) { assert(avl_count_range_uchar (tree, lo, hi) == avm_count_range_uchar (vect, lo, hi)); }
+void test_avl_count_range_float (TREE *tree, VECT *vect, float  lo, float  hi) { assert(avl_count_range_float (tree, lo, hi) == avm_count_range_float (vect, lo, hi)); }
+void test_avl_count_range_double(TREE *tree, VECT *vect, double lo, double hi) { assert(avl_count_range_double(tree, lo, hi) == avm_count_range_double(vect, lo, hi)); }
+
+void test_avl_select(TREE *tree, VECT *vect, long k) { assert(avl_select(tree, k) == avm_select(vect, k)); }
+
 void test_avl_first(TREE *tree, VECT *vect) { assert(avl_first(tree) == avm_first(vect)); }
 void test_avl_last (TREE *tree, VECT *vect) { assert(avl_last (tree) == avm_last (vect)); }
 void test_avl_next (TREE *tree, VECT *vect) { assert(avl_next (tree) == avm_next (vect)); }
@@ -467,6 +607,115 @@ void test_avl_rev_start_uchar (TREE *tree, VECT *vect, UCHAR  key) { assert(avl_
 void test_avl_rev_start_float (TREE *tree, VECT *vect, float  key) { assert(avl_rev_start_float (tree, key) == avm_rev_start_float (vect, key)); }
 void test_avl_rev_start_double(TREE *tree, VECT *vect, double key) { assert(avl_rev_start_double(tree, key) == avm_rev_start_double(vect, key)); }
 
+void test_avl_cursor_start       (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_start       (tree, cursor, key) == avm_start       (vect, key)); }
+void test_avl_cursor_start_mbr   (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_start_mbr   (tree, cursor, key) == avm_start_mbr   (vect, key)); }
+void test_avl_cursor_start_ptr   (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_start_ptr   (tree, cursor, key) == avm_start_ptr   (vect, key)); }
+void test_avl_cursor_start_chars (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_start_chars (tree, cursor, key) == avm_start_chars (vect, key)); }
+void test_avl_cursor_start_str   (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_start_str   (tree, cursor, key) == avm_start_str   (vect, key)); }
+void test_avl_cursor_start_long  (TREE *tree, VECT *vect, AVL_CURSOR *cursor, long   key) { assert(avl_cursor_start_long  (tree, cursor, key) == avm_start_long  (vect, key)); }
+void test_avl_cursor_start_int   (TREE *tree, VECT *vect, AVL_CURSOR *cursor, int    key) { assert(avl_cursor_start_int   (tree, cursor, key) == avm_start_int   (vect, key)); }
+void test_avl_cursor_start_short (TREE *tree, VECT *vect, AVL_CURSOR *cursor, short  key) { assert(avl_cursor_start_short (tree, cursor, key) == avm_start_short (vect, key)); }
+void test_avl_cursor_start_schar (TREE *tree, VECT *vect, AVL_CURSOR *cursor, SCHAR  key) { assert(avl_cursor_start_schar (tree, cursor, key) == avm_start_schar (vect, key)); }
+void test_avl_cursor_start_ulong (TREE *tree, VECT *vect, AVL_CURSOR *cursor, ULONG  key) { assert(avl_cursor_start_ulong (tree, cursor, key) == avm_start_ulong (vect, key)); }
+void test_avl_cursor_start_uint  (TREE *tree, VECT *vect, AVL_CURSOR *cursor, UINT   key) { assert(avl_cursor_start_uint  (tree, cursor, key) == avm_start_uint  (vect, key)); }
+void test_avl_cursor_start_ushort(TREE *tree, VECT *vect, AVL_CURSOR *cursor, USHORT key) { assert(avl_cursor_start_ushort(tree, cursor, key) == avm_start_ushort(vect, key)); }
+void test_avl_cursor_start_uchar (TREE *tree, VECT *vect, AVL_CURSOR *cursor, UCHAR  key) { assert(avl_cursor_start_uchar (tree, cursor, key) == avm_start_uchar (vect, key)); }
+void test_avl_cursor_start_float (TREE *tree, VECT *vect, AVL_CURSOR *cursor, float  key) { assert(avl_cursor_start_float (tree, cursor, key) == avm_start_float (vect, key)); }
+void test_avl_cursor_start_double(TREE *tree, VECT *vect, AVL_CURSOR *cursor, double key) { assert(avl_cursor_start_double(tree, cursor, key) == avm_start_double(vect, key)); }
+void test_avl_cursor_rev_start       (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_rev_start       (tree, cursor, key) == avm_rev_start       (vect, key)); }
+void test_avl_cursor_rev_start_mbr   (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_rev_start_mbr   (tree, cursor, key) == avm_rev_start_mbr   (vect, key)); }
+void test_avl_cursor_rev_start_ptr   (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_rev_start_ptr   (tree, cursor, key) == avm_rev_start_ptr   (vect, key)); }
+void test_avl_cursor_rev_start_chars (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_rev_start_chars (tree, cursor, key) == avm_rev_start_chars (vect, key)); }
+void test_avl_cursor_rev_start_str   (TREE *tree, VECT *vect, AVL_CURSOR *cursor, void  *key) { assert(avl_cursor_rev_start_str   (tree, cursor, key) == avm_rev_start_str   (vect, key)); }
+void test_avl_cursor_rev_start_long  (TREE *tree, VECT *vect, AVL_CURSOR *cursor, long   key) { assert(avl_cursor_rev_start_long  (tree, cursor, key) == avm_rev_start_long  (vect, key)); }
+void test_avl_cursor_rev_start_int   (TREE *tree, VECT *vect, AVL_CURSOR *cursor, int    key) { assert(avl_cursor_rev_start_int   (tree, cursor, key) == avm_rev_start_int   (vect, key)); }
+void test_avl_cursor_rev_start_short (TREE *tree, VECT *vect, AVL_CURSOR *cursor, short  key) { assert(avl_cursor_rev_start_short (tree, cursor, key) == avm_rev_start_short (vect, key)); }
+void test_avl_cursor_rev_start_schar (TREE *tree, VECT *vect, AVL_CURSOR *cursor, SCHAR  key) { assert(avl_cursor_rev_start_schar (tree, cursor, key) == avm_rev_start_schar (vect, key)); }
+void test_avl_cursor_rev_start_ulong (TREE *tree, VECT *vect, AVL_CURSOR *cursor, ULONG  key) { assert(avl_cursor_rev_start_ulong (tree, cursor, key) == avm_rev_start_ulong (vect, key)); }
+void test_avl_cursor_rev_start_uint  (TREE *tree, VECT *vect, AVL_CURSOR *cursor, UINT   key) { assert(avl_cursor_rev_start_uint  (tree, cursor, key) == avm_rev_start_uint  (vect, key)); }
+void test_avl_cursor_rev_start_ushort(TREE *tree, VECT *vect, AVL_CURSOR *cursor, USHORT key) { assert(avl_cursor_rev_start_ushort(tree, cursor, key) == avm_rev_start_ushort(vect, key)); }
+void test_avl_cursor_rev_start_uchar (TREE *tree, VECT *vect, AVL_CURSOR *cursor, UCHAR  key) { assert(avl_cursor_rev_start_uchar (tree, cursor, key) == avm_rev_start_uchar (vect, key)); }
+void test_avl_cursor_rev_start_float (TREE *tree, VECT *vect, AVL_CURSOR *cursor, float  key) { assert(avl_cursor_rev_start_float (tree, cursor, key) == avm_rev_start_float (vect, key)); }
+void test_avl_cursor_rev_start_double(TREE *tree, VECT *vect, AVL_CURSOR *cursor, double key) { assert(avl_cursor_rev_start_double(tree, cursor, key) == avm_rev_start_double(vect, key)); }
+
+void test_avl_cursor_next(VECT *vect, AVL_CURSOR *cursor) { assert(avl_cursor_next(cursor) == avm_next(vect)); }
+void test_avl_cursor_prev(VECT *vect, AVL_CURSOR *cursor) { assert(avl_cursor_prev(cursor) == avm_prev(vect)); }
+
+/* Locate the keys of the objects of obj_v with a cursor, mostly moving it by a few objects in their sorted order,
+ * sometimes jumping, and check the cursor by moving it further.
+ */
+#define TEST_AVL_LOCATE_NEAR(tree, vect, key_of_p, near_fun, avm_start_fun, obj_v, n) \
+   do { TREE  *sorted = avl_copy(tree); \
+        OBJ  **p_v    = malloc(MAX((n), 1) * sizeof(OBJ *)); \
+        OBJ   *p; \
+        AVL_CURSOR cursor; \
+        long   m = 0, j, k = 0; \
+        avl_empty(sorted); \
+        for (j = 0; j < (n); j++) avl_insert(sorted, &(obj_v)[j]); \
+        for (p = avl_first(sorted); p; p = avl_next(sorted)) p_v[m++] = p; \
+        avl_cursor_first((tree), &cursor); \
+        for (j = 0; j < 2 * m; j++) { \
+           k = j % 16 == 0 ? random_int(0, (int)m - 1) : k + random_int(-2, 4); \
+           k = MIN(MAX(k, 0), m - 1); \
+           p = p_v[k]; \
+           assert(near_fun((tree), &cursor, key_of_p) == avm_start_fun((vect), key_of_p)); \
+           if (j % 3 == 0) { \
+              test_avl_cursor_next((vect), &cursor); \
+              test_avl_cursor_prev((vect), &cursor); \
+           } \
+        } \
+        avl_free(sorted); \
+        free(p_v); } while (0)
+
+void test_avl_locate_near       (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p            , avl_locate_near       , avm_start       , obj_v, n); }
+void test_avl_locate_near_mbr   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->ch1       , avl_locate_near_mbr   , avm_start_mbr   , obj_v, n); }
+void test_avl_locate_near_ptr   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->str       , avl_locate_near_ptr   , avm_start_ptr   , obj_v, n); }
+void test_avl_locate_near_chars (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->ch0       , avl_locate_near_chars , avm_start_chars , obj_v, n); }
+void test_avl_locate_near_chars1(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->ch1       , avl_locate_near_chars , avm_start_chars , obj_v, n); }
+void test_avl_locate_near_str   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->str       , avl_locate_near_str   , avm_start_str   , obj_v, n); }
+void test_avl_locate_near_long  (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->l         , avl_locate_near_long  , avm_start_long  , obj_v, n); }
+void test_avl_locate_near_int   (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->i         , avl_locate_near_int   , avm_start_int   , obj_v, n); }
+void test_avl_locate_near_short (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->s         , avl_locate_near_short , avm_start_short , obj_v, n); }
+void test_avl_locate_near_schar (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->sc        , avl_locate_near_schar , avm_start_schar , obj_v, n); }
+void test_avl_locate_near_ulong (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->ul        , avl_locate_near_ulong , avm_start_ulong , obj_v, n); }
+void test_avl_locate_near_uint  (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->ui        , avl_locate_near_uint  , avm_start_uint  , obj_v, n); }
+void test_avl_locate_near_ushort(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->us        , avl_locate_near_ushort, avm_start_ushort, obj_v, n); }
+void test_avl_locate_near_uchar (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->uc        , avl_locate_near_uchar , avm_start_uchar , obj_v, n); }
+void test_avl_locate_near_float (TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->f         , avl_locate_near_float , avm_start_float , obj_v, n); }
+void test_avl_locate_near_double(TREE *tree, VECT *vect, OBJ *obj_v, int n) { TEST_AVL_LOCATE_NEAR(tree, vect, p->d         , avl_locate_near_double, avm_start_double, obj_v, n); }
+
+/*---------------------------------------------------------------------------*/
+
+void test_avl_cursor_walk(TREE *tree, VECT *vect)
+{
+   AVL_CURSOR cursor;
+   void *obj, *p;
+
+   obj = avm_first(vect);
+   p   = avl_first(tree);
+   assert(avl_cursor_first(tree, &cursor) == obj);
+   while (obj) {
+      assert(p == obj);
+      obj = avm_next(vect);
+      p   = avl_next(tree);
+      assert(avl_cursor_next(&cursor) == obj);
+   }
+   assert(p == NULL);
+   assert(avl_cursor_next(&cursor) == NULL);
+
+   obj = avm_last(vect);
+   p   = avl_last(tree);
+   assert(avl_cursor_last(tree, &cursor) == obj);
+   while (obj) {
+      assert(p == obj);
+      obj = avm_prev(vect);
+      p   = avl_prev(tree);
+      assert(avl_cursor_prev(&cursor) == obj);
+   }
+   assert(p == NULL);
+   assert(avl_cursor_prev(&cursor) == NULL);
+}
+
 /*---------------------------------------------------------------------------*/
 
 void test_avl_locate_first(TREE *tree, VECT *vect)
@@ -503,6 +752,1066 @@ void test_avl_rev_do_w_ctx(TREE *tree, VECT *vect, void (*callback)(), void *con
 
 /*---------------------------------------------------------------------------*/
 
+void test_avl_build_sorted(TREE *tree, VECT *vect)
+{
+   TREE  *built = avl_copy(tree);
+   void **data_v = malloc(MAX(avm_nodes(vect), 1) * sizeof(void *));
+   void  *obj;
+   long   n = 0;
+
+   avl_empty(built);
+   AVM_FOR(vect, obj) {
+      data_v[n++] = obj;
+   }
+   if (n >= 2 && !(avl_tree_type(tree) & AVL_DUP)) {
+      obj = data_v[0]; data_v[0] = data_v[n - 1]; data_v[n - 1] = obj;
+      assert( !avl_build_sorted(built, data_v, n));
+      assert(avl_nodes(built) == 0);
+      obj = data_v[0]; data_v[0] = data_v[n - 1]; data_v[n - 1] = obj;
+   }
+   assert(avl_build_sorted(built, data_v, n));
+   assert(avl_nodes(built) == n);
+   check_and_cmp(built, vect);
+   assert(avl_build_sorted(built, data_v, n) == (n == 0));
+   avl_free(built);
+   free(data_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Insert the objects of vect into an empty tree in two sorted batches, which interleave in nodup trees,
+ * while in dup trees the second one follows the first, so that equal keys keep their order.
+ */
+void test_avl_insert_sorted_batch(TREE *tree, VECT *vect)
+{
+   TREE  *built = avl_copy(tree);
+   long   n = avm_nodes(vect), n0, k = 0;
+   void **data_v = malloc(MAX(n, 1) * sizeof(void *));
+   void  *obj;
+   bool   dup = avl_tree_type(tree) & AVL_DUP;
+
+   avl_empty(built);
+   n0 = dup ? n / 2 : (n + 1) / 2;
+   AVM_FOR(vect, obj) {
+      data_v[dup ? k : k % 2 ? n0 + k / 2 : k / 2] = obj;
+      k++;
+   }
+   assert(avl_insert_sorted_batch(built, data_v, n0) == n0);
+   assert(avl_nodes(built) == n0);
+   assert(avl_insert_sorted_batch(built, data_v + n0, n - n0) == n - n0);
+   check_and_cmp(built, vect);
+   if ( !dup) {
+      assert(avl_insert_sorted_batch(built, data_v, n) == 0);
+      check_and_cmp(built, vect);
+   }
+   avl_free(built);
+   free(data_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Append the first half of the objects of vect to an empty tree, and insert the rest in order, which appends
+ * them too. In nodup trees, one object of the first half is inserted out of order before the rest.
+ */
+void test_avl_append(TREE *tree, VECT *vect)
+{
+   TREE  *built = avl_copy(tree);
+   long   n = avm_nodes(vect), i;
+   void **data_v = malloc(MAX(n, 1) * sizeof(void *));
+   void  *obj;
+   bool   skip = n >= 8 && !(avl_tree_type(tree) & AVL_DUP);
+
+   avl_empty(built);
+   i = 0;
+   AVM_FOR(vect, obj) {
+      data_v[i++] = obj;
+   }
+   for (i = 0; i < n / 2; i++) {
+      if (skip && i == n / 4) continue;
+      assert(avl_append(built, data_v[i]));
+   }
+   if (skip) {
+      assert( !avl_append(built, data_v[0]));
+      assert( !avl_append(built, data_v[n / 2 - 1]));
+      assert( !avl_append(built, data_v[n / 4]));
+      assert(avl_nodes(built) == n / 2 - 1);
+      assert(avl_insert(built, data_v[n / 4]));
+   }
+   for ( ; i < n; i++) {
+      assert(avl_insert(built, data_v[i]));
+   }
+   check_and_cmp(built, vect);
+   avl_free(built);
+   free(data_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Pop the objects of copies of tree and vect from random ends, reinserting one in five of them,
+ * which makes it the first or the last object again, unless its key is duplicated
+ */
+void test_avl_pop(TREE *tree, VECT *vect)
+{
+   TREE *copy = avl_copy(tree);
+   VECT *vect_copy = avm_copy(vect);
+   void *obj;
+   long  i = 0;
+
+   assert(copy && vect_copy);
+   do {
+      if (random_int(0, 1)) {
+         obj = avl_pop_first(copy);
+         assert(obj == avm_pop_first(vect_copy));
+      } else {
+         obj = avl_pop_last(copy);
+         assert(obj == avm_pop_last(vect_copy));
+      }
+      if (obj && i % 5 == 4) {
+         assert(avl_insert(copy, obj) && avm_insert(vect_copy, obj));
+      }
+      assert(avl_nodes(copy) == avm_nodes(vect_copy));
+      test_avl_locate_first(copy, vect_copy);
+      test_avl_locate_last (copy, vect_copy);
+      if (i++ % 64 == 0) {
+         check_and_cmp(copy, vect_copy);
+      }
+   } while (obj);
+   check_and_cmp(copy, vect_copy);
+   avl_free(copy);
+   avm_free(vect_copy);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Check the parts obtained by splitting tree and vect, as well as the parts obtained by splitting
+ * a copy of tree, which is freed before its part in order to check the sharing of node memory.
+ * Then join the parts back again.
+ */
+void check_split(TREE *tree, VECT *vect, TREE *tree_part, VECT *vect_part, TREE *copy, TREE *copy_part)
+{
+   assert(tree_part && vect_part && copy_part);
+   check_and_cmp(tree, vect);
+   check_and_cmp(tree_part, vect_part);
+   avl_free(copy);
+   check_and_cmp(copy_part, vect_part);
+   avl_free(copy_part);
+   if (avl_nodes(tree) && avl_nodes(tree_part)) {
+      assert( !avl_join(tree_part, tree));
+   }
+   assert(avl_join(tree, tree_part));
+   assert(avm_join(vect, vect_part));
+   assert(avl_nodes(tree_part) == 0);
+   avl_free(tree_part);
+   avm_free(vect_part);
+   check_and_cmp(tree, vect);
+}
+
+/* Join the parts of a split tree back together before anything counts their nodes.
+ */
+void rejoin(TREE *tree, TREE *tree_part)
+{
+   assert(tree_part);
+   avl_check_balance(tree);
+   avl_check_balance(tree_part);
+   assert(avl_join(tree, tree_part));
+   avl_free(tree_part);
+   avl_check_balance(tree);
+}
+
+#define TEST_AVL_SPLIT(tree, vect, split_fun, avm_split_fun, key) \
+   do { TREE *copy = avl_copy(tree), *rejoined = avl_copy(tree); \
+        rejoin(rejoined, split_fun(rejoined, key)); \
+        rejoin(rejoined, split_fun(rejoined, key)); \
+        check_and_cmp(rejoined, (vect)); \
+        avl_free(rejoined); \
+        check_split((tree), (vect), split_fun((tree), key), avm_split_fun((vect), key), copy, split_fun(copy, key)); } while (0)
+
+void test_avl_split       (TREE *tree, VECT *vect, void  *key) { TEST_AVL_SPLIT(tree, vect, avl_split       , avm_split       , key); }
+void test_avl_split_mbr   (TREE *tree, VECT *vect, void  *key) { TEST_AVL_SPLIT(tree, vect, avl_split_mbr   , avm_split_mbr   , key); }
+void test_avl_split_ptr   (TREE *tree, VECT *vect, void  *key) { TEST_AVL_SPLIT(tree, vect, avl_split_ptr   , avm_split_ptr   , key); }
+void test_avl_split_chars (TREE *tree, VECT *vect, char  *key) { TEST_AVL_SPLIT(tree, vect, avl_split_chars , avm_split_chars , key); }
+void test_avl_split_str   (TREE *tree, VECT *vect, char  *key) { TEST_AVL_SPLIT(tree, vect, avl_split_str   , avm_split_str   , key); }
+void test_avl_split_long  (TREE *tree, VECT *vect, long   key) { TEST_AVL_SPLIT(tree, vect, avl_split_long  , avm_split_long  , key); }
+void test_avl_split_int   (TREE *tree, VECT *vect, int    key) { TEST_AVL_SPLIT(tree, vect, avl_split_int   , avm_split_int   , key); }
+void test_avl_split_float (TREE *tree, VECT *vect, float  key) { TEST_AVL_SPLIT(tree, vect, avl_split_float , avm_split_float , key); }
+void test_avl_split_double(TREE *tree, VECT *vect, double key) { TEST_AVL_SPLIT(tree, vect, avl_split_double, avm_split_double, key); }
+
+/*---------------------------------------------------------------------------*/
+
+void test_avl_compact(TREE *tree, VECT *vect, int layout)
+{
+   assert( !avl_compact(tree, -1));
+   assert(avl_compact(tree, layout));
+   avl_check_compact(tree, layout);
+   check_and_cmp(tree, vect);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Trim the tree, then reinsert and remove again the object just removed from it,
+ * so that nodes are taken from the remaining blocks (or from a new one).
+ */
+void test_avl_trim(TREE *tree, VECT *vect, OBJ *obj)
+{
+   long blocks = avl_blocks(tree);
+
+   assert(avl_trim(tree) >= 0);
+   assert(avl_blocks(tree) <= blocks);
+   assert(avl_nodes(tree) > 0 || avl_blocks(tree) == 0);
+   check_and_cmp(tree, vect);
+   test_avl_insert(tree, vect, obj);
+   test_avl_remove(tree, vect, obj);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* An allocator that counts the blocks it has allocated and not yet released
+ */
+void *counting_allocate(void *context, size_t size) { ++*(long *)context; return malloc(size); }
+void  counting_release (void *context, void *ptr)   { --*(long *)context; free(ptr); }
+
+const AVL_ALLOCATOR counting_allocator = { counting_allocate, counting_release };
+
+/* An arena, which hands out memory from a single buffer and never releases it
+ */
+typedef struct arena {
+   char  *buf;
+   size_t used;
+   size_t size;
+} ARENA;
+
+void *arena_allocate(void *context, size_t size)
+{
+   ARENA *arena = context;
+   void  *ptr;
+
+   size = (size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+   if (size > arena->size - arena->used) return NULL;
+   ptr = arena->buf + arena->used;
+   arena->used += size;
+   return ptr;
+}
+
+const AVL_ALLOCATOR arena_allocator = { arena_allocate, NULL };
+
+/* Fill a tree allocated in an arena until the arena is exhausted, then copy and free it
+ */
+void test_avl_arena(OBJ *obj_v, int n)
+{
+   ARENA arena;
+   TREE *tree, *copy;
+   VECT *vect = avm_vect_dup_int(OBJ, i);
+   int   i;
+   AVL_ALLOCATOR no_allocator = { NULL, NULL };
+
+   arena.size = 4096;
+   arena.used = 0;
+   arena.buf  = malloc(arena.size);
+   assert( !avl_tree_with_allocator(AVL_INT, offsetof(OBJ, i), NULL, &no_allocator, &arena));
+   tree = avl_tree_with_allocator(AVL_INT|AVL_DUP, offsetof(OBJ, i), NULL, &arena_allocator, &arena);
+   assert(tree);
+   for (i = 0; i < n; i++) {
+      if ( !avl_insert(tree, &obj_v[i])) break;
+      avm_insert(vect, &obj_v[i]);
+   }
+   assert(i < n);
+   check_and_cmp(tree, vect);
+   assert( !avl_copy(tree));
+   avl_free(tree);
+
+   arena.used = 0;
+   tree = avl_tree_with_allocator(AVL_INT|AVL_DUP, offsetof(OBJ, i), NULL, &arena_allocator, &arena);
+   avm_empty(vect);
+   for (i = 0; i < 10 && i < n; i++) {
+      assert(avl_insert(tree, &obj_v[i]));
+      avm_insert(vect, &obj_v[i]);
+   }
+   copy = avl_copy(tree);
+   assert(copy);
+   check_and_cmp(copy, vect);
+   avl_free(copy);
+   avl_free(tree);
+   avm_free(vect);
+   free(arena.buf);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* An allocator that counts the bytes it has allocated and not yet released
+ */
+void *sizing_allocate(void *context, size_t size)
+{
+   size_t *p = malloc(sizeof(size_t) + size);
+
+   if ( !p) return NULL;
+   *p = size;
+   *(size_t *)context += size;
+   return p + 1;
+}
+
+void sizing_release(void *context, void *ptr)
+{
+   size_t *p = (size_t *)ptr - 1;
+
+   *(size_t *)context -= *p;
+   free(p);
+}
+
+const AVL_ALLOCATOR sizing_allocator = { sizing_allocate, sizing_release };
+
+/* Check that the result of a set operation doesn't keep a node block sized for a much larger result
+ */
+void test_avl_set_operation_size(int n)
+{
+   size_t allocated = 0, before;
+   TREE  *a = avl_tree_with_allocator(AVL_ULONG, offsetof(OBJ, ul), NULL, &sizing_allocator, &allocated);
+   TREE  *b = avl_tree_with_allocator(AVL_ULONG, offsetof(OBJ, ul), NULL, &sizing_allocator, &allocated);
+   TREE  *c;
+   OBJ   *obj_v = calloc(MAX(2 * n, 1), sizeof(OBJ));
+   int    i;
+
+   assert(a && b && obj_v);
+   for (i = 0; i < n; i++) {
+      obj_v[i].ul     = (ULONG)i;
+      obj_v[n + i].ul = (ULONG)(n - 1 + i);
+      assert(avl_insert(a, &obj_v[i]));
+      assert(avl_insert(b, &obj_v[n + i]));
+   }
+   before = allocated;
+   c = avl_intersection(a, b);
+   assert(c && avl_nodes(c) == (n > 0));
+   assert(allocated - before < 64 * sizeof(void *));
+   avl_free(c);
+   c = avl_difference(a, b);
+   assert(c && avl_nodes(c) == MAX(n - 1, 0));
+   if (n > 0) assert(avl_insert(c, &obj_v[n - 1]));
+   avl_free(c);
+   c = avl_union(a, b);
+   assert(c && avl_nodes(c) == MAX(2 * n - 1, 0));
+   avl_free(c);
+   assert(allocated == before);
+   avl_free(a);
+   avl_free(b);
+   assert(allocated == 0);
+   free(obj_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Append and insert ascending unsigned long keys (two per key), interleaved with removals of the greatest key
+ * and out-of-order reinsertions, which must all invalidate the cached right spine
+ */
+void test_avl_append_ulong(int treetype, int n)
+{
+   TREE *tree = avl_tree(AVL_ULONG|treetype, offsetof(OBJ, ul), NULL);
+   VECT *vect = (treetype & AVL_DUP) ? avm_vect_dup_ulong(OBJ, ul) : avm_vect_nodup_ulong(OBJ, ul);
+   OBJ  *obj_v = calloc(MAX(n, 1), sizeof(OBJ));
+   int   i;
+
+   assert(tree && vect && obj_v);
+   for (i = 0; i < n; i++) {
+      obj_v[i].ul = (ULONG)i / 2;
+      if (i % 3) {
+         test_avl_insert(tree, vect, &obj_v[i]);
+      } else {
+         assert(avl_append(tree, &obj_v[i]) == avm_insert(vect, &obj_v[i]));
+         check_and_cmp(tree, vect);
+      }
+      if (i % 7 == 6) {
+         test_avl_remove_ulong(tree, vect, obj_v[i].ul);
+      }
+      if (i % 11 == 10) {
+         test_avl_remove_ulong(tree, vect, obj_v[i / 2].ul);
+         test_avl_insert(tree, vect, &obj_v[i / 2]);
+         assert( !avl_append(tree, &obj_v[i / 4]));
+      }
+   }
+   avl_free(tree);
+   avm_free(vect);
+   free(obj_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void check_set_operation(TREE *tree, VECT *vect)
+{
+   assert(tree && vect);
+   check_and_cmp(tree, vect);
+   avl_free(tree);
+   avm_free(vect);
+}
+
+/* Check set operations between tree and a random subset of it, which is sparse more or less.
+ */
+void test_avl_set_operations(TREE *tree, VECT *vect)
+{
+   TREE  *part = avl_copy(tree);
+   VECT  *vect_part = avm_copy(vect);
+   void **data_v = malloc(MAX(avm_nodes(vect), 1) * sizeof(void *));
+   void  *obj;
+   long   n = 0, i;
+   int    one_in = random_int(1, 20);
+
+   AVM_FOR(vect, obj) {
+      if (random_int(0, one_in - 1) == 0) {
+         data_v[n++] = obj;
+      }
+   }
+   avl_empty(part);
+   avm_empty(vect_part);
+   assert(avl_build_sorted(part, data_v, n));
+   for (i = 0; i < n; i++) {
+      avm_insert(vect_part, data_v[i]);
+   }
+   check_and_cmp(part, vect_part);
+   check_set_operation(avl_union       (tree, part), avm_union       (vect, vect_part));
+   check_set_operation(avl_union       (part, tree), avm_union       (vect_part, vect));
+   check_set_operation(avl_union       (tree, tree), avm_union       (vect, vect));
+   check_set_operation(avl_intersection(tree, part), avm_intersection(vect, vect_part));
+   check_set_operation(avl_intersection(part, tree), avm_intersection(vect_part, vect));
+   check_set_operation(avl_difference  (tree, part), avm_difference  (vect, vect_part));
+   check_set_operation(avl_difference  (part, tree), avm_difference  (vect_part, vect));
+   avl_free(part);
+   avm_free(vect_part);
+   free(data_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* An allocator that fails while *(bool *)context is true
+ */
+void *failing_allocate(void *context, size_t size) { return *(bool *)context ? NULL : malloc(size); }
+void  failing_release (void *context, void *ptr)   { (void)context; free(ptr); }
+
+const AVL_ALLOCATOR failing_allocator = { failing_allocate, failing_release };
+
+/* Check that trees of up to AVL_SMALL_MAX items behave the same in their sorted array as in nodes,
+ * which they get when they grow larger or when a function which needs them is called
+ */
+void test_avl_small(OBJ *obj_v, int n)
+{
+   TREE *obj_tree = avl_tree_nodup      (obj_i_cmp);
+   TREE *ch0_tree = avl_tree_nodup_chars(OBJ, ch0);
+   TREE *str_tree = avl_tree_dup_str    (OBJ, str);
+   TREE *int_tree = avl_tree_dup_int    (OBJ, i);
+   VECT *obj_vect = avm_vect_nodup      (obj_i_cmp);
+   VECT *ch0_vect = avm_vect_nodup_chars(OBJ, ch0);
+   VECT *str_vect = avm_vect_dup_str    (OBJ, str);
+   VECT *int_vect = avm_vect_dup_int    (OBJ, i);
+   TREE *tree;
+   OBJ  *obj;
+   int   m = MIN(n, avl_small_max()), i;
+   bool  failing = false;
+   AVL_CURSOR cursor;
+
+   for (i = 0; i < m; i++) {
+      test_avl_insert(obj_tree, obj_vect, &obj_v[i]);
+      test_avl_insert(ch0_tree, ch0_vect, &obj_v[i]);
+      test_avl_insert(str_tree, str_vect, &obj_v[i]);
+      test_avl_insert(int_tree, int_vect, &obj_v[i]);
+      assert(avl_is_small(obj_tree) && avl_is_small(ch0_tree) && avl_is_small(str_tree) && avl_is_small(int_tree));
+   }
+   for (i = 0; i < n && i < 2 * m; i++) {
+      test_avl_locate      (obj_tree, obj_vect, &obj_v[i]);
+      test_avl_locate_chars(ch0_tree, ch0_vect, obj_v[i].ch0);
+      test_avl_locate_str  (str_tree, str_vect, obj_v[i].str);
+      test_avl_locate_int  (int_tree, int_vect, obj_v[i].i);
+   }
+   for (i = 0; i < n && i < 2 * m; i += 2) {
+      test_avl_remove    (obj_tree, obj_vect, &obj_v[i]);
+      test_avl_remove    (ch0_tree, ch0_vect, obj_v[i].ch0);
+      test_avl_remove_str(str_tree, str_vect, obj_v[i].str);
+      test_avl_remove_int(int_tree, int_vect, obj_v[i].i);
+   }
+   for (i = 0; i < m; i++) {
+      test_avl_insert(obj_tree, obj_vect, &obj_v[i]);
+      test_avl_insert(ch0_tree, ch0_vect, &obj_v[i]);
+   }
+   assert(avl_is_small(obj_tree) && avl_is_small(ch0_tree));
+   if (n > m) {
+      test_avl_insert(obj_tree, obj_vect, &obj_v[m]);
+      test_avl_insert(ch0_tree, ch0_vect, &obj_v[m]);
+      assert(avl_nodes(obj_tree) <= m || !avl_is_small(obj_tree));
+      assert(avl_nodes(ch0_tree) <= m || !avl_is_small(ch0_tree));
+   }
+   /* the reads are served by the sorted array, which they leave in place */
+   for (i = 0; i < n && i < 2 * m; i++) {
+      test_avl_locate_ge_str(str_tree, str_vect, obj_v[i].str);
+      test_avl_locate_gt_str(str_tree, str_vect, obj_v[i].str);
+      test_avl_locate_le_str(str_tree, str_vect, obj_v[i].str);
+      test_avl_locate_lt_str(str_tree, str_vect, obj_v[i].str);
+      test_avl_locate_ge_int(int_tree, int_vect, obj_v[i].i);
+      test_avl_locate_gt_int(int_tree, int_vect, obj_v[i].i);
+      test_avl_locate_le_int(int_tree, int_vect, obj_v[i].i);
+      test_avl_locate_lt_int(int_tree, int_vect, obj_v[i].i);
+      test_avl_start_str    (str_tree, str_vect, obj_v[i].str);
+      test_avl_next         (str_tree, str_vect);
+      test_avl_rev_start_int(int_tree, int_vect, obj_v[i].i);
+      test_avl_prev         (int_tree, int_vect);
+   }
+   test_avl_locate_near_str(str_tree, str_vect, obj_v, MIN(n, 2 * m));
+   test_avl_locate_near_int(int_tree, int_vect, obj_v, MIN(n, 2 * m));
+   assert(m == 0 || (avl_is_small(str_tree) && avl_is_small(int_tree)));
+   check_and_cmp(str_tree, str_vect);
+   avl_empty(int_tree);
+   avm_empty(int_vect);
+   for (i = 0; i < m; i++) {
+      obj = avm_last(int_vect);
+      if ( !obj || obj_v[i].i >= obj->i) {
+         assert(avl_append(int_tree, &obj_v[i]));
+         avm_insert(int_vect, &obj_v[i]);
+      } else {
+         assert( !avl_append(int_tree, &obj_v[i]));
+      }
+      assert(avl_is_small(int_tree));
+   }
+   check_and_cmp(int_tree, int_vect);
+   avl_free(obj_tree);
+   avl_free(ch0_tree);
+   avl_free(str_tree);
+   avl_free(int_tree);
+   avm_free(obj_vect);
+   avm_free(ch0_vect);
+   avm_free(str_vect);
+   avm_free(int_vect);
+
+   tree = avl_tree(AVL_INT|AVL_DUP|AVL_NOSMALL, offsetof(OBJ, i), NULL);
+   assert(m == 0 || (avl_insert(tree, &obj_v[0]) && !avl_is_small(tree)));
+   avl_free(tree);
+
+   /* the array is allocated once: without memory, reads and insertions into it still work,
+    * also after the tree has been emptied, while an insertion which needs the nodes fails and leaves it as it was
+    */
+   tree = avl_tree_with_allocator(AVL_INT|AVL_DUP, offsetof(OBJ, i), NULL, &failing_allocator, &failing);
+   for (i = 0; i < m; i++) {
+      assert(avl_insert(tree, &obj_v[i]));
+   }
+   if (m > 0) {
+      failing = true;
+      assert(avl_cursor_first(tree, &cursor) == avl_locate_first(tree) && avl_is_small(tree) && avl_nodes(tree) == m);
+      for (i = 0; i < m; i++) {
+         assert(avl_remove_int(tree, obj_v[i].i));
+      }
+      assert(avl_nodes(tree) == 0 && avl_is_small(tree));
+      for (i = 0; i < m; i++) {
+         assert(avl_insert(tree, &obj_v[i]));
+      }
+      assert(m < avl_small_max() || !avl_insert(tree, &obj_v[0]));
+      assert(avl_locate_int(tree, obj_v[0].i) && avl_is_small(tree) && avl_nodes(tree) == m);
+      failing = false;
+      assert(m < avl_small_max() || (avl_insert(tree, &obj_v[0]) && !avl_is_small(tree)));
+      avl_check_balance(tree);
+   }
+   avl_free(tree);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Check that avl_append() appends without the memory for a spine, by a descent from the root,
+ * and still refuses the keys that are not greater than the greatest one
+ */
+void test_avl_append_failing(int n)
+{
+   bool  failing = false;
+   TREE *obj_tree = avl_tree_with_allocator(AVL_USR|AVL_NOSMALL, 0,                obj_i_cmp, &failing_allocator, &failing);
+   TREE *int_tree = avl_tree_with_allocator(AVL_INT|AVL_NOSMALL, offsetof(OBJ, i), NULL,      &failing_allocator, &failing);
+   VECT *obj_vect = avm_vect_nodup    (obj_i_cmp);
+   VECT *int_vect = avm_vect_nodup_int(OBJ, i);
+   OBJ  *obj_v = calloc(MAX(2 * n, 1), sizeof(OBJ));
+   int   i;
+
+   assert(obj_tree && int_tree && obj_vect && int_vect && obj_v);
+   assert(avl_reserve(obj_tree, 2 * n) && avl_reserve(int_tree, 2 * n));
+   for (i = 0; i < n; i++) {
+      obj_v[i].i = n - 1 - i;
+      test_avl_insert(obj_tree, obj_vect, &obj_v[i]);
+      test_avl_insert(int_tree, int_vect, &obj_v[i]);
+   }
+   failing = true;
+   for (i = n; i < 2 * n; i++) {
+      obj_v[i].i = i;
+      assert(avl_append(obj_tree, &obj_v[i]) && avm_insert(obj_vect, &obj_v[i]));
+      assert(avl_append(int_tree, &obj_v[i]) && avm_insert(int_vect, &obj_v[i]));
+      assert( !avl_append(obj_tree, &obj_v[i]) && !avl_append(obj_tree, &obj_v[i - n]));
+      assert( !avl_append(int_tree, &obj_v[i]) && !avl_append(int_tree, &obj_v[i - n]));
+   }
+   failing = false;
+   check_and_cmp(obj_tree, obj_vect);
+   check_and_cmp(int_tree, int_vect);
+   avl_free(obj_tree);
+   avl_free(int_tree);
+   avm_free(obj_vect);
+   avm_free(int_vect);
+   free(obj_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Index the same objects by several trees created in a pool, and check that the nodes given back
+ * by one tree are taken by another one with nodes of the same size
+ */
+void test_avl_pool(OBJ *obj_v, int n)
+{
+   AVL_POOL *pool = avl_pool();
+   TREE *int_tree = avl_tree_in_pool(pool, AVL_INT|AVL_DUP,          offsetof(OBJ, i),   NULL);
+   TREE *obj_tree = avl_tree_in_pool(pool, AVL_USR|AVL_DUP|AVL_RANK, 0,                  obj_i_cmp);
+   TREE *str_tree = avl_tree_in_pool(pool, AVL_STR|AVL_DUP|AVL_RANK, offsetof(OBJ, str), NULL);
+   TREE *ch0_tree = avl_tree_in_pool(pool, AVL_CHARS,                offsetof(OBJ, ch0), NULL);
+   VECT *int_vect = avm_vect_dup_int  (OBJ, i);
+   VECT *obj_vect = avm_vect_dup      (obj_i_cmp);
+   VECT *str_vect = avm_vect_dup_str  (OBJ, str);
+   VECT *ch0_vect = avm_vect_nodup_chars(OBJ, ch0);
+   long  chunks;
+   int   i;
+
+   assert(pool && int_tree && obj_tree && str_tree && ch0_tree);
+   assert( !avl_tree_in_pool(pool, AVL_LONG|AVL_SET, sizeof(int), NULL));
+   for (i = 0; i < n; i++) {
+      assert(avl_insert(int_tree, &obj_v[i]) == avm_insert(int_vect, &obj_v[i]));
+      assert(avl_insert(str_tree, &obj_v[i]) == avm_insert(str_vect, &obj_v[i]));
+      assert(avl_insert(ch0_tree, &obj_v[i]) == avm_insert(ch0_vect, &obj_v[i]));
+   }
+   for (i = 0; i < n; i += 2) {
+      test_avl_remove_int  (int_tree, int_vect, obj_v[i].i);
+      test_avl_remove_str  (str_tree, str_vect, obj_v[i].str);
+      test_avl_remove_chars(ch0_tree, ch0_vect, obj_v[i].ch0);
+   }
+   test_avl_split_str(str_tree, str_vect, obj_v[n / 2].str);
+   test_avl_set_operations(ch0_tree, ch0_vect);
+   test_avl_compact(str_tree, str_vect, AVL_VEB);
+   test_avl_trim(ch0_tree, ch0_vect, &obj_v[1]);
+   check_and_cmp(int_tree, int_vect);
+
+   /* the nodes of int_tree and obj_tree (a rank tree with pointer keys) have the same size */
+   avl_empty(int_tree);
+   avm_empty(int_vect);
+   chunks = avl_pool_chunks(pool);
+   for (i = 0; i < n / 2; i++) {
+      assert(avl_insert(obj_tree, &obj_v[i]) == avm_insert(obj_vect, &obj_v[i]));
+   }
+   assert(avl_pool_chunks(pool) == chunks);
+   check_and_cmp(obj_tree, obj_vect);
+   avl_free(obj_tree);
+   assert(avl_pool_chunks(pool) == chunks - 1);
+   check_and_cmp(str_tree, str_vect);
+   avl_pool_free(pool);
+
+   avm_free(int_vect);
+   avm_free(obj_vect);
+   avm_free(str_vect);
+   avm_free(ch0_vect);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Check that the parts split off a pool tree without ranks, which hold nodes they have neither allocated
+ * nor counted, give their nodes back to the pool when emptied, as does a pool tree that was empty when joined
+ */
+void test_avl_pool_split(int n)
+{
+   AVL_POOL *pool = avl_pool();
+   TREE *tree  = avl_tree_in_pool(pool, AVL_ULONG, offsetof(OBJ, ul), NULL);
+   TREE *empty = avl_tree_in_pool(pool, AVL_ULONG, offsetof(OBJ, ul), NULL);
+   TREE *part, *part2;
+   OBJ  *obj_v = calloc(MAX(n, 1), sizeof(OBJ));
+   long  chunks;
+   int   i;
+
+   assert(pool && tree && empty && obj_v);
+   for (i = 0; i < n; i++) {
+      obj_v[i].ul = (ULONG)i;
+      assert(avl_insert(tree, &obj_v[i]));
+   }
+   part  = avl_split_ulong(tree, (ULONG)(n / 2));
+   part2 = avl_split_ulong(part, (ULONG)(n / 2 + n / 4));
+   assert(part && part2);
+   chunks = avl_pool_chunks(pool);
+   avl_empty(part2);
+   assert(avl_nodes(part2) == 0);
+   assert( !avl_locate_first(part2));
+   assert( !avl_locate_ulong(part2, (ULONG)(n - 1)));
+   for (i = n / 2 + n / 4; i < n; i++) {
+      assert(avl_insert(part2, &obj_v[i]));
+   }
+   assert(avl_pool_chunks(pool) == chunks);
+   assert(avl_join(empty, part));
+   avl_empty(empty);
+   assert( !avl_locate_first(empty));
+   assert( !avl_locate_ulong(empty, (ULONG)(n / 2)));
+   for (i = n / 2; i < n / 2 + n / 4; i++) {
+      assert(avl_insert(empty, &obj_v[i]));
+   }
+   assert(avl_pool_chunks(pool) == chunks);
+   assert(avl_nodes(tree) + avl_nodes(empty) + avl_nodes(part2) == n);
+   avl_free(part);
+   avl_free(part2);
+   avl_free(empty);
+   avl_free(tree);
+   avl_pool_free(pool);
+   free(obj_v);
+}
+
+/*---------------------------------------------------------------------------*/
+
+AVL_DEFINE_TREE(def_int, OBJ, i,   int,    AVL_CMP, AVL_NODUP)
+AVL_DEFINE_TREE(def_str, OBJ, str, char *, strcmp,  AVL_DUP)
+
+void test_def_int_insert(TREE *tree, VECT *vect, OBJ *obj) { assert(def_int_insert(tree, obj) == avm_insert    (vect, obj)); check_and_cmp(tree, vect); }
+void test_def_str_insert(TREE *tree, VECT *vect, OBJ *obj) { assert(def_str_insert(tree, obj) == avm_insert    (vect, obj)); check_and_cmp(tree, vect); }
+void test_def_int_remove(TREE *tree, VECT *vect, int   key) { assert(def_int_remove(tree, key) == avm_remove_int(vect, key)); check_and_cmp(tree, vect); }
+void test_def_str_remove(TREE *tree, VECT *vect, char *key) { assert(def_str_remove(tree, key) == avm_remove_str(vect, key)); check_and_cmp(tree, vect); }
+
+void test_def_int_locate(TREE *tree, VECT *vect, int key)
+{
+   AVL_CURSOR cursor;
+
+   assert(def_int_locate   (tree, key) == avm_locate_int   (vect, key));
+   assert(def_int_locate_ge(tree, key) == avm_locate_ge_int(vect, key));
+   assert(def_int_locate_gt(tree, key) == avm_locate_gt_int(vect, key));
+   assert(def_int_locate_le(tree, key) == avm_locate_le_int(vect, key));
+   assert(def_int_locate_lt(tree, key) == avm_locate_lt_int(vect, key));
+   assert(def_int_cursor_start    (tree, &cursor, key) == avm_start_int    (vect, key));
+   assert(def_int_cursor_next(&cursor) == avm_next(vect));
+   assert(def_int_cursor_rev_start(tree, &cursor, key) == avm_rev_start_int(vect, key));
+   assert(def_int_cursor_prev(&cursor) == avm_prev(vect));
+}
+
+void test_def_str_locate(TREE *tree, VECT *vect, char *key)
+{
+   AVL_CURSOR cursor;
+
+   assert(def_str_locate   (tree, key) == avm_locate_str   (vect, key));
+   assert(def_str_locate_ge(tree, key) == avm_locate_ge_str(vect, key));
+   assert(def_str_locate_gt(tree, key) == avm_locate_gt_str(vect, key));
+   assert(def_str_locate_le(tree, key) == avm_locate_le_str(vect, key));
+   assert(def_str_locate_lt(tree, key) == avm_locate_lt_str(vect, key));
+   assert(def_str_cursor_start    (tree, &cursor, key) == avm_start_str    (vect, key));
+   assert(def_str_cursor_next(&cursor) == avm_next(vect));
+   assert(def_str_cursor_rev_start(tree, &cursor, key) == avm_rev_start_str(vect, key));
+   assert(def_str_cursor_prev(&cursor) == avm_prev(vect));
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -*/
+
+void check_next_in_range(OBJ *obj, void *context)
+{
+   CMP *cmp = context;
+   assert(obj == cmp->obj);
+   cmp->obj = avm_next(cmp->vect);
+}
+
+void test_def_int_do_range(TREE *tree, VECT *vect, int lo, int hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_int(vect, lo);
+   def_int_do_range(tree, lo, hi, check_next_in_range, &cmp);
+   assert( !cmp.obj || cmp.obj->i > hi);
+}
+
+void test_def_str_do_range(TREE *tree, VECT *vect, char *lo, char *hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_str(vect, lo);
+   def_str_do_range(tree, lo, hi, check_next_in_range, &cmp);
+   assert( !cmp.obj || strcmp(cmp.obj->str, hi) > 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+AVL_DEFINE_INDEX_TREE(idx_int, OBJ, i,   int,    AVL_CMP, AVL_DUP)
+AVL_DEFINE_INDEX_TREE(idx_str, OBJ, str, char *, strcmp,  AVL_NODUP)
+AVL_DEFINE_INDEX_LONG_TREE(idx_lng, OBJ, i, int, AVL_NODUP)
+
+void check_index_and_cmp(AVL_INDEX_TREE *tree, VECT *vect)
+{
+   CMP cmp;
+
+   assert(avl_index_nodes(tree) == avm_nodes(vect));
+   cmp.vect = vect;
+   cmp.obj  = avm_first(vect);
+   avl_index_do_w_ctx(tree, check_next_in_range, &cmp);
+   assert(cmp.obj == NULL);
+   avl_index_check_balance(tree);
+}
+
+void test_idx_int_insert(AVL_INDEX_TREE *tree, VECT *vect, OBJ *obj) { assert(idx_int_insert(tree, obj) == avm_insert    (vect, obj)); check_index_and_cmp(tree, vect); }
+void test_idx_str_insert(AVL_INDEX_TREE *tree, VECT *vect, OBJ *obj) { assert(idx_str_insert(tree, obj) == avm_insert    (vect, obj)); check_index_and_cmp(tree, vect); }
+void test_idx_lng_insert(AVL_INDEX_TREE *tree, VECT *vect, OBJ *obj) { assert(idx_lng_insert(tree, obj) == avm_insert    (vect, obj)); check_index_and_cmp(tree, vect); }
+void test_idx_int_remove(AVL_INDEX_TREE *tree, VECT *vect, int   key) { assert(idx_int_remove(tree, key) == avm_remove_int(vect, key)); check_index_and_cmp(tree, vect); }
+void test_idx_str_remove(AVL_INDEX_TREE *tree, VECT *vect, char *key) { assert(idx_str_remove(tree, key) == avm_remove_str(vect, key)); check_index_and_cmp(tree, vect); }
+void test_idx_lng_remove(AVL_INDEX_TREE *tree, VECT *vect, int   key) { assert(idx_lng_remove(tree, key) == avm_remove_int(vect, key)); check_index_and_cmp(tree, vect); }
+
+void test_idx_int_locate(AVL_INDEX_TREE *tree, VECT *vect, int key)
+{
+   assert(idx_int_locate   (tree, key) == avm_locate_int   (vect, key));
+   assert(idx_int_locate_ge(tree, key) == avm_locate_ge_int(vect, key));
+   assert(idx_int_locate_gt(tree, key) == avm_locate_gt_int(vect, key));
+   assert(idx_int_locate_le(tree, key) == avm_locate_le_int(vect, key));
+   assert(idx_int_locate_lt(tree, key) == avm_locate_lt_int(vect, key));
+}
+
+void test_idx_str_locate(AVL_INDEX_TREE *tree, VECT *vect, char *key)
+{
+   assert(idx_str_locate   (tree, key) == avm_locate_str   (vect, key));
+   assert(idx_str_locate_ge(tree, key) == avm_locate_ge_str(vect, key));
+   assert(idx_str_locate_gt(tree, key) == avm_locate_gt_str(vect, key));
+   assert(idx_str_locate_le(tree, key) == avm_locate_le_str(vect, key));
+   assert(idx_str_locate_lt(tree, key) == avm_locate_lt_str(vect, key));
+}
+
+void test_idx_lng_locate(AVL_INDEX_TREE *tree, VECT *vect, int key)
+{
+   assert(idx_lng_locate   (tree, key) == avm_locate_int   (vect, key));
+   assert(idx_lng_locate_ge(tree, key) == avm_locate_ge_int(vect, key));
+   assert(idx_lng_locate_gt(tree, key) == avm_locate_gt_int(vect, key));
+   assert(idx_lng_locate_le(tree, key) == avm_locate_le_int(vect, key));
+   assert(idx_lng_locate_lt(tree, key) == avm_locate_lt_int(vect, key));
+}
+
+void test_idx_int_do_range(AVL_INDEX_TREE *tree, VECT *vect, int lo, int hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_int(vect, lo);
+   idx_int_do_range(tree, lo, hi, check_next_in_range, &cmp);
+   assert( !cmp.obj || cmp.obj->i > hi);
+}
+
+void test_idx_str_do_range(AVL_INDEX_TREE *tree, VECT *vect, char *lo, char *hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_str(vect, lo);
+   idx_str_do_range(tree, lo, hi, check_next_in_range, &cmp);
+   assert( !cmp.obj || strcmp(cmp.obj->str, hi) > 0);
+}
+
+void test_idx_lng_do_range(AVL_INDEX_TREE *tree, VECT *vect, int lo, int hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_int(vect, lo);
+   idx_lng_do_range(tree, lo, hi, check_next_in_range, &cmp);
+   assert( !cmp.obj || cmp.obj->i > hi);
+}
+
+/*---------------------------------------------------------------------------*/
+
+AVL_DEFINE_INTRUSIVE_TREE(itr_int, OBJ, i_links,   i,   int,    AVL_CMP, AVL_NODUP)
+AVL_DEFINE_INTRUSIVE_TREE(itr_str, OBJ, str_links, str, char *, strcmp,  AVL_DUP)
+
+void check_intrusive_and_cmp(AVL_INTRUSIVE_TREE *tree, VECT *vect)
+{
+   CMP cmp;
+
+   assert(avl_intrusive_nodes(tree) == avm_nodes(vect));
+   cmp.vect = vect;
+   cmp.obj  = avm_first(vect);
+   avl_intrusive_do_w_ctx(tree, check_next_in_range, &cmp);
+   assert(cmp.obj == NULL);
+   avl_intrusive_check_balance(tree);
+}
+
+void test_itr_int_insert(AVL_INTRUSIVE_TREE *tree, VECT *vect, OBJ *obj) { assert(itr_int_insert(tree, obj) == avm_insert    (vect, obj)); check_intrusive_and_cmp(tree, vect); }
+void test_itr_str_insert(AVL_INTRUSIVE_TREE *tree, VECT *vect, OBJ *obj) { assert(itr_str_insert(tree, obj) == avm_insert    (vect, obj)); check_intrusive_and_cmp(tree, vect); }
+void test_itr_int_remove(AVL_INTRUSIVE_TREE *tree, VECT *vect, int   key) { assert(itr_int_remove(tree, key) == avm_remove_int(vect, key)); check_intrusive_and_cmp(tree, vect); }
+void test_itr_str_remove(AVL_INTRUSIVE_TREE *tree, VECT *vect, char *key) { assert(itr_str_remove(tree, key) == avm_remove_str(vect, key)); check_intrusive_and_cmp(tree, vect); }
+
+void test_itr_int_locate(AVL_INTRUSIVE_TREE *tree, VECT *vect, int key)
+{
+   assert(itr_int_locate   (tree, key) == avm_locate_int   (vect, key));
+   assert(itr_int_locate_ge(tree, key) == avm_locate_ge_int(vect, key));
+   assert(itr_int_locate_gt(tree, key) == avm_locate_gt_int(vect, key));
+   assert(itr_int_locate_le(tree, key) == avm_locate_le_int(vect, key));
+   assert(itr_int_locate_lt(tree, key) == avm_locate_lt_int(vect, key));
+}
+
+void test_itr_str_locate(AVL_INTRUSIVE_TREE *tree, VECT *vect, char *key)
+{
+   assert(itr_str_locate   (tree, key) == avm_locate_str   (vect, key));
+   assert(itr_str_locate_ge(tree, key) == avm_locate_ge_str(vect, key));
+   assert(itr_str_locate_gt(tree, key) == avm_locate_gt_str(vect, key));
+   assert(itr_str_locate_le(tree, key) == avm_locate_le_str(vect, key));
+   assert(itr_str_locate_lt(tree, key) == avm_locate_lt_str(vect, key));
+}
+
+void test_itr_int_do_range(AVL_INTRUSIVE_TREE *tree, VECT *vect, int lo, int hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_int(vect, lo);
+   itr_int_do_range(tree, lo, hi, check_next_in_range, &cmp);
+   assert( !cmp.obj || cmp.obj->i > hi);
+}
+
+void test_itr_str_do_range(AVL_INTRUSIVE_TREE *tree, VECT *vect, char *lo, char *hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_str(vect, lo);
+   itr_str_do_range(tree, lo, hi, check_next_in_range, &cmp);
+   assert( !cmp.obj || strcmp(cmp.obj->str, hi) > 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void check_next_long_in_range  (long   key, void *context) { CMP *cmp = context; assert(cmp->obj && key == cmp->obj->l ); cmp->obj = avm_next(cmp->vect); }
+void check_next_ulong_in_range (ULONG  key, void *context) { CMP *cmp = context; assert(cmp->obj && key == cmp->obj->ul); cmp->obj = avm_next(cmp->vect); }
+void check_next_double_in_range(double key, void *context) { CMP *cmp = context; assert(cmp->obj && key == cmp->obj->d ); cmp->obj = avm_next(cmp->vect); }
+
+void test_set_long_do_range(TREE *tree, VECT *vect, long lo, long hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_long(vect, lo);
+   avl_set_do_range_long(tree, lo, hi, check_next_long_in_range, &cmp);
+   assert( !cmp.obj || cmp.obj->l > hi);
+}
+
+void test_set_ulong_do_range(TREE *tree, VECT *vect, ULONG lo, ULONG hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_ulong(vect, lo);
+   avl_set_do_range_ulong(tree, lo, hi, check_next_ulong_in_range, &cmp);
+   assert( !cmp.obj || cmp.obj->ul > hi);
+}
+
+void test_set_double_do_range(TREE *tree, VECT *vect, double lo, double hi)
+{
+   CMP cmp;
+   cmp.vect = vect;
+   cmp.obj  = avm_start_double(vect, lo);
+   avl_set_do_range_double(tree, lo, hi, check_next_double_in_range, &cmp);
+   assert( !cmp.obj || cmp.obj->d > hi);
+}
+
+void no_data(void *data) { (void)data; assert(false); }
+
+/* The functions returning, removing or passing data find none in a set tree, whose nodes have no data pointers
+ */
+void check_set_no_data(TREE *tree, VECT *vect)
+{
+   OBJ       *obj = avm_first(vect);
+   AVL_CURSOR cursor;
+   void      *result;
+
+   if ( !obj) return;
+   switch (avl_tree_type(tree) & ~(AVL_DUP | AVL_RANK | AVL_SET)) {
+   case AVL_LONG:
+      assert( !avl_locate_long(tree, obj->l) && !avl_locate_ge_long(tree, obj->l) && !avl_locate_lt_long(tree, obj->l + 1));
+      assert( !avl_remove_long(tree, obj->l) && !avl_cursor_start_long(tree, &cursor, obj->l));
+      assert( !avl_locate_many_long(tree, &obj->l, 1, &result) && !result);
+      break;
+   case AVL_ULONG:
+      assert( !avl_locate_ulong(tree, obj->ul) && !avl_locate_gt_ulong(tree, 0) && !avl_locate_le_ulong(tree, obj->ul));
+      assert( !avl_remove_ulong(tree, obj->ul) && !avl_cursor_start_ulong(tree, &cursor, obj->ul));
+      assert( !avl_locate_sorted_batch_long(tree, (long *)&obj->ul, 1, &result) && !result);
+      break;
+   case AVL_DOUBLE:
+      assert( !avl_locate_double(tree, obj->d) && !avl_locate_ge_double(tree, obj->d) && !avl_locate_le_double(tree, obj->d));
+      assert( !avl_remove_double(tree, obj->d) && !avl_cursor_start_double(tree, &cursor, obj->d));
+      assert( !avl_locate_many_double(tree, &obj->d, 1, &result) && !result);
+      break;
+   }
+   assert( !avl_cursor_next(&cursor));
+   assert( !avl_locate_first(tree) && !avl_locate_last(tree) && !avl_first(tree) && !avl_next(tree));
+   assert( !avl_cursor_first(tree, &cursor) && !avl_cursor_next(&cursor));
+   avl_do(tree, no_data);
+}
+
+void check_set_and_cmp(TREE *tree, VECT *vect)
+{
+   check_set_no_data(tree, vect);
+   assert(avl_nodes(tree) == avm_nodes(vect));
+   switch (avl_tree_type(tree) & ~(AVL_DUP | AVL_RANK | AVL_SET)) {
+   case AVL_LONG  : test_set_long_do_range  (tree, vect, LONG_MIN, LONG_MAX); break;
+   case AVL_ULONG : test_set_ulong_do_range (tree, vect, 0, ULONG_MAX);      break;
+   case AVL_DOUBLE: test_set_double_do_range(tree, vect, -DBL_MAX, DBL_MAX); break;
+   }
+   avl_check_balance(tree);
+}
+
+void test_set_long_insert  (TREE *tree, VECT *vect, OBJ *obj) { assert(avl_set_insert_long  (tree, obj->l ) == avm_insert(vect, obj)); check_set_and_cmp(tree, vect); }
+void test_set_ulong_insert (TREE *tree, VECT *vect, OBJ *obj) { assert(avl_set_insert_ulong (tree, obj->ul) == avm_insert(vect, obj)); check_set_and_cmp(tree, vect); }
+void test_set_double_insert(TREE *tree, VECT *vect, OBJ *obj) { assert(avl_set_insert_double(tree, obj->d ) == avm_insert(vect, obj)); check_set_and_cmp(tree, vect); }
+
+void test_set_long_remove  (TREE *tree, VECT *vect, long   key) { assert(avl_set_remove_long  (tree, key) == (avm_remove_long  (vect, key) != NULL)); check_set_and_cmp(tree, vect); }
+void test_set_ulong_remove (TREE *tree, VECT *vect, ULONG  key) { assert(avl_set_remove_ulong (tree, key) == (avm_remove_ulong (vect, key) != NULL)); check_set_and_cmp(tree, vect); }
+void test_set_double_remove(TREE *tree, VECT *vect, double key) { assert(avl_set_remove_double(tree, key) == (avm_remove_double(vect, key) != NULL)); check_set_and_cmp(tree, vect); }
+
+void test_set_long_contains  (TREE *tree, VECT *vect, long   key) { assert(avl_set_contains_long  (tree, key) == (avm_locate_long  (vect, key) != NULL)); }
+void test_set_ulong_contains (TREE *tree, VECT *vect, ULONG  key) { assert(avl_set_contains_ulong (tree, key) == (avm_locate_ulong (vect, key) != NULL)); }
+void test_set_double_contains(TREE *tree, VECT *vect, double key) { assert(avl_set_contains_double(tree, key) == (avm_locate_double(vect, key) != NULL)); }
+
+/*---------------------------------------------------------------------------*/
+
+/* the map trees map .l to .i and .ul to .ch0 */
+void check_map_long_and_cmp(TREE *tree, VECT *vect)
+{
+   OBJ *obj;
+   int  i;
+
+   check_set_and_cmp(tree, vect);
+   for (obj = avm_first(vect); obj; obj = avm_next(vect)) {
+      assert(*(int *)avl_map_ptr_long(tree, obj->l) == obj->i);
+      assert(avl_map_get_long(tree, obj->l, &i) && i == obj->i);
+   }
+}
+
+void check_map_ulong_and_cmp(TREE *tree, VECT *vect)
+{
+   OBJ *obj;
+   char ch0[CHA_SIZE];
+
+   check_set_and_cmp(tree, vect);
+   for (obj = avm_first(vect); obj; obj = avm_next(vect)) {
+      assert(memcmp(avl_map_ptr_ulong(tree, obj->ul), obj->ch0, CHA_SIZE) == 0);
+      assert(avl_map_get_ulong(tree, obj->ul, ch0) && memcmp(ch0, obj->ch0, CHA_SIZE) == 0);
+   }
+}
+
+void test_map_long_put(TREE *tree, VECT *vect, OBJ *obj)
+{
+   avm_remove_long(vect, obj->l);
+   avm_insert(vect, obj);
+   assert(avl_map_put_long(tree, obj->l, &obj->i));
+   check_map_long_and_cmp(tree, vect);
+}
+
+void test_map_ulong_put(TREE *tree, VECT *vect, OBJ *obj)
+{
+   avm_remove_ulong(vect, obj->ul);
+   avm_insert(vect, obj);
+   assert(avl_map_put_ulong(tree, obj->ul, obj->ch0));
+   check_map_ulong_and_cmp(tree, vect);
+}
+
+void test_map_long_get(TREE *tree, VECT *vect, long key)
+{
+   OBJ *obj = avm_locate_long(vect, key);
+   int  i;
+
+   assert((avl_map_ptr_long(tree, key) != NULL) == (obj != NULL));
+   assert(avl_map_get_long(tree, key, &i) == (obj != NULL));
+}
+
+void test_map_ulong_get(TREE *tree, VECT *vect, ULONG key)
+{
+   OBJ *obj = avm_locate_ulong(vect, key);
+   char ch0[CHA_SIZE];
+
+   assert((avl_map_ptr_ulong(tree, key) != NULL) == (obj != NULL));
+   assert(avl_map_get_ulong(tree, key, ch0) == (obj != NULL));
+}
+
+void test_map_long_remove (TREE *tree, VECT *vect, long  key) { assert(avl_set_remove_long (tree, key) == (avm_remove_long (vect, key) != NULL)); check_map_long_and_cmp (tree, vect); }
+void test_map_ulong_remove(TREE *tree, VECT *vect, ULONG key) { assert(avl_set_remove_ulong(tree, key) == (avm_remove_ulong(vect, key) != NULL)); check_map_ulong_and_cmp(tree, vect); }
+
+/*---------------------------------------------------------------------------*/
+
 void test_avl_empty(TREE *tree, VECT *vect)
 {
    avl_empty(tree);
@@ -519,6 +1828,8 @@ int main(int argc, char *argv[])
    OBJ *obj_v = calloc(MAX(N_OBJ, N_OBJ_2), sizeof(OBJ));
    int i, j, r, t;
    void *rig;
+   AVL_CURSOR cursor;
+   long allocated = 0;
 
    for (i = 0; i < N_OBJ; i++) {
       obj_v[i].idx = i;
@@ -557,6 +1868,22 @@ int main(int argc, char *argv[])
    TREE *flt_tree_dup   = avl_tree_dup_float   (OBJ, f);
    TREE *dbl_tree_dup   = avl_tree_dup_double  (OBJ, d);
 
+   TREE *obj_tree_dup_rank   = avl_tree_with_allocator(AVL_USR|AVL_DUP|AVL_RANK, 0, obj_i_cmp, &counting_allocator, &allocated);
+   TREE *ch0_tree_nodup_rank = avl_tree(AVL_CHARS |AVL_NODUP|AVL_RANK, offsetof(OBJ, ch0), NULL);
+   TREE *str_tree_dup_rank   = avl_tree_with_allocator(AVL_STR|AVL_DUP|AVL_RANK, offsetof(OBJ, str), NULL, &counting_allocator, &allocated);
+   TREE *int_tree_nodup_rank = avl_tree(AVL_INT   |AVL_NODUP|AVL_RANK, offsetof(OBJ, i),   NULL);
+   TREE *flt_tree_dup_rank   = avl_tree(AVL_FLOAT |AVL_DUP  |AVL_RANK, offsetof(OBJ, f),   NULL);
+   TREE *dbl_tree_nodup_rank = avl_tree(AVL_DOUBLE|AVL_NODUP|AVL_RANK, offsetof(OBJ, d),   NULL);
+
+   TREE *def_int_tree_nodup    = def_int_tree(false);
+   TREE *def_str_tree_dup_rank = def_str_tree(true);
+
+   AVL_INDEX_TREE *idx_int_tree_dup   = idx_int_tree();
+   AVL_INDEX_TREE *idx_str_tree_nodup = idx_str_tree();
+   AVL_INDEX_TREE *idx_lng_tree_nodup = idx_lng_tree();
+   AVL_INTRUSIVE_TREE itr_int_tree_nodup;
+   AVL_INTRUSIVE_TREE itr_str_tree_dup;
+
    VECT *obj_vect_nodup = avm_vect_nodup       (obj_i_cmp);
    VECT *mbr_vect_nodup = avm_vect_nodup_mbr   (OBJ, ch1, strcmp);
    VECT *ptr_vect_nodup = avm_vect_nodup_ptr   (OBJ, str, strcmp);
@@ -590,6 +1917,25 @@ int main(int argc, char *argv[])
    VECT *flt_vect_dup   = avm_vect_dup_float   (OBJ, f);
    VECT *dbl_vect_dup   = avm_vect_dup_double  (OBJ, d);
 
+   VECT *obj_vect_dup_rank   = avm_vect_dup         (obj_i_cmp);
+   VECT *ch0_vect_nodup_rank = avm_vect_nodup_chars (OBJ, ch0);
+   VECT *str_vect_dup_rank   = avm_vect_dup_str     (OBJ, str);
+   VECT *int_vect_nodup_rank = avm_vect_nodup_int   (OBJ, i);
+   VECT *flt_vect_dup_rank   = avm_vect_dup_float   (OBJ, f);
+   VECT *dbl_vect_nodup_rank = avm_vect_nodup_double(OBJ, d);
+
+   VECT *def_int_vect_nodup    = avm_vect_nodup_int(OBJ, i);
+   VECT *def_str_vect_dup_rank = avm_vect_dup_str  (OBJ, str);
+
+   VECT *idx_int_vect_dup   = avm_vect_dup_int  (OBJ, i);
+   VECT *idx_str_vect_nodup = avm_vect_nodup_str(OBJ, str);
+   VECT *idx_lng_vect_nodup = avm_vect_nodup_int(OBJ, i);
+   VECT *itr_int_vect_nodup = avm_vect_nodup_int(OBJ, i);
+   VECT *itr_str_vect_dup   = avm_vect_dup_str  (OBJ, str);
+
+   itr_int_tree(&itr_int_tree_nodup);
+   itr_str_tree(&itr_str_tree_dup);
+
    for (t = 0; t < N_TESTS; t++) {
       printf("%d ", t); fflush(stdout);
       for (i = 0; i < N_OBJ; i++) {
@@ -600,7 +1946,18 @@ int main(int argc, char *argv[])
                random_string( obj_v[i].ch1, random_int(0, STRLEN_MAX), "\001\177\200\377");
          alloc_random_string(&obj_v[i].str, random_int(0, STRLEN_MAX), "\001\177\200\377");
       }
+      avl_empty(int_tree_dup);
+      assert(avl_reserve(int_tree_dup, N_OBJ));
+      avl_empty(flt_tree_dup);
+      assert( !avl_set_growth(flt_tree_dup, -1, 1));
+      assert( !avl_set_growth(flt_tree_dup,  0, 0));
+      assert(avl_set_growth(flt_tree_dup, 0, 1));
       for (i = 0; i < N_OBJ; i++) {
+         if (i == N_OBJ / 2) {
+            assert(avl_reserve(str_tree_dup,        N_OBJ / 2));
+            assert(avl_reserve(obj_tree_dup_rank,   N_OBJ / 2));
+            assert(avl_reserve(ch0_tree_nodup_rank, N_OBJ / 2));
+         }
          test_avl_insert(obj_tree_nodup, obj_vect_nodup, &obj_v[i]);
          test_avl_insert(mbr_tree_nodup, mbr_vect_nodup, &obj_v[i]);
          test_avl_insert(ptr_tree_nodup, ptr_vect_nodup, &obj_v[i]);
@@ -619,7 +1976,22 @@ int main(int argc, char *argv[])
          test_avl_insert(int_tree_dup,   int_vect_dup,   &obj_v[i]);
          test_avl_insert(flt_tree_dup,   flt_vect_dup,   &obj_v[i]);
          test_avl_insert(dbl_tree_dup,   dbl_vect_dup,   &obj_v[i]);
+         test_avl_insert(obj_tree_dup_rank,   obj_vect_dup_rank,   &obj_v[i]);
+         test_avl_insert_or_locate(ch0_tree_nodup_rank, ch0_vect_nodup_rank, &obj_v[i]);
+         test_avl_insert(str_tree_dup_rank,   str_vect_dup_rank,   &obj_v[i]);
+         test_avl_insert_or_replace(int_tree_nodup_rank, int_vect_nodup_rank, &obj_v[i]);
+         test_avl_insert(flt_tree_dup_rank,   flt_vect_dup_rank,   &obj_v[i]);
+         test_avl_insert(dbl_tree_nodup_rank, dbl_vect_nodup_rank, &obj_v[i]);
+         test_def_int_insert(def_int_tree_nodup,    def_int_vect_nodup,    &obj_v[i]);
+         test_def_str_insert(def_str_tree_dup_rank, def_str_vect_dup_rank, &obj_v[i]);
+         test_idx_int_insert(idx_int_tree_dup,      idx_int_vect_dup,      &obj_v[i]);
+         test_idx_str_insert(idx_str_tree_nodup,    idx_str_vect_nodup,    &obj_v[i]);
+         test_idx_lng_insert(idx_lng_tree_nodup,    idx_lng_vect_nodup,    &obj_v[i]);
+         test_itr_int_insert(&itr_int_tree_nodup,   itr_int_vect_nodup,    &obj_v[i]);
+         test_itr_str_insert(&itr_str_tree_dup,     itr_str_vect_dup,      &obj_v[i]);
       }
+      assert(avl_blocks(int_tree_dup) == 1);
+      assert(avl_blocks(flt_tree_dup) == N_OBJ);
       assert(avl_nodes(obj_tree_nodup) == avm_nodes(obj_vect_nodup));
       assert(avl_nodes(mbr_tree_nodup) == avm_nodes(mbr_vect_nodup));
       assert(avl_nodes(ptr_tree_nodup) == avm_nodes(ptr_vect_nodup));
@@ -638,11 +2010,84 @@ int main(int argc, char *argv[])
       assert(avl_nodes(int_tree_dup)   == avm_nodes(int_vect_dup));
       assert(avl_nodes(flt_tree_dup)   == avm_nodes(flt_vect_dup));
       assert(avl_nodes(dbl_tree_dup)   == avm_nodes(dbl_vect_dup));
+      assert(avl_nodes(obj_tree_dup_rank)   == avm_nodes(obj_vect_dup_rank));
+      assert(avl_nodes(ch0_tree_nodup_rank) == avm_nodes(ch0_vect_nodup_rank));
+      assert(avl_nodes(str_tree_dup_rank)   == avm_nodes(str_vect_dup_rank));
+      assert(avl_nodes(int_tree_nodup_rank) == avm_nodes(int_vect_nodup_rank));
+      assert(avl_nodes(flt_tree_dup_rank)   == avm_nodes(flt_vect_dup_rank));
+      assert(avl_nodes(dbl_tree_nodup_rank) == avm_nodes(dbl_vect_nodup_rank));
+      assert(avl_rank_int(int_tree_nodup, 0) == -1);
+      assert(avl_select  (int_tree_nodup, 0) == NULL);
+      test_avl_build_sorted(obj_tree_dup_rank,   obj_vect_dup_rank);
+      test_avl_build_sorted(ch0_tree_nodup_rank, ch0_vect_nodup_rank);
+      for (i = 0; i < 4; i++) {
+         int r = random_int(0, N_OBJ - 1);
+
+         test_avl_split       (obj_tree_nodup,      obj_vect_nodup,      &obj_v[r]);
+         test_avl_split_mbr   (mbr_tree_nodup,      mbr_vect_nodup,      obj_v[r].ch1);
+         test_avl_split_ptr   (ptr_tree_dup,        ptr_vect_dup,        obj_v[r].str);
+         test_avl_split_chars (ch0_tree_dup,        ch0_vect_dup,        obj_v[r].ch0);
+         test_avl_split_str   (str_tree_nodup,      str_vect_nodup,      obj_v[r].str);
+         test_avl_split_long  (int_tree_dup,        int_vect_dup,        obj_v[r].i);
+         test_avl_split_float (flt_tree_nodup,      flt_vect_nodup,      obj_v[r].f);
+         test_avl_split_double(dbl_tree_dup,        dbl_vect_dup,        obj_v[r].d);
+         test_avl_split       (obj_tree_dup_rank,   obj_vect_dup_rank,   &obj_v[r]);
+         test_avl_split_int   (int_tree_nodup_rank, int_vect_nodup_rank, obj_v[r].i);
+         test_avl_split_str   (str_tree_dup_rank,   str_vect_dup_rank,   obj_v[r].str);
+      }
+      test_avl_compact(obj_tree_nodup,      obj_vect_nodup,      AVL_IN_ORDER);
+      test_avl_compact(ch0_tree_dup,        ch0_vect_dup,        AVL_BFS);
+      test_avl_compact(int_tree_dup,        int_vect_dup,        AVL_VEB);
+      test_avl_compact(obj_tree_dup_rank,   obj_vect_dup_rank,   AVL_BFS);
+      test_avl_compact(int_tree_nodup_rank, int_vect_nodup_rank, AVL_VEB);
+      test_avl_compact(str_tree_dup_rank,   str_vect_dup_rank,   AVL_IN_ORDER);
+      for (i = 0; i < 4; i++) {
+         int r = random_int(0, N_OBJ - 1);
+         OBJ clone = obj_v[r];
+
+         test_avl_insert_or_locate (obj_tree_nodup, obj_vect_nodup, &clone);
+         test_avl_insert_or_locate (str_tree_nodup, str_vect_nodup, &clone);
+         test_avl_insert_or_locate (flt_tree_nodup, flt_vect_nodup, &clone);
+         test_avl_insert_or_replace(mbr_tree_nodup, mbr_vect_nodup, &clone);
+         test_avl_insert_or_replace(int_tree_nodup, int_vect_nodup, &clone);
+         test_avl_insert_or_replace(mbr_tree_nodup, mbr_vect_nodup, &obj_v[r]);
+         test_avl_insert_or_replace(int_tree_nodup, int_vect_nodup, &obj_v[r]);
+      }
+      test_avl_set_operations(obj_tree_nodup,      obj_vect_nodup);
+      test_avl_set_operations(mbr_tree_dup,        mbr_vect_dup);
+      test_avl_set_operations(ptr_tree_nodup,      ptr_vect_nodup);
+      test_avl_set_operations(ch1_tree_dup,        ch1_vect_dup);
+      test_avl_set_operations(str_tree_dup,        str_vect_dup);
+      test_avl_set_operations(int_tree_nodup,      int_vect_nodup);
+      test_avl_set_operations(int_tree_dup,        int_vect_dup);
+      test_avl_set_operations(flt_tree_dup,        flt_vect_dup);
+      test_avl_set_operations(dbl_tree_nodup,      dbl_vect_nodup);
+      test_avl_set_operations(obj_tree_dup_rank,   obj_vect_dup_rank);
+      test_avl_set_operations(ch0_tree_nodup_rank, ch0_vect_nodup_rank);
+      test_avl_pop(obj_tree_nodup,      obj_vect_nodup);
+      test_avl_pop(mbr_tree_dup,        mbr_vect_dup);
+      test_avl_pop(ch1_tree_nodup,      ch1_vect_nodup);
+      test_avl_pop(str_tree_dup,        str_vect_dup);
+      test_avl_pop(lng_tree_nodup,      lng_vect_nodup);
+      test_avl_pop(uch_tree_dup,        uch_vect_dup);
+      test_avl_pop(dbl_tree_nodup,      dbl_vect_nodup);
+      test_avl_pop(obj_tree_dup_rank,   obj_vect_dup_rank);
+      test_avl_pop(int_tree_nodup_rank, int_vect_nodup_rank);
+      assert(avl_union       (int_tree_nodup, int_tree_dup) == NULL);
+      assert(avl_intersection(int_tree_nodup, flt_tree_dup) == NULL);
 
       rig = new_random_index_generator(N_OBJ);
       for (i = 0; i < N_OBJ; i++) {
          int r = random_index(rig);
-
+         int k = random_int(0, N_OBJ - 1);
+
+         if (i == N_OBJ / 2) {
+            test_avl_compact(mbr_tree_nodup,      mbr_vect_nodup,      AVL_VEB);
+            test_avl_compact(str_tree_nodup,      str_vect_nodup,      AVL_BFS);
+            test_avl_compact(flt_tree_dup,        flt_vect_dup,        AVL_IN_ORDER);
+            test_avl_compact(dbl_tree_nodup_rank, dbl_vect_nodup_rank, AVL_VEB);
+            test_avl_compact(def_int_tree_nodup,  def_int_vect_nodup,  AVL_BFS);
+         }
          test_avl_locate(obj_tree_nodup, obj_vect_nodup, &obj_v[r]);
          test_avl_remove(obj_tree_nodup, obj_vect_nodup, &obj_v[r]);
 
@@ -672,6 +2117,11 @@ int main(int argc, char *argv[])
 
          test_avl_locate(obj_tree_dup, obj_vect_dup, &obj_v[r]);
          test_avl_remove(obj_tree_dup, obj_vect_dup, &obj_v[r]);
+         if (i % (N_OBJ / 8) == 0 || i == N_OBJ - 1) {
+            test_avl_trim(obj_tree_nodup,    obj_vect_nodup,    &obj_v[r]);
+            test_avl_trim(obj_tree_dup,      obj_vect_dup,      &obj_v[r]);
+            test_avl_trim(obj_tree_dup_rank, obj_vect_dup_rank, &obj_v[r]);
+         }
 
          test_avl_locate(mbr_tree_dup, mbr_vect_dup, obj_v[r].ch1);
          test_avl_remove(mbr_tree_dup, mbr_vect_dup, obj_v[r].ch1);
@@ -696,6 +2146,65 @@ int main(int argc, char *argv[])
 
          test_avl_locate_double(dbl_tree_dup, dbl_vect_dup, obj_v[r].i);
          test_avl_remove_double(dbl_tree_dup, dbl_vect_dup, obj_v[r].i);
+
+         test_avl_rank       (obj_tree_dup_rank, obj_vect_dup_rank, &obj_v[r]);
+         test_avl_count_range(obj_tree_dup_rank, obj_vect_dup_rank, &obj_v[r], &obj_v[k]);
+         test_avl_select     (obj_tree_dup_rank, obj_vect_dup_rank, k - 1);
+         test_avl_remove     (obj_tree_dup_rank, obj_vect_dup_rank, &obj_v[r]);
+
+         test_avl_rank_chars       (ch0_tree_nodup_rank, ch0_vect_nodup_rank, obj_v[r].ch0);
+         test_avl_count_range_chars(ch0_tree_nodup_rank, ch0_vect_nodup_rank, obj_v[r].ch0, obj_v[k].ch0);
+         test_avl_select           (ch0_tree_nodup_rank, ch0_vect_nodup_rank, k - 1);
+         test_avl_remove_chars     (ch0_tree_nodup_rank, ch0_vect_nodup_rank, obj_v[r].ch0);
+
+         test_avl_rank_str       (str_tree_dup_rank, str_vect_dup_rank, obj_v[r].str);
+         test_avl_count_range_str(str_tree_dup_rank, str_vect_dup_rank, obj_v[r].str, obj_v[k].str);
+         test_avl_select         (str_tree_dup_rank, str_vect_dup_rank, k - 1);
+         test_avl_remove_str     (str_tree_dup_rank, str_vect_dup_rank, obj_v[r].str);
+
+         test_avl_rank_int       (int_tree_nodup_rank, int_vect_nodup_rank, obj_v[r].i);
+         test_avl_count_range_int(int_tree_nodup_rank, int_vect_nodup_rank, obj_v[r].i, obj_v[k].i);
+         test_avl_select         (int_tree_nodup_rank, int_vect_nodup_rank, k - 1);
+         test_avl_remove_int     (int_tree_nodup_rank, int_vect_nodup_rank, obj_v[r].i);
+
+         test_avl_rank_float       (flt_tree_dup_rank, flt_vect_dup_rank, obj_v[r].f);
+         test_avl_count_range_float(flt_tree_dup_rank, flt_vect_dup_rank, obj_v[r].f, obj_v[k].f);
+         test_avl_select           (flt_tree_dup_rank, flt_vect_dup_rank, k - 1);
+         test_avl_remove_float     (flt_tree_dup_rank, flt_vect_dup_rank, obj_v[r].f);
+
+         test_avl_rank_double       (dbl_tree_nodup_rank, dbl_vect_nodup_rank, obj_v[r].d);
+         test_avl_count_range_double(dbl_tree_nodup_rank, dbl_vect_nodup_rank, obj_v[r].d, obj_v[k].d);
+         test_avl_select            (dbl_tree_nodup_rank, dbl_vect_nodup_rank, k - 1);
+         test_avl_remove_double     (dbl_tree_nodup_rank, dbl_vect_nodup_rank, obj_v[r].d);
+
+         test_def_int_locate  (def_int_tree_nodup, def_int_vect_nodup, obj_v[r].i);
+         test_def_int_do_range(def_int_tree_nodup, def_int_vect_nodup, obj_v[r].i, obj_v[k].i);
+         test_def_int_remove  (def_int_tree_nodup, def_int_vect_nodup, obj_v[r].i);
+
+         test_def_str_locate  (def_str_tree_dup_rank, def_str_vect_dup_rank, obj_v[r].str);
+         test_def_str_do_range(def_str_tree_dup_rank, def_str_vect_dup_rank, obj_v[r].str, obj_v[k].str);
+         test_avl_select      (def_str_tree_dup_rank, def_str_vect_dup_rank, k - 1);
+         test_def_str_remove  (def_str_tree_dup_rank, def_str_vect_dup_rank, obj_v[r].str);
+
+         test_idx_int_locate  (idx_int_tree_dup, idx_int_vect_dup, obj_v[r].i);
+         test_idx_int_do_range(idx_int_tree_dup, idx_int_vect_dup, obj_v[r].i, obj_v[k].i);
+         test_idx_int_remove  (idx_int_tree_dup, idx_int_vect_dup, obj_v[r].i);
+
+         test_idx_str_locate  (idx_str_tree_nodup, idx_str_vect_nodup, obj_v[r].str);
+         test_idx_str_do_range(idx_str_tree_nodup, idx_str_vect_nodup, obj_v[r].str, obj_v[k].str);
+         test_idx_str_remove  (idx_str_tree_nodup, idx_str_vect_nodup, obj_v[r].str);
+
+         test_idx_lng_locate  (idx_lng_tree_nodup, idx_lng_vect_nodup, obj_v[r].i);
+         test_idx_lng_do_range(idx_lng_tree_nodup, idx_lng_vect_nodup, obj_v[r].i, obj_v[k].i);
+         test_idx_lng_remove  (idx_lng_tree_nodup, idx_lng_vect_nodup, obj_v[r].i);
+
+         test_itr_int_locate  (&itr_int_tree_nodup, itr_int_vect_nodup, obj_v[r].i);
+         test_itr_int_do_range(&itr_int_tree_nodup, itr_int_vect_nodup, obj_v[r].i, obj_v[k].i);
+         test_itr_int_remove  (&itr_int_tree_nodup, itr_int_vect_nodup, obj_v[r].i);
+
+         test_itr_str_locate  (&itr_str_tree_dup, itr_str_vect_dup, obj_v[r].str);
+         test_itr_str_do_range(&itr_str_tree_dup, itr_str_vect_dup, obj_v[r].str, obj_v[k].str);
+         test_itr_str_remove  (&itr_str_tree_dup, itr_str_vect_dup, obj_v[r].str);
       }
       free_random_index_generator(rig);
 
@@ -717,7 +2226,33 @@ int main(int argc, char *argv[])
       assert(avl_nodes(int_tree_dup  ) == 0); assert(avm_nodes(int_vect_dup  ) == 0);
       assert(avl_nodes(flt_tree_dup  ) == 0); assert(avm_nodes(flt_vect_dup  ) == 0);
       assert(avl_nodes(dbl_tree_dup  ) == 0); assert(avm_nodes(dbl_vect_dup  ) == 0);
+      assert(avl_nodes(obj_tree_dup_rank  ) == 0); assert(avm_nodes(obj_vect_dup_rank  ) == 0);
+      assert(avl_nodes(ch0_tree_nodup_rank) == 0); assert(avm_nodes(ch0_vect_nodup_rank) == 0);
+      assert(avl_nodes(str_tree_dup_rank  ) == 0); assert(avm_nodes(str_vect_dup_rank  ) == 0);
+      assert(avl_nodes(int_tree_nodup_rank) == 0); assert(avm_nodes(int_vect_nodup_rank) == 0);
+      assert(avl_nodes(flt_tree_dup_rank  ) == 0); assert(avm_nodes(flt_vect_dup_rank  ) == 0);
+      assert(avl_nodes(dbl_tree_nodup_rank) == 0); assert(avm_nodes(dbl_vect_nodup_rank) == 0);
+      assert(avl_nodes(def_int_tree_nodup   ) == 0); assert(avm_nodes(def_int_vect_nodup   ) == 0);
+      assert(avl_nodes(def_str_tree_dup_rank) == 0); assert(avm_nodes(def_str_vect_dup_rank) == 0);
+      assert(avl_index_nodes(idx_int_tree_dup  ) == 0); assert(avm_nodes(idx_int_vect_dup  ) == 0);
+      assert(avl_index_nodes(idx_str_tree_nodup) == 0); assert(avm_nodes(idx_str_vect_nodup) == 0);
+      assert(avl_index_nodes(idx_lng_tree_nodup) == 0); assert(avm_nodes(idx_lng_vect_nodup) == 0);
+      assert(avl_intrusive_nodes(&itr_int_tree_nodup) == 0); assert(avm_nodes(itr_int_vect_nodup) == 0);
+      assert(avl_intrusive_nodes(&itr_str_tree_dup  ) == 0); assert(avm_nodes(itr_str_vect_dup  ) == 0);
+      if (t % 2) {
+         avl_index_empty(idx_int_tree_dup);
+         avl_index_empty(idx_lng_tree_nodup);
+         avl_intrusive_empty(&itr_str_tree_dup);
+      }
    }
+   avl_index_free(idx_int_tree_dup);
+   avl_index_free(idx_str_tree_nodup);
+   avl_index_free(idx_lng_tree_nodup);
+   avm_free(idx_int_vect_dup);
+   avm_free(idx_str_vect_nodup);
+   avm_free(idx_lng_vect_nodup);
+   avm_free(itr_int_vect_nodup);
+   avm_free(itr_str_vect_dup);
    test_avl_empty(obj_tree_nodup, obj_vect_nodup);
    test_avl_empty(mbr_tree_nodup, mbr_vect_nodup);
    test_avl_empty(ptr_tree_nodup, ptr_vect_nodup);
@@ -736,6 +2271,25 @@ int main(int argc, char *argv[])
    test_avl_empty(int_tree_dup  , int_vect_dup  );
    test_avl_empty(flt_tree_dup  , flt_vect_dup  );
    test_avl_empty(dbl_tree_dup  , dbl_vect_dup  );
+   test_avl_empty(obj_tree_dup_rank  , obj_vect_dup_rank  );
+   test_avl_empty(ch0_tree_nodup_rank, ch0_vect_nodup_rank);
+   test_avl_empty(str_tree_dup_rank  , str_vect_dup_rank  );
+   test_avl_empty(int_tree_nodup_rank, int_vect_nodup_rank);
+   test_avl_empty(flt_tree_dup_rank  , flt_vect_dup_rank  );
+   test_avl_empty(dbl_tree_nodup_rank, dbl_vect_nodup_rank);
+   avl_free(obj_tree_dup_rank);
+   avl_free(str_tree_dup_rank);
+   assert(allocated == 0);
+
+   test_avl_arena(obj_v, N_OBJ);
+   test_avl_small(obj_v, N_OBJ);
+   test_avl_append_failing(N_OBJ);
+   test_avl_pool(obj_v, N_OBJ);
+   test_avl_pool_split(N_OBJ);
+   test_avl_set_operation_size(N_OBJ);
+   test_avl_append_ulong(AVL_NODUP         , N_OBJ);
+   test_avl_append_ulong(AVL_DUP           , N_OBJ);
+   test_avl_append_ulong(AVL_DUP | AVL_RANK, N_OBJ);
 
    for (i = 0;  i < N_OBJ; i++) {
       free(obj_v[i].str);
@@ -926,6 +2480,33 @@ int main(int argc, char *argv[])
       alloc_random_string(&obj_v[i].str, random_int(0, STRLEN_MAX), "\001\177\200\377");
    }
 
+   TREE *lng_set_nodup    = avl_set_long  ();
+   TREE *uln_set_nodup    = avl_set_ulong ();
+   TREE *dbl_set_nodup    = avl_set_double();
+   TREE *lng_set_dup_rank = avl_tree(AVL_LONG|AVL_DUP|AVL_RANK|AVL_SET, 0, NULL);
+   TREE *lng_map_nodup      = avl_map_long(sizeof(int));
+   TREE *uln_map_nodup_rank = avl_tree(AVL_ULONG|AVL_RANK|AVL_SET, CHA_SIZE, NULL);
+   TREE *set_copy;
+   VECT *lng_svect_nodup    = avm_vect_nodup_long  (OBJ, l);
+   VECT *uln_svect_nodup    = avm_vect_nodup_ulong (OBJ, ul);
+   VECT *dbl_svect_nodup    = avm_vect_nodup_double(OBJ, d);
+   VECT *lng_svect_dup_rank = avm_vect_dup_long    (OBJ, l);
+   VECT *lng_mvect_nodup      = avm_vect_nodup_long (OBJ, l);
+   VECT *uln_mvect_nodup_rank = avm_vect_nodup_ulong(OBJ, ul);
+
+   assert( !dbl_set_nodup == !avl_has_fast_doubles());
+   assert( !avl_tree(AVL_INT|AVL_SET, 0, NULL));
+   assert( !avl_tree(AVL_STR|AVL_SET, 0, NULL));
+   assert( !avl_set_insert_long(lng_tree_nodup, 0));
+   assert( !avl_set_insert_ulong(lng_set_nodup, 0));
+   assert( !avl_tree(AVL_LONG|AVL_DUP|AVL_SET, sizeof(int), NULL));
+   assert( !avl_map_put_long(lng_set_nodup, 0, &obj_v[0].i));
+   assert( !avl_map_ptr_long(lng_set_nodup, 0));
+   assert( !avl_map_put_long(uln_map_nodup_rank, 0, obj_v[0].ch0));
+   assert(avl_set_insert_long(lng_map_nodup, 0) && *(int *)avl_map_ptr_long(lng_map_nodup, 0) == 0);
+   assert( !avl_set_insert_long(lng_map_nodup, 0));
+   assert(avl_set_remove_long(lng_map_nodup, 0) && avl_nodes(lng_map_nodup) == 0);
+
    int r_v[N_OBJ_2];
    for (t = 0; t < N_TESTS_2; t++) {
       printf("%d ", t); fflush(stdout);
@@ -977,6 +2558,14 @@ int main(int argc, char *argv[])
          test_avl_insert(uch_tree_dup  , uch_vect_dup  , &obj_v[r_v[i]]);
          test_avl_insert(flt_tree_dup  , flt_vect_dup  , &obj_v[r_v[i]]);
          test_avl_insert(dbl_tree_dup  , dbl_vect_dup  , &obj_v[r_v[i]]);
+         test_set_long_insert  (lng_set_nodup   , lng_svect_nodup   , &obj_v[r_v[i]]);
+         test_set_ulong_insert (uln_set_nodup   , uln_svect_nodup   , &obj_v[r_v[i]]);
+         if (dbl_set_nodup) {
+            test_set_double_insert(dbl_set_nodup, dbl_svect_nodup   , &obj_v[r_v[i]]);
+         }
+         test_set_long_insert  (lng_set_dup_rank, lng_svect_dup_rank, &obj_v[r_v[i]]);
+         test_map_long_put     (lng_map_nodup     , lng_mvect_nodup     , &obj_v[r_v[i]]);
+         test_map_ulong_put    (uln_map_nodup_rank, uln_mvect_nodup_rank, &obj_v[r_v[i]]);
 
          test_avl_locate_first(obj_tree_nodup, obj_vect_nodup);
          test_avl_locate_first(mbr_tree_nodup, mbr_vect_nodup);
@@ -1044,6 +2633,105 @@ int main(int argc, char *argv[])
          test_avl_locate_last(flt_tree_dup  , flt_vect_dup  );
          test_avl_locate_last(dbl_tree_dup  , dbl_vect_dup  );
 
+         test_avl_locate_many       (obj_tree_nodup, obj_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_mbr   (mbr_tree_nodup, mbr_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_ptr   (ptr_tree_nodup, ptr_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_chars (ch0_tree_nodup, ch0_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_chars1(ch1_tree_nodup, ch1_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_str   (str_tree_nodup, str_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_long  (lng_tree_nodup, lng_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_int   (int_tree_nodup, int_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_short (sht_tree_nodup, sht_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_schar (sch_tree_nodup, sch_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_ulong (uln_tree_nodup, uln_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_uint  (uin_tree_nodup, uin_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_ushort(ush_tree_nodup, ush_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_uchar (uch_tree_nodup, uch_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_float (flt_tree_nodup, flt_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many_double(dbl_tree_nodup, dbl_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_many       (obj_tree_dup  , obj_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_mbr   (mbr_tree_dup  , mbr_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_ptr   (ptr_tree_dup  , ptr_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_chars (ch0_tree_dup  , ch0_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_chars1(ch1_tree_dup  , ch1_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_str   (str_tree_dup  , str_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_long  (lng_tree_dup  , lng_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_int   (int_tree_dup  , int_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_short (sht_tree_dup  , sht_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_schar (sch_tree_dup  , sch_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_ulong (uln_tree_dup  , uln_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_uint  (uin_tree_dup  , uin_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_ushort(ush_tree_dup  , ush_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_uchar (uch_tree_dup  , uch_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_float (flt_tree_dup  , flt_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_many_double(dbl_tree_dup  , dbl_vect_dup  , obj_v, N_OBJ_2);
+
+         test_avl_locate_sorted_batch       (obj_tree_nodup, obj_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_mbr   (mbr_tree_nodup, mbr_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_ptr   (ptr_tree_nodup, ptr_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_chars (ch0_tree_nodup, ch0_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_chars1(ch1_tree_nodup, ch1_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_str   (str_tree_nodup, str_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_long  (lng_tree_nodup, lng_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_int   (int_tree_nodup, int_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_short (sht_tree_nodup, sht_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_schar (sch_tree_nodup, sch_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_ulong (uln_tree_nodup, uln_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_uint  (uin_tree_nodup, uin_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_ushort(ush_tree_nodup, ush_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_uchar (uch_tree_nodup, uch_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_float (flt_tree_nodup, flt_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_double(dbl_tree_nodup, dbl_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch       (obj_tree_dup  , obj_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_mbr   (mbr_tree_dup  , mbr_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_ptr   (ptr_tree_dup  , ptr_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_chars (ch0_tree_dup  , ch0_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_chars1(ch1_tree_dup  , ch1_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_str   (str_tree_dup  , str_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_long  (lng_tree_dup  , lng_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_int   (int_tree_dup  , int_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_short (sht_tree_dup  , sht_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_schar (sch_tree_dup  , sch_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_ulong (uln_tree_dup  , uln_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_uint  (uin_tree_dup  , uin_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_ushort(ush_tree_dup  , ush_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_uchar (uch_tree_dup  , uch_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_float (flt_tree_dup  , flt_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_sorted_batch_double(dbl_tree_dup  , dbl_vect_dup  , obj_v, N_OBJ_2);
+
+         test_avl_locate_near       (obj_tree_nodup, obj_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_mbr   (mbr_tree_nodup, mbr_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_ptr   (ptr_tree_nodup, ptr_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_chars (ch0_tree_nodup, ch0_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_chars1(ch1_tree_nodup, ch1_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_str   (str_tree_nodup, str_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_long  (lng_tree_nodup, lng_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_int   (int_tree_nodup, int_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_short (sht_tree_nodup, sht_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_schar (sch_tree_nodup, sch_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_ulong (uln_tree_nodup, uln_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_uint  (uin_tree_nodup, uin_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_ushort(ush_tree_nodup, ush_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_uchar (uch_tree_nodup, uch_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_float (flt_tree_nodup, flt_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near_double(dbl_tree_nodup, dbl_vect_nodup, obj_v, N_OBJ_2);
+         test_avl_locate_near       (obj_tree_dup  , obj_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_mbr   (mbr_tree_dup  , mbr_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_ptr   (ptr_tree_dup  , ptr_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_chars (ch0_tree_dup  , ch0_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_chars1(ch1_tree_dup  , ch1_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_str   (str_tree_dup  , str_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_long  (lng_tree_dup  , lng_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_int   (int_tree_dup  , int_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_short (sht_tree_dup  , sht_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_schar (sch_tree_dup  , sch_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_ulong (uln_tree_dup  , uln_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_uint  (uin_tree_dup  , uin_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_ushort(ush_tree_dup  , ush_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_uchar (uch_tree_dup  , uch_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_float (flt_tree_dup  , flt_vect_dup  , obj_v, N_OBJ_2);
+         test_avl_locate_near_double(dbl_tree_dup  , dbl_vect_dup  , obj_v, N_OBJ_2);
+
          for (j = 0; j < N_OBJ_2; j++) {
             r = r_v[j];
             test_avl_locate       (obj_tree_nodup, obj_vect_nodup, &obj_v[r]);
@@ -1211,6 +2899,27 @@ int main(int argc, char *argv[])
             test_avl_locate_lt_float (flt_tree_dup  , flt_vect_dup  , obj_v[r].f);
             test_avl_locate_lt_double(dbl_tree_dup  , dbl_vect_dup  , obj_v[r].d);
 
+            test_set_long_contains  (lng_set_nodup   , lng_svect_nodup   , obj_v[r].l);
+            test_set_ulong_contains (uln_set_nodup   , uln_svect_nodup   , obj_v[r].ul);
+            test_set_long_contains  (lng_set_dup_rank, lng_svect_dup_rank, obj_v[r].l);
+            test_set_long_contains  (lng_set_nodup   , lng_svect_nodup   , obj_v[r].l ^ 1);
+            test_set_ulong_contains (uln_set_nodup   , uln_svect_nodup   , obj_v[r].ul - 1);
+            test_set_long_do_range  (lng_set_nodup   , lng_svect_nodup   , obj_v[r].l, obj_v[r_v[N_OBJ_2 - 1 - j]].l);
+            test_set_ulong_do_range (uln_set_nodup   , uln_svect_nodup   , obj_v[r].ul, obj_v[r_v[N_OBJ_2 - 1 - j]].ul);
+            test_set_long_do_range  (lng_set_dup_rank, lng_svect_dup_rank, obj_v[r].l, obj_v[r_v[N_OBJ_2 - 1 - j]].l);
+            test_avl_rank_long      (lng_set_dup_rank, lng_svect_dup_rank, obj_v[r].l);
+            test_avl_count_range_long(lng_set_dup_rank, lng_svect_dup_rank, obj_v[r].l, obj_v[r_v[N_OBJ_2 - 1 - j]].l);
+            test_map_long_get       (lng_map_nodup     , lng_mvect_nodup     , obj_v[r].l);
+            test_map_long_get       (lng_map_nodup     , lng_mvect_nodup     , obj_v[r].l ^ 1);
+            test_map_ulong_get      (uln_map_nodup_rank, uln_mvect_nodup_rank, obj_v[r].ul);
+            test_map_ulong_get      (uln_map_nodup_rank, uln_mvect_nodup_rank, obj_v[r].ul ^ 1);
+            test_avl_rank_ulong     (uln_map_nodup_rank, uln_mvect_nodup_rank, obj_v[r].ul);
+            if (dbl_set_nodup) {
+               test_set_double_contains(dbl_set_nodup, dbl_svect_nodup, obj_v[r].d);
+               test_set_double_contains(dbl_set_nodup, dbl_svect_nodup, obj_v[r].d / 2);
+               test_set_double_do_range(dbl_set_nodup, dbl_svect_nodup, obj_v[r].d, obj_v[r_v[N_OBJ_2 - 1 - j]].d);
+            }
+
             test_avl_start       (obj_tree_nodup, obj_vect_nodup, &obj_v[r]);    test_avl_next(obj_tree_nodup, obj_vect_nodup); test_avl_next(obj_tree_nodup, obj_vect_nodup); test_avl_prev(obj_tree_nodup, obj_vect_nodup);
             test_avl_start_mbr   (mbr_tree_nodup, mbr_vect_nodup, obj_v[r].ch1); test_avl_next(mbr_tree_nodup, mbr_vect_nodup); test_avl_next(mbr_tree_nodup, mbr_vect_nodup); test_avl_prev(mbr_tree_nodup, mbr_vect_nodup);
             test_avl_start_ptr   (ptr_tree_nodup, ptr_vect_nodup, obj_v[r].str); test_avl_next(ptr_tree_nodup, ptr_vect_nodup); test_avl_next(ptr_tree_nodup, ptr_vect_nodup); test_avl_prev(ptr_tree_nodup, ptr_vect_nodup);
@@ -1276,6 +2985,72 @@ int main(int argc, char *argv[])
             test_avl_rev_start_uchar (uch_tree_dup  , uch_vect_dup  , obj_v[r].uc);  test_avl_prev(uch_tree_dup  , uch_vect_dup  ); test_avl_prev(uch_tree_dup  , uch_vect_dup  ); test_avl_next(uch_tree_dup  , uch_vect_dup  );
             test_avl_rev_start_float (flt_tree_dup  , flt_vect_dup  , obj_v[r].f);   test_avl_prev(flt_tree_dup  , flt_vect_dup  ); test_avl_prev(flt_tree_dup  , flt_vect_dup  ); test_avl_next(flt_tree_dup  , flt_vect_dup  );
             test_avl_rev_start_double(dbl_tree_dup  , dbl_vect_dup  , obj_v[r].d);   test_avl_prev(dbl_tree_dup  , dbl_vect_dup  ); test_avl_prev(dbl_tree_dup  , dbl_vect_dup  ); test_avl_next(dbl_tree_dup  , dbl_vect_dup  );
+
+            test_avl_cursor_start       (obj_tree_nodup, obj_vect_nodup, &cursor, &obj_v[r]);    test_avl_cursor_next(obj_vect_nodup, &cursor); test_avl_cursor_next(obj_vect_nodup, &cursor); test_avl_cursor_prev(obj_vect_nodup, &cursor);
+            test_avl_cursor_start_mbr   (mbr_tree_nodup, mbr_vect_nodup, &cursor, obj_v[r].ch1); test_avl_cursor_next(mbr_vect_nodup, &cursor); test_avl_cursor_next(mbr_vect_nodup, &cursor); test_avl_cursor_prev(mbr_vect_nodup, &cursor);
+            test_avl_cursor_start_ptr   (ptr_tree_nodup, ptr_vect_nodup, &cursor, obj_v[r].str); test_avl_cursor_next(ptr_vect_nodup, &cursor); test_avl_cursor_next(ptr_vect_nodup, &cursor); test_avl_cursor_prev(ptr_vect_nodup, &cursor);
+            test_avl_cursor_start_chars (ch0_tree_nodup, ch0_vect_nodup, &cursor, obj_v[r].ch0); test_avl_cursor_next(ch0_vect_nodup, &cursor); test_avl_cursor_next(ch0_vect_nodup, &cursor); test_avl_cursor_prev(ch0_vect_nodup, &cursor);
+            test_avl_cursor_start_chars (ch1_tree_nodup, ch1_vect_nodup, &cursor, obj_v[r].ch1); test_avl_cursor_next(ch1_vect_nodup, &cursor); test_avl_cursor_next(ch1_vect_nodup, &cursor); test_avl_cursor_prev(ch1_vect_nodup, &cursor);
+            test_avl_cursor_start_str   (str_tree_nodup, str_vect_nodup, &cursor, obj_v[r].str); test_avl_cursor_next(str_vect_nodup, &cursor); test_avl_cursor_next(str_vect_nodup, &cursor); test_avl_cursor_prev(str_vect_nodup, &cursor);
+            test_avl_cursor_start_long  (lng_tree_nodup, lng_vect_nodup, &cursor, obj_v[r].l);   test_avl_cursor_next(lng_vect_nodup, &cursor); test_avl_cursor_next(lng_vect_nodup, &cursor); test_avl_cursor_prev(lng_vect_nodup, &cursor);
+            test_avl_cursor_start_int   (int_tree_nodup, int_vect_nodup, &cursor, obj_v[r].i);   test_avl_cursor_next(int_vect_nodup, &cursor); test_avl_cursor_next(int_vect_nodup, &cursor); test_avl_cursor_prev(int_vect_nodup, &cursor);
+            test_avl_cursor_start_short (sht_tree_nodup, sht_vect_nodup, &cursor, obj_v[r].s);   test_avl_cursor_next(sht_vect_nodup, &cursor); test_avl_cursor_next(sht_vect_nodup, &cursor); test_avl_cursor_prev(sht_vect_nodup, &cursor);
+            test_avl_cursor_start_schar (sch_tree_nodup, sch_vect_nodup, &cursor, obj_v[r].sc);  test_avl_cursor_next(sch_vect_nodup, &cursor); test_avl_cursor_next(sch_vect_nodup, &cursor); test_avl_cursor_prev(sch_vect_nodup, &cursor);
+            test_avl_cursor_start_ulong (uln_tree_nodup, uln_vect_nodup, &cursor, obj_v[r].ul);  test_avl_cursor_next(uln_vect_nodup, &cursor); test_avl_cursor_next(uln_vect_nodup, &cursor); test_avl_cursor_prev(uln_vect_nodup, &cursor);
+            test_avl_cursor_start_uint  (uin_tree_nodup, uin_vect_nodup, &cursor, obj_v[r].ui);  test_avl_cursor_next(uin_vect_nodup, &cursor); test_avl_cursor_next(uin_vect_nodup, &cursor); test_avl_cursor_prev(uin_vect_nodup, &cursor);
+            test_avl_cursor_start_ushort(ush_tree_nodup, ush_vect_nodup, &cursor, obj_v[r].us);  test_avl_cursor_next(ush_vect_nodup, &cursor); test_avl_cursor_next(ush_vect_nodup, &cursor); test_avl_cursor_prev(ush_vect_nodup, &cursor);
+            test_avl_cursor_start_uchar (uch_tree_nodup, uch_vect_nodup, &cursor, obj_v[r].uc);  test_avl_cursor_next(uch_vect_nodup, &cursor); test_avl_cursor_next(uch_vect_nodup, &cursor); test_avl_cursor_prev(uch_vect_nodup, &cursor);
+            test_avl_cursor_start_float (flt_tree_nodup, flt_vect_nodup, &cursor, obj_v[r].f);   test_avl_cursor_next(flt_vect_nodup, &cursor); test_avl_cursor_next(flt_vect_nodup, &cursor); test_avl_cursor_prev(flt_vect_nodup, &cursor);
+            test_avl_cursor_start_double(dbl_tree_nodup, dbl_vect_nodup, &cursor, obj_v[r].d);   test_avl_cursor_next(dbl_vect_nodup, &cursor); test_avl_cursor_next(dbl_vect_nodup, &cursor); test_avl_cursor_prev(dbl_vect_nodup, &cursor);
+            test_avl_cursor_start       (obj_tree_dup  , obj_vect_dup  , &cursor, &obj_v[r]);    test_avl_cursor_next(obj_vect_dup  , &cursor); test_avl_cursor_next(obj_vect_dup  , &cursor); test_avl_cursor_prev(obj_vect_dup  , &cursor);
+            test_avl_cursor_start_mbr   (mbr_tree_dup  , mbr_vect_dup  , &cursor, obj_v[r].ch1); test_avl_cursor_next(mbr_vect_dup  , &cursor); test_avl_cursor_next(mbr_vect_dup  , &cursor); test_avl_cursor_prev(mbr_vect_dup  , &cursor);
+            test_avl_cursor_start_ptr   (ptr_tree_dup  , ptr_vect_dup  , &cursor, obj_v[r].str); test_avl_cursor_next(ptr_vect_dup  , &cursor); test_avl_cursor_next(ptr_vect_dup  , &cursor); test_avl_cursor_prev(ptr_vect_dup  , &cursor);
+            test_avl_cursor_start_chars (ch0_tree_dup  , ch0_vect_dup  , &cursor, obj_v[r].ch0); test_avl_cursor_next(ch0_vect_dup  , &cursor); test_avl_cursor_next(ch0_vect_dup  , &cursor); test_avl_cursor_prev(ch0_vect_dup  , &cursor);
+            test_avl_cursor_start_chars (ch1_tree_dup  , ch1_vect_dup  , &cursor, obj_v[r].ch1); test_avl_cursor_next(ch1_vect_dup  , &cursor); test_avl_cursor_next(ch1_vect_dup  , &cursor); test_avl_cursor_prev(ch1_vect_dup  , &cursor);
+            test_avl_cursor_start_str   (str_tree_dup  , str_vect_dup  , &cursor, obj_v[r].str); test_avl_cursor_next(str_vect_dup  , &cursor); test_avl_cursor_next(str_vect_dup  , &cursor); test_avl_cursor_prev(str_vect_dup  , &cursor);
+            test_avl_cursor_start_long  (lng_tree_dup  , lng_vect_dup  , &cursor, obj_v[r].l);   test_avl_cursor_next(lng_vect_dup  , &cursor); test_avl_cursor_next(lng_vect_dup  , &cursor); test_avl_cursor_prev(lng_vect_dup  , &cursor);
+            test_avl_cursor_start_int   (int_tree_dup  , int_vect_dup  , &cursor, obj_v[r].i);   test_avl_cursor_next(int_vect_dup  , &cursor); test_avl_cursor_next(int_vect_dup  , &cursor); test_avl_cursor_prev(int_vect_dup  , &cursor);
+            test_avl_cursor_start_short (sht_tree_dup  , sht_vect_dup  , &cursor, obj_v[r].s);   test_avl_cursor_next(sht_vect_dup  , &cursor); test_avl_cursor_next(sht_vect_dup  , &cursor); test_avl_cursor_prev(sht_vect_dup  , &cursor);
+            test_avl_cursor_start_schar (sch_tree_dup  , sch_vect_dup  , &cursor, obj_v[r].sc);  test_avl_cursor_next(sch_vect_dup  , &cursor); test_avl_cursor_next(sch_vect_dup  , &cursor); test_avl_cursor_prev(sch_vect_dup  , &cursor);
+            test_avl_cursor_start_ulong (uln_tree_dup  , uln_vect_dup  , &cursor, obj_v[r].ul);  test_avl_cursor_next(uln_vect_dup  , &cursor); test_avl_cursor_next(uln_vect_dup  , &cursor); test_avl_cursor_prev(uln_vect_dup  , &cursor);
+            test_avl_cursor_start_uint  (uin_tree_dup  , uin_vect_dup  , &cursor, obj_v[r].ui);  test_avl_cursor_next(uin_vect_dup  , &cursor); test_avl_cursor_next(uin_vect_dup  , &cursor); test_avl_cursor_prev(uin_vect_dup  , &cursor);
+            test_avl_cursor_start_ushort(ush_tree_dup  , ush_vect_dup  , &cursor, obj_v[r].us);  test_avl_cursor_next(ush_vect_dup  , &cursor); test_avl_cursor_next(ush_vect_dup  , &cursor); test_avl_cursor_prev(ush_vect_dup  , &cursor);
+            test_avl_cursor_start_uchar (uch_tree_dup  , uch_vect_dup  , &cursor, obj_v[r].uc);  test_avl_cursor_next(uch_vect_dup  , &cursor); test_avl_cursor_next(uch_vect_dup  , &cursor); test_avl_cursor_prev(uch_vect_dup  , &cursor);
+            test_avl_cursor_start_float (flt_tree_dup  , flt_vect_dup  , &cursor, obj_v[r].f);   test_avl_cursor_next(flt_vect_dup  , &cursor); test_avl_cursor_next(flt_vect_dup  , &cursor); test_avl_cursor_prev(flt_vect_dup  , &cursor);
+            test_avl_cursor_start_double(dbl_tree_dup  , dbl_vect_dup  , &cursor, obj_v[r].d);   test_avl_cursor_next(dbl_vect_dup  , &cursor); test_avl_cursor_next(dbl_vect_dup  , &cursor); test_avl_cursor_prev(dbl_vect_dup  , &cursor);
+
+            test_avl_cursor_rev_start       (obj_tree_nodup, obj_vect_nodup, &cursor, &obj_v[r]);    test_avl_cursor_prev(obj_vect_nodup, &cursor); test_avl_cursor_prev(obj_vect_nodup, &cursor); test_avl_cursor_next(obj_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_mbr   (mbr_tree_nodup, mbr_vect_nodup, &cursor, obj_v[r].ch1); test_avl_cursor_prev(mbr_vect_nodup, &cursor); test_avl_cursor_prev(mbr_vect_nodup, &cursor); test_avl_cursor_next(mbr_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_ptr   (ptr_tree_nodup, ptr_vect_nodup, &cursor, obj_v[r].str); test_avl_cursor_prev(ptr_vect_nodup, &cursor); test_avl_cursor_prev(ptr_vect_nodup, &cursor); test_avl_cursor_next(ptr_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_chars (ch0_tree_nodup, ch0_vect_nodup, &cursor, obj_v[r].ch0); test_avl_cursor_prev(ch0_vect_nodup, &cursor); test_avl_cursor_prev(ch0_vect_nodup, &cursor); test_avl_cursor_next(ch0_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_chars (ch1_tree_nodup, ch1_vect_nodup, &cursor, obj_v[r].ch1); test_avl_cursor_prev(ch1_vect_nodup, &cursor); test_avl_cursor_prev(ch1_vect_nodup, &cursor); test_avl_cursor_next(ch1_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_str   (str_tree_nodup, str_vect_nodup, &cursor, obj_v[r].str); test_avl_cursor_prev(str_vect_nodup, &cursor); test_avl_cursor_prev(str_vect_nodup, &cursor); test_avl_cursor_next(str_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_long  (lng_tree_nodup, lng_vect_nodup, &cursor, obj_v[r].l);   test_avl_cursor_prev(lng_vect_nodup, &cursor); test_avl_cursor_prev(lng_vect_nodup, &cursor); test_avl_cursor_next(lng_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_int   (int_tree_nodup, int_vect_nodup, &cursor, obj_v[r].i);   test_avl_cursor_prev(int_vect_nodup, &cursor); test_avl_cursor_prev(int_vect_nodup, &cursor); test_avl_cursor_next(int_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_short (sht_tree_nodup, sht_vect_nodup, &cursor, obj_v[r].s);   test_avl_cursor_prev(sht_vect_nodup, &cursor); test_avl_cursor_prev(sht_vect_nodup, &cursor); test_avl_cursor_next(sht_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_schar (sch_tree_nodup, sch_vect_nodup, &cursor, obj_v[r].sc);  test_avl_cursor_prev(sch_vect_nodup, &cursor); test_avl_cursor_prev(sch_vect_nodup, &cursor); test_avl_cursor_next(sch_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_ulong (uln_tree_nodup, uln_vect_nodup, &cursor, obj_v[r].ul);  test_avl_cursor_prev(uln_vect_nodup, &cursor); test_avl_cursor_prev(uln_vect_nodup, &cursor); test_avl_cursor_next(uln_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_uint  (uin_tree_nodup, uin_vect_nodup, &cursor, obj_v[r].ui);  test_avl_cursor_prev(uin_vect_nodup, &cursor); test_avl_cursor_prev(uin_vect_nodup, &cursor); test_avl_cursor_next(uin_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_ushort(ush_tree_nodup, ush_vect_nodup, &cursor, obj_v[r].us);  test_avl_cursor_prev(ush_vect_nodup, &cursor); test_avl_cursor_prev(ush_vect_nodup, &cursor); test_avl_cursor_next(ush_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_uchar (uch_tree_nodup, uch_vect_nodup, &cursor, obj_v[r].uc);  test_avl_cursor_prev(uch_vect_nodup, &cursor); test_avl_cursor_prev(uch_vect_nodup, &cursor); test_avl_cursor_next(uch_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_float (flt_tree_nodup, flt_vect_nodup, &cursor, obj_v[r].f);   test_avl_cursor_prev(flt_vect_nodup, &cursor); test_avl_cursor_prev(flt_vect_nodup, &cursor); test_avl_cursor_next(flt_vect_nodup, &cursor);
+            test_avl_cursor_rev_start_double(dbl_tree_nodup, dbl_vect_nodup, &cursor, obj_v[r].d);   test_avl_cursor_prev(dbl_vect_nodup, &cursor); test_avl_cursor_prev(dbl_vect_nodup, &cursor); test_avl_cursor_next(dbl_vect_nodup, &cursor);
+            test_avl_cursor_rev_start       (obj_tree_dup  , obj_vect_dup  , &cursor, &obj_v[r]);    test_avl_cursor_prev(obj_vect_dup  , &cursor); test_avl_cursor_prev(obj_vect_dup  , &cursor); test_avl_cursor_next(obj_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_mbr   (mbr_tree_dup  , mbr_vect_dup  , &cursor, obj_v[r].ch1); test_avl_cursor_prev(mbr_vect_dup  , &cursor); test_avl_cursor_prev(mbr_vect_dup  , &cursor); test_avl_cursor_next(mbr_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_ptr   (ptr_tree_dup  , ptr_vect_dup  , &cursor, obj_v[r].str); test_avl_cursor_prev(ptr_vect_dup  , &cursor); test_avl_cursor_prev(ptr_vect_dup  , &cursor); test_avl_cursor_next(ptr_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_chars (ch0_tree_dup  , ch0_vect_dup  , &cursor, obj_v[r].ch0); test_avl_cursor_prev(ch0_vect_dup  , &cursor); test_avl_cursor_prev(ch0_vect_dup  , &cursor); test_avl_cursor_next(ch0_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_chars (ch1_tree_dup  , ch1_vect_dup  , &cursor, obj_v[r].ch1); test_avl_cursor_prev(ch1_vect_dup  , &cursor); test_avl_cursor_prev(ch1_vect_dup  , &cursor); test_avl_cursor_next(ch1_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_str   (str_tree_dup  , str_vect_dup  , &cursor, obj_v[r].str); test_avl_cursor_prev(str_vect_dup  , &cursor); test_avl_cursor_prev(str_vect_dup  , &cursor); test_avl_cursor_next(str_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_long  (lng_tree_dup  , lng_vect_dup  , &cursor, obj_v[r].l);   test_avl_cursor_prev(lng_vect_dup  , &cursor); test_avl_cursor_prev(lng_vect_dup  , &cursor); test_avl_cursor_next(lng_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_int   (int_tree_dup  , int_vect_dup  , &cursor, obj_v[r].i);   test_avl_cursor_prev(int_vect_dup  , &cursor); test_avl_cursor_prev(int_vect_dup  , &cursor); test_avl_cursor_next(int_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_short (sht_tree_dup  , sht_vect_dup  , &cursor, obj_v[r].s);   test_avl_cursor_prev(sht_vect_dup  , &cursor); test_avl_cursor_prev(sht_vect_dup  , &cursor); test_avl_cursor_next(sht_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_schar (sch_tree_dup  , sch_vect_dup  , &cursor, obj_v[r].sc);  test_avl_cursor_prev(sch_vect_dup  , &cursor); test_avl_cursor_prev(sch_vect_dup  , &cursor); test_avl_cursor_next(sch_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_ulong (uln_tree_dup  , uln_vect_dup  , &cursor, obj_v[r].ul);  test_avl_cursor_prev(uln_vect_dup  , &cursor); test_avl_cursor_prev(uln_vect_dup  , &cursor); test_avl_cursor_next(uln_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_uint  (uin_tree_dup  , uin_vect_dup  , &cursor, obj_v[r].ui);  test_avl_cursor_prev(uin_vect_dup  , &cursor); test_avl_cursor_prev(uin_vect_dup  , &cursor); test_avl_cursor_next(uin_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_ushort(ush_tree_dup  , ush_vect_dup  , &cursor, obj_v[r].us);  test_avl_cursor_prev(ush_vect_dup  , &cursor); test_avl_cursor_prev(ush_vect_dup  , &cursor); test_avl_cursor_next(ush_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_uchar (uch_tree_dup  , uch_vect_dup  , &cursor, obj_v[r].uc);  test_avl_cursor_prev(uch_vect_dup  , &cursor); test_avl_cursor_prev(uch_vect_dup  , &cursor); test_avl_cursor_next(uch_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_float (flt_tree_dup  , flt_vect_dup  , &cursor, obj_v[r].f);   test_avl_cursor_prev(flt_vect_dup  , &cursor); test_avl_cursor_prev(flt_vect_dup  , &cursor); test_avl_cursor_next(flt_vect_dup  , &cursor);
+            test_avl_cursor_rev_start_double(dbl_tree_dup  , dbl_vect_dup  , &cursor, obj_v[r].d);   test_avl_cursor_prev(dbl_vect_dup  , &cursor); test_avl_cursor_prev(dbl_vect_dup  , &cursor); test_avl_cursor_next(dbl_vect_dup  , &cursor);
          }
          test_avl_first(obj_tree_nodup, obj_vect_nodup); test_avl_next(obj_tree_nodup, obj_vect_nodup); test_avl_next(obj_tree_nodup, obj_vect_nodup); test_avl_prev(obj_tree_nodup, obj_vect_nodup);
          test_avl_first(mbr_tree_nodup, mbr_vect_nodup); test_avl_next(mbr_tree_nodup, mbr_vect_nodup); test_avl_next(mbr_tree_nodup, mbr_vect_nodup); test_avl_prev(mbr_tree_nodup, mbr_vect_nodup);
@@ -1342,7 +3117,146 @@ int main(int argc, char *argv[])
          test_avl_last (uch_tree_dup  , uch_vect_dup  ); test_avl_prev(uch_tree_dup  , uch_vect_dup  ); test_avl_prev(uch_tree_dup  , uch_vect_dup  ); test_avl_next(uch_tree_dup  , uch_vect_dup  );
          test_avl_last (flt_tree_dup  , flt_vect_dup  ); test_avl_prev(flt_tree_dup  , flt_vect_dup  ); test_avl_prev(flt_tree_dup  , flt_vect_dup  ); test_avl_next(flt_tree_dup  , flt_vect_dup  );
          test_avl_last (dbl_tree_dup  , dbl_vect_dup  ); test_avl_prev(dbl_tree_dup  , dbl_vect_dup  ); test_avl_prev(dbl_tree_dup  , dbl_vect_dup  ); test_avl_next(dbl_tree_dup  , dbl_vect_dup  );
+
+         test_avl_cursor_walk(obj_tree_nodup, obj_vect_nodup);
+         test_avl_cursor_walk(mbr_tree_nodup, mbr_vect_nodup);
+         test_avl_cursor_walk(ptr_tree_nodup, ptr_vect_nodup);
+         test_avl_cursor_walk(ch0_tree_nodup, ch0_vect_nodup);
+         test_avl_cursor_walk(ch1_tree_nodup, ch1_vect_nodup);
+         test_avl_cursor_walk(str_tree_nodup, str_vect_nodup);
+         test_avl_cursor_walk(lng_tree_nodup, lng_vect_nodup);
+         test_avl_cursor_walk(int_tree_nodup, int_vect_nodup);
+         test_avl_cursor_walk(sht_tree_nodup, sht_vect_nodup);
+         test_avl_cursor_walk(sch_tree_nodup, sch_vect_nodup);
+         test_avl_cursor_walk(uln_tree_nodup, uln_vect_nodup);
+         test_avl_cursor_walk(uin_tree_nodup, uin_vect_nodup);
+         test_avl_cursor_walk(ush_tree_nodup, ush_vect_nodup);
+         test_avl_cursor_walk(uch_tree_nodup, uch_vect_nodup);
+         test_avl_cursor_walk(flt_tree_nodup, flt_vect_nodup);
+         test_avl_cursor_walk(dbl_tree_nodup, dbl_vect_nodup);
+         test_avl_cursor_walk(obj_tree_dup  , obj_vect_dup  );
+         test_avl_cursor_walk(mbr_tree_dup  , mbr_vect_dup  );
+         test_avl_cursor_walk(ptr_tree_dup  , ptr_vect_dup  );
+         test_avl_cursor_walk(ch0_tree_dup  , ch0_vect_dup  );
+         test_avl_cursor_walk(ch1_tree_dup  , ch1_vect_dup  );
+         test_avl_cursor_walk(str_tree_dup  , str_vect_dup  );
+         test_avl_cursor_walk(lng_tree_dup  , lng_vect_dup  );
+         test_avl_cursor_walk(int_tree_dup  , int_vect_dup  );
+         test_avl_cursor_walk(sht_tree_dup  , sht_vect_dup  );
+         test_avl_cursor_walk(sch_tree_dup  , sch_vect_dup  );
+         test_avl_cursor_walk(uln_tree_dup  , uln_vect_dup  );
+         test_avl_cursor_walk(uin_tree_dup  , uin_vect_dup  );
+         test_avl_cursor_walk(ush_tree_dup  , ush_vect_dup  );
+         test_avl_cursor_walk(uch_tree_dup  , uch_vect_dup  );
+         test_avl_cursor_walk(flt_tree_dup  , flt_vect_dup  );
+         test_avl_cursor_walk(dbl_tree_dup  , dbl_vect_dup  );
+
+         test_avl_build_sorted(obj_tree_nodup, obj_vect_nodup);
+         test_avl_build_sorted(mbr_tree_nodup, mbr_vect_nodup);
+         test_avl_build_sorted(ptr_tree_nodup, ptr_vect_nodup);
+         test_avl_build_sorted(ch0_tree_nodup, ch0_vect_nodup);
+         test_avl_build_sorted(ch1_tree_nodup, ch1_vect_nodup);
+         test_avl_build_sorted(str_tree_nodup, str_vect_nodup);
+         test_avl_build_sorted(lng_tree_nodup, lng_vect_nodup);
+         test_avl_build_sorted(int_tree_nodup, int_vect_nodup);
+         test_avl_build_sorted(sht_tree_nodup, sht_vect_nodup);
+         test_avl_build_sorted(sch_tree_nodup, sch_vect_nodup);
+         test_avl_build_sorted(uln_tree_nodup, uln_vect_nodup);
+         test_avl_build_sorted(uin_tree_nodup, uin_vect_nodup);
+         test_avl_build_sorted(ush_tree_nodup, ush_vect_nodup);
+         test_avl_build_sorted(uch_tree_nodup, uch_vect_nodup);
+         test_avl_build_sorted(flt_tree_nodup, flt_vect_nodup);
+         test_avl_build_sorted(dbl_tree_nodup, dbl_vect_nodup);
+         test_avl_build_sorted(obj_tree_dup  , obj_vect_dup  );
+         test_avl_build_sorted(mbr_tree_dup  , mbr_vect_dup  );
+         test_avl_build_sorted(ptr_tree_dup  , ptr_vect_dup  );
+         test_avl_build_sorted(ch0_tree_dup  , ch0_vect_dup  );
+         test_avl_build_sorted(ch1_tree_dup  , ch1_vect_dup  );
+         test_avl_build_sorted(str_tree_dup  , str_vect_dup  );
+         test_avl_build_sorted(lng_tree_dup  , lng_vect_dup  );
+         test_avl_build_sorted(int_tree_dup  , int_vect_dup  );
+         test_avl_build_sorted(sht_tree_dup  , sht_vect_dup  );
+         test_avl_build_sorted(sch_tree_dup  , sch_vect_dup  );
+         test_avl_build_sorted(uln_tree_dup  , uln_vect_dup  );
+         test_avl_build_sorted(uin_tree_dup  , uin_vect_dup  );
+         test_avl_build_sorted(ush_tree_dup  , ush_vect_dup  );
+         test_avl_build_sorted(uch_tree_dup  , uch_vect_dup  );
+         test_avl_build_sorted(flt_tree_dup  , flt_vect_dup  );
+         test_avl_build_sorted(dbl_tree_dup  , dbl_vect_dup  );
+
+         test_avl_insert_sorted_batch(obj_tree_nodup, obj_vect_nodup);
+         test_avl_insert_sorted_batch(mbr_tree_nodup, mbr_vect_nodup);
+         test_avl_insert_sorted_batch(ptr_tree_nodup, ptr_vect_nodup);
+         test_avl_insert_sorted_batch(ch0_tree_nodup, ch0_vect_nodup);
+         test_avl_insert_sorted_batch(ch1_tree_nodup, ch1_vect_nodup);
+         test_avl_insert_sorted_batch(str_tree_nodup, str_vect_nodup);
+         test_avl_insert_sorted_batch(lng_tree_nodup, lng_vect_nodup);
+         test_avl_insert_sorted_batch(int_tree_nodup, int_vect_nodup);
+         test_avl_insert_sorted_batch(sht_tree_nodup, sht_vect_nodup);
+         test_avl_insert_sorted_batch(sch_tree_nodup, sch_vect_nodup);
+         test_avl_insert_sorted_batch(uln_tree_nodup, uln_vect_nodup);
+         test_avl_insert_sorted_batch(uin_tree_nodup, uin_vect_nodup);
+         test_avl_insert_sorted_batch(ush_tree_nodup, ush_vect_nodup);
+         test_avl_insert_sorted_batch(uch_tree_nodup, uch_vect_nodup);
+         test_avl_insert_sorted_batch(flt_tree_nodup, flt_vect_nodup);
+         test_avl_insert_sorted_batch(dbl_tree_nodup, dbl_vect_nodup);
+         test_avl_insert_sorted_batch(obj_tree_dup  , obj_vect_dup  );
+         test_avl_insert_sorted_batch(mbr_tree_dup  , mbr_vect_dup  );
+         test_avl_insert_sorted_batch(ptr_tree_dup  , ptr_vect_dup  );
+         test_avl_insert_sorted_batch(ch0_tree_dup  , ch0_vect_dup  );
+         test_avl_insert_sorted_batch(ch1_tree_dup  , ch1_vect_dup  );
+         test_avl_insert_sorted_batch(str_tree_dup  , str_vect_dup  );
+         test_avl_insert_sorted_batch(lng_tree_dup  , lng_vect_dup  );
+         test_avl_insert_sorted_batch(int_tree_dup  , int_vect_dup  );
+         test_avl_insert_sorted_batch(sht_tree_dup  , sht_vect_dup  );
+         test_avl_insert_sorted_batch(sch_tree_dup  , sch_vect_dup  );
+         test_avl_insert_sorted_batch(uln_tree_dup  , uln_vect_dup  );
+         test_avl_insert_sorted_batch(uin_tree_dup  , uin_vect_dup  );
+         test_avl_insert_sorted_batch(ush_tree_dup  , ush_vect_dup  );
+         test_avl_insert_sorted_batch(uch_tree_dup  , uch_vect_dup  );
+         test_avl_insert_sorted_batch(flt_tree_dup  , flt_vect_dup  );
+         test_avl_insert_sorted_batch(dbl_tree_dup  , dbl_vect_dup  );
+
+         test_avl_append(obj_tree_nodup, obj_vect_nodup);
+         test_avl_append(mbr_tree_nodup, mbr_vect_nodup);
+         test_avl_append(ptr_tree_nodup, ptr_vect_nodup);
+         test_avl_append(ch0_tree_nodup, ch0_vect_nodup);
+         test_avl_append(ch1_tree_nodup, ch1_vect_nodup);
+         test_avl_append(str_tree_nodup, str_vect_nodup);
+         test_avl_append(lng_tree_nodup, lng_vect_nodup);
+         test_avl_append(int_tree_nodup, int_vect_nodup);
+         test_avl_append(sht_tree_nodup, sht_vect_nodup);
+         test_avl_append(sch_tree_nodup, sch_vect_nodup);
+         test_avl_append(uln_tree_nodup, uln_vect_nodup);
+         test_avl_append(uin_tree_nodup, uin_vect_nodup);
+         test_avl_append(ush_tree_nodup, ush_vect_nodup);
+         test_avl_append(uch_tree_nodup, uch_vect_nodup);
+         test_avl_append(flt_tree_nodup, flt_vect_nodup);
+         test_avl_append(dbl_tree_nodup, dbl_vect_nodup);
+         test_avl_append(obj_tree_dup  , obj_vect_dup  );
+         test_avl_append(mbr_tree_dup  , mbr_vect_dup  );
+         test_avl_append(ptr_tree_dup  , ptr_vect_dup  );
+         test_avl_append(ch0_tree_dup  , ch0_vect_dup  );
+         test_avl_append(ch1_tree_dup  , ch1_vect_dup  );
+         test_avl_append(str_tree_dup  , str_vect_dup  );
+         test_avl_append(lng_tree_dup  , lng_vect_dup  );
+         test_avl_append(int_tree_dup  , int_vect_dup  );
+         test_avl_append(sht_tree_dup  , sht_vect_dup  );
+         test_avl_append(sch_tree_dup  , sch_vect_dup  );
+         test_avl_append(uln_tree_dup  , uln_vect_dup  );
+         test_avl_append(uin_tree_dup  , uin_vect_dup  );
+         test_avl_append(ush_tree_dup  , ush_vect_dup  );
+         test_avl_append(uch_tree_dup  , uch_vect_dup  );
+         test_avl_append(flt_tree_dup  , flt_vect_dup  );
+         test_avl_append(dbl_tree_dup  , dbl_vect_dup  );
       }
+      set_copy = avl_copy(lng_set_dup_rank);
+      assert(avl_pop_first(set_copy) == NULL && avl_pop_last(set_copy) == NULL);
+      check_set_and_cmp(set_copy, lng_svect_dup_rank);
+      avl_free(set_copy);
+      set_copy = avl_copy(uln_map_nodup_rank);
+      check_map_ulong_and_cmp(set_copy, uln_mvect_nodup_rank);
+      avl_free(set_copy);
       for (i = 0; i < N_OBJ_2; i++) {
          test_avl_remove       (obj_tree_nodup, obj_vect_nodup, &obj_v[r_v[i]]);
          test_avl_remove_mbr   (mbr_tree_nodup, mbr_vect_nodup, obj_v[r_v[i]].ch1);
@@ -1376,6 +3290,14 @@ int main(int argc, char *argv[])
          test_avl_remove_uchar (uch_tree_dup  , uch_vect_dup  , obj_v[r_v[i]].uc);
          test_avl_remove_float (flt_tree_dup  , flt_vect_dup  , obj_v[r_v[i]].f);
          test_avl_remove_double(dbl_tree_dup  , dbl_vect_dup  , obj_v[r_v[i]].d);
+         test_set_long_remove  (lng_set_nodup   , lng_svect_nodup   , obj_v[r_v[i]].l);
+         test_set_ulong_remove (uln_set_nodup   , uln_svect_nodup   , obj_v[r_v[i]].ul);
+         if (dbl_set_nodup) {
+            test_set_double_remove(dbl_set_nodup, dbl_svect_nodup   , obj_v[r_v[i]].d);
+         }
+         test_set_long_remove  (lng_set_dup_rank, lng_svect_dup_rank, obj_v[r_v[i]].l);
+         test_map_long_remove  (lng_map_nodup     , lng_mvect_nodup     , obj_v[r_v[i]].l);
+         test_map_ulong_remove (uln_map_nodup_rank, uln_mvect_nodup_rank, obj_v[r_v[i]].ul);
       }
       assert(avl_nodes(obj_tree_nodup) == 0); assert(avm_nodes(obj_vect_nodup) == 0);
       assert(avl_nodes(mbr_tree_nodup) == 0); assert(avm_nodes(mbr_vect_nodup) == 0);
@@ -1409,7 +3331,29 @@ int main(int argc, char *argv[])
       assert(avl_nodes(uch_tree_dup  ) == 0); assert(avm_nodes(uch_vect_dup  ) == 0);
       assert(avl_nodes(flt_tree_dup  ) == 0); assert(avm_nodes(flt_vect_dup  ) == 0);
       assert(avl_nodes(dbl_tree_dup  ) == 0); assert(avm_nodes(dbl_vect_dup  ) == 0);
+      assert(avl_nodes(lng_set_nodup   ) == 0); assert(avm_nodes(lng_svect_nodup   ) == 0);
+      assert(avl_nodes(uln_set_nodup   ) == 0); assert(avm_nodes(uln_svect_nodup   ) == 0);
+      assert(avl_nodes(lng_set_dup_rank) == 0); assert(avm_nodes(lng_svect_dup_rank) == 0);
+      assert(avl_nodes(lng_map_nodup     ) == 0); assert(avm_nodes(lng_mvect_nodup     ) == 0);
+      assert(avl_nodes(uln_map_nodup_rank) == 0); assert(avm_nodes(uln_mvect_nodup_rank) == 0);
+      if (t % 2) {
+         avl_trim(lng_set_nodup);
+      }
+   }
+   avl_free(lng_set_nodup);
+   avl_free(uln_set_nodup);
+   if (dbl_set_nodup) {
+      avl_free(dbl_set_nodup);
    }
+   avl_free(lng_set_dup_rank);
+   avl_free(lng_map_nodup);
+   avl_free(uln_map_nodup_rank);
+   avm_free(lng_svect_nodup);
+   avm_free(uln_svect_nodup);
+   avm_free(dbl_svect_nodup);
+   avm_free(lng_svect_dup_rank);
+   avm_free(lng_mvect_nodup);
+   avm_free(uln_mvect_nodup_rank);
    printf("\nok\n"); fflush(stdout);
 
    printf("%s OK\n", argv[0]);
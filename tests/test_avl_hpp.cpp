@@ -0,0 +1,200 @@
+/*----------------------------------------------------------------------------*
+ |                                                                            |
+ |                              test_avl_hpp.cpp                              |
+ |                                                                            |
+ |                  tests for the C++ interface (../avl.hpp)                  |
+ |                                                                            |
+ *----------------------------------------------------------------------------*/
+/*
+Copyright (c) 2013, Walter Tross <waltertross at gmail dot com>
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* The trees of avl.hpp are checked against a std::multimap of the same items,
+ * which plays the role of the avm mockup of test_avl.c.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "../avl.hpp"
+
+/*---------------------------------------------------------------------------*/
+
+#define N_ITEMS  2000
+#define N_KEYS    500
+#define N_ROUNDS   20
+
+/*---------------------------------------------------------------------------*/
+
+struct obj {
+   int         i;
+   std::string s;
+};
+
+typedef avl::tree<obj, avl::member<obj, int, &obj::i>, std::less<int>, false>                 int_tree;
+typedef avl::tree<obj, avl::member<obj, std::string, &obj::s>, std::greater<std::string>, true> str_tree;
+
+static int errors = 0;
+
+#define CHECK(cond) \
+   do { \
+      if ( !(cond)) { \
+         fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+         if (++errors > 10) exit(EXIT_FAILURE); \
+      } \
+   } while (0)
+
+/*---------------------------------------------------------------------------*/
+
+/* Check the whole tree, forwards and backwards, and the bounds of all keys in [lo, hi]
+ */
+template <class Tree, class Map, class Key>
+static void check_tree(const Tree &tree, const Map &map, const std::vector<Key> &keys)
+{
+   typename Tree::iterator it;
+   typename Map::const_iterator mit;
+   typename Map::const_reverse_iterator rmit;
+   typename Tree::reverse_iterator rit;
+
+   CHECK(tree.size() == (long)map.size());
+   CHECK(tree.empty() == map.empty());
+   for (it = tree.begin(), mit = map.begin(); it != tree.end() && mit != map.end(); ++it, ++mit) {
+      CHECK(&*it == mit->second);
+   }
+   CHECK(it == tree.end() && mit == map.end());
+   for (rit = tree.rbegin(), rmit = map.rbegin(); rit != tree.rend() && rmit != map.rend(); ++rit, ++rmit) {
+      CHECK(&*rit == rmit->second);
+   }
+   CHECK(rit == tree.rend() && rmit == map.rend());
+
+   for (const Key &key : keys) {
+      typename Tree::iterator lo = tree.lower_bound(key), hi = tree.upper_bound(key);
+      typename Map::const_iterator mlo = map.lower_bound(key), mhi = map.upper_bound(key);
+      CHECK(lo == tree.end() ? mlo == map.end() : mlo != map.end() && &*lo == mlo->second);
+      CHECK(hi == tree.end() ? mhi == map.end() : mhi != map.end() && &*hi == mhi->second);
+      CHECK(tree.equal_range(key).first == lo && tree.equal_range(key).second == hi);
+      CHECK(tree.count(key) == (long)map.count(key));
+      CHECK(tree.locate(key) == (mlo != mhi ? mlo->second : NULL));
+      CHECK(tree.find(key) == (mlo != mhi ? lo : tree.end()));
+      if (lo != tree.end()) {
+         /* stepping back from a bound, and copies of iterators */
+         typename Tree::iterator prev = lo;
+         --prev;
+         CHECK(mlo == map.begin() ? prev == tree.end() : &*prev == std::prev(mlo)->second);
+         CHECK(lo != prev);
+      } else if ( !map.empty()) {
+         --lo;
+         CHECK(&*lo == map.rbegin()->second);
+      }
+   }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void test_avl_hpp(std::mt19937 &rng, bool rank)
+{
+   std::vector<obj>          obj_v(N_ITEMS);
+   int_tree                  ti(rank);
+   str_tree                  ts(rank);
+   std::map<int, obj *>      mi;
+   std::multimap<std::string, obj *, std::greater<std::string> > ms;
+   std::vector<int>          ki;
+   std::vector<std::string>  ks;
+   int                       n;
+   char                      buf[16];
+
+   for (n = -1; n <= N_KEYS; n++) {
+      snprintf(buf, sizeof buf, "k%04d", n);
+      ki.push_back(n);
+      ks.push_back(buf);
+   }
+   for (n = 0; n < N_ITEMS; n++) {
+      obj_v[n].i = ki[1 + rng() % N_KEYS];
+      obj_v[n].s = ks[1 + rng() % N_KEYS];
+      CHECK(ti.insert(&obj_v[n]) == mi.insert(std::make_pair(obj_v[n].i, &obj_v[n])).second);
+      CHECK(ts.insert(&obj_v[n]));
+      ms.insert(std::make_pair(obj_v[n].s, &obj_v[n]));
+   }
+   check_tree(ti, mi, ki);
+   check_tree(ts, ms, ks);
+
+   /* remove by key (the first item with the key) and by iterator (any item) */
+   for (n = 0; n < N_ITEMS / 2; n++) {
+      int          k  = ki[rng() % ki.size()];
+      const std::string &s = ks[rng() % ks.size()];
+      std::map<int, obj *>::iterator mit = mi.find(k);
+      obj *o = ti.erase(k);
+      CHECK(o == (mit == mi.end() ? NULL : mit->second));
+      if (mit != mi.end()) mi.erase(mit);
+
+      std::pair<str_tree::iterator, str_tree::iterator> r = ts.equal_range(s);
+      std::multimap<std::string, obj *, std::greater<std::string> >::iterator msit = ms.lower_bound(s);
+      if (rng() % 2) {
+         CHECK(ts.erase(s) == (msit == ms.upper_bound(s) ? NULL : msit->second));
+         if (msit != ms.upper_bound(s)) ms.erase(msit);
+      } else if (r.first != r.second) {
+         long skip = rng() % ts.count(s);
+         while (skip--) { ++r.first; ++msit; }
+         CHECK(ts.erase(r.first) == msit->second);
+         ms.erase(msit);
+      }
+   }
+   check_tree(ti, mi, ki);
+   check_tree(ts, ms, ks);
+
+   /* moving */
+   int_tree tm(std::move(ti));
+   CHECK(ti.get() == NULL);
+   check_tree(tm, mi, ki);
+   ti = std::move(tm);
+   check_tree(ti, mi, ki);
+
+   ts.clear();
+   ms.clear();
+   check_tree(ts, ms, ks);
+}
+
+/*---------------------------------------------------------------------------*/
+
+int main(void)
+{
+   std::mt19937 rng(12345);
+   int          r;
+
+   for (r = 0; r < N_ROUNDS; r++) {
+      test_avl_hpp(rng, r % 2);
+      printf("%d ", r);
+      fflush(stdout);
+   }
+   printf("\n");
+   if (errors) {
+      printf("./test_avl_hpp FAILED\n");
+      return EXIT_FAILURE;
+   }
+   printf("./test_avl_hpp OK\n");
+   return EXIT_SUCCESS;
+}